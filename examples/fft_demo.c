@@ -0,0 +1,166 @@
+/**
+ * FFT Demo - Frequency analysis with the Convolution library
+ *
+ * This program shows spectrum analysis of a two-tone signal, an FFT
+ * round trip through plans, FFT-based convolution against the direct
+ * method, and a short-time Fourier transform of a signal whose pitch
+ * changes halfway through.
+ */
+
+#include "../include/convolution.h"
+
+int main() {
+    printf("=== FFT Demo ===\n\n");
+
+    double sample_rate = 8000.0;
+
+    // Two tones: 440 Hz and a quieter 1250 Hz
+    Signal *low = generate_sine_wave(440.0, 1.0, 0.0, 0.5, sample_rate);
+    Signal *high = generate_sine_wave(1250.0, 0.3, 0.0, 0.5, sample_rate);
+    Signal *tones = create_signal(low->length, sample_rate);
+    for (int i = 0; i < tones->length; i++) {
+        tones->data[i] = low->data[i] + high->data[i];
+    }
+    strcpy(tones->name, "440 Hz + 1250 Hz");
+    print_signal_info(tones);
+
+    printf("Spectrum analysis...\n");
+
+    // Only positive frequencies are needed, and power avoids square roots
+    FFTResult *spectrum = compute_fft_flags(tones, FFT_WANT_POWER | FFT_HALF_SPECTRUM);
+    if (spectrum) {
+        // The two largest local maxima
+        int peaks[2] = {0, 0};
+        for (int i = 1; i < spectrum->length - 1; i++) {
+            double p = spectrum->power[i];
+            if (p < spectrum->power[i - 1] || p < spectrum->power[i + 1]) continue;
+
+            if (p > spectrum->power[peaks[0]]) {
+                peaks[1] = peaks[0];
+                peaks[0] = i;
+            } else if (p > spectrum->power[peaks[1]]) {
+                peaks[1] = i;
+            }
+        }
+
+        printf("FFT size: %d (%d bins, %.2f Hz per bin)\n", spectrum->fft_size,
+               spectrum->length, sample_rate / spectrum->fft_size);
+        for (int k = 0; k < 2; k++) {
+            printf("Peak %d: %.1f Hz (%.1f dB)\n", k + 1, spectrum->frequency[peaks[k]],
+                   10.0 * log10(spectrum->power[peaks[k]]));
+        }
+
+        free_fft_result(spectrum);
+    }
+
+    printf("\nFFT round trip...\n");
+
+    // Forward and inverse real transforms through cached plans, using the
+    // split (separate real / imaginary) spectrum layout
+    int n = 1024;
+    FFTPlan *forward = fft_plan_acquire_real(n, FFT_FORWARD);
+    FFTPlan *inverse = fft_plan_acquire_real(n, FFT_INVERSE);
+    double *re = (double*)malloc((n / 2 + 1) * sizeof(double));
+    double *im = (double*)malloc((n / 2 + 1) * sizeof(double));
+    double *restored = (double*)malloc(n * sizeof(double));
+
+    if (forward && inverse && re && im && restored) {
+        fft_execute_r2c_split(forward, tones->data, re, im);
+        fft_execute_c2r_split(inverse, re, im, restored);
+
+        double max_error = 0.0;
+        for (int i = 0; i < n; i++) {
+            double error = fabs(restored[i] / n - tones->data[i]);
+            if (error > max_error) max_error = error;
+        }
+        printf("%d-point round trip, maximum error: %.2e\n", n, max_error);
+    }
+
+    free(re);
+    free(im);
+    free(restored);
+    fft_plan_release(forward);
+    fft_plan_release(inverse);
+
+    printf("\nFFT convolution...\n");
+
+    // A 63-tap moving average: direct and FFT convolution should agree
+    Signal *average = create_signal(63, sample_rate);
+    for (int i = 0; i < average->length; i++) {
+        average->data[i] = 1.0 / average->length;
+    }
+    strcpy(average->name, "63-point Moving Average");
+
+    Signal *direct = convolve(tones, average);
+    Signal *fast = convolve_fft(tones, average);
+    if (direct && fast) {
+        double max_diff = 0.0;
+        for (int i = 0; i < direct->length; i++) {
+            double diff = fabs(direct->data[i] - fast->data[i]);
+            if (diff > max_diff) max_diff = diff;
+        }
+        printf("Output length: %d, maximum difference: %.2e\n", direct->length, max_diff);
+    }
+
+    printf("\nShort-time Fourier transform...\n");
+
+    // 600 Hz for the first half second, then 1800 Hz
+    Signal *first = generate_sine_wave(600.0, 1.0, 0.0, 0.5, sample_rate);
+    Signal *second = generate_sine_wave(1800.0, 1.0, 0.0, 0.5, sample_rate);
+    Signal *sweep = create_signal(first->length + second->length, sample_rate);
+    memcpy(sweep->data, first->data, first->length * sizeof(double));
+    memcpy(sweep->data + first->length, second->data, second->length * sizeof(double));
+    strcpy(sweep->name, "600 Hz then 1800 Hz");
+
+    STFTPlan *plan = stft_plan_create(WINDOW_HANN, 256, 128, 0);
+    STFTResult *stft = plan ? compute_stft(plan, sweep) : NULL;
+    if (stft) {
+        printf("%d frames of %d bins (hop %d samples)\n", stft->frames, stft->bins, stft->hop_size);
+
+        // Strongest bin of every 8th frame
+        for (int f = 0; f < stft->frames; f += 8) {
+            int peak = 0;
+            double peak_power = 0.0;
+            for (int b = 0; b < stft->bins; b++) {
+                size_t cell = (size_t)f * stft->bins + b;
+                double p = stft->real[cell] * stft->real[cell] + stft->imag[cell] * stft->imag[cell];
+                if (p > peak_power) {
+                    peak_power = p;
+                    peak = b;
+                }
+            }
+            printf("  t = %.3f s: %.1f Hz\n", (double)f * stft->hop_size / sample_rate,
+                   peak * sample_rate / stft->fft_size);
+        }
+
+        // Weighted overlap-add resynthesis recovers the signal
+        Signal *resynthesized = inverse_stft(plan, stft);
+        if (resynthesized) {
+            double max_error = 0.0;
+            for (int i = 0; i < sweep->length; i++) {
+                double error = fabs(resynthesized->data[i] - sweep->data[i]);
+                if (error > max_error) max_error = error;
+            }
+            printf("ISTFT maximum error: %.2e\n", max_error);
+            free_signal(resynthesized);
+        }
+
+        free_stft_result(stft);
+    }
+    stft_plan_destroy(plan);
+
+    printf("\nDemo complete!\n");
+
+    // Cleanup
+    free_signal(low);
+    free_signal(high);
+    free_signal(tones);
+    free_signal(average);
+    free_signal(direct);
+    free_signal(fast);
+    free_signal(first);
+    free_signal(second);
+    free_signal(sweep);
+
+    return 0;
+}
@@ -0,0 +1,767 @@
+#define _POSIX_C_SOURCE 200809L
+
+/**
+ * Performance Test - Convolution benchmark suite
+ *
+ * Sweeps signal length N and kernel length M (equal and lopsided sizes)
+ * across every convolution algorithm and reports median / p99 run times,
+ * GFLOP/s and working-set bytes per output sample. Results can be written
+ * as CSV or JSON so runs from different releases can be compared.
+ *
+ * Usage: performance_test [--csv | --json] [--output FILE] [--quick | --full]
+ *                         [--max-log2 K] [--sizes N:M,...] [--threads T]
+ *                         [--trials T] [--warmup W] [--budget SECONDS]
+ *                         [--max-seconds SECONDS] [--max-memory MB]
+ *        performance_test --check-threads
+ *
+ * --check-threads runs the threaded block and batch convolutions at several
+ * thread counts and fails unless every result matches the single-thread one.
+ */
+
+#include "../include/convolution.h"
+#include <time.h>
+
+#define MAX_CASES 256
+#define MAX_TRIALS 1000
+
+// Shortest span a timed trial covers; faster calls are repeated inside it
+#define MIN_TRIAL_NS 200000.0
+
+// Block size of the streaming (partitioned) convolver benchmark
+#define STREAM_BLOCK 1024
+
+// Channels of the --check-threads batch cases
+#define CHECK_CHANNELS 8
+
+typedef enum {
+    FORMAT_TABLE,
+    FORMAT_CSV,
+    FORMAT_JSON
+} OutputFormat;
+
+// Benchmarked methods: the ConvAlgorithm values, the cost-model choice and
+// the streaming convolver
+typedef enum {
+    BENCH_DIRECT,
+    BENCH_SIMD_DIRECT,
+    BENCH_FFT,
+    BENCH_OVERLAP_ADD,
+    BENCH_OVERLAP_SAVE,
+    BENCH_AUTO,
+    BENCH_PARTITIONED,
+    BENCH_COUNT
+} BenchMethod;
+
+typedef struct {
+    int n;
+    int m;
+} BenchCase;
+
+typedef struct {
+    OutputFormat format;
+    const char *output;
+    int max_log2;
+    int step_log2;
+    int threads;
+    int trials;
+    int warmup;
+    double budget_s;         // Time spent timing one case, after min trials
+    double max_seconds;      // Skip cases estimated to take longer per call
+    double max_memory_mb;    // Skip cases with a larger working set
+    BenchCase cases[MAX_CASES];
+    int case_count;
+    int check_threads;       // Run the thread-count check instead
+} BenchOptions;
+
+typedef struct {
+    const char *method;
+    const char *chosen;      // Algorithm run (differs from method for auto)
+    int n;
+    int m;
+    int trials;
+    int repeats;             // Calls per trial
+    double median_ns;
+    double p99_ns;
+    double min_ns;
+    double gflops;           // Algorithmic flops / median time
+    double effective_gflops; // 2*N*M / median time (direct-equivalent)
+    double ns_per_sample;
+    double bytes_per_sample; // Working set / output samples
+    double max_error;        // Relative to the reference method of the case
+    const char *status;      // "ok", "skipped" or "failed"
+} BenchRecord;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static const char* method_name(BenchMethod method) {
+    switch (method) {
+        case BENCH_DIRECT:       return "direct";
+        case BENCH_SIMD_DIRECT:  return "simd_direct";
+        case BENCH_FFT:          return "fft";
+        case BENCH_OVERLAP_ADD:  return "overlap_add";
+        case BENCH_OVERLAP_SAVE: return "overlap_save";
+        case BENCH_AUTO:         return "auto";
+        case BENCH_PARTITIONED:  return "partitioned";
+        default:                 return "unknown";
+    }
+}
+
+// Reproducible uniform samples in [-1, 1)
+static void fill_random(Signal *signal, unsigned long long seed) {
+    unsigned long long state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (int i = 0; i < signal->length; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        signal->data[i] = (double)(state >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+    }
+}
+
+// FFT size the block methods use for an n x m convolution (n >= m)
+static int block_size_for(int n, int m) {
+    int fft_size = choose_block_fft_size(m);
+    int full_size = fft_next_fast_size_real(n + m - 1);
+    return (fft_size > full_size) ? full_size : fft_size;
+}
+
+// Flops of one real transform of size f (half a complex 5 f log2 f FFT)
+static double real_fft_flops(int f) {
+    return 2.5 * f * log2((double)f);
+}
+
+// Flops of one complex multiply over the bins of a size-f real transform
+static double multiply_flops(int f) {
+    return 6.0 * (f / 2 + 1);
+}
+
+// Algorithmic flop count of a method for an n x m convolution (n >= m)
+static double method_flops(ConvAlgorithm algorithm, int streaming, int n, int m) {
+    int length = n + m - 1;
+
+    if (streaming) {
+        int segments = (m + STREAM_BLOCK - 1) / STREAM_BLOCK;
+        int blocks = (length + STREAM_BLOCK - 1) / STREAM_BLOCK;
+        int f = 2 * STREAM_BLOCK;
+        return (double)blocks * (2.0 * real_fft_flops(f) + segments * 8.0 * (f / 2 + 1));
+    }
+
+    switch (algorithm) {
+        case CONV_ALGO_DIRECT:
+        case CONV_ALGO_SIMD_DIRECT:
+            return 2.0 * n * m;
+
+        case CONV_ALGO_FFT: {
+            int f = fft_next_fast_size_real(length);
+            return 3.0 * real_fft_flops(f) + multiply_flops(f) + f;
+        }
+
+        case CONV_ALGO_OVERLAP_ADD:
+        case CONV_ALGO_OVERLAP_SAVE: {
+            int f = block_size_for(n, m);
+            int step = f - m + 1;
+            int covered = (algorithm == CONV_ALGO_OVERLAP_SAVE) ? length : n;
+            int blocks = (covered + step - 1) / step;
+            return real_fft_flops(f) + blocks * (2.0 * real_fft_flops(f) + multiply_flops(f));
+        }
+
+        default:
+            return 0.0;
+    }
+}
+
+// Approximate bytes a method touches: inputs, output and its transform
+// buffers (one block buffer per worker thread for the block methods)
+static double method_bytes(ConvAlgorithm algorithm, int streaming, int n, int m, int threads) {
+    int length = n + m - 1;
+    double bytes = (double)(n + m + length) * sizeof(double);
+
+    if (streaming) {
+        int segments = (m + STREAM_BLOCK - 1) / STREAM_BLOCK;
+        double spectrum = (2.0 * STREAM_BLOCK + 2) * sizeof(double);
+        return bytes + 2.0 * segments * spectrum + 4.0 * spectrum;
+    }
+
+    switch (algorithm) {
+        case CONV_ALGO_FFT: {
+            int f = fft_next_fast_size_real(length);
+            return bytes + 2.0 * (f + 2) * sizeof(double);
+        }
+
+        case CONV_ALGO_OVERLAP_ADD:
+        case CONV_ALGO_OVERLAP_SAVE: {
+            int f = block_size_for(n, m);
+            return bytes + (1.0 + threads) * (f + 2) * sizeof(double);
+        }
+
+        default:
+            return bytes;
+    }
+}
+
+// Run one method once. Returns the full-length result or NULL.
+static Signal* run_method(BenchMethod method, ConvAlgorithm algorithm,
+                          const Signal *signal, const Signal *kernel) {
+    if (method != BENCH_PARTITIONED) {
+        return convolve_with_algorithm(signal, kernel, CONV_MODE_FULL, algorithm);
+    }
+
+    Convolver *convolver = convolver_create_partitioned(kernel, STREAM_BLOCK);
+    if (!convolver) return NULL;
+
+    Signal *result = create_signal(signal->length + kernel->length - 1, signal->sample_rate);
+    if (result) {
+        int written = 0;
+        for (int i = 0; i < signal->length; i += STREAM_BLOCK) {
+            int count = signal->length - i;
+            if (count > STREAM_BLOCK) count = STREAM_BLOCK;
+            written += convolver_process(convolver, signal->data + i, count, result->data + i);
+        }
+        written += convolver_flush(convolver, result->data + written);
+        if (written != result->length) {
+            free_signal(result);
+            result = NULL;
+        }
+    }
+
+    convolver_destroy(convolver);
+    return result;
+}
+
+// Largest |a - b| relative to the largest |b|
+static double relative_error(const Signal *a, const Signal *b) {
+    if (!a || !b || a->length != b->length) return -1.0;
+
+    double error = 0.0;
+    double scale = 0.0;
+    for (int i = 0; i < a->length; i++) {
+        double diff = fabs(a->data[i] - b->data[i]);
+        if (diff > error) error = diff;
+        if (fabs(b->data[i]) > scale) scale = fabs(b->data[i]);
+    }
+
+    return (scale > 0.0) ? error / scale : error;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const double *sorted, int count, double p) {
+    int rank = (int)ceil(p / 100.0 * count);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+// Time one method on one case. *reference is the first successful result
+// of the case; later methods are checked against it.
+static void bench_method(BenchRecord *record, const BenchOptions *options,
+                         BenchMethod method, const Signal *signal, const Signal *kernel,
+                         Signal **reference) {
+    int n = signal->length;
+    int m = kernel->length;
+    int longer = (n > m) ? n : m;
+    int shorter = (n > m) ? m : n;
+
+    ConvAlgorithm algorithm = (ConvAlgorithm)method;
+    if (method == BENCH_AUTO) algorithm = conv_select_algorithm(n, m);
+    int streaming = (method == BENCH_PARTITIONED);
+
+    memset(record, 0, sizeof(*record));
+    record->method = method_name(method);
+    record->chosen = streaming ? "partitioned" : conv_algorithm_name(algorithm);
+    record->n = n;
+    record->m = m;
+    record->max_error = -1.0;
+    record->status = "skipped";
+
+    double output = (double)(n + m - 1);
+    double bytes = method_bytes(algorithm, streaming, longer, shorter, conv_get_num_threads());
+    record->bytes_per_sample = bytes / output;
+
+    // Keep the sweep bounded: the cost model screens out calls that would
+    // take far too long (direct methods at large N*M) or need too much memory
+    double estimate = streaming
+        ? conv_estimate_cost(CONV_ALGO_OVERLAP_ADD, n, m)
+        : conv_estimate_cost(algorithm, n, m);
+    if (estimate > options->max_seconds * 1e9) return;
+    if (bytes > options->max_memory_mb * 1024.0 * 1024.0) return;
+
+    // Warm-up runs fill the plan and window caches and fault in the
+    // output pages; they also size the repeat count of short calls
+    Signal *result = NULL;
+    double warm_ns = 0.0;
+    for (int w = 0; w < options->warmup || !result; w++) {
+        free_signal(result);
+        double start = now_ns();
+        result = run_method(method, algorithm, signal, kernel);
+        warm_ns = now_ns() - start;
+        if (!result) {
+            record->status = "failed";
+            return;
+        }
+    }
+
+    if (*reference) {
+        record->max_error = relative_error(result, *reference);
+        free_signal(result);
+    } else {
+        *reference = result;
+        record->max_error = 0.0;
+    }
+
+    int repeats = 1;
+    if (warm_ns < MIN_TRIAL_NS) {
+        repeats = (int)ceil(MIN_TRIAL_NS / (warm_ns > 1.0 ? warm_ns : 1.0));
+    }
+
+    double samples[MAX_TRIALS];
+    int trials = 0;
+    double spent = 0.0;
+    while (trials < options->trials && (trials < 3 || spent < options->budget_s * 1e9)) {
+        double start = now_ns();
+        for (int r = 0; r < repeats; r++) {
+            free_signal(run_method(method, algorithm, signal, kernel));
+        }
+        double elapsed = now_ns() - start;
+        samples[trials++] = elapsed / repeats;
+        spent += elapsed;
+    }
+
+    qsort(samples, trials, sizeof(double), compare_doubles);
+
+    record->trials = trials;
+    record->repeats = repeats;
+    record->min_ns = samples[0];
+    record->median_ns = percentile(samples, trials, 50.0);
+    record->p99_ns = percentile(samples, trials, 99.0);
+    record->gflops = method_flops(algorithm, streaming, longer, shorter) / record->median_ns;
+    record->effective_gflops = 2.0 * n * m / record->median_ns;
+    record->ns_per_sample = record->median_ns / output;
+    record->status = "ok";
+}
+
+// Default sweep: every N = 2^k and every M = 2^j <= N on the log2 step,
+// plus non-power-of-two lengths that just spill into the next FFT size
+static void build_default_cases(BenchOptions *options) {
+    options->case_count = 0;
+
+    for (int log_n = 8; log_n <= options->max_log2; log_n += options->step_log2) {
+        int n = 1 << log_n;
+        for (int log_m = 2; log_m <= log_n && options->case_count < MAX_CASES; log_m += options->step_log2) {
+            options->cases[options->case_count++] = (BenchCase){n, 1 << log_m};
+        }
+        if (options->case_count < MAX_CASES) {
+            options->cases[options->case_count++] = (BenchCase){n + 1, n / 8 + 3};
+        }
+    }
+}
+
+// Parse "N:M,N:M,..." into the case list. Returns 0 on success.
+static int parse_cases(BenchOptions *options, const char *list) {
+    options->case_count = 0;
+
+    const char *p = list;
+    while (*p) {
+        int n, m, used;
+        if (sscanf(p, "%d:%d%n", &n, &m, &used) != 2 || n < 1 || m < 1) return -1;
+        if (options->case_count >= MAX_CASES) return -1;
+
+        options->cases[options->case_count++] = (BenchCase){n, m};
+        p += used;
+        if (*p == ',') p++;
+        else if (*p) return -1;
+    }
+
+    return options->case_count > 0 ? 0 : -1;
+}
+
+static void print_usage(const char *program) {
+    printf("Usage: %s [options]\n\n", program);
+    printf("  --csv, --json        Machine-readable output (default: table)\n");
+    printf("  --output FILE        Write results to FILE instead of stdout\n");
+    printf("  --quick              Sizes up to 2^16, every other power of two\n");
+    printf("  --full               Sizes up to 2^24\n");
+    printf("  --max-log2 K         Largest N = 2^K (default 20)\n");
+    printf("  --sizes N:M,...      Explicit cases instead of the sweep\n");
+    printf("  --threads T          Worker threads (0 = one per core)\n");
+    printf("  --trials T           Timed trials per case (default 15)\n");
+    printf("  --warmup W           Untimed warm-up runs (default 2)\n");
+    printf("  --budget S           Seconds per case after 3 trials (default 1)\n");
+    printf("  --max-seconds S      Skip calls estimated above S seconds (default 2)\n");
+    printf("  --max-memory MB      Skip cases above MB of working set (default 2048)\n");
+    printf("  --check-threads      Check block/batch results across thread counts\n");
+}
+
+// Parse the command line. Returns 0 to run, 1 after --help, -1 on error.
+static int parse_options(BenchOptions *options, int argc, char **argv) {
+    memset(options, 0, sizeof(*options));
+    options->format = FORMAT_TABLE;
+    options->max_log2 = 20;
+    options->step_log2 = 2;
+    options->trials = 15;
+    options->warmup = 2;
+    options->budget_s = 1.0;
+    options->max_seconds = 2.0;
+    options->max_memory_mb = 2048.0;
+
+    const char *sizes = NULL;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--csv") == 0) {
+            options->format = FORMAT_CSV;
+        } else if (strcmp(arg, "--json") == 0) {
+            options->format = FORMAT_JSON;
+        } else if (strcmp(arg, "--quick") == 0) {
+            options->max_log2 = 16;
+            options->step_log2 = 4;
+        } else if (strcmp(arg, "--full") == 0) {
+            options->max_log2 = 24;
+        } else if (strcmp(arg, "--check-threads") == 0) {
+            options->check_threads = 1;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 1;
+        } else if (!value) {
+            fprintf(stderr, "Unknown or incomplete option: %s\n", arg);
+            return -1;
+        } else if (strcmp(arg, "--output") == 0) {
+            options->output = value;
+            i++;
+        } else if (strcmp(arg, "--max-log2") == 0) {
+            options->max_log2 = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--sizes") == 0) {
+            sizes = value;
+            i++;
+        } else if (strcmp(arg, "--threads") == 0) {
+            options->threads = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--trials") == 0) {
+            options->trials = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--warmup") == 0) {
+            options->warmup = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--budget") == 0) {
+            options->budget_s = atof(value);
+            i++;
+        } else if (strcmp(arg, "--max-seconds") == 0) {
+            options->max_seconds = atof(value);
+            i++;
+        } else if (strcmp(arg, "--max-memory") == 0) {
+            options->max_memory_mb = atof(value);
+            i++;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            return -1;
+        }
+    }
+
+    if (options->max_log2 < 8 || options->max_log2 > 24) {
+        fprintf(stderr, "--max-log2 must be between 8 and 24\n");
+        return -1;
+    }
+    if (options->trials < 1) options->trials = 1;
+    if (options->trials > MAX_TRIALS) options->trials = MAX_TRIALS;
+    if (options->warmup < 0) options->warmup = 0;
+
+    if (sizes) {
+        if (parse_cases(options, sizes) != 0) {
+            fprintf(stderr, "Invalid --sizes list: %s\n", sizes);
+            return -1;
+        }
+    } else {
+        build_default_cases(options);
+    }
+
+    return 0;
+}
+
+static void write_header(FILE *out, const BenchOptions *options) {
+    switch (options->format) {
+        case FORMAT_CSV:
+            fprintf(out, "method,algorithm,n,m,status,trials,repeats,median_ns,p99_ns,min_ns,"
+                         "gflops,effective_gflops,ns_per_sample,bytes_per_sample,max_error,"
+                         "simd,threads\n");
+            break;
+
+        case FORMAT_JSON:
+            fprintf(out, "{\n  \"benchmark\": \"convolution\",\n");
+            fprintf(out, "  \"simd\": \"%s\",\n", conv_simd_level_name(conv_get_simd_level()));
+            fprintf(out, "  \"threads\": %d,\n", conv_get_num_threads());
+            fprintf(out, "  \"warmup\": %d,\n  \"max_trials\": %d,\n", options->warmup, options->trials);
+            fprintf(out, "  \"results\": [");
+            break;
+
+        default:
+            fprintf(out, "=== Convolution Benchmark ===\n");
+            fprintf(out, "SIMD: %s, threads: %d, up to %d trials after %d warm-up runs\n\n",
+                    conv_simd_level_name(conv_get_simd_level()), conv_get_num_threads(),
+                    options->trials, options->warmup);
+            fprintf(out, "%-13s %9s %9s %12s %12s %9s %9s %9s %10s\n",
+                    "Method", "N", "M", "Median(us)", "P99(us)", "GFLOP/s",
+                    "Eff.GF/s", "B/sample", "Error");
+            break;
+    }
+}
+
+static void write_record(FILE *out, const BenchOptions *options, const BenchRecord *r, int index) {
+    int ok = (strcmp(r->status, "ok") == 0);
+
+    switch (options->format) {
+        case FORMAT_CSV:
+            fprintf(out, "%s,%s,%d,%d,%s,%d,%d,%.1f,%.1f,%.1f,%.4f,%.4f,%.4f,%.2f,%.3e,%s,%d\n",
+                    r->method, r->chosen, r->n, r->m, r->status, r->trials, r->repeats,
+                    r->median_ns, r->p99_ns, r->min_ns, r->gflops, r->effective_gflops,
+                    r->ns_per_sample, r->bytes_per_sample, r->max_error,
+                    conv_simd_level_name(conv_get_simd_level()), conv_get_num_threads());
+            break;
+
+        case FORMAT_JSON:
+            fprintf(out, "%s\n    {\"method\": \"%s\", \"algorithm\": \"%s\", \"n\": %d, \"m\": %d, "
+                         "\"status\": \"%s\"",
+                    index > 0 ? "," : "", r->method, r->chosen, r->n, r->m, r->status);
+            if (ok) {
+                fprintf(out, ", \"trials\": %d, \"repeats\": %d, \"median_ns\": %.1f, "
+                             "\"p99_ns\": %.1f, \"min_ns\": %.1f, \"gflops\": %.4f, "
+                             "\"effective_gflops\": %.4f, \"ns_per_sample\": %.4f, "
+                             "\"bytes_per_sample\": %.2f, \"max_error\": %.3e",
+                        r->trials, r->repeats, r->median_ns, r->p99_ns, r->min_ns,
+                        r->gflops, r->effective_gflops, r->ns_per_sample,
+                        r->bytes_per_sample, r->max_error);
+            }
+            fprintf(out, "}");
+            break;
+
+        default:
+            if (ok) {
+                fprintf(out, "%-13s %9d %9d %12.2f %12.2f %9.3f %9.3f %9.1f %10.2e\n",
+                        r->method, r->n, r->m, r->median_ns / 1000.0, r->p99_ns / 1000.0,
+                        r->gflops, r->effective_gflops, r->bytes_per_sample, r->max_error);
+            } else {
+                fprintf(out, "%-13s %9d %9d %12s\n", r->method, r->n, r->m, r->status);
+            }
+            break;
+    }
+    fflush(out);
+}
+
+static void write_footer(FILE *out, const BenchOptions *options) {
+    if (options->format == FORMAT_JSON) {
+        fprintf(out, "\n  ]\n}\n");
+    }
+}
+
+// Block and batch convolutions whose work is split across the thread pool
+// (see check_thread_counts)
+typedef enum {
+    CHECK_OVERLAP_ADD,
+    CHECK_OVERLAP_SAVE,
+    CHECK_BATCH_SHARED,
+    CHECK_BATCH_PER_CHANNEL,
+    CHECK_COUNT
+} CheckMethod;
+
+static const char* check_method_name(CheckMethod method) {
+    switch (method) {
+        case CHECK_OVERLAP_ADD:       return "overlap-add";
+        case CHECK_OVERLAP_SAVE:      return "overlap-save";
+        case CHECK_BATCH_SHARED:      return "batch-shared";
+        case CHECK_BATCH_PER_CHANNEL: return "batch-channel";
+        default:                      return "unknown";
+    }
+}
+
+// Run one check method at the current thread count. The block methods
+// convolve the long signal with kernels[0]; the batch methods take the
+// CHECK_CHANNELS signals. Returns an array of CHECK_CHANNELS results (only
+// the first is set by the block methods), or NULL on error.
+static Signal** run_check_method(CheckMethod method, const Signal *long_signal,
+                                 Signal *const *signals, Signal *const *kernels) {
+    switch (method) {
+        case CHECK_OVERLAP_ADD:
+        case CHECK_OVERLAP_SAVE: {
+            Signal **results = (Signal**)calloc(CHECK_CHANNELS, sizeof(Signal*));
+            if (!results) return NULL;
+            // Small blocks, so that the long signal spans many parallel tasks
+            results[0] = convolve_block(long_signal, kernels[0],
+                                        method == CHECK_OVERLAP_ADD ? BLOCK_OVERLAP_ADD
+                                                                    : BLOCK_OVERLAP_SAVE,
+                                        1024);
+            if (!results[0]) {
+                free(results);
+                return NULL;
+            }
+            return results;
+        }
+        case CHECK_BATCH_SHARED:
+            return convolve_batch(signals, CHECK_CHANNELS, kernels, 1);
+        case CHECK_BATCH_PER_CHANNEL:
+            return convolve_batch(signals, CHECK_CHANNELS, kernels, CHECK_CHANNELS);
+        default:
+            return NULL;
+    }
+}
+
+// Largest difference between two result sets, or -1 if their shapes differ
+static double results_difference(Signal *const *a, Signal *const *b, int count) {
+    double max_diff = 0.0;
+    for (int c = 0; c < count; c++) {
+        if (!a[c] && !b[c]) continue;
+        if (!a[c] || !b[c] || a[c]->length != b[c]->length) return -1.0;
+        for (int i = 0; i < a[c]->length; i++) {
+            double diff = fabs(a[c]->data[i] - b[c]->data[i]);
+            if (diff != diff) return INFINITY;
+            if (diff > max_diff) max_diff = diff;
+        }
+    }
+    return max_diff;
+}
+
+// Block and batch convolution promise results that do not depend on the
+// thread count. Run each at 2, 3, 4 and 7 threads and compare with a
+// single-thread baseline; any difference fails. Returns the number of
+// mismatching runs, or -1 if the inputs could not be built.
+static int check_thread_counts(FILE *out) {
+    static const int thread_counts[] = { 2, 3, 4, 7 };
+    int count = (int)(sizeof(thread_counts) / sizeof(thread_counts[0]));
+
+    // Equal-length channels let the shared-kernel batch run planar; the
+    // per-channel kernels differ in length, so that case is split by channel
+    Signal *long_signal = create_signal(200000, 44100.0);
+    Signal *signals[CHECK_CHANNELS] = { NULL };
+    Signal *kernels[CHECK_CHANNELS] = { NULL };
+    int ok = (long_signal != NULL);
+    if (ok) fill_random(long_signal, 99);
+    for (int c = 0; c < CHECK_CHANNELS && ok; c++) {
+        signals[c] = create_signal(30000, 44100.0);
+        kernels[c] = create_signal(257 - 16 * c, 44100.0);
+        if (!signals[c] || !kernels[c]) ok = 0;
+        else {
+            fill_random(signals[c], 1 + c);
+            fill_random(kernels[c], 1000 + c);
+        }
+    }
+
+    int original_threads = conv_get_num_threads();
+    int failures = ok ? 0 : -1;
+    fprintf(out, "=== Thread-count check ===\n");
+    for (int method = 0; method < CHECK_COUNT && failures >= 0; method++) {
+        conv_set_num_threads(1);
+        Signal **baseline = run_check_method((CheckMethod)method, long_signal, signals, kernels);
+        if (!baseline) {
+            failures = -1;
+            break;
+        }
+
+        for (int t = 0; t < count; t++) {
+            conv_set_num_threads(thread_counts[t]);
+            Signal **results = run_check_method((CheckMethod)method, long_signal, signals, kernels);
+            double diff = results ? results_difference(baseline, results, CHECK_CHANNELS) : -1.0;
+            int match = (diff == 0.0);
+            fprintf(out, "%-13s threads %d: %s", check_method_name((CheckMethod)method),
+                    thread_counts[t], match ? "ok" : "MISMATCH");
+            if (!match) {
+                if (diff < 0.0) fprintf(out, " (missing or misshapen result)");
+                else fprintf(out, " (max difference %.3e)", diff);
+                failures++;
+            }
+            fprintf(out, "\n");
+            if (results) free_signal_batch(results, CHECK_CHANNELS);
+        }
+
+        free_signal_batch(baseline, CHECK_CHANNELS);
+    }
+
+    conv_set_num_threads(original_threads);
+    free_signal(long_signal);
+    for (int c = 0; c < CHECK_CHANNELS; c++) {
+        free_signal(signals[c]);
+        free_signal(kernels[c]);
+    }
+
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    int status = parse_options(&options, argc, argv);
+    if (status != 0) return status > 0 ? 0 : 1;
+
+    if (options.check_threads) {
+        int failures = check_thread_counts(stdout);
+        if (failures < 0) fprintf(stderr, "Thread-count check could not run\n");
+        else printf("%s\n", failures == 0 ? "All thread counts match" : "Thread-count check FAILED");
+        fft_plan_cache_clear();
+        conv_thread_pool_shutdown();
+        return failures == 0 ? 0 : 1;
+    }
+
+    if (options.threads > 0) conv_set_num_threads(options.threads);
+
+    FILE *out = stdout;
+    if (options.output) {
+        out = fopen(options.output, "w");
+        if (!out) {
+            fprintf(stderr, "Cannot open %s for writing\n", options.output);
+            return 1;
+        }
+    }
+
+    write_header(out, &options);
+
+    int index = 0;
+    for (int c = 0; c < options.case_count; c++) {
+        const BenchCase *bench = &options.cases[c];
+
+        Signal *signal = create_signal(bench->n, 44100.0);
+        Signal *kernel = create_signal(bench->m, 44100.0);
+        if (!signal || !kernel) {
+            fprintf(stderr, "Out of memory for N=%d, M=%d\n", bench->n, bench->m);
+            free_signal(signal);
+            free_signal(kernel);
+            continue;
+        }
+        fill_random(signal, 1 + c);
+        fill_random(kernel, 1000 + c);
+
+        // SIMD direct goes first so that, where it runs, it is the
+        // reference the FFT-based methods are checked against
+        static const BenchMethod order[BENCH_COUNT] = {
+            BENCH_SIMD_DIRECT, BENCH_DIRECT, BENCH_FFT, BENCH_OVERLAP_ADD,
+            BENCH_OVERLAP_SAVE, BENCH_PARTITIONED, BENCH_AUTO
+        };
+
+        Signal *reference = NULL;
+        for (int i = 0; i < BENCH_COUNT; i++) {
+            BenchRecord record;
+            bench_method(&record, &options, order[i], signal, kernel, &reference);
+            write_record(out, &options, &record, index++);
+        }
+
+        if (options.format == FORMAT_TABLE) fprintf(out, "\n");
+
+        free_signal(reference);
+        free_signal(signal);
+        free_signal(kernel);
+    }
+
+    write_footer(out, &options);
+
+    if (out != stdout) fclose(out);
+
+    fft_plan_cache_clear();
+    conv_thread_pool_shutdown();
+
+    return 0;
+}
@@ -37,16 +37,18 @@ int main() {
     
     printf("Frequency analysis...\n");
     
-    // Analyze frequency content
-    FFTResult *original_fft = compute_fft(sine_wave);
-    FFTResult *filtered_fft = compute_fft(filtered_sine);
+    // Analyze frequency content (only the positive-frequency magnitudes
+    // are needed)
+    unsigned flags = FFT_WANT_MAG | FFT_HALF_SPECTRUM;
+    FFTResult *original_fft = compute_fft_flags(sine_wave, flags);
+    FFTResult *filtered_fft = compute_fft_flags(filtered_sine, flags);
     
     if (original_fft && filtered_fft) {
         // Find peak frequencies
         int original_peak = 0, filtered_peak = 0;
         double original_max = 0.0, filtered_max = 0.0;
         
-        int half_length = original_fft->length / 2;
+        int half_length = original_fft->fft_size / 2;
         for (int i = 1; i < half_length; i++) {
             if (original_fft->magnitude[i] > original_max) {
                 original_max = original_fft->magnitude[i];
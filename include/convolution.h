@@ -6,12 +6,26 @@
 #include <math.h>
 #include <complex.h>
 #include <string.h>
+#include <stddef.h>
+#include <stdint.h>
 
 // Constants
 #define MAX_SIGNAL_LENGTH 4096
 #define PI 3.14159265359
 #define TWO_PI 6.28318530718
 
+// FFT directions (sign of the exponent)
+#define FFT_FORWARD -1
+#define FFT_INVERSE 1
+
+// FFTResult contents, OR'd together (see compute_fft_flags). Arrays that
+// are not requested are left NULL.
+#define FFT_WANT_MAG      0x01   // magnitude[k] = |X[k]|
+#define FFT_WANT_PHASE    0x02   // phase[k] = arg X[k]
+#define FFT_WANT_POWER    0x04   // power[k] = |X[k]|^2 (no square root)
+#define FFT_HALF_SPECTRUM 0x08   // Keep only bins 0..N/2 of the real input
+#define FFT_WANT_DEFAULT  (FFT_WANT_MAG | FFT_WANT_PHASE)
+
 // Signal types
 typedef enum {
     SIGNAL_SINE,
@@ -24,6 +38,13 @@ typedef enum {
     SIGNAL_CUSTOM
 } SignalType;
 
+// Who owns a Signal's or FFTResult's memory
+typedef enum {
+    STORAGE_HEAP,          // malloc'd; freed by free_signal / free_fft_result
+    STORAGE_ARENA,         // Drawn from a SignalArena; freed by resetting it
+    STORAGE_EXTERNAL       // Caller-owned buffers (see signal_init)
+} StorageKind;
+
 // Signal structure
 typedef struct {
     double *data;           // Signal samples
@@ -32,8 +53,96 @@ typedef struct {
     double duration;       // Duration in seconds
     SignalType type;       // Type of signal
     char name[64];         // Signal name for display
+    StorageKind storage;   // Owner of data (and of the struct itself)
 } Signal;
 
+// Non-owning view of samples: sample i is data[i * stride]. Views are
+// never freed; the samples belong to whatever the view points into.
+typedef struct {
+    double *data;          // First sample
+    int length;            // Number of samples
+    int stride;            // Distance between samples (1 = contiguous)
+    double sample_rate;    // Sampling rate in Hz
+} SignalView;
+
+// Grayscale image: pixel (x, y) is data[y * stride + x]
+typedef struct {
+    double *data;          // Row-major pixels
+    int width;             // Pixels per row
+    int height;            // Number of rows
+    int stride;            // Distance between rows (>= width)
+    char name[64];         // Image name for display
+    StorageKind storage;   // Owner of data (and of the struct itself)
+} Image;
+
+// Summary of a signal's samples, computed in one pass (see signal_statistics)
+typedef struct {
+    int count;
+    double min;
+    double max;
+    double mean;
+    double variance;       // Population variance (divides by count)
+    double stddev;
+    double rms;
+    double peak;           // Largest absolute value
+} SignalStats;
+
+// Sample encodings of the binary signal format
+typedef enum {
+    SAMPLE_FLOAT64,        // IEEE double, little-endian
+    SAMPLE_FLOAT32         // IEEE float, little-endian
+} SampleFormat;
+
+// Binary signal file mapped into memory. Float64 files on little-endian
+// hosts are used in place; other files are decoded into a private buffer.
+typedef struct {
+    double *samples;       // frames x channels, interleaved
+    int frames;            // Samples per channel
+    int channels;          // Interleaved channels
+    double sample_rate;    // Sampling rate in Hz
+    SampleFormat format;   // Encoding on disk
+    char name[64];         // Signal name stored in the header
+    Signal signal;         // Mono files: the samples as a Signal (never freed)
+    void *map;             // mmap'd file, or NULL if decoded
+    size_t map_length;
+    double *decoded;       // Decoded samples, or NULL if mapped in place
+} MappedSignal;
+
+// File encodings for the streaming readers and writers
+typedef enum {
+    SIGNAL_FILE_CSV,       // "Time,Amplitude" text (mono)
+    SIGNAL_FILE_BINARY     // Binary signal format
+} SignalFileType;
+
+// Chunked reader over a CSV or binary signal file
+typedef struct {
+    FILE *file;
+    SignalFileType type;
+    SampleFormat format;     // Binary files: encoding on disk
+    int channels;            // Interleaved channels (1 for CSV)
+    double sample_rate;      // From the header
+    long long frames;        // Frames in the file, or -1 if unknown (CSV)
+    long long frames_read;   // Frames returned so far
+    char name[64];
+    unsigned char *buffer;   // Raw binary samples, or buffered CSV text
+    size_t buffer_capacity;
+    size_t text_start;       // CSV: first unparsed byte
+    size_t text_end;         // CSV: end of buffered text (a NUL follows)
+    size_t complete_end;     // CSV: end of the last complete buffered line
+    int at_eof;
+} SignalReader;
+
+// Chunked writer for a CSV or binary signal file
+typedef struct {
+    FILE *file;
+    SignalFileType type;
+    SampleFormat format;
+    int channels;
+    double sample_rate;
+    long long frames;        // Frames written so far
+    long length_offset;      // CSV: offset of the Length/Duration lines
+} SignalWriter;
+
 // Complex number for FFT
 typedef struct {
     double real;
@@ -43,12 +152,323 @@ typedef struct {
 // FFT Result structure
 typedef struct {
     Complex *data;         // Complex frequency domain data
-    double *magnitude;     // Magnitude spectrum
-    double *phase;         // Phase spectrum
-    double *frequency;     // Frequency bins
+    double *real;          // The same bins in split layout: real parts
+    double *imag;          // and imaginary parts
+    double *magnitude;     // Magnitude spectrum (FFT_WANT_MAG, else NULL)
+    double *phase;         // Phase spectrum (FFT_WANT_PHASE, else NULL)
+    double *power;         // Squared magnitude (FFT_WANT_POWER, else NULL)
+    double *frequency;     // Frequency of each bin in Hz
     int length;           // Number of frequency bins
+    int fft_size;         // Transform size (length unless FFT_HALF_SPECTRUM)
+    unsigned flags;       // FFT_WANT_* / FFT_HALF_SPECTRUM contents
+    StorageKind storage;  // Owner of the arrays and the struct
 } FFTResult;
 
+// Analysis window shapes
+typedef enum {
+    WINDOW_RECTANGULAR,
+    WINDOW_HANN,
+    WINDOW_HAMMING,
+    WINDOW_BLACKMAN,
+    WINDOW_KAISER,         // Shape WINDOW_KAISER_BETA (see window_table_kaiser)
+    WINDOW_FLAT_TOP
+} WindowType;
+
+// Kaiser shape used when none is given (sidelobes close to Blackman's)
+#define WINDOW_KAISER_BETA 8.6
+
+// Single-precision signal: the fields of Signal with float samples
+typedef struct {
+    float *data;           // Signal samples
+    int length;            // Number of samples
+    double sample_rate;    // Sampling rate in Hz
+    double duration;       // Duration in seconds
+    SignalType type;       // Type of signal
+    char name[64];         // Signal name for display
+    StorageKind storage;   // Owner of data (and of the struct itself)
+} SignalF32;
+
+// Single-precision complex number
+typedef struct {
+    float real;
+    float imag;
+} ComplexF32;
+
+// Single-precision FFT result (see FFTResult)
+typedef struct {
+    ComplexF32 *data;      // Complex frequency domain data
+    float *magnitude;      // Magnitude spectrum
+    float *phase;          // Phase spectrum
+    float *frequency;      // Frequency bins
+    int length;            // Number of frequency bins
+    StorageKind storage;   // Owner of the arrays and the struct
+} FFTResultF32;
+
+// Arithmetic used by the float32 entry points
+typedef enum {
+    CONV_PRECISION_SINGLE,   // Compute in float throughout
+    CONV_PRECISION_MIXED     // Store float, accumulate and transform in double
+} ConvPrecision;
+
+// Bump allocator for per-frame Signals and FFTResults
+typedef struct {
+    unsigned char *memory;   // Aligned start of the block
+    unsigned char *block;    // Block as returned by malloc
+    size_t capacity;         // Usable bytes
+    size_t used;             // Bytes handed out since the last reset
+    size_t peak;             // Largest used seen
+    int overflows;           // Requests that did not fit (served from the heap)
+} SignalArena;
+
+// FFT plan: precomputed tables for one transform size and direction. The
+// engine works on split (structure-of-arrays) data: real parts in one array,
+// imaginary parts in another. A split spectrum of B bins is stored as B real
+// parts followed by B imaginary parts.
+// Complex plans of any size: powers of 2 run the radix-4 engine, sizes
+// whose other prime factors are 3, 5 and 7 run mixed-radix passes, and the
+// rest run Bluestein's algorithm on a convolution of such a size.
+#define FFT_MAX_STAGES 32
+
+typedef struct FFTPlan {
+    int n;                 // Transform size
+    int direction;         // FFT_FORWARD or FFT_INVERSE
+    int is_real;           // Real-input plan (r2c forward / c2r inverse)
+    int *bit_reverse;      // Bit-reversal permutation (power-of-2 complex plans)
+    double *twiddles;      // Split per-pass twiddles, or split twiddles for real plans
+    Complex *scratch;      // Work buffer owned by the plan's holder (n points, or
+                           // n/2+1 bins = one split spectrum for real plans)
+    struct FFTPlan *half;  // Complex plan used by real plans: n/2 points, or
+                           // n points when n is odd
+    int stage_count;       // Mixed-radix passes (0 for other plans)
+    int radices[FFT_MAX_STAGES];
+    int chirp_size;        // Bluestein convolution length (0 for other plans)
+    double *chirp;         // Bluestein: split chirp (n), then its split
+                           // conjugate's spectrum / chirp_size
+    struct FFTPlan *chirp_forward;  // Bluestein chirp_size-point plans (fast sizes)
+    struct FFTPlan *chirp_inverse;
+    struct FFTPlan *next;  // Link in the plan cache
+} FFTPlan;
+
+// Single-precision FFT plan (see FFTPlan)
+typedef struct FFTPlanF32 {
+    int n;
+    int direction;
+    int is_real;
+    int *bit_reverse;
+    ComplexF32 *twiddles;
+    ComplexF32 *scratch;       // n points, or n/2+1 bins for real plans
+    struct FFTPlanF32 *half;
+    struct FFTPlanF32 *next;
+} FFTPlanF32;
+
+// Block convolution modes
+typedef enum {
+    BLOCK_OVERLAP_ADD,
+    BLOCK_OVERLAP_SAVE
+} BlockConvMode;
+
+// Kernel transformed once for block convolution
+typedef struct {
+    double *bins;          // Split spectrum of fft_size/2+1 bins, pre-scaled by 1/fft_size
+    int fft_size;          // Block FFT size
+    int kernel_length;     // Number of kernel taps
+} KernelSpectrum;
+
+// One stage of a partitioned convolver: kernel taps [offset, offset + taps)
+// split into segment_count partitions of segment_length taps
+typedef struct {
+    int offset;              // First kernel tap handled by this stage
+    int block_size;          // Input samples per FFT block
+    int segment_length;      // Kernel taps per partition
+    int segment_count;       // Number of partitions
+    int fft_size;            // next_pow2(block_size + segment_length - 1)
+    double *segments;        // Split partition spectra (segment_count x bins, scaled 1/F)
+    double *delay_line;      // Frequency-domain delay line of split input block spectra
+    double *accum;           // Earlier blocks' contribution to the current block (split)
+    int current;             // Delay-line slot of the current block
+    int fill;                // Samples already in the current block
+    double *input;           // Current input block (block_size samples)
+    double *overlap;         // Tails of earlier blocks, relative to this block
+    double *output;          // Delayed output ring (stages with offset > 0)
+    double *head_taps;       // Head stage: first block_size taps, reversed
+    double *pending;         // Head stage: earlier blocks' part of the current block
+    int pending_valid;       // pending holds IFFT(accum) for the current block
+    int output_pos;          // Ring slot of the next output sample
+    FFTPlan *forward;        // Real plans held for the stage's lifetime;
+    FFTPlan *inverse;        // the forward plan's scratch is the work buffer
+} ConvolverStage;
+
+// Streaming convolver: kernel state kept between convolver_process calls
+typedef struct {
+    ConvolverStage stages[2];  // Head stage, plus a tail stage if non-uniform
+    int stage_count;
+    int block_size;            // Head stage block size
+    int kernel_length;
+} Convolver;
+
+// Peak of a run of matched-filter positions whose score reached the
+// threshold
+typedef struct {
+    long long position;    // Stream index of the template's first sample
+    double score;          // Normalized correlation, in [-1, 1]
+    double correlation;    // Raw correlation
+} MatchedFilterDetection;
+
+// Streaming matched filter: correlates a stream with a fixed template by
+// overlap-save blocks against the template's cached conjugate spectrum
+typedef struct {
+    KernelSpectrum *spectrum;  // conj(FFT(template)) / fft_size
+    FFTPlan *forward;          // Real plans held for the filter's lifetime;
+    FFTPlan *inverse;          // the forward plan's scratch is the work buffer
+    int template_length;
+    int block_length;          // Outputs per block: fft_size - template_length + 1
+    double template_energy;    // Sum of the squared template samples
+    double threshold;          // Detection score threshold (0 disables detection)
+    double *window;            // fft_size samples: template_length - 1 of history, then the block
+    int fill;                  // Samples already in the current block
+    long long produced;        // Outputs written so far
+    int in_run;                // The last output's score reached the threshold
+    MatchedFilterDetection peak;         // Best position of the current run
+    MatchedFilterDetection *detections;  // Detections not yet collected
+    int detection_count;
+    int detection_capacity;
+} MatchedFilter;
+
+// Polyphase FIR rate changer: filters at up times the input rate and keeps
+// every down-th output, computing only the outputs that are kept and only
+// the taps that land on input samples rather than inserted zeros.
+typedef struct {
+    int up;                  // Interpolation factor
+    int down;                // Decimation factor
+    int filter_length;       // Taps at the upsampled rate
+    int phase_count;         // Filter branches: up, or down for long decimators
+    int phase_length;        // Taps per branch (zero-padded)
+    double *phases;          // phase_count x phase_length, each branch reversed
+    int history;             // Input samples before an output's newest one that it reads
+    long long offset;        // Upsampled-rate index of output 0
+    double *input;           // Input from absolute index input_base on
+    int input_fill;
+    int input_capacity;
+    long long input_base;
+    long long received;      // Input samples pushed so far
+    long long produced;      // Outputs written so far
+} PolyphaseFilter;
+
+// Short-time Fourier transform setup. Frame f is centred on sample
+// f * hop_size: it covers window_length samples starting at
+// f * hop_size - window_length / 2, zero outside the signal, and is
+// zero-padded to fft_size before the transform.
+typedef struct {
+    WindowType window_type;
+    int window_length;
+    int hop_size;
+    int fft_size;            // Power of 2, at least window_length
+    int bins;                // fft_size/2 + 1
+    const double *window;    // Shared window_length table (analysis and synthesis)
+} STFTPlan;
+
+// STFT of one signal: a frames x bins matrix, frame-major, in split layout
+typedef struct {
+    double *real;            // real[f * bins + k]
+    double *imag;            // imag[f * bins + k]
+    int frames;
+    int bins;
+    int fft_size;
+    int hop_size;
+    int signal_length;       // Samples analysed
+    double sample_rate;
+    StorageKind storage;     // Owner of the arrays and the struct
+} STFTResult;
+
+// SIMD instruction sets for the direct convolution kernels
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_NEON,
+    SIMD_AVX2,
+    SIMD_AVX512
+} SimdLevel;
+
+// Output region of convolve_auto
+typedef enum {
+    CONV_MODE_FULL,      // All N + M - 1 samples
+    CONV_MODE_SAME,      // Centre N samples (length of the first signal)
+    CONV_MODE_VALID      // Only samples where the signals fully overlap
+} ConvMode;
+
+// Convolution algorithms convolve_auto chooses between
+typedef enum {
+    CONV_ALGO_DIRECT,
+    CONV_ALGO_SIMD_DIRECT,
+    CONV_ALGO_FFT,
+    CONV_ALGO_OVERLAP_ADD,
+    CONV_ALGO_OVERLAP_SAVE
+} ConvAlgorithm;
+
+// 2D convolution algorithms convolve_image chooses between
+typedef enum {
+    IMAGE_CONV_DIRECT,       // Cache-tiled direct sums over every kernel tap
+    IMAGE_CONV_SEPARABLE,    // Rank-1 kernel: a row pass and a column pass
+    IMAGE_CONV_FFT           // Row-column 2D FFT
+} ImageConvAlgorithm;
+
+// Per-machine cost model coefficients (nanoseconds)
+typedef struct {
+    double direct_ns;    // Per multiply-add, scalar direct convolution
+    double simd_ns;      // Per multiply-add, SIMD direct convolution
+    double fft_ns;       // Per F*log2(F), full-length FFT convolution
+    double block_ns;     // Per F*log2(F) per block, overlap-add
+    double setup_ns;     // Fixed cost of an FFT-based call
+} ConvTuning;
+
+// Task run by conv_parallel_for: index is in [0, count)
+typedef void (*ConvTaskFunction)(void *context, int index);
+
+// Operations timed by the instrumentation counters (CONV_ENABLE_STATS).
+// Times are inclusive: an FFT convolution run by a block convolution
+// counts in both.
+typedef enum {
+    CONV_STAT_DIRECT,        // Direct convolution kernels (double)
+    CONV_STAT_FFT,           // Full-length FFT convolution
+    CONV_STAT_BLOCK,         // Overlap-add / overlap-save
+    CONV_STAT_STREAM,        // convolver_process
+    CONV_STAT_BATCH,         // Batched multi-channel convolution
+    CONV_STAT_F32,           // Single-precision convolution
+    CONV_STAT_SPECTRUM,      // compute_fft and compute_fft_f32
+    CONV_STAT_STFT,          // STFT analysis
+    CONV_STAT_ISTFT,         // STFT resynthesis
+    CONV_STAT_CORRELATE,     // correlate and autocorrelate
+    CONV_STAT_MATCHED,       // matched_filter_process
+    CONV_STAT_IMAGE,         // 2D image convolution
+    CONV_STAT_MULTIRATE,     // Polyphase decimation, interpolation and resampling
+    CONV_STAT_COUNT
+} ConvStatOp;
+
+// Transform sizes are counted by log2
+#define CONV_STATS_FFT_SIZES 32
+
+typedef struct {
+    unsigned long long calls;
+    unsigned long long samples;      // Output samples (input samples for analyses)
+    unsigned long long nanoseconds;  // Cumulative wall time
+} ConvOpCounters;
+
+// Snapshot of the process-wide counters (see conv_stats_snapshot)
+typedef struct {
+    int enabled;                     // Built with CONV_ENABLE_STATS
+    ConvOpCounters ops[CONV_STAT_COUNT];
+    unsigned long long transforms[CONV_STATS_FFT_SIZES]; // FFTs run, by log2 size
+    unsigned long long plan_cache_hits;
+    unsigned long long plan_cache_misses;
+    unsigned long long allocations;  // Signals, results, plans, arenas, workspace growth
+    unsigned long long bytes_allocated;
+} ConvStats;
+
+// xoshiro256** random number generator (see conv_rng_seed). Not shared
+// between threads: each thread seeds its own or uses conv_rng_thread.
+typedef struct {
+    uint64_t state[4];
+} ConvRng;
+
 // Visualization structure
 typedef struct {
     int width;
@@ -65,6 +485,7 @@ typedef struct {
 // Signal generation
 Signal* create_signal(int length, double sample_rate);
 void free_signal(Signal *signal);
+void signal_init(Signal *signal, double *data, int length, double sample_rate);
 Signal* generate_sine_wave(double frequency, double amplitude, double phase, 
                           double duration, double sample_rate);
 Signal* generate_square_wave(double frequency, double amplitude, 
@@ -78,24 +499,310 @@ Signal* generate_impulse(double amplitude, double delay,
                         double duration, double sample_rate);
 Signal* generate_gaussian_pulse(double amplitude, double sigma, double center, 
                                double duration, double sample_rate);
+Signal* generate_noise_seeded(double amplitude, double duration, double sample_rate,
+                              uint64_t seed);
+Signal* generate_gaussian_noise(double stddev, double duration, double sample_rate,
+                                uint64_t seed);
+
+// Random numbers
+void conv_rng_seed(ConvRng *rng, uint64_t seed);
+uint64_t conv_rng_next(ConvRng *rng);
+double conv_rng_uniform(ConvRng *rng);
+double conv_rng_gaussian(ConvRng *rng);
+ConvRng* conv_rng_thread(void);
+void conv_random_seed(uint64_t seed);
+uint64_t conv_random_next_seed(void);
+void conv_fill_uniform(double *output, int length, double low, double high, uint64_t seed);
+void conv_fill_gaussian(double *output, int length, double mean, double stddev, uint64_t seed);
 
 // Convolution operations
 Signal* convolve(const Signal *signal1, const Signal *signal2);
 Signal* convolve_circular(const Signal *signal1, const Signal *signal2);
 Signal* convolve_fft(const Signal *signal1, const Signal *signal2);
+int convolve_into(Signal *output, const Signal *signal1, const Signal *signal2);
+int convolve_fft_into(Signal *output, const Signal *signal1, const Signal *signal2);
+
+// Signal views
+SignalView signal_view(const Signal *signal);
+SignalView signal_view_slice(const SignalView *view, int start, int length);
+SignalView signal_view_channel(double *frames, int frame_count, int channels,
+                               int channel, double sample_rate);
+void signal_view_gather(const SignalView *view, double *output);
+Signal* signal_from_view(const SignalView *view);
+Signal* convolve_view(const SignalView *view1, const SignalView *view2, ConvMode mode);
+
+// Arena allocation and caller-owned storage
+SignalArena* signal_arena_create(size_t capacity);
+void signal_arena_destroy(SignalArena *arena);
+void signal_arena_reset(SignalArena *arena);
+void* signal_arena_alloc(SignalArena *arena, size_t bytes);
+SignalArena* signal_arena_bind(SignalArena *arena);
+SignalArena* signal_arena_current(void);
+double* conv_workspace(size_t count);
+void conv_workspace_release(void);
+
+// SIMD direct convolution kernels
+void convolve_direct_kernel(const double *x, int n, const double *h, int m, double *y);
+SimdLevel conv_simd_detect(void);
+SimdLevel conv_get_simd_level(void);
+void conv_set_simd_level(SimdLevel level);
+const char* conv_simd_level_name(SimdLevel level);
+void convolve_direct_kernel_at(const double *x, int n, const double *h, int m,
+                               double *y, SimdLevel level);
+void convolve_direct_body(const double *xs, int count, const double *hr, int m, double *y);
+
+// Batched multi-channel convolution
+Signal** convolve_batch(Signal *const *signals, int channels,
+                        Signal *const *kernels, int kernel_count);
+int convolve_batch_planar(const double *input, int channels, int length,
+                          const double *kernels, int kernel_count, int kernel_length,
+                          double *output);
+void free_signal_batch(Signal **signals, int count);
+
+// Thread pool
+void conv_set_num_threads(int num_threads);
+int conv_get_num_threads(void);
+int conv_parallel_for(int count, ConvTaskFunction task, void *context);
+void conv_thread_pool_shutdown(void);
+
+// Instrumentation counters. The hooks below compile to nothing unless
+// CONV_ENABLE_STATS is defined (make STATS=1); the API is always present
+// and reports zeros with enabled == 0 otherwise.
+void conv_stats_snapshot(ConvStats *stats);
+void conv_stats_reset(void);
+void conv_stats_print(const ConvStats *stats);
+const char* conv_stats_op_name(ConvStatOp op);
+unsigned long long conv_stats_now(void);
+void conv_stats_record(ConvStatOp op, unsigned long long samples, unsigned long long nanoseconds);
+void conv_stats_count_transform(int n);
+void conv_stats_count_plan(int hit);
+void conv_stats_count_alloc(size_t bytes);
+
+#if defined(CONV_ENABLE_STATS)
+#define CONV_STATS_START(start) unsigned long long start = conv_stats_now()
+#define CONV_STATS_STOP(op, start, samples) \
+    conv_stats_record((op), (unsigned long long)(samples), conv_stats_now() - (start))
+#define CONV_STATS_TRANSFORM(n) conv_stats_count_transform(n)
+#define CONV_STATS_PLAN(hit) conv_stats_count_plan(hit)
+#define CONV_STATS_ALLOC(bytes) conv_stats_count_alloc(bytes)
+#else
+#define CONV_STATS_START(start) ((void)0)
+#define CONV_STATS_STOP(op, start, samples) ((void)0)
+#define CONV_STATS_TRANSFORM(n) ((void)0)
+#define CONV_STATS_PLAN(hit) ((void)0)
+#define CONV_STATS_ALLOC(bytes) ((void)0)
+#endif
+
+// Automatic algorithm selection
+Signal* convolve_auto(const Signal *signal1, const Signal *signal2, ConvMode mode);
+Signal* convolve_with_algorithm(const Signal *signal1, const Signal *signal2,
+                                ConvMode mode, ConvAlgorithm algorithm);
+ConvAlgorithm conv_select_algorithm(int n, int m);
+double conv_estimate_cost(ConvAlgorithm algorithm, int n, int m);
+double conv_estimate_image_cost(ImageConvAlgorithm algorithm, int height, int width,
+                                int kernel_height, int kernel_width);
+const char* conv_algorithm_name(ConvAlgorithm algorithm);
+const ConvTuning* conv_tuning_get(void);
+void conv_tuning_set(const ConvTuning *tuning);
+void conv_tuning_calibrate(ConvTuning *tuning);
+int conv_tuning_save(const ConvTuning *tuning, const char *filename);
+int conv_tuning_load(ConvTuning *tuning, const char *filename);
+
+// Block convolution (overlap-add / overlap-save)
+Signal* convolve_block(const Signal *signal, const Signal *kernel,
+                       BlockConvMode mode, int fft_size);
+int convolve_block_into(Signal *output, const Signal *signal, const Signal *kernel,
+                        BlockConvMode mode, int fft_size);
+Signal* convolve_overlap_add(const Signal *signal, const Signal *kernel);
+Signal* convolve_overlap_save(const Signal *signal, const Signal *kernel);
+int choose_block_fft_size(int kernel_length);
+KernelSpectrum* kernel_spectrum_create(const double *kernel, int length, int fft_size);
+void kernel_spectrum_free(KernelSpectrum *spectrum);
+void kernel_spectrum_filter(const KernelSpectrum *kernel, FFTPlan *forward,
+                            FFTPlan *inverse, double *buffer);
+void kernel_spectrum_overlap_add(const KernelSpectrum *kernel, FFTPlan *forward,
+                                 FFTPlan *inverse, double *buffer,
+                                 const double *input, int length, double *output);
+void spectrum_multiply(Complex *x, const Complex *h, int bins);
+void spectrum_multiply_accumulate(Complex *acc, const Complex *x, const Complex *h, int bins);
+void spectrum_multiply_split(double *x, const double *h, int bins);
+void spectrum_multiply_accumulate_split(double *acc, const double *x, const double *h, int bins);
+
+// Correlation and matched filtering
+Signal* correlate(const Signal *signal, const Signal *template_signal, ConvMode mode);
+Signal* autocorrelate(const Signal *signal, int max_lag);
+MatchedFilter* matched_filter_create(const Signal *template_signal, int block_length,
+                                     double threshold);
+void matched_filter_destroy(MatchedFilter *filter);
+int matched_filter_process(MatchedFilter *filter, const double *in, int n, double *out);
+int matched_filter_flush(MatchedFilter *filter, double *out);
+int matched_filter_detections(MatchedFilter *filter, MatchedFilterDetection *detections,
+                              int max_detections);
+void matched_filter_reset(MatchedFilter *filter);
+
+// Image convolution
+Image* create_image(int width, int height);
+void image_init(Image *image, double *data, int width, int height, int stride);
+void free_image(Image *image);
+int image_kernel_separable(const Image *kernel, double *column, double *row);
+Image* convolve_image(const Image *image, const Image *kernel, ConvMode mode);
+Image* convolve_image_with_algorithm(const Image *image, const Image *kernel,
+                                     ConvMode mode, ImageConvAlgorithm algorithm);
+Image* convolve_image_separable(const Image *image, const double *column, int column_length,
+                                const double *row, int row_length, ConvMode mode);
+ImageConvAlgorithm image_select_algorithm(const Image *image, const Image *kernel);
+const char* image_conv_algorithm_name(ImageConvAlgorithm algorithm);
+
+// Multirate filtering (polyphase)
+Signal* fir_design_resampler(int up, int down);
+Signal* fir_decimate(const Signal *signal, const Signal *filter, int factor, ConvMode mode);
+Signal* fir_interpolate(const Signal *signal, const Signal *filter, int factor, ConvMode mode);
+Signal* fir_resample(const Signal *signal, const Signal *filter, int up, int down, ConvMode mode);
+PolyphaseFilter* polyphase_filter_create(const Signal *filter, int up, int down);
+void polyphase_filter_destroy(PolyphaseFilter *filter);
+int polyphase_filter_process(PolyphaseFilter *filter, const double *in, int n, double *out);
+int polyphase_filter_flush(PolyphaseFilter *filter, double *out);
+void polyphase_filter_reset(PolyphaseFilter *filter);
+
+// Streaming convolution
+Convolver* convolver_create(const Signal *kernel, int block_size);
+Convolver* convolver_create_partitioned(const Signal *kernel, int block_size);
+Convolver* convolver_create_nonuniform(const Signal *kernel, int head_block, int tail_block);
+void convolver_destroy(Convolver *convolver);
+int convolver_process(Convolver *convolver, const double *in, int n, double *out);
+int convolver_flush(Convolver *convolver, double *out);
+void convolver_reset(Convolver *convolver);
 
 // FFT operations
 FFTResult* compute_fft(const Signal *signal);
+FFTResult* compute_fft_flags(const Signal *signal, unsigned flags);
+FFTResult* fft_result_create(int length);
+FFTResult* fft_result_create_flags(int fft_size, unsigned flags);
+int compute_fft_into(FFTResult *result, const Signal *signal);
+FFTResult* compute_fft_view(const SignalView *view);
+FFTResult* compute_fft_view_flags(const SignalView *view, unsigned flags);
+int compute_fft_view_into(FFTResult *result, const SignalView *view);
 void free_fft_result(FFTResult *result);
+const double* fft_frequency_axis(int fft_size, double sample_rate);
+void fft_frequency_axis_cache_clear(void);
 void fft_recursive(Complex *data, int n);
 void ifft_recursive(Complex *data, int n);
+void fft_iterative(Complex *data, int n, int direction);
+int next_power_of_2(int n);
+
+// FFT plans and plan cache
+FFTPlan* fft_plan_create(int n, int direction);
+void fft_plan_destroy(FFTPlan *plan);
+void fft_execute(const FFTPlan *plan, Complex *data);
+void fft_execute_split(const FFTPlan *plan, double *re, double *im);
+FFTPlan* fft_plan_create_real(int n, int direction);
+void fft_execute_r2c(const FFTPlan *plan, const double *in, Complex *out);
+void fft_execute_c2r(const FFTPlan *plan, Complex *in, double *out);
+void fft_execute_r2c_split(const FFTPlan *plan, const double *in,
+                           double *out_real, double *out_imag);
+void fft_execute_c2r_split(const FFTPlan *plan, const double *in_real,
+                           const double *in_imag, double *out);
+FFTPlan* fft_plan_acquire(int n, int direction);
+FFTPlan* fft_plan_acquire_real(int n, int direction);
+void fft_plan_release(FFTPlan *plan);
+void fft_plan_cache_clear(void);
+double fft_transform_work(int n);
+int fft_next_fast_size(int n);
+int fft_next_fast_size_real(int n);
+
+// Window functions
+WindowType window_type_from_name(const char *name);
+const char* window_type_name(WindowType type);
+void window_fill(double *coefficients, int length, WindowType type);
+void window_fill_kaiser(double *coefficients, int length, double beta);
+const double* window_table(WindowType type, int length);
+const double* window_table_kaiser(int length, double beta);
+void window_cache_clear(void);
+void window_multiply(double *out, const double *samples, const double *window, int length);
+Signal* window_signal(const Signal *signal, const char *window_type);
+Signal* window_signal_view(const SignalView *view, const char *window_type);
+int window_signal_in_place(Signal *signal, WindowType type);
+int window_signal_view_in_place(SignalView *view, WindowType type);
+
+// Short-time Fourier transform
+STFTPlan* stft_plan_create(WindowType window, int window_length, int hop_size, int fft_size);
+void stft_plan_destroy(STFTPlan *plan);
+int stft_frame_count(const STFTPlan *plan, int signal_length);
+STFTResult* stft_result_create(const STFTPlan *plan, int signal_length, double sample_rate);
+void free_stft_result(STFTResult *result);
+STFTResult* compute_stft(const STFTPlan *plan, const Signal *signal);
+int compute_stft_into(STFTResult *result, const STFTPlan *plan, const Signal *signal);
+int compute_stft_view_into(STFTResult *result, const STFTPlan *plan, const SignalView *view);
+Signal* inverse_stft(const STFTPlan *plan, const STFTResult *stft);
+int inverse_stft_into(Signal *output, const STFTPlan *plan, const STFTResult *stft);
+
+// Single-precision FFT plans
+FFTPlanF32* fft_plan_create_f32(int n, int direction);
+FFTPlanF32* fft_plan_create_real_f32(int n, int direction);
+void fft_plan_destroy_f32(FFTPlanF32 *plan);
+void fft_execute_f32(const FFTPlanF32 *plan, ComplexF32 *data);
+void fft_execute_r2c_f32(const FFTPlanF32 *plan, const float *in, ComplexF32 *out);
+void fft_execute_c2r_f32(const FFTPlanF32 *plan, ComplexF32 *in, float *out);
+FFTPlanF32* fft_plan_acquire_f32(int n, int direction);
+FFTPlanF32* fft_plan_acquire_real_f32(int n, int direction);
+void fft_plan_release_f32(FFTPlanF32 *plan);
+void fft_plan_cache_clear_f32(void);
+
+// Single-precision signals and convolution
+SignalF32* create_signal_f32(int length, double sample_rate);
+void free_signal_f32(SignalF32 *signal);
+void signal_init_f32(SignalF32 *signal, float *data, int length, double sample_rate);
+SignalF32* signal_to_f32(const Signal *signal);
+Signal* signal_from_f32(const SignalF32 *signal);
+void conv_set_precision(ConvPrecision precision);
+ConvPrecision conv_get_precision(void);
+void convolve_direct_kernel_f32(const float *x, int n, const float *h, int m, float *y);
+void convolve_direct_kernel_f32_at(const float *x, int n, const float *h, int m, float *y,
+                                   SimdLevel level, ConvPrecision precision);
+SignalF32* convolve_f32(const SignalF32 *signal1, const SignalF32 *signal2);
+int convolve_into_f32(SignalF32 *output, const SignalF32 *signal1, const SignalF32 *signal2);
+SignalF32* convolve_fft_f32(const SignalF32 *signal1, const SignalF32 *signal2);
+int convolve_fft_into_f32(SignalF32 *output, const SignalF32 *signal1, const SignalF32 *signal2);
+SignalF32* convolve_overlap_add_f32(const SignalF32 *signal, const SignalF32 *kernel);
+int convolve_overlap_add_into_f32(SignalF32 *output, const SignalF32 *signal,
+                                  const SignalF32 *kernel, int fft_size);
+FFTResultF32* compute_fft_f32(const SignalF32 *signal);
+FFTResultF32* fft_result_create_f32(int length);
+int compute_fft_into_f32(FFTResultF32 *result, const SignalF32 *signal);
+void free_fft_result_f32(FFTResultF32 *result);
 
 // Utility functions
 void print_signal_info(const Signal *signal);
+void print_signal_view_info(const SignalView *view);
 void save_signal_to_file(const Signal *signal, const char *filename);
 Signal* load_signal_from_file(const char *filename);
 void normalize_signal(Signal *signal);
-Signal* window_signal(const Signal *signal, const char *window_type);
+int signal_statistics(const Signal *signal, SignalStats *stats);
+int signal_view_statistics(const SignalView *view, SignalStats *stats);
+void normalize_signal_with_stats(Signal *signal, const SignalStats *stats);
+void normalize_signal_view_with_stats(SignalView *view, const SignalStats *stats);
+int save_signal_binary(const Signal *signal, const char *filename, SampleFormat format);
+int save_frames_binary(const double *frames, int frame_count, int channels,
+                       double sample_rate, const char *name,
+                       SampleFormat format, const char *filename);
+Signal* load_signal_binary(const char *filename, int channel);
+int is_binary_signal_file(const char *filename);
+MappedSignal* map_signal_file(const char *filename);
+SignalView mapped_signal_channel(const MappedSignal *mapped, int channel);
+void unmap_signal_file(MappedSignal *mapped);
+
+// Streaming signal I/O
+SignalReader* signal_reader_open(const char *filename);
+int signal_reader_read(SignalReader *reader, double *frames, int max_frames);
+void signal_reader_close(SignalReader *reader);
+SignalWriter* signal_writer_open(const char *filename, SignalFileType type,
+                                 SampleFormat format, int channels,
+                                 double sample_rate, const char *name);
+int signal_writer_write(SignalWriter *writer, const double *frames, int frame_count);
+int signal_writer_close(SignalWriter *writer);
+int convolve_file(const char *input_file, const Signal *kernel,
+                  const char *output_file, SignalFileType output_type);
+void normalize_signal_view(SignalView *view);
 
 // Visualization functions
 int init_visualization(int width, int height);
@@ -103,8 +810,12 @@ void plot_signal(const Signal *signal, const char *title, int subplot);
 void plot_fft(const FFTResult *fft, const char *title, int subplot);
 void plot_convolution_demo(const Signal *input, const Signal *kernel, 
                           const Signal *output);
+void plot_image_ascii(const Image *image, int width, int height);
 void cleanup_visualization(void);
 
+// Command-line mode (convolution_explorer <command> ...)
+int conv_cli_run(int argc, char **argv);
+
 // Interactive demo functions
 void run_interactive_demo(void);
 void demo_lowpass_filter(void);
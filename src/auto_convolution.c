@@ -0,0 +1,359 @@
+#include "../include/convolution.h"
+
+// Environment variable naming a tuning file loaded on first use
+#define CONV_TUNING_ENV "CONV_TUNING_FILE"
+
+// Minimum wall time per calibration measurement
+#define CALIBRATION_MIN_SECONDS 0.02
+
+// Fallback coefficients (ns), calibrated on an AVX-512 x86-64 server
+static ConvTuning active_tuning = {
+    0.39,     // direct_ns
+    0.064,    // simd_ns
+    2.6,      // fft_ns
+    1.1,      // block_ns
+    600.0     // setup_ns
+};
+static int tuning_initialized = 0;
+
+static const char *algorithm_names[] = {
+    "direct", "simd-direct", "fft", "overlap-add", "overlap-save"
+};
+
+// Display name of an algorithm
+const char* conv_algorithm_name(ConvAlgorithm algorithm) {
+    if (algorithm < CONV_ALGO_DIRECT || algorithm > CONV_ALGO_OVERLAP_SAVE) return "unknown";
+    return algorithm_names[algorithm];
+}
+
+// Active cost model; the first call loads $CONV_TUNING_FILE if it is set
+const ConvTuning* conv_tuning_get(void) {
+    if (!tuning_initialized) {
+        tuning_initialized = 1;
+        const char *filename = getenv(CONV_TUNING_ENV);
+        if (filename && filename[0] != '\0') {
+            ConvTuning loaded = active_tuning;
+            if (conv_tuning_load(&loaded, filename) == 0) {
+                active_tuning = loaded;
+            }
+        }
+    }
+    return &active_tuning;
+}
+
+// Replace the active cost model
+void conv_tuning_set(const ConvTuning *tuning) {
+    if (!tuning) return;
+    active_tuning = *tuning;
+    tuning_initialized = 1;
+}
+
+// Write a tuning table as "key value" lines; returns 0 on success, -1 on error
+int conv_tuning_save(const ConvTuning *tuning, const char *filename) {
+    if (!tuning || !filename) return -1;
+
+    FILE *file = fopen(filename, "w");
+    if (!file) return -1;
+
+    fprintf(file, "# Convolution cost model (ns)\n");
+    fprintf(file, "direct_ns %.6g\n", tuning->direct_ns);
+    fprintf(file, "simd_ns %.6g\n", tuning->simd_ns);
+    fprintf(file, "fft_ns %.6g\n", tuning->fft_ns);
+    fprintf(file, "block_ns %.6g\n", tuning->block_ns);
+    fprintf(file, "setup_ns %.6g\n", tuning->setup_ns);
+
+    return (fclose(file) == 0) ? 0 : -1;
+}
+
+// Read a tuning table written by conv_tuning_save. Keys missing from the file
+// keep their current values in *tuning. Returns 0 on success, -1 on error.
+int conv_tuning_load(ConvTuning *tuning, const char *filename) {
+    if (!tuning || !filename) return -1;
+
+    FILE *file = fopen(filename, "r");
+    if (!file) return -1;
+
+    ConvTuning loaded = *tuning;
+    char line[256];
+    char key[64];
+    double value;
+    int found = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || sscanf(line, "%63s %lf", key, &value) != 2) continue;
+        if (value <= 0.0) continue;
+
+        if (strcmp(key, "direct_ns") == 0) loaded.direct_ns = value;
+        else if (strcmp(key, "simd_ns") == 0) loaded.simd_ns = value;
+        else if (strcmp(key, "fft_ns") == 0) loaded.fft_ns = value;
+        else if (strcmp(key, "block_ns") == 0) loaded.block_ns = value;
+        else if (strcmp(key, "setup_ns") == 0) loaded.setup_ns = value;
+        else continue;
+        found++;
+    }
+    fclose(file);
+
+    if (found == 0) return -1;
+    *tuning = loaded;
+    return 0;
+}
+
+// Work of a real F-point transform (a complex F/2-point one plus the
+// untangling pass), in units where a power-of-2 F costs F * log2(F)
+static double fft_work(int fft_size) {
+    return 2.0 * fft_transform_work(fft_size / 2) + fft_size;
+}
+
+// Block FFT size convolve_block picks for these lengths
+static int block_fft_size(int n, int m) {
+    int fft_size = choose_block_fft_size(m);
+    int full_size = fft_next_fast_size_real(n + m - 1);
+    return (fft_size > full_size) ? full_size : fft_size;
+}
+
+// Estimated run time (ns) of an algorithm for a full n x m convolution
+double conv_estimate_cost(ConvAlgorithm algorithm, int n, int m) {
+    if (n < 1 || m < 1) return 0.0;
+
+    const ConvTuning *tuning = conv_tuning_get();
+
+    // Block methods stream the longer input through the shorter one
+    if (m > n) {
+        int temp = n;
+        n = m;
+        m = temp;
+    }
+
+    switch (algorithm) {
+        case CONV_ALGO_DIRECT:
+            return tuning->direct_ns * n * m;
+
+        case CONV_ALGO_SIMD_DIRECT:
+            // The vector edges run all m taps for every output
+            return tuning->simd_ns * (n + m - 1) * m;
+
+        case CONV_ALGO_FFT: {
+            int fft_size = fft_next_fast_size_real(n + m - 1);
+            return tuning->setup_ns + tuning->fft_ns * fft_work(fft_size);
+        }
+
+        case CONV_ALGO_OVERLAP_ADD:
+        case CONV_ALGO_OVERLAP_SAVE: {
+            int fft_size = block_fft_size(n, m);
+            int block_length = fft_size - m + 1;
+            int blocks = (n + block_length - 1) / block_length;
+            if (algorithm == CONV_ALGO_OVERLAP_SAVE) {
+                // Save blocks cover the whole output, including the tail
+                blocks = (n + m - 1 + block_length - 1) / block_length;
+            }
+            // A single block is a full-length transform, outside the cache
+            double per_block = (blocks == 1) ? tuning->fft_ns : tuning->block_ns;
+            return tuning->setup_ns + per_block * blocks * fft_work(fft_size);
+        }
+
+        default:
+            return 0.0;
+    }
+}
+
+// Work of a 2D transform of rows x columns real samples (a real transform
+// per row, then a complex one per column of the half spectrum), in the
+// units of fft_work
+static double fft_work_2d(int rows, int columns) {
+    return (double)rows * fft_work(columns) + (columns / 2 + 1) * fft_transform_work(rows);
+}
+
+// Estimated run time (ns) of an algorithm for a full 2D convolution of a
+// height x width image with a kernel_height x kernel_width kernel. The
+// per-tap and per-transform coefficients are the 1D ones.
+double conv_estimate_image_cost(ImageConvAlgorithm algorithm, int height, int width,
+                                int kernel_height, int kernel_width) {
+    if (height < 1 || width < 1 || kernel_height < 1 || kernel_width < 1) return 0.0;
+
+    const ConvTuning *tuning = conv_tuning_get();
+    double rows = height + kernel_height - 1;
+    double columns = width + kernel_width - 1;
+
+    switch (algorithm) {
+        case IMAGE_CONV_DIRECT:
+            return tuning->simd_ns * rows * columns * kernel_height * kernel_width;
+
+        case IMAGE_CONV_SEPARABLE:
+            // Row pass over the image rows, column pass over every output
+            return tuning->simd_ns * ((double)height * columns * kernel_width +
+                                      rows * columns * kernel_height);
+
+        case IMAGE_CONV_FFT: {
+            int fft_rows = fft_next_fast_size(height + kernel_height - 1);
+            int fft_columns = fft_next_fast_size_real(width + kernel_width - 1);
+            return tuning->setup_ns + tuning->fft_ns * fft_work_2d(fft_rows, fft_columns);
+        }
+
+        default:
+            return 0.0;
+    }
+}
+
+// Cheapest algorithm for a full n x m convolution under the active cost model
+ConvAlgorithm conv_select_algorithm(int n, int m) {
+    ConvAlgorithm best = (conv_get_simd_level() != SIMD_SCALAR) ? CONV_ALGO_SIMD_DIRECT
+                                                                : CONV_ALGO_DIRECT;
+    double best_cost = conv_estimate_cost(best, n, m);
+
+    // Overlap-save costs the same as overlap-add (plus the tail), so it is
+    // only used when requested explicitly
+    ConvAlgorithm candidates[] = {CONV_ALGO_FFT, CONV_ALGO_OVERLAP_ADD};
+    for (int i = 0; i < 2; i++) {
+        double cost = conv_estimate_cost(candidates[i], n, m);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = candidates[i];
+        }
+    }
+
+    return best;
+}
+
+// Keep samples [start, start + length) of a full convolution result
+static Signal* crop_signal(Signal *signal, int start, int length) {
+    if (start == 0 && length == signal->length) return signal;
+
+    memmove(signal->data, signal->data + start, length * sizeof(double));
+    if (signal->storage == STORAGE_HEAP) {
+        double *data = (double*)realloc(signal->data, length * sizeof(double));
+        if (data) signal->data = data;
+    }
+    signal->length = length;
+    signal->duration = (double)length / signal->sample_rate;
+
+    return signal;
+}
+
+// Convolution with an explicitly chosen algorithm. SAME keeps the centre
+// signal1->length samples, VALID only the samples where the inputs fully
+// overlap (|N - M| + 1 of them).
+Signal* convolve_with_algorithm(const Signal *signal1, const Signal *signal2,
+                                ConvMode mode, ConvAlgorithm algorithm) {
+    if (!signal1 || !signal2 || signal1->length < 1 || signal2->length < 1) return NULL;
+
+    const Signal *longer = (signal1->length >= signal2->length) ? signal1 : signal2;
+    const Signal *shorter = (longer == signal1) ? signal2 : signal1;
+    Signal *result = NULL;
+
+    switch (algorithm) {
+        case CONV_ALGO_DIRECT:
+        case CONV_ALGO_SIMD_DIRECT:
+            result = create_signal(signal1->length + signal2->length - 1, signal1->sample_rate);
+            if (!result) return NULL;
+
+            result->type = SIGNAL_CUSTOM;
+            snprintf(result->name, sizeof(result->name),
+                     "Conv(%.27s * %.27s)", signal1->name, signal2->name);
+            convolve_direct_kernel_at(signal1->data, signal1->length,
+                                      signal2->data, signal2->length, result->data,
+                                      (algorithm == CONV_ALGO_DIRECT) ? SIMD_SCALAR
+                                                                      : conv_get_simd_level());
+            break;
+
+        case CONV_ALGO_FFT:
+            result = convolve_fft(signal1, signal2);
+            break;
+
+        case CONV_ALGO_OVERLAP_ADD:
+            result = convolve_block(longer, shorter, BLOCK_OVERLAP_ADD, 0);
+            break;
+
+        case CONV_ALGO_OVERLAP_SAVE:
+            result = convolve_block(longer, shorter, BLOCK_OVERLAP_SAVE, 0);
+            break;
+
+        default:
+            return NULL;
+    }
+    if (!result) return NULL;
+
+    int n = signal1->length;
+    int m = signal2->length;
+
+    switch (mode) {
+        case CONV_MODE_SAME:
+            return crop_signal(result, (m - 1) / 2, n);
+        case CONV_MODE_VALID:
+            return crop_signal(result, shorter->length - 1,
+                               longer->length - shorter->length + 1);
+        default:
+            return result;
+    }
+}
+
+// Convolution with the algorithm picked by the cost model
+Signal* convolve_auto(const Signal *signal1, const Signal *signal2, ConvMode mode) {
+    if (!signal1 || !signal2 || signal1->length < 1 || signal2->length < 1) return NULL;
+
+    ConvAlgorithm algorithm = conv_select_algorithm(signal1->length, signal2->length);
+    return convolve_with_algorithm(signal1, signal2, mode, algorithm);
+}
+
+// Average wall time (ns) of one full convolution, repeated until the total
+// reaches CALIBRATION_MIN_SECONDS. Wall time, not process CPU time: the
+// pooled algorithms spread their CPU time over several threads.
+static double time_algorithm(ConvAlgorithm algorithm, int n, int m) {
+    Signal *signal = create_signal(n, 1000.0);
+    Signal *kernel = create_signal(m, 1000.0);
+    if (!signal || !kernel) {
+        free_signal(signal);
+        free_signal(kernel);
+        return 0.0;
+    }
+
+    for (int i = 0; i < n; i++) signal->data[i] = sin(0.01 * i);
+    for (int i = 0; i < m; i++) kernel->data[i] = 1.0 / (i + 1);
+
+    int repetitions = 0;
+    unsigned long long start = conv_stats_now();
+    double elapsed;
+    do {
+        free_signal(convolve_with_algorithm(signal, kernel, CONV_MODE_FULL, algorithm));
+        repetitions++;
+        elapsed = (double)(conv_stats_now() - start);
+    } while (elapsed < CALIBRATION_MIN_SECONDS * 1e9);
+
+    free_signal(signal);
+    free_signal(kernel);
+
+    return elapsed / repetitions;
+}
+
+// Measure the cost model coefficients on this machine (takes ~0.2 s)
+void conv_tuning_calibrate(ConvTuning *tuning) {
+    if (!tuning) return;
+
+    // Direct paths: ns per multiply-add
+    int n = 8192, m = 64;
+    tuning->direct_ns = time_algorithm(CONV_ALGO_DIRECT, n, m) / ((double)n * m);
+    if (conv_get_simd_level() != SIMD_SCALAR) {
+        tuning->simd_ns = time_algorithm(CONV_ALGO_SIMD_DIRECT, n, m) / ((double)n * m);
+    } else {
+        tuning->simd_ns = tuning->direct_ns;
+    }
+
+    // Fixed cost of an FFT-based call (allocation, plans, kernel transform)
+    tuning->setup_ns = time_algorithm(CONV_ALGO_FFT, 8, 8);
+
+    // Full-length FFT: ns per F*log2(F)
+    n = m = 16384;
+    double elapsed = time_algorithm(CONV_ALGO_FFT, n, m) - tuning->setup_ns;
+    tuning->fft_ns = elapsed / fft_work(fft_next_fast_size_real(n + m - 1));
+
+    // Overlap-add: ns per F*log2(F) per block
+    n = 262144;
+    m = 255;
+    int fft_size = block_fft_size(n, m);
+    int blocks = (n + fft_size - m) / (fft_size - m + 1);
+    elapsed = time_algorithm(CONV_ALGO_OVERLAP_ADD, n, m) - tuning->setup_ns;
+    tuning->block_ns = elapsed / (blocks * fft_work(fft_size));
+
+    // Guard against timer noise on very fast machines
+    if (tuning->fft_ns <= 0.0) tuning->fft_ns = active_tuning.fft_ns;
+    if (tuning->block_ns <= 0.0) tuning->block_ns = active_tuning.block_ns;
+}
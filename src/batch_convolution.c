@@ -0,0 +1,274 @@
+#include "../include/convolution.h"
+
+// One batch: equal-length channels, kernel_count 1 (shared kernel) or one
+// kernel per channel, all kernels kernel_length taps long
+typedef struct {
+    const double *const *inputs;
+    const double *const *kernels;
+    double *const *outputs;
+    int channels;
+    int length;
+    int kernel_count;
+    int kernel_length;
+
+    // Frequency-domain path
+    const KernelSpectrum *shared_spectrum;
+    FFTPlan *forward;
+    FFTPlan *inverse;
+    int fft_size;
+    double *buffers;
+    int buffer_stride;
+    int channels_per_task;
+    int failed;
+} BatchJob;
+
+static const double* batch_kernel(const BatchJob *job, int channel) {
+    return job->kernels[(job->kernel_count == 1) ? 0 : channel];
+}
+
+// Direct path: one task per channel through the time-vectorized kernel
+static void batch_direct_task(void *context, int channel) {
+    BatchJob *job = (BatchJob*)context;
+
+    convolve_direct_kernel(job->inputs[channel], job->length, batch_kernel(job, channel),
+                           job->kernel_length, job->outputs[channel]);
+}
+
+// Frequency-domain path: task t overlap-adds a contiguous run of channels
+// using its own block buffer. A shared kernel is transformed once up front;
+// per-channel kernels are transformed by the task that uses them.
+static void batch_block_task(void *context, int index) {
+    BatchJob *job = (BatchJob*)context;
+    double *buffer = job->buffers + (size_t)index * job->buffer_stride;
+
+    int first = index * job->channels_per_task;
+    int last = first + job->channels_per_task;
+    if (last > job->channels) last = job->channels;
+
+    for (int c = first; c < last; c++) {
+        const KernelSpectrum *spectrum = job->shared_spectrum;
+        KernelSpectrum *own = NULL;
+
+        if (!spectrum) {
+            own = kernel_spectrum_create(batch_kernel(job, c), job->kernel_length, job->fft_size);
+            if (!own) {
+                __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+                continue;
+            }
+            spectrum = own;
+        }
+
+        kernel_spectrum_overlap_add(spectrum, job->forward, job->inverse, buffer,
+                                    job->inputs[c], job->length, job->outputs[c]);
+        kernel_spectrum_free(own);
+    }
+}
+
+static int batch_convolve_blocks(BatchJob *job) {
+    int threads = conv_get_num_threads();
+    int tasks = (threads < job->channels) ? threads : job->channels;
+
+    int fft_size = choose_block_fft_size(job->kernel_length);
+    int full_size = fft_next_fast_size_real(job->length + job->kernel_length - 1);
+    if (fft_size > full_size) fft_size = full_size;
+
+    job->fft_size = fft_size;
+    job->buffer_stride = fft_size + 2;
+    job->channels_per_task = (job->channels + tasks - 1) / tasks;
+    tasks = (job->channels + job->channels_per_task - 1) / job->channels_per_task;
+
+    KernelSpectrum *shared = NULL;
+    if (job->kernel_count == 1) {
+        shared = kernel_spectrum_create(job->kernels[0], job->kernel_length, fft_size);
+    }
+    job->shared_spectrum = shared;
+    job->forward = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+    job->inverse = fft_plan_acquire_real(fft_size, FFT_INVERSE);
+    job->buffers = (double*)malloc((size_t)tasks * job->buffer_stride * sizeof(double));
+
+    int status = -1;
+    if ((shared || job->kernel_count != 1) && job->forward && job->inverse && job->buffers) {
+        conv_parallel_for(tasks, batch_block_task, job);
+        status = job->failed ? -1 : 0;
+    }
+
+    kernel_spectrum_free(shared);
+    fft_plan_release(job->forward);
+    fft_plan_release(job->inverse);
+    free(job->buffers);
+
+    return status;
+}
+
+// Run one batch with the algorithm the cost model picks for a single channel
+static int batch_convolve(BatchJob *job) {
+    ConvAlgorithm algorithm = conv_select_algorithm(job->length, job->kernel_length);
+
+    if (algorithm == CONV_ALGO_DIRECT || algorithm == CONV_ALGO_SIMD_DIRECT) {
+        conv_parallel_for(job->channels, batch_direct_task, job);
+        return 0;
+    }
+
+    return batch_convolve_blocks(job);
+}
+
+// Convolve a planar channels x length buffer (channel c starts at
+// input + c * length) with one shared kernel (kernel_count 1) or one kernel
+// per channel (kernel_count == channels, kernels stored the same way).
+// output is channels x (length + kernel_length - 1), planar.
+// Returns 0 on success, -1 on error.
+int convolve_batch_planar(const double *input, int channels, int length,
+                          const double *kernels, int kernel_count, int kernel_length,
+                          double *output) {
+    if (!input || !kernels || !output || channels < 1 || length < 1 || kernel_length < 1) return -1;
+    if (kernel_count != 1 && kernel_count != channels) return -1;
+
+    int output_length = length + kernel_length - 1;
+    CONV_STATS_START(stats_start);
+    const double **inputs = (const double**)malloc(channels * sizeof(double*));
+    const double **kernel_rows = (const double**)malloc(kernel_count * sizeof(double*));
+    double **outputs = (double**)malloc(channels * sizeof(double*));
+
+    int status = -1;
+    if (inputs && kernel_rows && outputs) {
+        for (int c = 0; c < channels; c++) {
+            inputs[c] = input + (size_t)c * length;
+            outputs[c] = output + (size_t)c * output_length;
+        }
+        for (int k = 0; k < kernel_count; k++) {
+            kernel_rows[k] = kernels + (size_t)k * kernel_length;
+        }
+
+        BatchJob job = {0};
+        job.inputs = inputs;
+        job.kernels = kernel_rows;
+        job.outputs = outputs;
+        job.channels = channels;
+        job.length = length;
+        job.kernel_count = kernel_count;
+        job.kernel_length = kernel_length;
+        status = batch_convolve(&job);
+    }
+
+    free(inputs);
+    free(kernel_rows);
+    free(outputs);
+
+    CONV_STATS_STOP(CONV_STAT_BATCH, stats_start, (size_t)channels * output_length);
+    return status;
+}
+
+// Per-channel fallback for batches whose lengths differ
+typedef struct {
+    Signal *const *signals;
+    Signal *const *kernels;
+    Signal **results;
+    int kernel_count;
+} BatchSignalJob;
+
+static void batch_signal_task(void *context, int index) {
+    BatchSignalJob *job = (BatchSignalJob*)context;
+    const Signal *kernel = job->kernels[(job->kernel_count == 1) ? 0 : index];
+
+    job->results[index] = convolve_auto(job->signals[index], kernel, CONV_MODE_FULL);
+}
+
+// Convolve each signal with a shared kernel (kernel_count 1) or with its own
+// kernel (kernel_count == channels). Returns an array of channels results
+// (free with free_signal_batch), or NULL on error. When all signals and
+// kernels have matching lengths the batch runs through the planar engine;
+// otherwise each channel is convolved separately on the thread pool.
+Signal** convolve_batch(Signal *const *signals, int channels,
+                        Signal *const *kernels, int kernel_count) {
+    if (!signals || !kernels || channels < 1) return NULL;
+    if (kernel_count != 1 && kernel_count != channels) return NULL;
+
+    for (int c = 0; c < channels; c++) {
+        if (!signals[c] || signals[c]->length < 1) return NULL;
+    }
+    for (int k = 0; k < kernel_count; k++) {
+        if (!kernels[k] || kernels[k]->length < 1) return NULL;
+    }
+
+    Signal **results = (Signal**)calloc(channels, sizeof(Signal*));
+    if (!results) return NULL;
+
+    int length = signals[0]->length;
+    int kernel_length = kernels[0]->length;
+    int uniform = 1;
+    for (int c = 0; c < channels; c++) {
+        if (signals[c]->length != length) uniform = 0;
+    }
+    for (int k = 0; k < kernel_count; k++) {
+        if (kernels[k]->length != kernel_length) uniform = 0;
+    }
+
+    if (!uniform) {
+        BatchSignalJob job = {signals, kernels, results, kernel_count};
+        conv_parallel_for(channels, batch_signal_task, &job);
+        for (int c = 0; c < channels; c++) {
+            if (!results[c]) {
+                free_signal_batch(results, channels);
+                return NULL;
+            }
+        }
+        return results;
+    }
+
+    const double **inputs = (const double**)malloc(channels * sizeof(double*));
+    const double **kernel_rows = (const double**)malloc(kernel_count * sizeof(double*));
+    double **outputs = (double**)malloc(channels * sizeof(double*));
+    int status = (inputs && kernel_rows && outputs) ? 0 : -1;
+
+    for (int c = 0; c < channels && status == 0; c++) {
+        const Signal *kernel = kernels[(kernel_count == 1) ? 0 : c];
+        results[c] = create_signal(length + kernel_length - 1, signals[c]->sample_rate);
+        if (!results[c]) {
+            status = -1;
+            break;
+        }
+        results[c]->type = SIGNAL_CUSTOM;
+        snprintf(results[c]->name, sizeof(results[c]->name),
+                 "Conv(%.27s * %.27s)", signals[c]->name, kernel->name);
+
+        inputs[c] = signals[c]->data;
+        outputs[c] = results[c]->data;
+    }
+
+    if (status == 0) {
+        for (int k = 0; k < kernel_count; k++) {
+            kernel_rows[k] = kernels[k]->data;
+        }
+
+        BatchJob job = {0};
+        job.inputs = inputs;
+        job.kernels = kernel_rows;
+        job.outputs = outputs;
+        job.channels = channels;
+        job.length = length;
+        job.kernel_count = kernel_count;
+        job.kernel_length = kernel_length;
+        status = batch_convolve(&job);
+    }
+
+    free(inputs);
+    free(kernel_rows);
+    free(outputs);
+
+    if (status != 0) {
+        free_signal_batch(results, channels);
+        return NULL;
+    }
+
+    return results;
+}
+
+// Free a batch of signals and the array holding them
+void free_signal_batch(Signal **signals, int count) {
+    if (signals) {
+        for (int i = 0; i < count; i++) {
+            free_signal(signals[i]);
+        }
+        free(signals);
+    }
+}
@@ -0,0 +1,479 @@
+#include "../include/convolution.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONV_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Largest block FFT picked automatically. A block (F real samples plus the
+// F/2+1 input and kernel bins) is ~24*F bytes, so 32K points stays in L2.
+#define BLOCK_FFT_CACHE_LIMIT 32768
+
+// Inputs with at least this many blocks are filtered on the thread pool
+#define BLOCK_PARALLEL_MIN_BLOCKS 4
+
+// Pick the block FFT size for a kernel of the given length. Each block of an
+// F-point FFT yields F - M + 1 new outputs, so the cost per output sample is
+// roughly F*log2(F) / (F - M + 1); take the cheapest power of 2, searching up
+// to the cache limit (or the smallest size that fits the kernel, if larger).
+int choose_block_fft_size(int kernel_length) {
+    if (kernel_length < 1) kernel_length = 1;
+
+    int min_size = next_power_of_2(2 * kernel_length);
+    if (min_size < 64) min_size = 64;
+    int max_size = (min_size > BLOCK_FFT_CACHE_LIMIT) ? min_size : BLOCK_FFT_CACHE_LIMIT;
+
+    int best_size = min_size;
+    double best_cost = 0.0;
+
+    int log2_size = 0;
+    while ((1 << log2_size) < min_size) log2_size++;
+
+    for (int size = min_size; size <= max_size; size *= 2, log2_size++) {
+        double cost = (double)size * log2_size / (size - kernel_length + 1);
+        if (size == min_size || cost < best_cost) {
+            best_cost = cost;
+            best_size = size;
+        }
+    }
+
+    return best_size;
+}
+
+// Fill spectrum->bins (a split spectrum of fft_size/2+1 bins, already
+// allocated) with the transform of the kernel, pre-scaled by 1/fft_size
+static int kernel_spectrum_transform(KernelSpectrum *spectrum, const double *kernel) {
+    int fft_size = spectrum->fft_size;
+    int length = spectrum->kernel_length;
+    int bins = fft_size / 2 + 1;
+
+    FFTPlan *plan = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+    if (!plan) return -1;
+
+    double *padded = spectrum->bins;
+    memcpy(padded, kernel, length * sizeof(double));
+    memset(padded + length, 0, (fft_size - length) * sizeof(double));
+    fft_execute_r2c_split(plan, padded, spectrum->bins, spectrum->bins + bins);
+    fft_plan_release(plan);
+
+    double scale = 1.0 / fft_size;
+    for (int i = 0; i < 2 * bins; i++) {
+        spectrum->bins[i] *= scale;
+    }
+
+    return 0;
+}
+
+// Transform a kernel once for block convolution with the given FFT size.
+// The bins are pre-scaled by 1/fft_size so the inverse needs no extra pass.
+KernelSpectrum* kernel_spectrum_create(const double *kernel, int length, int fft_size) {
+    if (!kernel || length < 1 || fft_size < 2 || length > fft_size) return NULL;
+
+    KernelSpectrum *spectrum = (KernelSpectrum*)malloc(sizeof(KernelSpectrum));
+    if (!spectrum) return NULL;
+
+    spectrum->fft_size = fft_size;
+    spectrum->kernel_length = length;
+    spectrum->bins = (double*)malloc((fft_size + 2) * sizeof(double));
+
+    if (!spectrum->bins || kernel_spectrum_transform(spectrum, kernel) != 0) {
+        kernel_spectrum_free(spectrum);
+        return NULL;
+    }
+
+    return spectrum;
+}
+
+// Free a kernel spectrum
+void kernel_spectrum_free(KernelSpectrum *spectrum) {
+    if (spectrum) {
+        if (spectrum->bins) free(spectrum->bins);
+        free(spectrum);
+    }
+}
+
+// Pointwise complex multiply: x[i] *= h[i]
+void spectrum_multiply(Complex *x, const Complex *h, int bins) {
+    for (int i = 0; i < bins; i++) {
+        Complex temp = {
+            x[i].real * h[i].real - x[i].imag * h[i].imag,
+            x[i].real * h[i].imag + x[i].imag * h[i].real
+        };
+        x[i] = temp;
+    }
+}
+
+// Pointwise complex multiply-accumulate: acc[i] += x[i] * h[i]
+void spectrum_multiply_accumulate(Complex *acc, const Complex *x, const Complex *h, int bins) {
+    for (int i = 0; i < bins; i++) {
+        acc[i].real += x[i].real * h[i].real - x[i].imag * h[i].imag;
+        acc[i].imag += x[i].real * h[i].imag + x[i].imag * h[i].real;
+    }
+}
+
+#if defined(CONV_HAVE_X86_SIMD)
+// AVX2 split multiply: bins [i, bins) in four-bin vectors. Same arithmetic
+// as the scalar loop (no FMA), so results do not depend on the SIMD level.
+__attribute__((target("avx2")))
+static int spectrum_multiply_split_avx2(double *out, const double *x, const double *h,
+                                        int bins, int accumulate, int i) {
+    for (; i + 4 <= bins; i += 4) {
+        __m256d xr = _mm256_loadu_pd(x + i), xi = _mm256_loadu_pd(x + bins + i);
+        __m256d hr = _mm256_loadu_pd(h + i), hi = _mm256_loadu_pd(h + bins + i);
+        __m256d pr = _mm256_sub_pd(_mm256_mul_pd(xr, hr), _mm256_mul_pd(xi, hi));
+        __m256d pi = _mm256_add_pd(_mm256_mul_pd(xr, hi), _mm256_mul_pd(xi, hr));
+        if (accumulate) {
+            pr = _mm256_add_pd(_mm256_loadu_pd(out + i), pr);
+            pi = _mm256_add_pd(_mm256_loadu_pd(out + bins + i), pi);
+        }
+        _mm256_storeu_pd(out + i, pr);
+        _mm256_storeu_pd(out + bins + i, pi);
+    }
+
+    return i;
+}
+
+// AVX-512 split multiply, eight bins per vector
+__attribute__((target("avx512f")))
+static int spectrum_multiply_split_avx512(double *out, const double *x, const double *h,
+                                          int bins, int accumulate, int i) {
+    for (; i + 8 <= bins; i += 8) {
+        __m512d xr = _mm512_loadu_pd(x + i), xi = _mm512_loadu_pd(x + bins + i);
+        __m512d hr = _mm512_loadu_pd(h + i), hi = _mm512_loadu_pd(h + bins + i);
+        __m512d pr = _mm512_sub_pd(_mm512_mul_pd(xr, hr), _mm512_mul_pd(xi, hi));
+        __m512d pi = _mm512_add_pd(_mm512_mul_pd(xr, hi), _mm512_mul_pd(xi, hr));
+        if (accumulate) {
+            pr = _mm512_add_pd(_mm512_loadu_pd(out + i), pr);
+            pi = _mm512_add_pd(_mm512_loadu_pd(out + bins + i), pi);
+        }
+        _mm512_storeu_pd(out + i, pr);
+        _mm512_storeu_pd(out + bins + i, pi);
+    }
+
+    return i;
+}
+#endif
+
+// Vector part of the split multiplies: out = x * h, or out += x * h when
+// accumulating. Returns the first bin left for the scalar loop.
+static int spectrum_multiply_split_simd(double *out, const double *x, const double *h,
+                                        int bins, int accumulate) {
+    int i = 0;
+
+    switch (conv_get_simd_level()) {
+#if defined(CONV_HAVE_X86_SIMD)
+        case SIMD_AVX512:
+            i = spectrum_multiply_split_avx512(out, x, h, bins, accumulate, i);
+            i = spectrum_multiply_split_avx2(out, x, h, bins, accumulate, i);
+            break;
+        case SIMD_AVX2:
+            i = spectrum_multiply_split_avx2(out, x, h, bins, accumulate, i);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    return i;
+}
+
+// Pointwise multiply of split spectra (bins real parts, then bins imaginary
+// parts): x *= h
+void spectrum_multiply_split(double *x, const double *h, int bins) {
+    int i = spectrum_multiply_split_simd(x, x, h, bins, 0);
+
+    for (; i < bins; i++) {
+        double xr = x[i], xi = x[bins + i];
+        double hr = h[i], hi = h[bins + i];
+        x[i] = xr * hr - xi * hi;
+        x[bins + i] = xr * hi + xi * hr;
+    }
+}
+
+// Pointwise multiply-accumulate of split spectra: acc += x * h
+void spectrum_multiply_accumulate_split(double *acc, const double *x, const double *h, int bins) {
+    int i = spectrum_multiply_split_simd(acc, x, h, bins, 1);
+
+    for (; i < bins; i++) {
+        double xr = x[i], xi = x[bins + i];
+        double hr = h[i], hi = h[bins + i];
+        acc[i] += xr * hr - xi * hi;
+        acc[bins + i] += xr * hi + xi * hr;
+    }
+}
+
+// Filter one block in place: buffer holds fft_size real samples on entry and
+// the circular convolution with the kernel on exit. buffer needs room for
+// fft_size + 2 doubles (one split spectrum); forward/inverse are real plans
+// of the kernel's FFT size.
+void kernel_spectrum_filter(const KernelSpectrum *kernel, FFTPlan *forward,
+                            FFTPlan *inverse, double *buffer) {
+    int bins = kernel->fft_size / 2 + 1;
+
+    fft_execute_r2c_split(forward, buffer, buffer, buffer + bins);
+    spectrum_multiply_split(buffer, kernel->bins, bins);
+    fft_execute_c2r_split(inverse, buffer, buffer + bins, buffer);
+}
+
+// Overlap-add block: convolve input samples [start, start + L) zero-padded
+// to F and add all L + M - 1 outputs (the tail reaches into the next block)
+static void overlap_add_block(const double *input, int input_length,
+                              const KernelSpectrum *kernel, FFTPlan *forward,
+                              FFTPlan *inverse, double *buffer,
+                              double *output, int output_length, int block) {
+    int fft_size = kernel->fft_size;
+    int block_length = fft_size - kernel->kernel_length + 1;
+    int start = block * block_length;
+
+    int count = input_length - start;
+    if (count > block_length) count = block_length;
+
+    memcpy(buffer, &input[start], count * sizeof(double));
+    memset(buffer + count, 0, (fft_size - count) * sizeof(double));
+
+    kernel_spectrum_filter(kernel, forward, inverse, buffer);
+
+    int valid = count + kernel->kernel_length - 1;
+    if (start + valid > output_length) valid = output_length - start;
+
+    for (int i = 0; i < valid; i++) {
+        output[start + i] += buffer[i];
+    }
+}
+
+// Overlap-add a whole input through a kernel spectrum. output receives the
+// length + kernel_length - 1 samples of the linear convolution; buffer needs
+// room for fft_size/2+1 bins and forward/inverse are real plans of that size.
+void kernel_spectrum_overlap_add(const KernelSpectrum *kernel, FFTPlan *forward,
+                                 FFTPlan *inverse, double *buffer,
+                                 const double *input, int length, double *output) {
+    int output_length = length + kernel->kernel_length - 1;
+    int block_length = kernel->fft_size - kernel->kernel_length + 1;
+
+    memset(output, 0, output_length * sizeof(double));
+    for (int block = 0; block * block_length < length; block++) {
+        overlap_add_block(input, length, kernel, forward, inverse, buffer,
+                          output, output_length, block);
+    }
+}
+
+// Overlap-save block: filter an F-sample window (M - 1 samples of history
+// plus L new ones) and keep the last L outputs, which are free of circular
+// wrap-around
+static void overlap_save_block(const Signal *signal, const KernelSpectrum *kernel,
+                               FFTPlan *forward, FFTPlan *inverse, double *buffer,
+                               Signal *result, int block) {
+    int fft_size = kernel->fft_size;
+    int history = kernel->kernel_length - 1;
+    int block_length = fft_size - history;
+    int start = block * block_length;
+
+    // Window covers input samples [start - history, start + block_length)
+    for (int i = 0; i < fft_size; i++) {
+        int index = start - history + i;
+        buffer[i] = (index >= 0 && index < signal->length) ? signal->data[index] : 0.0;
+    }
+
+    kernel_spectrum_filter(kernel, forward, inverse, buffer);
+
+    int count = result->length - start;
+    if (count > block_length) count = block_length;
+
+    memcpy(&result->data[start], buffer + history, count * sizeof(double));
+}
+
+// Blocks needed to cover the input (overlap-add) or the output (overlap-save)
+static int block_count(const Signal *signal, const KernelSpectrum *kernel,
+                       const Signal *result, BlockConvMode mode) {
+    int block_length = kernel->fft_size - kernel->kernel_length + 1;
+    int length = (mode == BLOCK_OVERLAP_SAVE) ? result->length : signal->length;
+    return (length + block_length - 1) / block_length;
+}
+
+// Parallel block convolution state. Task t owns buffers[t] and filters a
+// contiguous run of the blocks in the current set: all blocks for
+// overlap-save, only even (phase 0) or odd (phase 1) ones for overlap-add.
+typedef struct {
+    const Signal *signal;
+    const KernelSpectrum *kernel;
+    FFTPlan *forward;
+    FFTPlan *inverse;
+    Signal *result;
+    double *buffers;
+    int buffer_stride;
+    BlockConvMode mode;
+    int first_block;            // First block of the set
+    int block_step;             // Distance between blocks in the set
+    int set_blocks;             // Blocks in the set
+    int blocks_per_task;
+} BlockJob;
+
+static void block_task(void *context, int index) {
+    BlockJob *job = (BlockJob*)context;
+    double *buffer = job->buffers + (size_t)index * job->buffer_stride;
+
+    int first = index * job->blocks_per_task;
+    int last = first + job->blocks_per_task;
+    if (last > job->set_blocks) last = job->set_blocks;
+
+    for (int i = first; i < last; i++) {
+        int block = job->first_block + i * job->block_step;
+        if (job->mode == BLOCK_OVERLAP_SAVE) {
+            overlap_save_block(job->signal, job->kernel, job->forward, job->inverse,
+                               buffer, job->result, block);
+        } else {
+            overlap_add_block(job->signal->data, job->signal->length, job->kernel,
+                              job->forward, job->inverse, buffer,
+                              job->result->data, job->result->length, block);
+        }
+    }
+}
+
+static void run_block_set(BlockJob *job, int tasks, int first_block, int block_step, int blocks) {
+    job->first_block = first_block;
+    job->block_step = block_step;
+    job->set_blocks = (blocks - first_block + block_step - 1) / block_step;
+    job->blocks_per_task = (job->set_blocks + tasks - 1) / tasks;
+    if (job->set_blocks > 0) {
+        conv_parallel_for((job->set_blocks + job->blocks_per_task - 1) / job->blocks_per_task,
+                          block_task, job);
+    }
+}
+
+// Tasks to filter the blocks with on the thread pool, or 0 to run them
+// serially. Overlap-save blocks write disjoint outputs. Overlap-add blocks
+// only overlap their neighbour (L >= M - 1), so even blocks run first and odd
+// ones second; each output gets at most two contributions, and since
+// a + b == b + a exactly, the result matches the serial loop bit for bit.
+static int block_parallel_tasks(const Signal *signal, const KernelSpectrum *kernel,
+                                const Signal *result, BlockConvMode mode) {
+    int threads = conv_get_num_threads();
+    int blocks = block_count(signal, kernel, result, mode);
+    int block_length = kernel->fft_size - kernel->kernel_length + 1;
+
+    if (threads < 2 || blocks < BLOCK_PARALLEL_MIN_BLOCKS) return 0;
+    if (mode == BLOCK_OVERLAP_ADD && block_length < kernel->kernel_length - 1) return 0;
+
+    return (threads < blocks) ? threads : blocks;
+}
+
+// Filter the blocks on the thread pool with tasks block buffers of
+// fft_size + 2 doubles each (F/2+1 bins, like the plan scratch buffer)
+static void block_convolve_parallel(const Signal *signal, const KernelSpectrum *kernel,
+                                    FFTPlan *forward, FFTPlan *inverse, Signal *result,
+                                    BlockConvMode mode, int tasks, double *buffers) {
+    int blocks = block_count(signal, kernel, result, mode);
+    int stride = kernel->fft_size + 2;
+
+    BlockJob job = {signal, kernel, forward, inverse, result, buffers, stride, mode, 0, 1, 0, 0};
+
+    if (mode == BLOCK_OVERLAP_SAVE) {
+        run_block_set(&job, tasks, 0, 1, blocks);
+    } else {
+        run_block_set(&job, tasks, 0, 2, blocks);
+        run_block_set(&job, tasks, 1, 2, blocks);
+    }
+}
+
+// Block (overlap-add / overlap-save) convolution. The kernel is transformed
+// once and the input is processed in blocks, so working memory is O(F)
+// regardless of the signal length (plus one block buffer per thread when
+// the blocks run in parallel). fft_size 0 picks the size automatically.
+Signal* convolve_block(const Signal *signal, const Signal *kernel,
+                       BlockConvMode mode, int fft_size) {
+    if (!signal || !kernel || signal->length < 1 || kernel->length < 1) return NULL;
+
+    Signal *result = create_signal(signal->length + kernel->length - 1, signal->sample_rate);
+    if (!result) return NULL;
+
+    result->type = SIGNAL_CUSTOM;
+    snprintf(result->name, sizeof(result->name), "%s(%.27s * %.27s)",
+             (mode == BLOCK_OVERLAP_SAVE) ? "OLS" : "OLA",
+             signal->name, kernel->name);
+
+    if (convolve_block_into(result, signal, kernel, mode, fft_size) != 0) {
+        free_signal(result);
+        return NULL;
+    }
+
+    return result;
+}
+
+// Block convolution into a caller-provided signal of exactly
+// signal->length + kernel->length - 1 samples. The kernel spectrum and the
+// block buffers live in the calling thread's workspace, so repeated calls
+// do not allocate. Returns 0 on success, -1 on error.
+int convolve_block_into(Signal *output, const Signal *signal, const Signal *kernel,
+                        BlockConvMode mode, int fft_size) {
+    if (!output || !signal || !kernel || signal->length < 1 || kernel->length < 1) return -1;
+
+    int conv_length = signal->length + kernel->length - 1;
+    if (output->length != conv_length) return -1;
+
+    if (fft_size <= 0) {
+        fft_size = choose_block_fft_size(kernel->length);
+
+        // No point in blocks larger than a single full-length transform
+        int full_size = fft_next_fast_size_real(conv_length);
+        if (fft_size > full_size) fft_size = full_size;
+    }
+    if (fft_size < kernel->length) return -1;
+    CONV_STATS_START(stats_start);
+
+    // Workspace: kernel bins, then one block buffer per parallel task
+    KernelSpectrum spectrum = {NULL, fft_size, kernel->length};
+    int stride = fft_size + 2;
+    int tasks = block_parallel_tasks(signal, &spectrum, output, mode);
+    double *workspace = conv_workspace((size_t)(1 + tasks) * stride);
+    if (!workspace) return -1;
+
+    spectrum.bins = workspace;
+    if (kernel_spectrum_transform(&spectrum, kernel->data) != 0) return -1;
+
+    FFTPlan *forward = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+    FFTPlan *inverse = fft_plan_acquire_real(fft_size, FFT_INVERSE);
+
+    if (!forward || !inverse) {
+        fft_plan_release(forward);
+        fft_plan_release(inverse);
+        return -1;
+    }
+
+    // Overlap-add accumulates; overlap-save writes every output
+    if (mode == BLOCK_OVERLAP_ADD) {
+        memset(output->data, 0, conv_length * sizeof(double));
+    }
+
+    if (tasks > 0) {
+        block_convolve_parallel(signal, &spectrum, forward, inverse, output, mode,
+                                tasks, workspace + stride);
+    } else {
+        // The forward plan's scratch (F/2+1 bins = F+2 doubles) is the block buffer
+        double *buffer = (double*)forward->scratch;
+        int blocks = block_count(signal, &spectrum, output, mode);
+        for (int block = 0; block < blocks; block++) {
+            if (mode == BLOCK_OVERLAP_SAVE) {
+                overlap_save_block(signal, &spectrum, forward, inverse, buffer, output, block);
+            } else {
+                overlap_add_block(signal->data, signal->length, &spectrum, forward, inverse,
+                                  buffer, output->data, output->length, block);
+            }
+        }
+    }
+
+    fft_plan_release(forward);
+    fft_plan_release(inverse);
+
+    CONV_STATS_STOP(CONV_STAT_BLOCK, stats_start, conv_length);
+    return 0;
+}
+
+// Overlap-add convolution with an automatically chosen block size
+Signal* convolve_overlap_add(const Signal *signal, const Signal *kernel) {
+    return convolve_block(signal, kernel, BLOCK_OVERLAP_ADD, 0);
+}
+
+// Overlap-save convolution with an automatically chosen block size
+Signal* convolve_overlap_save(const Signal *signal, const Signal *kernel) {
+    return convolve_block(signal, kernel, BLOCK_OVERLAP_SAVE, 0);
+}
@@ -0,0 +1,557 @@
+#include "../include/convolution.h"
+
+// Headless command mode of convolution_explorer:
+//
+//   convolution_explorer convolve --in x.bin --kernel h.bin --out y.bin [--algo auto]
+//   convolution_explorer fft --in x.bin --out spectrum.csv
+//   convolution_explorer stft --in x.bin --out stft.bin --window hann --size 1024 --hop 256
+//
+// No banner, menus or plots. Errors go to stderr and the process exit code
+// tells the caller what happened.
+
+#define CLI_EXIT_OK 0
+#define CLI_EXIT_FAILURE 1     // The command ran and failed (I/O, memory, ...)
+#define CLI_EXIT_USAGE 2       // Bad command line
+
+// Parsed command line. Options not given keep their defaults.
+typedef struct {
+    const char *command;
+    const char *input;
+    const char *kernel;
+    const char *output;
+    const char *algo;          // auto, stream, or a conv_algorithm_name
+    const char *mode;          // full, same, valid
+    const char *format;        // f64, f32 (binary outputs)
+    const char *window;        // STFT window name
+    int channel;               // fft / stft: input channel
+    int threads;               // 0 = library default
+    int size;                  // STFT window length
+    int hop;                   // STFT hop (0 = size / 4)
+    int fft_size;              // STFT transform size (0 = automatic)
+    int full;                  // fft: all bins instead of 0..N/2
+    int power;                 // stft: power instead of magnitude
+    int stats;                 // Print the instrumentation counters
+    int verbose;               // One summary line on stderr
+} CliOptions;
+
+static void cli_usage(FILE *out) {
+    fprintf(out, "Usage: convolution_explorer [command [options]]\n\n");
+    fprintf(out, "Without a command the interactive menu starts.\n\n");
+    fprintf(out, "Commands:\n");
+    fprintf(out, "  convolve --in FILE --kernel FILE --out FILE\n");
+    fprintf(out, "           [--algo auto|stream|direct|simd-direct|fft|overlap-add|overlap-save]\n");
+    fprintf(out, "           [--mode full|same|valid] [--format f64|f32]\n");
+    fprintf(out, "      Convolve every channel of the input with the kernel. --algo stream\n");
+    fprintf(out, "      filters file to file in fixed-size chunks (full mode, f64 output).\n");
+    fprintf(out, "  fft --in FILE --out FILE [--channel C] [--full]\n");
+    fprintf(out, "      Spectrum of one channel: CSV (Frequency,Real,Imag,Magnitude,Phase)\n");
+    fprintf(out, "      or a binary file with real and imaginary channels.\n");
+    fprintf(out, "  stft --in FILE --out FILE [--window hann] [--size 1024] [--hop 256]\n");
+    fprintf(out, "       [--fft-size N] [--channel C] [--power]\n");
+    fprintf(out, "      Magnitude (or power) spectrogram, one frame per row (CSV) or per\n");
+    fprintf(out, "      binary frame with one channel per bin.\n");
+    fprintf(out, "  help\n\n");
+    fprintf(out, "Common options: --threads N, --stats (print counters), --verbose\n");
+    fprintf(out, "Files ending in .csv are written as text, anything else as binary.\n");
+    fprintf(out, "Exit status: 0 success, 1 failure, 2 usage error.\n");
+}
+
+// Parse a non-negative integer option value. Returns 0 on success.
+static int cli_parse_int(const char *option, const char *value, int *out) {
+    char *end;
+    long parsed = strtol(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || parsed < 0 || parsed > 1 << 30) {
+        fprintf(stderr, "%s: invalid value '%s'\n", option, value);
+        return -1;
+    }
+    *out = (int)parsed;
+    return 0;
+}
+
+// Fill options from argv[2...]. Returns 0 on success, -1 on a usage error.
+static int cli_parse(CliOptions *options, int argc, char **argv) {
+    memset(options, 0, sizeof(*options));
+    options->command = argv[1];
+    options->algo = "auto";
+    options->mode = "full";
+    options->format = "f64";
+    options->window = "hann";
+    options->size = 1024;
+
+    for (int i = 2; i < argc; i++) {
+        const char *arg = argv[i];
+
+        // Flags without a value
+        if (strcmp(arg, "--full") == 0) {
+            options->full = 1;
+            continue;
+        }
+        if (strcmp(arg, "--power") == 0) {
+            options->power = 1;
+            continue;
+        }
+        if (strcmp(arg, "--stats") == 0) {
+            options->stats = 1;
+            continue;
+        }
+        if (strcmp(arg, "--verbose") == 0) {
+            options->verbose = 1;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            fprintf(stderr, "%s: unknown option or missing value\n", arg);
+            return -1;
+        }
+        const char *value = argv[++i];
+
+        if (strcmp(arg, "--in") == 0) options->input = value;
+        else if (strcmp(arg, "--kernel") == 0) options->kernel = value;
+        else if (strcmp(arg, "--out") == 0) options->output = value;
+        else if (strcmp(arg, "--algo") == 0) options->algo = value;
+        else if (strcmp(arg, "--mode") == 0) options->mode = value;
+        else if (strcmp(arg, "--format") == 0) options->format = value;
+        else if (strcmp(arg, "--window") == 0) options->window = value;
+        else if (strcmp(arg, "--channel") == 0) {
+            if (cli_parse_int(arg, value, &options->channel) != 0) return -1;
+        } else if (strcmp(arg, "--threads") == 0) {
+            if (cli_parse_int(arg, value, &options->threads) != 0) return -1;
+        } else if (strcmp(arg, "--size") == 0) {
+            if (cli_parse_int(arg, value, &options->size) != 0) return -1;
+        } else if (strcmp(arg, "--hop") == 0) {
+            if (cli_parse_int(arg, value, &options->hop) != 0) return -1;
+        } else if (strcmp(arg, "--fft-size") == 0) {
+            if (cli_parse_int(arg, value, &options->fft_size) != 0) return -1;
+        } else {
+            fprintf(stderr, "%s: unknown option\n", arg);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// Check that the options a command needs were given
+static int cli_require(const char *option, const char *value) {
+    if (value) return 0;
+    fprintf(stderr, "%s is required\n", option);
+    return -1;
+}
+
+// Output file type from the file name: .csv is text, anything else binary
+static SignalFileType cli_file_type(const char *filename) {
+    size_t length = strlen(filename);
+    if (length >= 4 && strcmp(filename + length - 4, ".csv") == 0) return SIGNAL_FILE_CSV;
+    return SIGNAL_FILE_BINARY;
+}
+
+static int cli_parse_format(const char *name, SampleFormat *format) {
+    if (strcmp(name, "f64") == 0) *format = SAMPLE_FLOAT64;
+    else if (strcmp(name, "f32") == 0) *format = SAMPLE_FLOAT32;
+    else {
+        fprintf(stderr, "--format: expected f64 or f32, got '%s'\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+static int cli_parse_mode(const char *name, ConvMode *mode) {
+    if (strcmp(name, "full") == 0) *mode = CONV_MODE_FULL;
+    else if (strcmp(name, "same") == 0) *mode = CONV_MODE_SAME;
+    else if (strcmp(name, "valid") == 0) *mode = CONV_MODE_VALID;
+    else {
+        fprintf(stderr, "--mode: expected full, same or valid, got '%s'\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+// One channel of a CSV or binary signal file
+static Signal* cli_load(const char *filename, int channel) {
+    Signal *signal = (channel == 0) ? load_signal_from_file(filename)
+                                    : load_signal_binary(filename, channel);
+    if (!signal || signal->length < 1) {
+        fprintf(stderr, "%s: cannot read channel %d\n", filename, channel);
+        free_signal(signal);
+        return NULL;
+    }
+    return signal;
+}
+
+// Write frames x channels interleaved samples with the streaming writer
+static int cli_write_frames(const char *filename, const double *frames, int frame_count,
+                            int channels, double sample_rate, const char *name,
+                            SampleFormat format) {
+    SignalFileType type = cli_file_type(filename);
+    if (type == SIGNAL_FILE_CSV && channels != 1) {
+        fprintf(stderr, "%s: CSV output is mono; use a binary file for %d channels\n",
+                filename, channels);
+        return -1;
+    }
+
+    SignalWriter *writer = signal_writer_open(filename, type, format, channels, sample_rate, name);
+    if (!writer) {
+        fprintf(stderr, "%s: cannot open for writing\n", filename);
+        return -1;
+    }
+
+    int status = signal_writer_write(writer, frames, frame_count);
+    if (signal_writer_close(writer) != 0) status = -1;
+    if (status != 0) fprintf(stderr, "%s: write failed\n", filename);
+
+    return status;
+}
+
+// convolve: every channel of --in with channel 0 of --kernel
+static int cli_convolve(const CliOptions *options) {
+    if (cli_require("--in", options->input) != 0 || cli_require("--kernel", options->kernel) != 0 ||
+        cli_require("--out", options->output) != 0) {
+        return CLI_EXIT_USAGE;
+    }
+
+    ConvMode mode;
+    SampleFormat format;
+    if (cli_parse_mode(options->mode, &mode) != 0 || cli_parse_format(options->format, &format) != 0) {
+        return CLI_EXIT_USAGE;
+    }
+
+    int streaming = (strcmp(options->algo, "stream") == 0);
+    int automatic = (strcmp(options->algo, "auto") == 0);
+    ConvAlgorithm algorithm = CONV_ALGO_DIRECT;
+    if (!streaming && !automatic) {
+        int found = 0;
+        for (int a = CONV_ALGO_DIRECT; a <= CONV_ALGO_OVERLAP_SAVE && !found; a++) {
+            if (strcmp(options->algo, conv_algorithm_name((ConvAlgorithm)a)) == 0) {
+                algorithm = (ConvAlgorithm)a;
+                found = 1;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "--algo: unknown algorithm '%s'\n", options->algo);
+            return CLI_EXIT_USAGE;
+        }
+    }
+    if (streaming && (mode != CONV_MODE_FULL || format != SAMPLE_FLOAT64)) {
+        fprintf(stderr, "--algo stream writes full-length f64 output only\n");
+        return CLI_EXIT_USAGE;
+    }
+
+    Signal *kernel = cli_load(options->kernel, 0);
+    if (!kernel) return CLI_EXIT_FAILURE;
+
+    if (streaming) {
+        int status = convolve_file(options->input, kernel, options->output,
+                                   cli_file_type(options->output));
+        if (status != 0) fprintf(stderr, "%s: streaming convolution failed\n", options->input);
+        free_signal(kernel);
+        return (status == 0) ? CLI_EXIT_OK : CLI_EXIT_FAILURE;
+    }
+
+    // Whole-signal algorithms: map the input (float64 files are used in
+    // place) and convolve one channel at a time into an interleaved buffer
+    MappedSignal *mapped = map_signal_file(options->input);
+    Signal *csv = NULL;
+    SignalView channel_views[1];
+    int channels = 1;
+    double sample_rate;
+    const char *name;
+
+    if (mapped) {
+        channels = mapped->channels;
+        sample_rate = mapped->sample_rate;
+        name = mapped->name;
+    } else {
+        csv = cli_load(options->input, 0);
+        if (!csv) {
+            free_signal(kernel);
+            return CLI_EXIT_FAILURE;
+        }
+        channel_views[0] = signal_view(csv);
+        sample_rate = csv->sample_rate;
+        name = csv->name;
+    }
+
+    int status = CLI_EXIT_OK;
+    double *frames = NULL;
+    int frame_count = 0;
+
+    if (channels != 1 && cli_file_type(options->output) == SIGNAL_FILE_CSV) {
+        fprintf(stderr, "%s: CSV output is mono; use a binary file for %d channels\n",
+                options->output, channels);
+        status = CLI_EXIT_USAGE;
+    }
+
+    for (int c = 0; c < channels && status == CLI_EXIT_OK; c++) {
+        SignalView view = mapped ? mapped_signal_channel(mapped, c) : channel_views[0];
+        if (!view.data || view.length < 1) {
+            fprintf(stderr, "%s: channel %d is empty\n", options->input, c);
+            status = CLI_EXIT_FAILURE;
+            break;
+        }
+
+        // Contiguous channels are wrapped, strided ones gathered
+        Signal wrapper;
+        Signal *copy = NULL;
+        const Signal *input = &wrapper;
+        if (view.stride == 1) {
+            signal_init(&wrapper, view.data, view.length, view.sample_rate);
+        } else {
+            copy = signal_from_view(&view);
+            input = copy;
+        }
+
+        Signal *result = NULL;
+        if (input) {
+            result = automatic ? convolve_auto(input, kernel, mode)
+                               : convolve_with_algorithm(input, kernel, mode, algorithm);
+        }
+        free_signal(copy);
+
+        if (!result) {
+            fprintf(stderr, "%s: convolution of channel %d failed\n", options->input, c);
+            status = CLI_EXIT_FAILURE;
+            break;
+        }
+
+        if (!frames) {
+            frame_count = result->length;
+            frames = (double*)malloc((size_t)frame_count * channels * sizeof(double));
+            if (!frames) {
+                fprintf(stderr, "Out of memory\n");
+                status = CLI_EXIT_FAILURE;
+            }
+        }
+        if (frames) {
+            for (int i = 0; i < frame_count; i++) {
+                frames[(size_t)i * channels + c] = result->data[i];
+            }
+        }
+        free_signal(result);
+    }
+
+    if (status == CLI_EXIT_OK) {
+        char output_name[64];
+        snprintf(output_name, sizeof(output_name), "Conv(%.27s * %.27s)", name, kernel->name);
+        if (cli_write_frames(options->output, frames, frame_count, channels, sample_rate,
+                             output_name, format) != 0) {
+            status = CLI_EXIT_FAILURE;
+        }
+    }
+
+    if (options->verbose && status == CLI_EXIT_OK) {
+        fprintf(stderr, "%s: %d channel(s) x %d samples\n", options->output, channels, frame_count);
+    }
+
+    free(frames);
+    free_signal(csv);
+    if (mapped) unmap_signal_file(mapped);
+    free_signal(kernel);
+
+    return status;
+}
+
+// fft: spectrum of one channel
+static int cli_fft(const CliOptions *options) {
+    if (cli_require("--in", options->input) != 0 || cli_require("--out", options->output) != 0) {
+        return CLI_EXIT_USAGE;
+    }
+
+    SampleFormat format;
+    if (cli_parse_format(options->format, &format) != 0) return CLI_EXIT_USAGE;
+
+    Signal *signal = cli_load(options->input, options->channel);
+    if (!signal) return CLI_EXIT_FAILURE;
+
+    unsigned flags = FFT_WANT_MAG | FFT_WANT_PHASE;
+    if (!options->full) flags |= FFT_HALF_SPECTRUM;
+
+    FFTResult *spectrum = compute_fft_flags(signal, flags);
+    if (!spectrum) {
+        fprintf(stderr, "%s: FFT failed\n", options->input);
+        free_signal(signal);
+        return CLI_EXIT_FAILURE;
+    }
+
+    int status = CLI_EXIT_OK;
+    if (cli_file_type(options->output) == SIGNAL_FILE_CSV) {
+        FILE *file = fopen(options->output, "w");
+        if (!file) {
+            fprintf(stderr, "%s: cannot open for writing\n", options->output);
+            status = CLI_EXIT_FAILURE;
+        } else {
+            fprintf(file, "# FFT(%s)\n", signal->name);
+            fprintf(file, "# FFT size: %d\n", spectrum->fft_size);
+            fprintf(file, "Frequency,Real,Imag,Magnitude,Phase\n");
+            for (int i = 0; i < spectrum->length; i++) {
+                fprintf(file, "%.6f,%.10g,%.10g,%.10g,%.10g\n", spectrum->frequency[i],
+                        spectrum->real[i], spectrum->imag[i],
+                        spectrum->magnitude[i], spectrum->phase[i]);
+            }
+            if (fclose(file) != 0) status = CLI_EXIT_FAILURE;
+        }
+    } else {
+        // Two interleaved channels: real, imaginary
+        double *frames = (double*)malloc(2 * (size_t)spectrum->length * sizeof(double));
+        if (!frames) {
+            status = CLI_EXIT_FAILURE;
+        } else {
+            for (int i = 0; i < spectrum->length; i++) {
+                frames[2 * i] = spectrum->real[i];
+                frames[2 * i + 1] = spectrum->imag[i];
+            }
+
+            char name[64];
+            snprintf(name, sizeof(name), "FFT(%.48s)", signal->name);
+            if (cli_write_frames(options->output, frames, spectrum->length, 2,
+                                 signal->sample_rate, name, format) != 0) {
+                status = CLI_EXIT_FAILURE;
+            }
+            free(frames);
+        }
+    }
+
+    if (options->verbose && status == CLI_EXIT_OK) {
+        fprintf(stderr, "%s: %d bins of a %d-point FFT\n", options->output,
+                spectrum->length, spectrum->fft_size);
+    }
+
+    free_fft_result(spectrum);
+    free_signal(signal);
+
+    return status;
+}
+
+// stft: magnitude or power spectrogram of one channel
+static int cli_stft(const CliOptions *options) {
+    if (cli_require("--in", options->input) != 0 || cli_require("--out", options->output) != 0) {
+        return CLI_EXIT_USAGE;
+    }
+
+    SampleFormat format;
+    if (cli_parse_format(options->format, &format) != 0) return CLI_EXIT_USAGE;
+
+    WindowType window = window_type_from_name(options->window);
+    if (window == WINDOW_RECTANGULAR && strcmp(options->window, "rectangular") != 0) {
+        fprintf(stderr, "--window: unknown window '%s'\n", options->window);
+        return CLI_EXIT_USAGE;
+    }
+
+    int hop = options->hop ? options->hop : options->size / 4;
+    STFTPlan *plan = stft_plan_create(window, options->size, hop > 0 ? hop : 1, options->fft_size);
+    if (!plan) {
+        fprintf(stderr, "Invalid STFT setup: size %d, hop %d, FFT size %d\n",
+                options->size, hop, options->fft_size);
+        return CLI_EXIT_USAGE;
+    }
+
+    Signal *signal = cli_load(options->input, options->channel);
+    STFTResult *stft = signal ? compute_stft(plan, signal) : NULL;
+    if (!stft) {
+        if (signal) fprintf(stderr, "%s: STFT failed\n", options->input);
+        free_signal(signal);
+        stft_plan_destroy(plan);
+        return CLI_EXIT_FAILURE;
+    }
+
+    int status = CLI_EXIT_OK;
+    size_t cells = (size_t)stft->frames * stft->bins;
+    double *values = (double*)malloc(cells * sizeof(double));
+    if (!values) {
+        fprintf(stderr, "Out of memory\n");
+        status = CLI_EXIT_FAILURE;
+    } else {
+        for (size_t i = 0; i < cells; i++) {
+            double power = stft->real[i] * stft->real[i] + stft->imag[i] * stft->imag[i];
+            values[i] = options->power ? power : sqrt(power);
+        }
+    }
+
+    double frame_rate = signal->sample_rate / stft->hop_size;
+    if (status == CLI_EXIT_OK && cli_file_type(options->output) == SIGNAL_FILE_CSV) {
+        FILE *file = fopen(options->output, "w");
+        if (!file) {
+            fprintf(stderr, "%s: cannot open for writing\n", options->output);
+            status = CLI_EXIT_FAILURE;
+        } else {
+            // One row per frame: its centre time, then every bin
+            fprintf(file, "# STFT(%s), %s window, hop %d\n", signal->name,
+                    window_type_name(window), stft->hop_size);
+            fprintf(file, "Time");
+            for (int b = 0; b < stft->bins; b++) {
+                fprintf(file, ",%.3f", b * signal->sample_rate / stft->fft_size);
+            }
+            fprintf(file, "\n");
+            for (int f = 0; f < stft->frames; f++) {
+                fprintf(file, "%.6f", f / frame_rate);
+                for (int b = 0; b < stft->bins; b++) {
+                    fprintf(file, ",%.8g", values[(size_t)f * stft->bins + b]);
+                }
+                fprintf(file, "\n");
+            }
+            if (fclose(file) != 0) status = CLI_EXIT_FAILURE;
+        }
+    } else if (status == CLI_EXIT_OK) {
+        // One binary frame per STFT frame, one channel per bin, at the frame rate
+        char name[64];
+        snprintf(name, sizeof(name), "STFT(%.48s)", signal->name);
+        if (cli_write_frames(options->output, values, stft->frames, stft->bins,
+                             frame_rate, name, format) != 0) {
+            status = CLI_EXIT_FAILURE;
+        }
+    }
+
+    if (options->verbose && status == CLI_EXIT_OK) {
+        fprintf(stderr, "%s: %d frames x %d bins\n", options->output, stft->frames, stft->bins);
+    }
+
+    free(values);
+    free_stft_result(stft);
+    free_signal(signal);
+    stft_plan_destroy(plan);
+
+    return status;
+}
+
+// Run a command line that names a command. Returns the process exit code.
+int conv_cli_run(int argc, char **argv) {
+    if (argc < 2) {
+        cli_usage(stderr);
+        return CLI_EXIT_USAGE;
+    }
+
+    const char *command = argv[1];
+    if (strcmp(command, "help") == 0 || strcmp(command, "--help") == 0 ||
+        strcmp(command, "-h") == 0) {
+        cli_usage(stdout);
+        return CLI_EXIT_OK;
+    }
+
+    CliOptions options;
+    if (cli_parse(&options, argc, argv) != 0) {
+        fprintf(stderr, "Run '%s help' for usage.\n", argv[0]);
+        return CLI_EXIT_USAGE;
+    }
+
+    if (options.threads > 0) conv_set_num_threads(options.threads);
+
+    int status;
+    if (strcmp(command, "convolve") == 0) {
+        status = cli_convolve(&options);
+    } else if (strcmp(command, "fft") == 0) {
+        status = cli_fft(&options);
+    } else if (strcmp(command, "stft") == 0) {
+        status = cli_stft(&options);
+    } else {
+        fprintf(stderr, "Unknown command '%s'. Run '%s help' for usage.\n", command, argv[0]);
+        return CLI_EXIT_USAGE;
+    }
+
+    if (options.stats) {
+        ConvStats stats;
+        conv_stats_snapshot(&stats);
+        conv_stats_print(&stats);
+    }
+
+    conv_thread_pool_shutdown();
+    return status;
+}
@@ -0,0 +1,143 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../include/convolution.h"
+#include <time.h>
+
+// Process-wide counters behind the CONV_STATS_* hooks. Updates are relaxed
+// atomic adds, so counters are exact but a snapshot taken while other
+// threads run is not a single instant.
+static ConvStats counters;
+
+static void counter_add(unsigned long long *counter, unsigned long long value) {
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+static unsigned long long counter_load(const unsigned long long *counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+// Monotonic clock in nanoseconds
+unsigned long long conv_stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+// Count one call of op covering samples samples and nanoseconds of time
+void conv_stats_record(ConvStatOp op, unsigned long long samples, unsigned long long nanoseconds) {
+    if ((int)op < 0 || op >= CONV_STAT_COUNT) return;
+
+    ConvOpCounters *entry = &counters.ops[op];
+    counter_add(&entry->calls, 1);
+    counter_add(&entry->samples, samples);
+    counter_add(&entry->nanoseconds, nanoseconds);
+}
+
+// Count one n-point transform
+void conv_stats_count_transform(int n) {
+    int log2n = 0;
+    while (log2n < CONV_STATS_FFT_SIZES - 1 && (1 << (log2n + 1)) <= n) log2n++;
+    counter_add(&counters.transforms[log2n], 1);
+}
+
+// Count a plan cache lookup: hit nonzero when an idle plan was reused
+void conv_stats_count_plan(int hit) {
+    counter_add(hit ? &counters.plan_cache_hits : &counters.plan_cache_misses, 1);
+}
+
+// Count an allocation of bytes
+void conv_stats_count_alloc(size_t bytes) {
+    counter_add(&counters.allocations, 1);
+    counter_add(&counters.bytes_allocated, bytes);
+}
+
+// Copy the counters. enabled tells whether the library was built with
+// CONV_ENABLE_STATS; without it every counter stays zero.
+void conv_stats_snapshot(ConvStats *stats) {
+    if (!stats) return;
+
+    memset(stats, 0, sizeof(*stats));
+#if defined(CONV_ENABLE_STATS)
+    stats->enabled = 1;
+#endif
+
+    for (int op = 0; op < CONV_STAT_COUNT; op++) {
+        stats->ops[op].calls = counter_load(&counters.ops[op].calls);
+        stats->ops[op].samples = counter_load(&counters.ops[op].samples);
+        stats->ops[op].nanoseconds = counter_load(&counters.ops[op].nanoseconds);
+    }
+    for (int i = 0; i < CONV_STATS_FFT_SIZES; i++) {
+        stats->transforms[i] = counter_load(&counters.transforms[i]);
+    }
+    stats->plan_cache_hits = counter_load(&counters.plan_cache_hits);
+    stats->plan_cache_misses = counter_load(&counters.plan_cache_misses);
+    stats->allocations = counter_load(&counters.allocations);
+    stats->bytes_allocated = counter_load(&counters.bytes_allocated);
+}
+
+// Zero every counter
+void conv_stats_reset(void) {
+    unsigned long long *fields = (unsigned long long*)&counters.ops[0];
+    size_t count = (sizeof(counters) - offsetof(ConvStats, ops)) / sizeof(unsigned long long);
+
+    for (size_t i = 0; i < count; i++) {
+        __atomic_store_n(&fields[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+const char* conv_stats_op_name(ConvStatOp op) {
+    switch (op) {
+        case CONV_STAT_DIRECT:   return "direct";
+        case CONV_STAT_FFT:      return "fft-convolve";
+        case CONV_STAT_BLOCK:    return "block";
+        case CONV_STAT_STREAM:   return "stream";
+        case CONV_STAT_BATCH:    return "batch";
+        case CONV_STAT_F32:      return "float32";
+        case CONV_STAT_SPECTRUM: return "spectrum";
+        case CONV_STAT_STFT:     return "stft";
+        case CONV_STAT_ISTFT:    return "istft";
+        case CONV_STAT_CORRELATE: return "correlate";
+        case CONV_STAT_MATCHED:  return "matched-filter";
+        case CONV_STAT_IMAGE:    return "image";
+        case CONV_STAT_MULTIRATE: return "multirate";
+        default:                 return "unknown";
+    }
+}
+
+// Print a snapshot as a table of the operations that ran
+void conv_stats_print(const ConvStats *stats) {
+    if (!stats) return;
+
+    printf("\nInstrumentation counters:\n");
+    if (!stats->enabled) {
+        printf("  Not available: rebuild with `make clean && make STATS=1`\n");
+        printf("  (defines CONV_ENABLE_STATS).\n");
+        return;
+    }
+
+    printf("  %-14s %12s %14s %12s %12s\n", "Operation", "Calls", "Samples", "Total (ms)", "ns/sample");
+    for (int op = 0; op < CONV_STAT_COUNT; op++) {
+        const ConvOpCounters *entry = &stats->ops[op];
+        if (entry->calls == 0) continue;
+
+        printf("  %-14s %12llu %14llu %12.3f %12.3f\n", conv_stats_op_name((ConvStatOp)op),
+               entry->calls, entry->samples, entry->nanoseconds / 1e6,
+               entry->samples ? (double)entry->nanoseconds / entry->samples : 0.0);
+    }
+
+    printf("\n  FFT sizes:");
+    int any = 0;
+    for (int i = 0; i < CONV_STATS_FFT_SIZES; i++) {
+        if (stats->transforms[i] == 0) continue;
+        printf("%s2^%d x %llu", any ? ", " : " ", i, stats->transforms[i]);
+        any = 1;
+    }
+    printf("%s\n", any ? "" : " none");
+
+    unsigned long long lookups = stats->plan_cache_hits + stats->plan_cache_misses;
+    printf("  Plan cache: %llu hits, %llu misses", stats->plan_cache_hits, stats->plan_cache_misses);
+    if (lookups > 0) printf(" (%.1f%% hit rate)", 100.0 * stats->plan_cache_hits / lookups);
+    printf("\n");
+
+    printf("  Allocations: %llu (%.2f MB)\n", stats->allocations,
+           stats->bytes_allocated / (1024.0 * 1024.0));
+}
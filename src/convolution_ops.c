@@ -15,31 +15,35 @@ Signal* convolve(const Signal *signal1, const Signal *signal2) {
     snprintf(result->name, sizeof(result->name), 
              "Conv(%s * %s)", signal1->name, signal2->name);
     
-    // Perform convolution: y[n] = sum(x[k] * h[n-k]) for all valid k
-    for (int n = 0; n < output_length; n++) {
-        result->data[n] = 0.0;
-        
-        // Determine the range of k values for which both x[k] and h[n-k] are valid
-        int k_min = (n >= signal2->length - 1) ? n - signal2->length + 1 : 0;
-        int k_max = (n < signal1->length) ? n : signal1->length - 1;
-        
-        for (int k = k_min; k <= k_max; k++) {
-            int h_index = n - k;
-            if (h_index >= 0 && h_index < signal2->length && k >= 0 && k < signal1->length) {
-                result->data[n] += signal1->data[k] * signal2->data[h_index];
-            }
-        }
-    }
+    convolve_into(result, signal1, signal2);
     
     return result;
 }
 
-// Circular convolution
+// Linear convolution into a caller-provided signal of exactly
+// signal1->length + signal2->length - 1 samples (not aliasing the inputs).
+// Only the samples are written. Returns 0 on success, -1 on error.
+int convolve_into(Signal *output, const Signal *signal1, const Signal *signal2) {
+    if (!output || !signal1 || !signal2) return -1;
+    if (output->length != signal1->length + signal2->length - 1) return -1;
+    
+    // Perform convolution: y[n] = sum(x[k] * h[n-k]) for all valid k
+    convolve_direct_kernel(signal1->data, signal1->length,
+                           signal2->data, signal2->length, output->data);
+    
+    return 0;
+}
+
+static int fft_convolve_padded(double *output, int output_length, const Signal *signal1,
+                               const Signal *signal2, int fft_size);
+static int circular_direct(double *output, int length, const Signal *signal1,
+                           const Signal *signal2);
+
+// Circular convolution at the native length: both signals are zero-padded
+// to the longer one's length L and convolved modulo L
 Signal* convolve_circular(const Signal *signal1, const Signal *signal2) {
-    if (!signal1 || !signal2) return NULL;
+    if (!signal1 || !signal2 || signal1->length < 1 || signal2->length < 1) return NULL;
     
-    // For circular convolution, both signals should have the same length
-    // If they don't, we'll use the length of the longer signal and zero-pad
     int length = (signal1->length > signal2->length) ? signal1->length : signal2->length;
     double sample_rate = signal1->sample_rate;
     
@@ -50,301 +54,338 @@ Signal* convolve_circular(const Signal *signal1, const Signal *signal2) {
     snprintf(result->name, sizeof(result->name), 
              "CircConv(%s * %s)", signal1->name, signal2->name);
     
-    // Perform circular convolution
-    for (int n = 0; n < length; n++) {
-        result->data[n] = 0.0;
-        
-        for (int k = 0; k < length; k++) {
-            // Get signal1 value (zero-padded if necessary)
-            double x_val = (k < signal1->length) ? signal1->data[k] : 0.0;
-            
-            // Get signal2 value with circular indexing (zero-padded if necessary)
-            int h_index = (n - k + length) % length;
-            double h_val = (h_index < signal2->length) ? signal2->data[h_index] : 0.0;
-            
-            result->data[n] += x_val * h_val;
-        }
+    // Short signals run directly: the linear convolution folded onto the
+    // period, when the cost model rates it below three transforms
+    int shorter = signal1->length < signal2->length ? signal1->length : signal2->length;
+    int status;
+    if (length < 2 || conv_estimate_cost(CONV_ALGO_SIMD_DIRECT, length, shorter) <=
+                      conv_estimate_cost(CONV_ALGO_FFT, length, shorter)) {
+        status = circular_direct(result->data, length, signal1, signal2);
+    } else {
+        CONV_STATS_START(stats_start);
+        status = fft_convolve_padded(result->data, length, signal1, signal2, length);
+        CONV_STATS_STOP(CONV_STAT_FFT, stats_start, length);
     }
     
-    return result;
-}
-
-// Helper function to find next power of 2
-static int next_power_of_2(int n) {
-    int power = 1;
-    while (power < n) {
-        power *= 2;
+    if (status != 0) {
+        free_signal(result);
+        return NULL;
     }
-    return power;
+    return result;
 }
 
 // Fast Fourier Transform (Cooley-Tukey algorithm)
+// Kept for API compatibility; the work is done by the iterative engine.
 void fft_recursive(Complex *data, int n) {
-    if (n <= 1) return;
-    
-    // Divide
-    Complex *even = (Complex*)malloc(n/2 * sizeof(Complex));
-    Complex *odd = (Complex*)malloc(n/2 * sizeof(Complex));
-    
-    for (int i = 0; i < n/2; i++) {
-        even[i] = data[i*2];
-        odd[i] = data[i*2 + 1];
-    }
-    
-    // Conquer
-    fft_recursive(even, n/2);
-    fft_recursive(odd, n/2);
-    
-    // Combine
-    for (int k = 0; k < n/2; k++) {
-        double angle = -2.0 * PI * k / n;
-        Complex twiddle = {cos(angle), sin(angle)};
-        
-        // Complex multiplication: twiddle * odd[k]
-        Complex temp = {
-            twiddle.real * odd[k].real - twiddle.imag * odd[k].imag,
-            twiddle.real * odd[k].imag + twiddle.imag * odd[k].real
-        };
-        
-        data[k].real = even[k].real + temp.real;
-        data[k].imag = even[k].imag + temp.imag;
-        
-        data[k + n/2].real = even[k].real - temp.real;
-        data[k + n/2].imag = even[k].imag - temp.imag;
-    }
-    
-    free(even);
-    free(odd);
+    fft_iterative(data, n, FFT_FORWARD);
 }
 
 // Inverse Fast Fourier Transform
 void ifft_recursive(Complex *data, int n) {
     if (n <= 1) return;
     
-    // Conjugate the input
-    for (int i = 0; i < n; i++) {
-        data[i].imag = -data[i].imag;
-    }
-    
-    // Apply FFT
-    fft_recursive(data, n);
+    fft_iterative(data, n, FFT_INVERSE);
     
-    // Conjugate the output and scale
+    // Scale by 1/n
     for (int i = 0; i < n; i++) {
         data[i].real /= n;
-        data[i].imag = -data[i].imag / n;
+        data[i].imag /= n;
     }
 }
 
 // FFT-based convolution (faster for large signals)
 Signal* convolve_fft(const Signal *signal1, const Signal *signal2) {
-    if (!signal1 || !signal2) return NULL;
+    if (!signal1 || !signal2 || signal1->length < 1 || signal2->length < 1) return NULL;
     
-    // For FFT convolution, we need to zero-pad to avoid circular effects
     int conv_length = signal1->length + signal2->length - 1;
-    int fft_size = next_power_of_2(conv_length);
-    
-    // Create FFT buffers
-    Complex *fft1 = (Complex*)calloc(fft_size, sizeof(Complex));
-    Complex *fft2 = (Complex*)calloc(fft_size, sizeof(Complex));
-    
-    if (!fft1 || !fft2) {
-        free(fft1);
-        free(fft2);
-        return NULL;
-    }
-    
-    // Copy signal data to FFT buffers (zero-padded)
-    for (int i = 0; i < signal1->length; i++) {
-        fft1[i].real = signal1->data[i];
-        fft1[i].imag = 0.0;
-    }
     
-    for (int i = 0; i < signal2->length; i++) {
-        fft2[i].real = signal2->data[i];
-        fft2[i].imag = 0.0;
-    }
-    
-    // Compute FFTs
-    fft_recursive(fft1, fft_size);
-    fft_recursive(fft2, fft_size);
-    
-    // Multiply in frequency domain (pointwise multiplication)
-    for (int i = 0; i < fft_size; i++) {
-        Complex temp = {
-            fft1[i].real * fft2[i].real - fft1[i].imag * fft2[i].imag,
-            fft1[i].real * fft2[i].imag + fft1[i].imag * fft2[i].real
-        };
-        fft1[i] = temp;
-    }
-    
-    // Inverse FFT to get convolution result
-    ifft_recursive(fft1, fft_size);
-    
-    // Create result signal
     Signal *result = create_signal(conv_length, signal1->sample_rate);
-    if (!result) {
-        free(fft1);
-        free(fft2);
-        return NULL;
-    }
+    if (!result) return NULL;
     
     result->type = SIGNAL_CUSTOM;
     snprintf(result->name, sizeof(result->name), 
              "FFTConv(%s * %s)", signal1->name, signal2->name);
     
-    // Copy real part of IFFT result
-    for (int i = 0; i < conv_length; i++) {
-        result->data[i] = fft1[i].real;
+    if (convolve_fft_into(result, signal1, signal2) != 0) {
+        free_signal(result);
+        return NULL;
     }
     
-    free(fft1);
-    free(fft2);
-    
     return result;
 }
 
-// Compute FFT of a signal for frequency analysis
-FFTResult* compute_fft(const Signal *signal) {
-    if (!signal) return NULL;
+// FFT-based convolution into a caller-provided signal of exactly
+// signal1->length + signal2->length - 1 samples. Only the samples are
+// written. Returns 0 on success, -1 on error.
+int convolve_fft_into(Signal *output, const Signal *signal1, const Signal *signal2) {
+    if (!output || !signal1 || !signal2) return -1;
+    if (signal1->length < 1 || signal2->length < 1) return -1;
     
-    int fft_size = next_power_of_2(signal->length);
+    // For FFT convolution, we need to zero-pad to avoid circular effects
+    int conv_length = signal1->length + signal2->length - 1;
+    if (output->length != conv_length) return -1;
     
-    FFTResult *result = (FFTResult*)malloc(sizeof(FFTResult));
-    if (!result) return NULL;
+    // Cheapest even size that holds the full result (real plans of any
+    // even size split into a half-size complex transform)
+    int fft_size = fft_next_fast_size_real(conv_length);
+    CONV_STATS_START(stats_start);
     
-    result->data = (Complex*)calloc(fft_size, sizeof(Complex));
-    result->magnitude = (double*)malloc(fft_size * sizeof(double));
-    result->phase = (double*)malloc(fft_size * sizeof(double));
-    result->frequency = (double*)malloc(fft_size * sizeof(double));
-    result->length = fft_size;
+    int status = fft_convolve_padded(output->data, conv_length, signal1, signal2, fft_size);
     
-    if (!result->data || !result->magnitude || !result->phase || !result->frequency) {
-        free_fft_result(result);
-        return NULL;
+    CONV_STATS_STOP(CONV_STAT_FFT, stats_start, conv_length);
+    return status;
+}
+
+// Circular convolution of period fft_size (at least either signal's
+// length) through real transforms; the first output_length samples go to
+// output. A period of at least length1 + length2 - 1 makes it linear.
+static int fft_convolve_padded(double *output, int output_length, const Signal *signal1,
+                               const Signal *signal2, int fft_size) {
+    // Real-input plans: each scratch buffer holds one split spectrum of
+    // fft_size/2+1 bins (fft_size + 2 doubles)
+    FFTPlan *forward = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+    FFTPlan *inverse = fft_plan_acquire_real(fft_size, FFT_INVERSE);
+    
+    if (!forward || !inverse) {
+        fft_plan_release(forward);
+        fft_plan_release(inverse);
+        return -1;
     }
     
-    // Copy signal data (zero-padded)
-    for (int i = 0; i < signal->length; i++) {
-        result->data[i].real = signal->data[i];
-        result->data[i].imag = 0.0;
+    int bins = fft_size / 2 + 1;
+    double *fft1 = (double*)forward->scratch;
+    double *fft2 = (double*)inverse->scratch;
+    
+    // Zero-pad each signal in place inside its spectrum buffer
+    memcpy(fft1, signal1->data, signal1->length * sizeof(double));
+    memset(fft1 + signal1->length, 0, (fft_size - signal1->length) * sizeof(double));
+    memcpy(fft2, signal2->data, signal2->length * sizeof(double));
+    memset(fft2 + signal2->length, 0, (fft_size - signal2->length) * sizeof(double));
+    
+    // Compute split half spectra. The samples are read before any bin is
+    // written, so transforming in place is safe.
+    fft_execute_r2c_split(forward, fft1, fft1, fft1 + bins);
+    fft_execute_r2c_split(forward, fft2, fft2, fft2 + bins);
+    
+    // Multiply in frequency domain (pointwise multiplication), folding
+    // the 1/N scale of the inverse transform into the kernel spectrum
+    double scale = 1.0 / fft_size;
+    for (int i = 0; i < 2 * bins; i++) {
+        fft2[i] *= scale;
     }
+    spectrum_multiply_split(fft1, fft2, bins);
     
-    // Compute FFT
-    fft_recursive(result->data, fft_size);
+    // Inverse real FFT to get convolution result
+    fft_execute_c2r_split(inverse, fft1, fft1 + bins, fft1);
+    memcpy(output, fft1, output_length * sizeof(double));
     
-    // Compute magnitude, phase, and frequency arrays
-    double freq_resolution = signal->sample_rate / fft_size;
+    fft_plan_release(forward);
+    fft_plan_release(inverse);
     
-    for (int i = 0; i < fft_size; i++) {
-        // Magnitude spectrum
-        result->magnitude[i] = sqrt(result->data[i].real * result->data[i].real + 
-                                   result->data[i].imag * result->data[i].imag);
-        
-        // Phase spectrum
-        result->phase[i] = atan2(result->data[i].imag, result->data[i].real);
-        
-        // Frequency bins
-        if (i <= fft_size/2) {
-            result->frequency[i] = i * freq_resolution;
-        } else {
-            result->frequency[i] = (i - fft_size) * freq_resolution;
-        }
+    return 0;
+}
+
+// Circular convolution of period length by direct summation: the linear
+// convolution (at most 2 * length - 1 samples) folded onto one period
+static int circular_direct(double *output, int length, const Signal *signal1,
+                           const Signal *signal2) {
+    int linear_length = signal1->length + signal2->length - 1;
+    double *linear = (double*)malloc(linear_length * sizeof(double));
+    if (!linear) return -1;
+    
+    convolve_direct_kernel(signal1->data, signal1->length,
+                           signal2->data, signal2->length, linear);
+    
+    memcpy(output, linear, length * sizeof(double));
+    for (int i = length; i < linear_length; i++) {
+        output[i - length] += linear[i];
     }
     
-    return result;
+    free(linear);
+    return 0;
 }
 
-// Free FFT result memory
-void free_fft_result(FFTResult *result) {
-    if (result) {
-        if (result->data) free(result->data);
-        if (result->magnitude) free(result->magnitude);
-        if (result->phase) free(result->phase);
-        if (result->frequency) free(result->frequency);
-        free(result);
-    }
+// Allocate an FFT result with length bins and the default contents
+// (magnitude and phase of the full spectrum)
+FFTResult* fft_result_create(int length) {
+    return fft_result_create_flags(length, FFT_WANT_DEFAULT);
 }
 
-// Save signal to CSV file for external analysis
-void save_signal_to_file(const Signal *signal, const char *filename) {
-    if (!signal || !filename) return;
-    
-    FILE *file = fopen(filename, "w");
-    if (!file) {
-        printf("Error: Could not open file %s for writing\n", filename);
-        return;
+// Allocate an FFT result for an fft_size-point transform holding the
+// contents selected by flags: fft_size bins, or fft_size/2+1 with
+// FFT_HALF_SPECTRUM. The struct, the frequency axis and all requested arrays
+// share one block, taken from the bound arena when there is one.
+FFTResult* fft_result_create_flags(int fft_size, unsigned flags) {
+    if (fft_size < 1) return NULL;
+    
+    int length = (flags & FFT_HALF_SPECTRUM) ? fft_size / 2 + 1 : fft_size;
+    int derived = ((flags & FFT_WANT_MAG) != 0) + ((flags & FFT_WANT_PHASE) != 0) +
+                  ((flags & FFT_WANT_POWER) != 0);
+    
+    size_t header = (sizeof(FFTResult) + 63) & ~(size_t)63;
+    size_t bytes = header + (size_t)length * (sizeof(Complex) + (3 + derived) * sizeof(double));
+    
+    StorageKind storage = STORAGE_ARENA;
+    unsigned char *block = (unsigned char*)signal_arena_alloc(signal_arena_current(), bytes);
+    if (!block) {
+        storage = STORAGE_HEAP;
+        block = (unsigned char*)malloc(bytes);
+        if (!block) return NULL;
+    }
+    CONV_STATS_ALLOC(bytes);
+    
+    FFTResult *result = (FFTResult*)block;
+    result->data = (Complex*)(block + header);
+    result->real = (double*)(result->data + length);
+    result->imag = result->real + length;
+    result->frequency = result->imag + length;
+    
+    double *next = result->frequency + length;
+    result->magnitude = NULL;
+    result->phase = NULL;
+    result->power = NULL;
+    if (flags & FFT_WANT_MAG) {
+        result->magnitude = next;
+        next += length;
+    }
+    if (flags & FFT_WANT_PHASE) {
+        result->phase = next;
+        next += length;
+    }
+    if (flags & FFT_WANT_POWER) {
+        result->power = next;
     }
     
-    fprintf(file, "# %s\n", signal->name);
-    fprintf(file, "# Sample Rate: %.1f Hz\n", signal->sample_rate);
-    fprintf(file, "# Length: %d samples\n", signal->length);
-    fprintf(file, "# Duration: %.6f seconds\n", signal->duration);
-    fprintf(file, "Time,Amplitude\n");
+    result->length = length;
+    result->fft_size = fft_size;
+    result->flags = flags;
+    result->storage = storage;
     
-    for (int i = 0; i < signal->length; i++) {
-        double time = (double)i / signal->sample_rate;
-        fprintf(file, "%.6f,%.6f\n", time, signal->data[i]);
-    }
+    return result;
+}
+
+// Compute FFT of a signal for frequency analysis
+FFTResult* compute_fft(const Signal *signal) {
+    return compute_fft_flags(signal, FFT_WANT_DEFAULT);
+}
+
+// FFT of a signal computing only the contents selected by flags
+FFTResult* compute_fft_flags(const Signal *signal, unsigned flags) {
+    if (!signal) return NULL;
     
-    fclose(file);
-    printf("Signal saved to %s\n", filename);
+    SignalView view = signal_view(signal);
+    return compute_fft_view_flags(&view, flags);
+}
+
+// Compute the FFT of a signal into a caller-provided result whose fft_size
+// is next_power_of_2(signal->length). The result's flags select what is
+// computed. Returns 0 on success, -1 on error.
+int compute_fft_into(FFTResult *result, const Signal *signal) {
+    if (!signal) return -1;
+    
+    SignalView view = signal_view(signal);
+    return compute_fft_view_into(result, &view);
 }
 
-// Load signal from CSV file
-Signal* load_signal_from_file(const char *filename) {
-    if (!filename) return NULL;
+// FFT of a view (see compute_fft)
+FFTResult* compute_fft_view(const SignalView *view) {
+    return compute_fft_view_flags(view, FFT_WANT_DEFAULT);
+}
+
+// FFT of a view computing only the contents selected by flags
+FFTResult* compute_fft_view_flags(const SignalView *view, unsigned flags) {
+    if (!view || !view->data) return NULL;
+    
+    FFTResult *result = fft_result_create_flags(next_power_of_2(view->length), flags);
+    if (!result) return NULL;
     
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        printf("Error: Could not open file %s for reading\n", filename);
+    if (compute_fft_view_into(result, view) != 0) {
+        free_fft_result(result);
         return NULL;
     }
     
-    char line[256];
-    double sample_rate = 44100.0; // Default
-    int estimated_length = 0;
-    
-    // First pass: read header and count data lines
-    while (fgets(line, sizeof(line), file)) {
-        if (line[0] == '#') {
-            if (strstr(line, "Sample Rate:")) {
-                sscanf(line, "# Sample Rate: %lf Hz", &sample_rate);
-            }
-        } else if (line[0] != 'T') { // Skip "Time,Amplitude" header
-            estimated_length++;
+    return result;
+}
+
+// FFT of a view into a caller-provided result whose fft_size is
+// next_power_of_2(length). Strided samples are gathered straight into the
+// transform buffer. The spectrum is computed in split form into
+// result->real/imag and interleaved into result->data once; only the
+// derived arrays the result was created with are filled. Returns 0 on
+// success, -1 on error.
+int compute_fft_view_into(FFTResult *result, const SignalView *view) {
+    if (!result || !view || !view->data) return -1;
+    
+    int fft_size = next_power_of_2(view->length);
+    if (result->fft_size != fft_size) return -1;
+    
+    CONV_STATS_START(stats_start);
+    
+    int length = result->length;
+    double *real = result->real;
+    double *imag = result->imag;
+    
+    if (fft_size == 1) {
+        // One sample, or none: an empty view gives a zeroed 1-bin spectrum
+        real[0] = view->length > 0 ? view->data[0] : 0.0;
+        imag[0] = 0.0;
+    } else {
+        // Real-input FFT of the zero-padded signal: the first fft_size/2+1
+        // bins are computed, the rest follow from conjugate symmetry
+        FFTPlan *plan = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+        if (!plan) return -1;
+        
+        double *padded = (double*)plan->scratch;
+        signal_view_gather(view, padded);
+        memset(padded + view->length, 0, (fft_size - view->length) * sizeof(double));
+        
+        fft_execute_r2c_split(plan, padded, real, imag);
+        fft_plan_release(plan);
+        
+        for (int i = fft_size / 2 + 1; i < length; i++) {
+            real[i] = real[fft_size - i];
+            imag[i] = -imag[fft_size - i];
         }
     }
     
-    if (estimated_length == 0) {
-        fclose(file);
-        return NULL;
+    for (int i = 0; i < length; i++) {
+        result->data[i].real = real[i];
+        result->data[i].imag = imag[i];
     }
     
-    // Create signal
-    Signal *signal = create_signal(estimated_length, sample_rate);
-    if (!signal) {
-        fclose(file);
-        return NULL;
+    // Derived spectra, each in its own loop so the unwanted ones cost
+    // nothing and the power spectrum needs no square root
+    if (result->magnitude) {
+        for (int i = 0; i < length; i++) {
+            result->magnitude[i] = sqrt(real[i] * real[i] + imag[i] * imag[i]);
+        }
     }
-    
-    // Second pass: read data
-    rewind(file);
-    int data_index = 0;
-    
-    while (fgets(line, sizeof(line), file) && data_index < estimated_length) {
-        if (line[0] != '#' && line[0] != 'T') {
-            double time, amplitude;
-            if (sscanf(line, "%lf,%lf", &time, &amplitude) == 2) {
-                signal->data[data_index] = amplitude;
-                data_index++;
-            }
+    if (result->power) {
+        for (int i = 0; i < length; i++) {
+            result->power[i] = real[i] * real[i] + imag[i] * imag[i];
+        }
+    }
+    if (result->phase) {
+        for (int i = 0; i < length; i++) {
+            result->phase[i] = atan2(imag[i], real[i]);
         }
     }
     
-    signal->length = data_index;
-    strcpy(signal->name, "Loaded from file");
+    // Frequency axis (as fft_frequency_axis, without going through its cache)
+    double freq_resolution = view->sample_rate / fft_size;
+    for (int i = 0; i < length; i++) {
+        result->frequency[i] = (i <= fft_size / 2) ? i * freq_resolution
+                                                   : (i - fft_size) * freq_resolution;
+    }
     
-    fclose(file);
-    return signal;
-}
\ No newline at end of file
+    CONV_STATS_STOP(CONV_STAT_SPECTRUM, stats_start, view->length);
+    return 0;
+}
+
+// Free FFT result memory (a single block from fft_result_create; arena
+// results are released by signal_arena_reset)
+void free_fft_result(FFTResult *result) {
+    if (result && result->storage == STORAGE_HEAP) {
+        free(result);
+    }
+}
@@ -0,0 +1,400 @@
+#include "../include/convolution.h"
+
+// Free the buffers of one stage and hand its plans back to the cache
+static void stage_free(ConvolverStage *stage) {
+    if (stage->segments) free(stage->segments);
+    if (stage->delay_line) free(stage->delay_line);
+    if (stage->accum) free(stage->accum);
+    if (stage->input) free(stage->input);
+    if (stage->overlap) free(stage->overlap);
+    if (stage->output) free(stage->output);
+    if (stage->head_taps) free(stage->head_taps);
+    if (stage->pending) free(stage->pending);
+    fft_plan_release(stage->forward);
+    fft_plan_release(stage->inverse);
+    memset(stage, 0, sizeof(ConvolverStage));
+}
+
+// Set up a stage for kernel taps [offset, offset + taps). A stage with a
+// non-zero offset must have offset >= block_size: its outputs are needed
+// `offset` samples after the input that produces them, which leaves time to
+// compute them once per full block.
+static int stage_init(ConvolverStage *stage, const double *kernel, int offset,
+                      int taps, int block_size, int segment_length) {
+    memset(stage, 0, sizeof(ConvolverStage));
+
+    int fft_size = next_power_of_2(block_size + segment_length - 1);
+    if (fft_size < 2) fft_size = 2;
+    int bins = fft_size / 2 + 1;
+
+    stage->offset = offset;
+    stage->block_size = block_size;
+    stage->segment_length = segment_length;
+    stage->segment_count = (taps + segment_length - 1) / segment_length;
+    stage->fft_size = fft_size;
+
+    // Each spectrum is a split block of 2 * bins doubles
+    int count = stage->segment_count;
+    int span = 2 * bins;
+    stage->segments = (double*)malloc((size_t)count * span * sizeof(double));
+    stage->delay_line = (double*)calloc((size_t)count * span, sizeof(double));
+    stage->accum = (double*)calloc(span, sizeof(double));
+    stage->input = (double*)calloc(block_size, sizeof(double));
+    stage->overlap = (double*)calloc(fft_size, sizeof(double));
+    stage->forward = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+    stage->inverse = fft_plan_acquire_real(fft_size, FFT_INVERSE);
+    if (offset > 0) {
+        stage->output = (double*)calloc(offset, sizeof(double));
+    } else {
+        stage->head_taps = (double*)calloc(block_size, sizeof(double));
+        stage->pending = (double*)calloc(block_size, sizeof(double));
+    }
+
+    if (!stage->segments || !stage->delay_line || !stage->accum || !stage->input ||
+        !stage->overlap || !stage->forward || !stage->inverse ||
+        (offset > 0 && !stage->output) ||
+        (offset == 0 && (!stage->head_taps || !stage->pending))) {
+        stage_free(stage);
+        return -1;
+    }
+
+    // Partial blocks reach at most block_size taps back into the block
+    if (offset == 0) {
+        int head = (segment_length < taps) ? segment_length : taps;
+        if (head > block_size) head = block_size;
+        for (int j = 0; j < head; j++) {
+            stage->head_taps[block_size - 1 - j] = kernel[j];
+        }
+    }
+
+    // Transform each partition, pre-scaled by 1/F for the inverse
+    double *buffer = (double*)stage->forward->scratch;
+    double scale = 1.0 / fft_size;
+
+    for (int p = 0; p < count; p++) {
+        int start = offset + p * segment_length;
+        int length = offset + taps - start;
+        if (length > segment_length) length = segment_length;
+
+        memcpy(buffer, kernel + start, length * sizeof(double));
+        memset(buffer + length, 0, (fft_size - length) * sizeof(double));
+
+        double *segment = stage->segments + (size_t)p * span;
+        fft_execute_r2c_split(stage->forward, buffer, segment, segment + bins);
+        for (int i = 0; i < span; i++) {
+            segment[i] *= scale;
+        }
+    }
+
+    return 0;
+}
+
+// Split spectrum of the delay-line entry `age` blocks before the current one
+static double* stage_block_spectrum(ConvolverStage *stage, int age) {
+    int span = stage->fft_size + 2;
+    int slot = (stage->current - age) % stage->segment_count;
+    if (slot < 0) slot += stage->segment_count;
+    return stage->delay_line + (size_t)slot * span;
+}
+
+// Split spectrum of partition p
+static const double* stage_segment(const ConvolverStage *stage, int p) {
+    return stage->segments + (size_t)p * (stage->fft_size + 2);
+}
+
+// Transform the first `filled` samples of the current block into its
+// delay-line slot and inverse-transform accum + X * H0 into the work buffer
+static double* stage_filter_current(ConvolverStage *stage, int filled, int include_accum) {
+    int fft_size = stage->fft_size;
+    int bins = fft_size / 2 + 1;
+    double *buffer = (double*)stage->forward->scratch;
+    double *spectrum = stage_block_spectrum(stage, 0);
+
+    memcpy(buffer, stage->input, filled * sizeof(double));
+    memset(buffer + filled, 0, (fft_size - filled) * sizeof(double));
+    fft_execute_r2c_split(stage->forward, buffer, spectrum, spectrum + bins);
+
+    // The work spectrum reuses the block buffer (F + 2 doubles)
+    double *work = buffer;
+    if (include_accum) {
+        memcpy(work, stage->accum, 2 * bins * sizeof(double));
+    } else {
+        memset(work, 0, 2 * bins * sizeof(double));
+    }
+    spectrum_multiply_accumulate_split(work, spectrum, stage_segment(stage, 0), bins);
+
+    fft_execute_c2r_split(stage->inverse, work, work + bins, buffer);
+    return buffer;
+}
+
+// A block has been completed: carry its tail into the overlap buffer, move
+// the delay line on and (for the head stage) pre-sum the earlier blocks'
+// contribution to the next block
+static void stage_advance(ConvolverStage *stage, const double *result, int presum) {
+    int block_size = stage->block_size;
+    int carry = stage->fft_size - block_size;
+    int bins = stage->fft_size / 2 + 1;
+
+    for (int i = 0; i < carry; i++) {
+        stage->overlap[i] = stage->overlap[block_size + i] + result[block_size + i];
+    }
+    memset(stage->overlap + carry, 0, block_size * sizeof(double));
+
+    stage->fill = 0;
+    stage->current = (stage->current + 1) % stage->segment_count;
+    stage->pending_valid = 0;
+
+    if (presum) {
+        memset(stage->accum, 0, 2 * bins * sizeof(double));
+        for (int p = 1; p < stage->segment_count; p++) {
+            spectrum_multiply_accumulate_split(stage->accum, stage_block_spectrum(stage, p),
+                                               stage_segment(stage, p), bins);
+        }
+    }
+}
+
+// Outputs [fill, filled) of a partial head block without transforming it:
+// the current block's samples against the first taps, directly, plus the
+// earlier blocks' part (IFFT of accum, once per block) and the overlap
+static void stage_head_partial(ConvolverStage *stage, int fill, int filled, double *out) {
+    int block_size = stage->block_size;
+
+    if (!stage->pending_valid) {
+        int bins = stage->fft_size / 2 + 1;
+        double *buffer = (double*)stage->forward->scratch;
+
+        memcpy(buffer, stage->accum, 2 * bins * sizeof(double));
+        fft_execute_c2r_split(stage->inverse, buffer, buffer + bins, buffer);
+        memcpy(stage->pending, buffer, block_size * sizeof(double));
+        stage->pending_valid = 1;
+    }
+
+    for (int t = fill; t < filled; t++) {
+        const double *taps = stage->head_taps + block_size - 1 - t;
+        double sum = 0.0;
+        for (int j = 0; j <= t; j++) {
+            sum += stage->input[j] * taps[j];
+        }
+        out[t - fill] = sum + stage->pending[t] + stage->overlap[t];
+    }
+}
+
+// Head stage: out[i] is written as soon as in[i] arrives. A call that ends
+// inside a block computes its outputs directly (O(n * block_size)); the
+// call that completes the block costs one FFT pair, as the earlier blocks
+// were pre-summed into accum.
+static void stage_process_head(ConvolverStage *stage, const double *in, int n, double *out) {
+    int done = 0;
+
+    while (done < n) {
+        int fill = stage->fill;
+        int count = n - done;
+        if (count > stage->block_size - fill) count = stage->block_size - fill;
+
+        if (in) {
+            memcpy(stage->input + fill, in + done, count * sizeof(double));
+        } else {
+            memset(stage->input + fill, 0, count * sizeof(double));
+        }
+
+        int filled = fill + count;
+        stage->fill = filled;
+        done += count;
+
+        if (filled < stage->block_size) {
+            stage_head_partial(stage, fill, filled, out + done - count);
+            continue;
+        }
+
+        double *result = stage_filter_current(stage, filled, 1);
+        for (int i = 0; i < count; i++) {
+            out[done - count + i] = result[fill + i] + stage->overlap[fill + i];
+        }
+        stage_advance(stage, result, 1);
+    }
+}
+
+// Delayed stage: outputs for the next `offset` samples are already in the
+// output ring, so input is only transformed once per full block. Adds the
+// stage's contribution into out.
+static void stage_process_delayed(ConvolverStage *stage, const double *in, int n, double *out) {
+    int done = 0;
+    int bins = stage->fft_size / 2 + 1;
+
+    while (done < n) {
+        int fill = stage->fill;
+        int count = n - done;
+        if (count > stage->block_size - fill) count = stage->block_size - fill;
+
+        for (int i = 0; i < count; i++) {
+            out[done + i] += stage->output[stage->output_pos];
+            stage->output[stage->output_pos] = 0.0;
+            stage->output_pos = (stage->output_pos + 1) % stage->offset;
+        }
+
+        if (in) {
+            memcpy(stage->input + fill, in + done, count * sizeof(double));
+        } else {
+            memset(stage->input + fill, 0, count * sizeof(double));
+        }
+
+        stage->fill = fill + count;
+        done += count;
+
+        if (stage->fill == stage->block_size) {
+            // Sum every partition against its delayed input block at once
+            double *buffer = (double*)stage->forward->scratch;
+            double *spectrum = stage_block_spectrum(stage, 0);
+
+            memcpy(buffer, stage->input, stage->block_size * sizeof(double));
+            memset(buffer + stage->block_size, 0,
+                   (stage->fft_size - stage->block_size) * sizeof(double));
+            fft_execute_r2c_split(stage->forward, buffer, spectrum, spectrum + bins);
+
+            double *work = buffer;
+            memset(work, 0, 2 * bins * sizeof(double));
+            for (int p = 0; p < stage->segment_count; p++) {
+                spectrum_multiply_accumulate_split(work, stage_block_spectrum(stage, p),
+                                                   stage_segment(stage, p), bins);
+            }
+            fft_execute_c2r_split(stage->inverse, work, work + bins, buffer);
+
+            // The block that just ended contributes to outputs
+            // offset - block_size .. offset - 1 samples from now
+            int start = stage->output_pos + stage->offset - stage->block_size;
+            for (int i = 0; i < stage->block_size; i++) {
+                stage->output[(start + i) % stage->offset] = buffer[i] + stage->overlap[i];
+            }
+
+            stage_advance(stage, buffer, 0);
+        }
+    }
+}
+
+// Build a convolver with a head stage for taps [0, head_taps) and, when
+// head_taps < M, a delayed tail stage for the rest
+static Convolver* convolver_build(const Signal *kernel, int head_block, int head_segment,
+                                  int head_taps, int tail_block) {
+    Convolver *convolver = (Convolver*)calloc(1, sizeof(Convolver));
+    if (!convolver) return NULL;
+
+    convolver->block_size = head_block;
+    convolver->kernel_length = kernel->length;
+    convolver->stage_count = 1;
+
+    if (stage_init(&convolver->stages[0], kernel->data, 0, head_taps,
+                   head_block, head_segment) < 0) {
+        free(convolver);
+        return NULL;
+    }
+
+    if (head_taps < kernel->length) {
+        convolver->stage_count = 2;
+        if (stage_init(&convolver->stages[1], kernel->data, head_taps,
+                       kernel->length - head_taps, tail_block, tail_block) < 0) {
+            convolver_destroy(convolver);
+            return NULL;
+        }
+    }
+
+    return convolver;
+}
+
+// Create a streaming convolver for a kernel. Input is gathered into blocks of
+// block_size samples (0 picks one from the kernel length) and each completed
+// block is transformed once. Every output sample is available as soon as its
+// input sample has been pushed: outputs inside an unfinished block are
+// computed directly from the block's samples.
+Convolver* convolver_create(const Signal *kernel, int block_size) {
+    if (!kernel || !kernel->data || kernel->length < 1) return NULL;
+
+    if (block_size <= 0) {
+        block_size = choose_block_fft_size(kernel->length) - kernel->length + 1;
+    }
+
+    return convolver_build(kernel, block_size, kernel->length, kernel->length, 0);
+}
+
+// Create a uniformly partitioned convolver: the kernel is cut into segments
+// of block_size taps, each transformed with a ~2*block_size FFT, and past
+// input spectra are kept in a frequency-domain delay line. The FFT size (and
+// so the block cost) no longer grows with the kernel length, which keeps the
+// block size small for long impulse responses.
+Convolver* convolver_create_partitioned(const Signal *kernel, int block_size) {
+    if (!kernel || !kernel->data || kernel->length < 1 || block_size < 1) return NULL;
+
+    return convolver_build(kernel, block_size, block_size, kernel->length, 0);
+}
+
+// Create a non-uniformly partitioned convolver: the first tail_block taps run
+// in a head stage with small head_block blocks (low latency), the rest in a
+// tail stage with large tail_block blocks (fewer, cheaper partitions). The
+// tail stage only computes when one of its blocks fills up.
+Convolver* convolver_create_nonuniform(const Signal *kernel, int head_block, int tail_block) {
+    if (!kernel || !kernel->data || kernel->length < 1) return NULL;
+    if (head_block < 1 || tail_block < head_block) return NULL;
+
+    int head_taps = (kernel->length < tail_block) ? kernel->length : tail_block;
+    return convolver_build(kernel, head_block, head_block, head_taps, tail_block);
+}
+
+// Free a convolver and hand its plans back to the cache
+void convolver_destroy(Convolver *convolver) {
+    if (convolver) {
+        for (int s = 0; s < convolver->stage_count; s++) {
+            stage_free(&convolver->stages[s]);
+        }
+        free(convolver);
+    }
+}
+
+// Push n input samples and write the n matching output samples, so that the
+// concatenated outputs equal the linear convolution of the concatenated
+// inputs. Chunk sizes are arbitrary; pushing whole blocks costs one FFT pair
+// per block. in may be NULL to push zeros. Returns n, or -1 on bad arguments.
+int convolver_process(Convolver *convolver, const double *in, int n, double *out) {
+    if (!convolver || n < 0 || (n > 0 && !out)) return -1;
+    CONV_STATS_START(stats_start);
+
+    stage_process_head(&convolver->stages[0], in, n, out);
+    if (convolver->stage_count > 1) {
+        stage_process_delayed(&convolver->stages[1], in, n, out);
+    }
+
+    CONV_STATS_STOP(CONV_STAT_STREAM, stats_start, n);
+    return n;
+}
+
+// Write the kernel_length - 1 output samples still pending after the last
+// input (the convolution tail), then reset. Returns the number written.
+int convolver_flush(Convolver *convolver, double *out) {
+    if (!convolver) return -1;
+
+    int tail = convolver->kernel_length - 1;
+    if (convolver_process(convolver, NULL, tail, out) < 0) return -1;
+
+    convolver_reset(convolver);
+    return tail;
+}
+
+// Drop all buffered input and pending tails
+void convolver_reset(Convolver *convolver) {
+    if (!convolver) return;
+
+    for (int s = 0; s < convolver->stage_count; s++) {
+        ConvolverStage *stage = &convolver->stages[s];
+        int bins = stage->fft_size / 2 + 1;
+
+        stage->fill = 0;
+        stage->current = 0;
+        stage->output_pos = 0;
+        stage->pending_valid = 0;
+        memset(stage->delay_line, 0, (size_t)stage->segment_count * 2 * bins * sizeof(double));
+        memset(stage->accum, 0, 2 * bins * sizeof(double));
+        memset(stage->input, 0, stage->block_size * sizeof(double));
+        memset(stage->overlap, 0, stage->fft_size * sizeof(double));
+        if (stage->output) {
+            memset(stage->output, 0, stage->offset * sizeof(double));
+        }
+    }
+}
@@ -0,0 +1,453 @@
+#include "../include/convolution.h"
+
+// Cross-correlation r[k] = sum_n x[n + k] y[n] for lags k in
+// [-(M - 1), N - 1]. A full result stores lag k at index k + M - 1, the
+// layout of convolving with the reversed template, so the ConvMode crops
+// of convolve_with_algorithm apply unchanged.
+
+// Scores below this fraction of the block energy are treated as silence:
+// the correlation there is FFT rounding noise
+#define MATCHED_SILENCE 1e-20
+
+// First index and length a mode keeps of a full n x m result
+static void mode_range(ConvMode mode, int n, int m, int *start, int *length) {
+    int shorter = (n < m) ? n : m;
+    int longer = (n < m) ? m : n;
+
+    switch (mode) {
+        case CONV_MODE_SAME:
+            *start = (m - 1) / 2;
+            *length = n;
+            break;
+        case CONV_MODE_VALID:
+            *start = shorter - 1;
+            *length = longer - shorter + 1;
+            break;
+        default:
+            *start = 0;
+            *length = n + m - 1;
+            break;
+    }
+}
+
+// Copy of a signal with its samples in reverse order
+static Signal* reversed_signal(const Signal *signal) {
+    Signal *reversed = create_signal(signal->length, signal->sample_rate);
+    if (!reversed) return NULL;
+
+    for (int i = 0; i < signal->length; i++) {
+        reversed->data[i] = signal->data[signal->length - 1 - i];
+    }
+    return reversed;
+}
+
+// Full indices [start, start + length) of the correlation through one
+// circular correlation of period fft_size >= n + m - 1: X * conj(Y), so no
+// reversed copy of the template is made
+static int correlate_fft(double *output, int start, int length,
+                         const Signal *signal, const Signal *template_signal) {
+    int n = signal->length;
+    int m = template_signal->length;
+    int fft_size = fft_next_fast_size_real(n + m - 1);
+
+    FFTPlan *forward = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+    FFTPlan *inverse = fft_plan_acquire_real(fft_size, FFT_INVERSE);
+    if (!forward || !inverse) {
+        fft_plan_release(forward);
+        fft_plan_release(inverse);
+        return -1;
+    }
+
+    int bins = fft_size / 2 + 1;
+    double *fft1 = (double*)forward->scratch;
+    double *fft2 = (double*)inverse->scratch;
+
+    memcpy(fft1, signal->data, n * sizeof(double));
+    memset(fft1 + n, 0, (fft_size - n) * sizeof(double));
+    memcpy(fft2, template_signal->data, m * sizeof(double));
+    memset(fft2 + m, 0, (fft_size - m) * sizeof(double));
+
+    fft_execute_r2c_split(forward, fft1, fft1, fft1 + bins);
+    fft_execute_r2c_split(forward, fft2, fft2, fft2 + bins);
+
+    // Conjugate the template spectrum and fold in the 1/N of the inverse
+    double scale = 1.0 / fft_size;
+    for (int i = 0; i < bins; i++) {
+        fft2[i] *= scale;
+        fft2[bins + i] *= -scale;
+    }
+    spectrum_multiply_split(fft1, fft2, bins);
+    fft_execute_c2r_split(inverse, fft1, fft1 + bins, fft1);
+
+    // Negative lags wrapped around to the end of the period
+    for (int i = 0; i < length; i++) {
+        int lag = start + i - (m - 1);
+        output[i] = fft1[lag < 0 ? lag + fft_size : lag];
+    }
+
+    fft_plan_release(forward);
+    fft_plan_release(inverse);
+    return 0;
+}
+
+// Cross-correlation of signal with template_signal over the lags the mode
+// keeps (FULL: all N + M - 1, lag k at index k + M - 1). The cost model
+// picks the algorithm; the FFT path multiplies by the conjugate template
+// spectrum, the direct and block paths convolve with the reversed template.
+Signal* correlate(const Signal *signal, const Signal *template_signal, ConvMode mode) {
+    if (!signal || !template_signal || signal->length < 1 || template_signal->length < 1) {
+        return NULL;
+    }
+    CONV_STATS_START(stats_start);
+
+    int n = signal->length;
+    int m = template_signal->length;
+    Signal *result = NULL;
+
+    ConvAlgorithm algorithm = conv_select_algorithm(n, m);
+    if (algorithm == CONV_ALGO_FFT) {
+        int start, length;
+        mode_range(mode, n, m, &start, &length);
+
+        result = create_signal(length, signal->sample_rate);
+        if (!result) return NULL;
+
+        if (correlate_fft(result->data, start, length, signal, template_signal) != 0) {
+            free_signal(result);
+            return NULL;
+        }
+    } else {
+        Signal *reversed = reversed_signal(template_signal);
+        if (!reversed) return NULL;
+
+        result = convolve_with_algorithm(signal, reversed, mode, algorithm);
+        free_signal(reversed);
+        if (!result) return NULL;
+    }
+
+    result->type = SIGNAL_CUSTOM;
+    snprintf(result->name, sizeof(result->name),
+             "Corr(%.27s, %.27s)", signal->name, template_signal->name);
+
+    CONV_STATS_STOP(CONV_STAT_CORRELATE, stats_start, result->length);
+    return result;
+}
+
+// r[k] for k in [0, lags) by direct summation
+static void autocorrelate_direct(const double *x, int n, int lags, double *output) {
+    for (int k = 0; k < lags; k++) {
+        double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+        int count = n - k;
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            sum0 += x[i] * x[i + k];
+            sum1 += x[i + 1] * x[i + 1 + k];
+            sum2 += x[i + 2] * x[i + 2 + k];
+            sum3 += x[i + 3] * x[i + 3 + k];
+        }
+        for (; i < count; i++) {
+            sum0 += x[i] * x[i + k];
+        }
+        output[k] = (sum0 + sum1) + (sum2 + sum3);
+    }
+}
+
+// r[k] for k in [0, lags) from the power spectrum: one forward and one
+// inverse transform of period >= n + lags - 1, so lags never wrap
+static int autocorrelate_fft(const double *x, int n, int lags, double *output) {
+    int fft_size = fft_next_fast_size_real(n + lags - 1);
+
+    FFTPlan *forward = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+    FFTPlan *inverse = fft_plan_acquire_real(fft_size, FFT_INVERSE);
+    if (!forward || !inverse) {
+        fft_plan_release(forward);
+        fft_plan_release(inverse);
+        return -1;
+    }
+
+    int bins = fft_size / 2 + 1;
+    double *buffer = (double*)forward->scratch;
+
+    memcpy(buffer, x, n * sizeof(double));
+    memset(buffer + n, 0, (fft_size - n) * sizeof(double));
+    fft_execute_r2c_split(forward, buffer, buffer, buffer + bins);
+
+    double scale = 1.0 / fft_size;
+    for (int i = 0; i < bins; i++) {
+        double re = buffer[i];
+        double im = buffer[bins + i];
+        buffer[i] = (re * re + im * im) * scale;
+        buffer[bins + i] = 0.0;
+    }
+    fft_execute_c2r_split(inverse, buffer, buffer + bins, buffer);
+    memcpy(output, buffer, lags * sizeof(double));
+
+    fft_plan_release(forward);
+    fft_plan_release(inverse);
+    return 0;
+}
+
+// Autocorrelation r[k] = sum_n x[n] x[n + k] for lags 0..max_lag (the
+// negative lags mirror these). max_lag < 0 or >= N gives all N lags.
+Signal* autocorrelate(const Signal *signal, int max_lag) {
+    if (!signal || signal->length < 1) return NULL;
+    CONV_STATS_START(stats_start);
+
+    int n = signal->length;
+    int lags = (max_lag < 0 || max_lag >= n) ? n : max_lag + 1;
+
+    Signal *result = create_signal(lags, signal->sample_rate);
+    if (!result) return NULL;
+
+    result->type = SIGNAL_CUSTOM;
+    snprintf(result->name, sizeof(result->name), "AutoCorr(%.48s)", signal->name);
+
+    // The FFT path needs one transform fewer than an FFT convolution, so
+    // the convolution cost model errs towards direct summation
+    if (conv_estimate_cost(CONV_ALGO_DIRECT, n, lags) <= conv_estimate_cost(CONV_ALGO_FFT, n, lags)) {
+        autocorrelate_direct(signal->data, n, lags, result->data);
+    } else if (autocorrelate_fft(signal->data, n, lags, result->data) != 0) {
+        free_signal(result);
+        return NULL;
+    }
+
+    CONV_STATS_STOP(CONV_STAT_CORRELATE, stats_start, lags);
+    return result;
+}
+
+// Create a streaming matched filter for a template. Each block of
+// block_length input samples (0 picks a size from the template length)
+// costs one forward and one inverse real FFT against the cached conjugate
+// template spectrum. threshold > 0 enables detection on the normalized
+// score r / sqrt(E_x E_y), where E_x is the energy of the stream under the
+// template.
+MatchedFilter* matched_filter_create(const Signal *template_signal, int block_length,
+                                     double threshold) {
+    if (!template_signal || !template_signal->data || template_signal->length < 1) return NULL;
+    if (block_length < 0) return NULL;
+
+    int m = template_signal->length;
+    int fft_size = (block_length > 0) ? fft_next_fast_size_real(block_length + m - 1)
+                                      : choose_block_fft_size(m);
+
+    MatchedFilter *filter = (MatchedFilter*)calloc(1, sizeof(MatchedFilter));
+    if (!filter) return NULL;
+
+    filter->template_length = m;
+    filter->block_length = fft_size - m + 1;
+    filter->threshold = (threshold > 0.0) ? threshold : 0.0;
+
+    for (int i = 0; i < m; i++) {
+        filter->template_energy += template_signal->data[i] * template_signal->data[i];
+    }
+
+    // Transform the template before this filter holds plans of its size
+    filter->spectrum = kernel_spectrum_create(template_signal->data, m, fft_size);
+    filter->window = (double*)calloc(fft_size, sizeof(double));
+    filter->forward = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+    filter->inverse = fft_plan_acquire_real(fft_size, FFT_INVERSE);
+
+    if (!filter->spectrum || !filter->window || !filter->forward || !filter->inverse) {
+        matched_filter_destroy(filter);
+        return NULL;
+    }
+
+    // Correlation: multiply by conj(Y) instead of Y
+    int bins = fft_size / 2 + 1;
+    for (int i = 0; i < bins; i++) {
+        filter->spectrum->bins[bins + i] = -filter->spectrum->bins[bins + i];
+    }
+
+    return filter;
+}
+
+// Free a matched filter and hand its plans back to the cache
+void matched_filter_destroy(MatchedFilter *filter) {
+    if (filter) {
+        kernel_spectrum_free(filter->spectrum);
+        if (filter->window) free(filter->window);
+        if (filter->detections) free(filter->detections);
+        fft_plan_release(filter->forward);
+        fft_plan_release(filter->inverse);
+        free(filter);
+    }
+}
+
+// Queue the peak of a finished run
+static void matched_filter_emit(MatchedFilter *filter) {
+    if (filter->detection_count == filter->detection_capacity) {
+        int capacity = filter->detection_capacity ? 2 * filter->detection_capacity : 16;
+        MatchedFilterDetection *grown = (MatchedFilterDetection*)realloc(
+            filter->detections, capacity * sizeof(MatchedFilterDetection));
+        if (!grown) return;  // Drop the detection rather than the stream
+
+        filter->detections = grown;
+        filter->detection_capacity = capacity;
+    }
+    filter->detections[filter->detection_count++] = filter->peak;
+}
+
+// Score the first count outputs of a block and track runs above the
+// threshold. Output k covers window samples [k, k + M).
+static void matched_filter_detect(MatchedFilter *filter, const double *result, int count) {
+    int m = filter->template_length;
+    const double *window = filter->window;
+
+    double block_energy = 0.0;
+    for (int i = 0; i < count + m - 1; i++) {
+        block_energy += window[i] * window[i];
+    }
+    double silence = MATCHED_SILENCE * block_energy;
+
+    // Energy under the template, slid one sample per output
+    double energy = 0.0;
+    for (int i = 0; i < m; i++) {
+        energy += window[i] * window[i];
+    }
+
+    for (int k = 0; k < count; k++) {
+        if (k > 0) {
+            energy += window[k + m - 1] * window[k + m - 1] - window[k - 1] * window[k - 1];
+        }
+
+        double score = 0.0;
+        if (energy > silence && filter->template_energy > 0.0) {
+            score = result[k] / sqrt(energy * filter->template_energy);
+            if (score > 1.0) score = 1.0;
+            if (score < -1.0) score = -1.0;
+        }
+
+        if (score >= filter->threshold) {
+            if (!filter->in_run || score > filter->peak.score) {
+                filter->peak.position = filter->produced + k - (m - 1);
+                filter->peak.score = score;
+                filter->peak.correlation = result[k];
+            }
+            filter->in_run = 1;
+        } else if (filter->in_run) {
+            matched_filter_emit(filter);
+            filter->in_run = 0;
+        }
+    }
+}
+
+// Correlate the current window with the template and write its first
+// count outputs, then keep the last M - 1 samples as the next history
+static void matched_filter_block(MatchedFilter *filter, int count, double *out) {
+    int fft_size = filter->spectrum->fft_size;
+    int bins = fft_size / 2 + 1;
+    double *buffer = (double*)filter->forward->scratch;
+
+    memcpy(buffer, filter->window, fft_size * sizeof(double));
+    fft_execute_r2c_split(filter->forward, buffer, buffer, buffer + bins);
+    spectrum_multiply_split(buffer, filter->spectrum->bins, bins);
+    fft_execute_c2r_split(filter->inverse, buffer, buffer + bins, buffer);
+
+    // Circular lags 0..block_length-1 never wrap: they are the block's outputs
+    if (out) memcpy(out, buffer, count * sizeof(double));
+    if (filter->threshold > 0.0) matched_filter_detect(filter, buffer, count);
+
+    filter->produced += count;
+    filter->fill = 0;
+    memmove(filter->window, filter->window + filter->block_length,
+            (filter->template_length - 1) * sizeof(double));
+}
+
+// Push n input samples. Outputs are written a block at a time: output i of
+// the stream is full-correlation index i (the template ending at input
+// sample i), so the concatenated outputs and flush equal correlate(x, y,
+// CONV_MODE_FULL). out may be NULL when only detections are wanted;
+// otherwise it needs room for n + block_length - 1 values. in may be NULL
+// to push zeros. Returns the number of outputs written, or -1 on error.
+int matched_filter_process(MatchedFilter *filter, const double *in, int n, double *out) {
+    if (!filter || n < 0) return -1;
+    CONV_STATS_START(stats_start);
+
+    int history = filter->template_length - 1;
+    int written = 0;
+    int done = 0;
+
+    while (done < n) {
+        int count = n - done;
+        if (count > filter->block_length - filter->fill) {
+            count = filter->block_length - filter->fill;
+        }
+
+        double *slot = filter->window + history + filter->fill;
+        if (in) {
+            memcpy(slot, in + done, count * sizeof(double));
+        } else {
+            memset(slot, 0, count * sizeof(double));
+        }
+        filter->fill += count;
+        done += count;
+
+        if (filter->fill == filter->block_length) {
+            matched_filter_block(filter, filter->block_length, out ? out + written : NULL);
+            written += filter->block_length;
+        }
+    }
+
+    CONV_STATS_STOP(CONV_STAT_MATCHED, stats_start, written);
+    return written;
+}
+
+// Write the outputs still pending after the last input (the buffered
+// partial block and the template_length - 1 tail), close an open
+// detection run and restart the stream. Collected detections are kept.
+// out needs room for block_length + template_length - 2 values.
+// Returns the number written.
+int matched_filter_flush(MatchedFilter *filter, double *out) {
+    if (!filter) return -1;
+
+    int written = matched_filter_process(filter, NULL, filter->template_length - 1, out);
+    if (written < 0) return -1;
+
+    if (filter->fill > 0) {
+        int history = filter->template_length - 1;
+        int fft_size = filter->spectrum->fft_size;
+        memset(filter->window + history + filter->fill, 0,
+               (fft_size - history - filter->fill) * sizeof(double));
+
+        int count = filter->fill;
+        matched_filter_block(filter, count, out ? out + written : NULL);
+        written += count;
+    }
+
+    if (filter->in_run) matched_filter_emit(filter);
+
+    int detections = filter->detection_count;
+    matched_filter_reset(filter);
+    filter->detection_count = detections;
+
+    return written;
+}
+
+// Move up to max_detections queued detections, oldest first, into
+// detections. Returns the number moved.
+int matched_filter_detections(MatchedFilter *filter, MatchedFilterDetection *detections,
+                              int max_detections) {
+    if (!filter || !detections || max_detections < 0) return -1;
+
+    int count = (filter->detection_count < max_detections) ? filter->detection_count
+                                                           : max_detections;
+    if (count == 0) return 0;
+
+    memcpy(detections, filter->detections, count * sizeof(MatchedFilterDetection));
+    memmove(filter->detections, filter->detections + count,
+            (filter->detection_count - count) * sizeof(MatchedFilterDetection));
+    filter->detection_count -= count;
+
+    return count;
+}
+
+// Drop all buffered input, the open run and queued detections
+void matched_filter_reset(MatchedFilter *filter) {
+    if (!filter) return;
+
+    memset(filter->window, 0, filter->spectrum->fft_size * sizeof(double));
+    filter->fill = 0;
+    filter->produced = 0;
+    filter->in_run = 0;
+    filter->detection_count = 0;
+}
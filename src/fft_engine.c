@@ -0,0 +1,1412 @@
+#include "../include/convolution.h"
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FFT_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Full-precision 2*pi for twiddle factors. The rounded TWO_PI from the header
+// makes w^n drift away from 1, which shows up as ~1e-13 round-trip error.
+#define FFT_TWO_PI 6.28318530717958647692
+
+// Transforms at least this large split each pass across the thread pool
+#define FFT_PARALLEL_MIN_SIZE 65536
+
+// Butterflies per parallel task
+#define FFT_PARALLEL_CHUNK 8192
+
+// Idle plans waiting to be handed out again, newest first
+static FFTPlan *plan_cache = NULL;
+static pthread_mutex_t plan_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Frequency axis of an fft_size-point transform at one sample rate. Tables
+// are shared by every fft_frequency_axis caller asking for that size and
+// rate and live until fft_frequency_axis_cache_clear.
+typedef struct FrequencyAxis {
+    int fft_size;
+    double sample_rate;
+    double *bins;
+    struct FrequencyAxis *next;
+} FrequencyAxis;
+
+static FrequencyAxis *axis_cache = NULL;
+static pthread_mutex_t axis_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Per-thread staging buffers, grown on demand: one holds the packed
+// half-length signal of the real transforms, the other converts interleaved
+// data at the Complex entry points. They are per thread rather than per plan
+// so that one plan can run on several pool threads at once.
+typedef struct {
+    double *data;
+    size_t capacity;
+} WorkBuffer;
+
+static __thread WorkBuffer packed_work;
+static __thread WorkBuffer boundary_work;
+
+// Ping-pong buffer of mixed-radix passes, and the padded sequence of
+// Bluestein plans (whose own sub-plans may be mixed-radix)
+static __thread WorkBuffer stage_work;
+static __thread WorkBuffer chirp_work;
+
+// Frees a thread's staging buffers when it exits
+static pthread_key_t work_key;
+static pthread_once_t work_key_once = PTHREAD_ONCE_INIT;
+
+static void work_buffers_free(void *unused) {
+    (void)unused;
+    free(packed_work.data);
+    free(boundary_work.data);
+    free(stage_work.data);
+    free(chirp_work.data);
+    packed_work.data = boundary_work.data = stage_work.data = chirp_work.data = NULL;
+    packed_work.capacity = boundary_work.capacity = 0;
+    stage_work.capacity = chirp_work.capacity = 0;
+}
+
+static void work_key_create(void) {
+    pthread_key_create(&work_key, work_buffers_free);
+}
+
+static double* work_buffer(WorkBuffer *buffer, size_t count) {
+    if (count > buffer->capacity) {
+        // The destructor only runs for threads with a non-NULL key value
+        pthread_once(&work_key_once, work_key_create);
+        pthread_setspecific(work_key, &packed_work);
+
+        double *grown = (double*)realloc(buffer->data, count * sizeof(double));
+        if (!grown) return NULL;
+        buffer->data = grown;
+        buffer->capacity = count;
+    }
+    return buffer->data;
+}
+
+// Helper function to find next power of 2
+int next_power_of_2(int n) {
+    int power = 1;
+    while (power < n) {
+        power *= 2;
+    }
+    return power;
+}
+
+static int smooth_radices(int n, int *radices);
+
+// Relative cost per point and per bit of radix of a pass (power-of-2 SIMD
+// passes = 1). Measured: radix 3 keeps pace with the vector passes, 5 and
+// 7 do not.
+static double radix_weight(int radix) {
+    switch (radix) {
+        case 5:  return 1.6;
+        case 7:  return 2.0;
+        default: return 1.0;
+    }
+}
+
+// Estimated work of an n-point complex transform in units of a power-of-2
+// transform's n*log2(n)
+double fft_transform_work(int n) {
+    if (n < 2) return 1.0;
+
+    int radices[FFT_MAX_STAGES];
+    int count = (n & (n - 1)) == 0 ? 0 : smooth_radices(n, radices);
+
+    if ((n & (n - 1)) == 0 || count > 0) {
+        double work = 0.0;
+        int rest = n;
+        for (int s = 0; s < count; s++) {
+            work += radix_weight(radices[s]) * log2((double)radices[s]);
+            rest /= radices[s];
+        }
+        return (double)n * (work + log2((double)rest));
+    }
+
+    // Bluestein: two convolution-length transforms plus the chirp products
+    int size = fft_next_fast_size(2 * n - 1);
+    return 2.0 * fft_transform_work(size) + 4.0 * size;
+}
+
+// Cheapest size >= n, by fft_transform_work, of the form 2^a 3^b 5^c 7^d.
+// Never larger than next_power_of_2(n).
+int fft_next_fast_size(int n) {
+    if (n <= 1) return 1;
+
+    int limit = next_power_of_2(n);
+    int best = limit;
+    double best_work = fft_transform_work(limit);
+
+    for (long long p7 = 1; p7 < limit; p7 *= 7) {
+        for (long long p5 = p7; p5 < limit; p5 *= 5) {
+            for (long long p3 = p5; p3 < limit; p3 *= 3) {
+                // Smallest power-of-2 multiple reaching n
+                long long size = p3;
+                while (size < n) size *= 2;
+                if (size >= limit) continue;
+
+                double work = fft_transform_work((int)size);
+                if (work < best_work || (work == best_work && size < best)) {
+                    best = (int)size;
+                    best_work = work;
+                }
+            }
+        }
+    }
+
+    return best;
+}
+
+// Cheapest even size >= n for real transforms, which run a complex
+// transform of half the size
+int fft_next_fast_size_real(int n) {
+    if (n <= 2) return 2;
+    return 2 * fft_next_fast_size((n + 1) / 2);
+}
+
+// Build the split per-pass twiddle table. Each radix-4 pass of quarter
+// length q stores six rows of q values: real(w), imag(w), real(w^2),
+// imag(w^2), real(w^3), imag(w^3) for k = 0..q-1; the radix-2 tail (if any)
+// stores real(w^k) then imag(w^k) for k = 0..n/2-1 after them. With every
+// row contiguous in k, a vector of butterflies loads its twiddles directly.
+static void fill_twiddles(double *twiddles, int n, int direction) {
+    double *w = twiddles;
+
+    int q = 1;
+    while (4 * q <= n) {
+        for (int k = 0; k < q; k++) {
+            double angle = direction * FFT_TWO_PI * k / (4 * q);
+            for (int m = 1; m <= 3; m++) {
+                w[(2 * m - 2) * q + k] = cos(m * angle);
+                w[(2 * m - 1) * q + k] = sin(m * angle);
+            }
+        }
+        w += 6 * q;
+        q *= 4;
+    }
+
+    if (q < n) {
+        for (int k = 0; k < n / 2; k++) {
+            double angle = direction * FFT_TWO_PI * k / n;
+            w[k] = cos(angle);
+            w[n / 2 + k] = sin(angle);
+        }
+    }
+}
+
+// Radices of a mixed-radix plan: 4s, at most one 2, then 3s, 5s and 7s.
+// Returns the pass count, or 0 if n has a prime factor above 7.
+static int smooth_radices(int n, int *radices) {
+    static const int primes[] = {3, 5, 7};
+    int count = 0;
+
+    while (n % 4 == 0) {
+        radices[count++] = 4;
+        n /= 4;
+    }
+    if (n % 2 == 0) {
+        radices[count++] = 2;
+        n /= 2;
+    }
+    for (int p = 0; p < 3; p++) {
+        while (n % primes[p] == 0) {
+            radices[count++] = primes[p];
+            n /= primes[p];
+        }
+    }
+
+    return n == 1 ? count : 0;
+}
+
+// Mixed-radix plan: one Stockham pass per radix (no bit reversal). Pass s
+// of radix r splits each of l sub-transforms of length r*m into r of
+// length m and stores twiddle rows w^(t*k), k = 1..r-1, t = 0..m-1, with
+// w = exp(direction * 2*pi*i / (r*m)): r-1 rows of real parts, then r-1
+// rows of imaginary parts.
+static FFTPlan* create_mixed_plan(FFTPlan *plan, const int *radices, int count) {
+    int n = plan->n;
+    size_t table = 0;
+
+    int m = n;
+    for (int s = 0; s < count; s++) {
+        m /= radices[s];
+        table += 2 * (size_t)(radices[s] - 1) * m;
+        plan->radices[s] = radices[s];
+    }
+    plan->stage_count = count;
+
+    plan->twiddles = (double*)malloc((table + 1) * sizeof(double));
+    if (!plan->twiddles) return NULL;
+
+    double *w = plan->twiddles;
+    int length = n;
+    for (int s = 0; s < count; s++) {
+        int r = radices[s];
+        m = length / r;
+        for (int k = 1; k < r; k++) {
+            for (int t = 0; t < m; t++) {
+                // t*k < length, so the angle stays in one turn
+                double angle = plan->direction * FFT_TWO_PI * (double)(t * k) / length;
+                w[(k - 1) * m + t] = cos(angle);
+                w[(r - 1 + k - 1) * m + t] = sin(angle);
+            }
+        }
+        w += 2 * (size_t)(r - 1) * m;
+        length = m;
+    }
+
+    CONV_STATS_ALLOC((table + 1) * sizeof(double));
+    return plan;
+}
+
+// Bluestein plan: X[k] = c[k] * sum_t (x[t] c[t]) conj(c[k - t]) with the
+// chirp c[t] = exp(direction * pi*i * t^2 / n), a linear convolution run
+// as a chirp_size-point circular one (chirp_size >= 2n - 1, a fast size)
+static FFTPlan* create_bluestein_plan(FFTPlan *plan) {
+    int n = plan->n;
+    if (n > (1 << 29)) return NULL;
+
+    int size = fft_next_fast_size(2 * n - 1);
+    plan->chirp_size = size;
+    plan->chirp = (double*)malloc((2 * (size_t)n + 2 * (size_t)size) * sizeof(double));
+    plan->chirp_forward = fft_plan_create(size, FFT_FORWARD);
+    plan->chirp_inverse = fft_plan_create(size, FFT_INVERSE);
+    if (!plan->chirp || !plan->chirp_forward || !plan->chirp_inverse) return NULL;
+
+    double *c_real = plan->chirp;
+    double *c_imag = plan->chirp + n;
+    double *b_real = plan->chirp + 2 * n;
+    double *b_imag = b_real + size;
+
+    for (int t = 0; t < n; t++) {
+        // t^2 mod 2n keeps the angle within one turn
+        long long square = (long long)t * t % (2 * (long long)n);
+        double angle = plan->direction * (FFT_TWO_PI / 2) * (double)square / n;
+        c_real[t] = cos(angle);
+        c_imag[t] = sin(angle);
+    }
+
+    // conj(c) at offsets -(n-1)..n-1, wrapped, transformed and scaled by
+    // 1/size so the inverse transform needs no normalization
+    memset(b_real, 0, 2 * (size_t)size * sizeof(double));
+    double scale = 1.0 / size;
+    b_real[0] = c_real[0] * scale;
+    b_imag[0] = -c_imag[0] * scale;
+    for (int t = 1; t < n; t++) {
+        b_real[t] = b_real[size - t] = c_real[t] * scale;
+        b_imag[t] = b_imag[size - t] = -c_imag[t] * scale;
+    }
+    fft_execute_split(plan->chirp_forward, b_real, b_imag);
+
+    CONV_STATS_ALLOC((2 * (size_t)n + 2 * (size_t)size) * sizeof(double));
+    return plan;
+}
+
+// Create a complex FFT plan of any size n >= 1
+FFTPlan* fft_plan_create(int n, int direction) {
+    if (n < 1) return NULL;
+    if (direction != FFT_FORWARD && direction != FFT_INVERSE) return NULL;
+
+    FFTPlan *plan = (FFTPlan*)calloc(1, sizeof(FFTPlan));
+    if (!plan) return NULL;
+
+    if ((n & (n - 1)) != 0) {
+        int radices[FFT_MAX_STAGES];
+        int count = smooth_radices(n, radices);
+
+        plan->n = n;
+        plan->direction = direction;
+        plan->scratch = (Complex*)malloc(n * sizeof(Complex));
+        FFTPlan *built = !plan->scratch ? NULL
+                       : count > 0 ? create_mixed_plan(plan, radices, count)
+                                   : create_bluestein_plan(plan);
+        if (!built) {
+            fft_plan_destroy(plan);
+            return NULL;
+        }
+        CONV_STATS_ALLOC(sizeof(FFTPlan) + n * sizeof(Complex));
+        return plan;
+    }
+
+    plan->n = n;
+    plan->direction = direction;
+    plan->bit_reverse = (int*)malloc(n * sizeof(int));
+    plan->twiddles = (double*)malloc((3 * (size_t)n + 2) * sizeof(double));
+    plan->scratch = (Complex*)malloc(n * sizeof(Complex));
+
+    if (!plan->bit_reverse || !plan->twiddles || !plan->scratch) {
+        fft_plan_destroy(plan);
+        return NULL;
+    }
+
+    // Bit-reversal permutation
+    plan->bit_reverse[0] = 0;
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        plan->bit_reverse[i] = j;
+    }
+
+    fill_twiddles(plan->twiddles, n, direction);
+    CONV_STATS_ALLOC(sizeof(FFTPlan) + n * (sizeof(int) + sizeof(Complex)) +
+                     (3 * (size_t)n + 2) * sizeof(double));
+
+    return plan;
+}
+
+// Create a real-input plan for a size n >= 2. A forward plan maps n real
+// samples to the n/2+1 non-redundant bins (fft_execute_r2c), an inverse plan
+// maps them back (fft_execute_c2r). Even sizes run one n/2-point complex FFT;
+// odd sizes cannot be packed and run an n-point one.
+FFTPlan* fft_plan_create_real(int n, int direction) {
+    if (n < 2) return NULL;
+    if (direction != FFT_FORWARD && direction != FFT_INVERSE) return NULL;
+
+    FFTPlan *plan = (FFTPlan*)calloc(1, sizeof(FFTPlan));
+    if (!plan) return NULL;
+
+    int half = n / 2;
+    int split = half / 2 + 1;
+    plan->n = n;
+    plan->direction = direction;
+    plan->is_real = 1;
+
+    if (n % 2) {
+        plan->half = fft_plan_create(n, direction);
+        plan->scratch = (Complex*)malloc((half + 1) * sizeof(Complex));
+        if (!plan->half || !plan->scratch) {
+            fft_plan_destroy(plan);
+            return NULL;
+        }
+        CONV_STATS_ALLOC(sizeof(FFTPlan) + (half + 1) * sizeof(Complex));
+        return plan;
+    }
+    plan->half = fft_plan_create(half, direction);
+    plan->twiddles = (double*)malloc(2 * split * sizeof(double));
+    plan->scratch = (Complex*)malloc((half + 1) * sizeof(Complex));
+
+    if (!plan->half || !plan->twiddles || !plan->scratch) {
+        fft_plan_destroy(plan);
+        return NULL;
+    }
+
+    // Split twiddles w^k = exp(direction * 2*pi*i*k/n) for k = 0..n/4:
+    // real parts, then imaginary parts
+    for (int k = 0; k < split; k++) {
+        double angle = direction * FFT_TWO_PI * k / n;
+        plan->twiddles[k] = cos(angle);
+        plan->twiddles[split + k] = sin(angle);
+    }
+    CONV_STATS_ALLOC(sizeof(FFTPlan) + 2 * split * sizeof(double) + (half + 1) * sizeof(Complex));
+
+    return plan;
+}
+
+// Free an FFT plan (plans from fft_plan_acquire go back via fft_plan_release)
+void fft_plan_destroy(FFTPlan *plan) {
+    if (plan) {
+        if (plan->bit_reverse) free(plan->bit_reverse);
+        if (plan->twiddles) free(plan->twiddles);
+        if (plan->scratch) free(plan->scratch);
+        free(plan->chirp);
+        fft_plan_destroy(plan->half);
+        fft_plan_destroy(plan->chirp_forward);
+        fft_plan_destroy(plan->chirp_inverse);
+        free(plan);
+    }
+}
+
+// Twiddle rows of one radix-4 pass (see fill_twiddles)
+typedef struct {
+    const double *w1_real, *w1_imag;
+    const double *w2_real, *w2_imag;
+    const double *w3_real, *w3_imag;
+} Radix4Twiddles;
+
+static Radix4Twiddles radix4_twiddles(const double *w, int q) {
+    Radix4Twiddles t = {w, w + q, w + 2 * q, w + 3 * q, w + 4 * q, w + 5 * q};
+    return t;
+}
+
+// Radix-4 butterflies k = k_start..k_end-1 of one group: points k, k+q, k+2q
+// and k+3q of re/im. After bit reversal the four quarter blocks hold the DFTs
+// of x[4i], x[4i+2], x[4i+1] and x[4i+3], which is why the twiddles
+// (w^1, w^2, w^3) are applied as w^2, w, w^3.
+static void radix4_scalar(double *re, double *im, int q, double direction,
+                          const Radix4Twiddles *w, int k_start, int k_end) {
+    for (int k = k_start; k < k_end; k++) {
+        double ar = re[k], ai = im[k];
+        double xr = re[k + q], xi = im[k + q];
+        double yr = re[k + 2*q], yi = im[k + 2*q];
+        double zr = re[k + 3*q], zi = im[k + 3*q];
+
+        double br = w->w2_real[k] * xr - w->w2_imag[k] * xi;
+        double bi = w->w2_real[k] * xi + w->w2_imag[k] * xr;
+        double cr = w->w1_real[k] * yr - w->w1_imag[k] * yi;
+        double ci = w->w1_real[k] * yi + w->w1_imag[k] * yr;
+        double dr = w->w3_real[k] * zr - w->w3_imag[k] * zi;
+        double di = w->w3_real[k] * zi + w->w3_imag[k] * zr;
+
+        double t0r = ar + br, t0i = ai + bi;
+        double t1r = ar - br, t1i = ai - bi;
+        double t2r = cr + dr, t2i = ci + di;
+        double t3r = cr - dr, t3i = ci - di;
+
+        // direction * i * t3
+        double rot_r = -direction * t3i;
+        double rot_i = direction * t3r;
+
+        re[k]       = t0r + t2r;
+        im[k]       = t0i + t2i;
+        re[k + q]   = t1r + rot_r;
+        im[k + q]   = t1i + rot_i;
+        re[k + 2*q] = t0r - t2r;
+        im[k + 2*q] = t0i - t2i;
+        re[k + 3*q] = t1r - rot_r;
+        im[k + 3*q] = t1i - rot_i;
+    }
+}
+
+#if defined(FFT_HAVE_X86_SIMD)
+// AVX2 radix-4 butterflies, four per iteration. The split layout means
+// every operand is a plain vector load; the arithmetic is the scalar
+// sequence (no FMA), so results match radix4_scalar bit for bit.
+__attribute__((target("avx2")))
+static int radix4_avx2(double *re, double *im, int q, double direction,
+                       const Radix4Twiddles *w, int k, int k_end) {
+    __m256d neg_dir = _mm256_set1_pd(-direction);
+    __m256d dir = _mm256_set1_pd(direction);
+
+    for (; k + 4 <= k_end; k += 4) {
+        __m256d ar = _mm256_loadu_pd(re + k), ai = _mm256_loadu_pd(im + k);
+        __m256d xr = _mm256_loadu_pd(re + k + q), xi = _mm256_loadu_pd(im + k + q);
+        __m256d yr = _mm256_loadu_pd(re + k + 2*q), yi = _mm256_loadu_pd(im + k + 2*q);
+        __m256d zr = _mm256_loadu_pd(re + k + 3*q), zi = _mm256_loadu_pd(im + k + 3*q);
+
+        __m256d w1r = _mm256_loadu_pd(w->w1_real + k), w1i = _mm256_loadu_pd(w->w1_imag + k);
+        __m256d w2r = _mm256_loadu_pd(w->w2_real + k), w2i = _mm256_loadu_pd(w->w2_imag + k);
+        __m256d w3r = _mm256_loadu_pd(w->w3_real + k), w3i = _mm256_loadu_pd(w->w3_imag + k);
+
+        __m256d br = _mm256_sub_pd(_mm256_mul_pd(w2r, xr), _mm256_mul_pd(w2i, xi));
+        __m256d bi = _mm256_add_pd(_mm256_mul_pd(w2r, xi), _mm256_mul_pd(w2i, xr));
+        __m256d cr = _mm256_sub_pd(_mm256_mul_pd(w1r, yr), _mm256_mul_pd(w1i, yi));
+        __m256d ci = _mm256_add_pd(_mm256_mul_pd(w1r, yi), _mm256_mul_pd(w1i, yr));
+        __m256d dr = _mm256_sub_pd(_mm256_mul_pd(w3r, zr), _mm256_mul_pd(w3i, zi));
+        __m256d di = _mm256_add_pd(_mm256_mul_pd(w3r, zi), _mm256_mul_pd(w3i, zr));
+
+        __m256d t0r = _mm256_add_pd(ar, br), t0i = _mm256_add_pd(ai, bi);
+        __m256d t1r = _mm256_sub_pd(ar, br), t1i = _mm256_sub_pd(ai, bi);
+        __m256d t2r = _mm256_add_pd(cr, dr), t2i = _mm256_add_pd(ci, di);
+        __m256d t3r = _mm256_sub_pd(cr, dr), t3i = _mm256_sub_pd(ci, di);
+
+        __m256d rot_r = _mm256_mul_pd(neg_dir, t3i);
+        __m256d rot_i = _mm256_mul_pd(dir, t3r);
+
+        _mm256_storeu_pd(re + k, _mm256_add_pd(t0r, t2r));
+        _mm256_storeu_pd(im + k, _mm256_add_pd(t0i, t2i));
+        _mm256_storeu_pd(re + k + q, _mm256_add_pd(t1r, rot_r));
+        _mm256_storeu_pd(im + k + q, _mm256_add_pd(t1i, rot_i));
+        _mm256_storeu_pd(re + k + 2*q, _mm256_sub_pd(t0r, t2r));
+        _mm256_storeu_pd(im + k + 2*q, _mm256_sub_pd(t0i, t2i));
+        _mm256_storeu_pd(re + k + 3*q, _mm256_sub_pd(t1r, rot_r));
+        _mm256_storeu_pd(im + k + 3*q, _mm256_sub_pd(t1i, rot_i));
+    }
+
+    return k;
+}
+
+// AVX-512 radix-4 butterflies, eight per iteration (see radix4_avx2)
+__attribute__((target("avx512f")))
+static int radix4_avx512(double *re, double *im, int q, double direction,
+                         const Radix4Twiddles *w, int k, int k_end) {
+    __m512d neg_dir = _mm512_set1_pd(-direction);
+    __m512d dir = _mm512_set1_pd(direction);
+
+    for (; k + 8 <= k_end; k += 8) {
+        __m512d ar = _mm512_loadu_pd(re + k), ai = _mm512_loadu_pd(im + k);
+        __m512d xr = _mm512_loadu_pd(re + k + q), xi = _mm512_loadu_pd(im + k + q);
+        __m512d yr = _mm512_loadu_pd(re + k + 2*q), yi = _mm512_loadu_pd(im + k + 2*q);
+        __m512d zr = _mm512_loadu_pd(re + k + 3*q), zi = _mm512_loadu_pd(im + k + 3*q);
+
+        __m512d w1r = _mm512_loadu_pd(w->w1_real + k), w1i = _mm512_loadu_pd(w->w1_imag + k);
+        __m512d w2r = _mm512_loadu_pd(w->w2_real + k), w2i = _mm512_loadu_pd(w->w2_imag + k);
+        __m512d w3r = _mm512_loadu_pd(w->w3_real + k), w3i = _mm512_loadu_pd(w->w3_imag + k);
+
+        __m512d br = _mm512_sub_pd(_mm512_mul_pd(w2r, xr), _mm512_mul_pd(w2i, xi));
+        __m512d bi = _mm512_add_pd(_mm512_mul_pd(w2r, xi), _mm512_mul_pd(w2i, xr));
+        __m512d cr = _mm512_sub_pd(_mm512_mul_pd(w1r, yr), _mm512_mul_pd(w1i, yi));
+        __m512d ci = _mm512_add_pd(_mm512_mul_pd(w1r, yi), _mm512_mul_pd(w1i, yr));
+        __m512d dr = _mm512_sub_pd(_mm512_mul_pd(w3r, zr), _mm512_mul_pd(w3i, zi));
+        __m512d di = _mm512_add_pd(_mm512_mul_pd(w3r, zi), _mm512_mul_pd(w3i, zr));
+
+        __m512d t0r = _mm512_add_pd(ar, br), t0i = _mm512_add_pd(ai, bi);
+        __m512d t1r = _mm512_sub_pd(ar, br), t1i = _mm512_sub_pd(ai, bi);
+        __m512d t2r = _mm512_add_pd(cr, dr), t2i = _mm512_add_pd(ci, di);
+        __m512d t3r = _mm512_sub_pd(cr, dr), t3i = _mm512_sub_pd(ci, di);
+
+        __m512d rot_r = _mm512_mul_pd(neg_dir, t3i);
+        __m512d rot_i = _mm512_mul_pd(dir, t3r);
+
+        _mm512_storeu_pd(re + k, _mm512_add_pd(t0r, t2r));
+        _mm512_storeu_pd(im + k, _mm512_add_pd(t0i, t2i));
+        _mm512_storeu_pd(re + k + q, _mm512_add_pd(t1r, rot_r));
+        _mm512_storeu_pd(im + k + q, _mm512_add_pd(t1i, rot_i));
+        _mm512_storeu_pd(re + k + 2*q, _mm512_sub_pd(t0r, t2r));
+        _mm512_storeu_pd(im + k + 2*q, _mm512_sub_pd(t0i, t2i));
+        _mm512_storeu_pd(re + k + 3*q, _mm512_sub_pd(t1r, rot_r));
+        _mm512_storeu_pd(im + k + 3*q, _mm512_sub_pd(t1i, rot_i));
+    }
+
+    return k;
+}
+
+// AVX2 radix-2 butterflies, four per iteration
+__attribute__((target("avx2")))
+static int radix2_avx2(double *re, double *im, int half, const double *w_real,
+                       const double *w_imag, int k, int end) {
+    for (; k + 4 <= end; k += 4) {
+        __m256d wr = _mm256_loadu_pd(w_real + k), wi = _mm256_loadu_pd(w_imag + k);
+        __m256d xr = _mm256_loadu_pd(re + k + half), xi = _mm256_loadu_pd(im + k + half);
+        __m256d ar = _mm256_loadu_pd(re + k), ai = _mm256_loadu_pd(im + k);
+
+        __m256d tr = _mm256_sub_pd(_mm256_mul_pd(wr, xr), _mm256_mul_pd(wi, xi));
+        __m256d ti = _mm256_add_pd(_mm256_mul_pd(wr, xi), _mm256_mul_pd(wi, xr));
+
+        _mm256_storeu_pd(re + k + half, _mm256_sub_pd(ar, tr));
+        _mm256_storeu_pd(im + k + half, _mm256_sub_pd(ai, ti));
+        _mm256_storeu_pd(re + k, _mm256_add_pd(ar, tr));
+        _mm256_storeu_pd(im + k, _mm256_add_pd(ai, ti));
+    }
+
+    return k;
+}
+
+// AVX-512 radix-2 butterflies, eight per iteration
+__attribute__((target("avx512f")))
+static int radix2_avx512(double *re, double *im, int half, const double *w_real,
+                         const double *w_imag, int k, int end) {
+    for (; k + 8 <= end; k += 8) {
+        __m512d wr = _mm512_loadu_pd(w_real + k), wi = _mm512_loadu_pd(w_imag + k);
+        __m512d xr = _mm512_loadu_pd(re + k + half), xi = _mm512_loadu_pd(im + k + half);
+        __m512d ar = _mm512_loadu_pd(re + k), ai = _mm512_loadu_pd(im + k);
+
+        __m512d tr = _mm512_sub_pd(_mm512_mul_pd(wr, xr), _mm512_mul_pd(wi, xi));
+        __m512d ti = _mm512_add_pd(_mm512_mul_pd(wr, xi), _mm512_mul_pd(wi, xr));
+
+        _mm512_storeu_pd(re + k + half, _mm512_sub_pd(ar, tr));
+        _mm512_storeu_pd(im + k + half, _mm512_sub_pd(ai, ti));
+        _mm512_storeu_pd(re + k, _mm512_add_pd(ar, tr));
+        _mm512_storeu_pd(im + k, _mm512_add_pd(ai, ti));
+    }
+
+    return k;
+}
+#endif
+
+// Butterflies k_start..k_end-1 of one radix-4 group at the active SIMD level
+static void radix4_group(double *re, double *im, int q, double direction,
+                         const Radix4Twiddles *w, int k_start, int k_end, SimdLevel level) {
+    int k = k_start;
+
+    switch (level) {
+#if defined(FFT_HAVE_X86_SIMD)
+        case SIMD_AVX512:
+            k = radix4_avx512(re, im, q, direction, w, k, k_end);
+            k = radix4_avx2(re, im, q, direction, w, k, k_end);
+            break;
+        case SIMD_AVX2:
+            k = radix4_avx2(re, im, q, direction, w, k, k_end);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    radix4_scalar(re, im, q, direction, w, k, k_end);
+}
+
+// Butterflies [start, end) of a radix-4 pass, numbered group by group
+// (butterfly u is k = u % q of group u / q). Each group's butterflies are
+// contiguous in k, so they run as vectors.
+static void radix4_range(double *re, double *im, int q, int direction,
+                         const double *twiddles, int start, int end, SimdLevel level) {
+    Radix4Twiddles w = radix4_twiddles(twiddles, q);
+
+    // Groups narrower than a vector run straight through the scalar loop
+    if (q < 4) {
+        for (int u = start; u < end; u++) {
+            int base = (u / q) * 4 * q;
+            int k = u % q;
+            radix4_scalar(re + base, im + base, q, direction, &w, k, k + 1);
+        }
+        return;
+    }
+
+    int k = start % q;
+    int base = (start / q) * 4 * q;
+
+    for (int u = start; u < end; ) {
+        int count = q - k;
+        if (count > end - u) count = end - u;
+
+        radix4_group(re + base, im + base, q, direction, &w, k, k + count, level);
+
+        u += count;
+        k = 0;
+        base += 4 * q;
+    }
+}
+
+// Butterflies [start, end) of the radix-2 pass used when log2(n) is odd
+static void radix2_range(double *re, double *im, int n, const double *twiddles,
+                         int start, int end, SimdLevel level) {
+    int half = n / 2;
+    const double *w_real = twiddles;
+    const double *w_imag = twiddles + half;
+    int k = start;
+
+    switch (level) {
+#if defined(FFT_HAVE_X86_SIMD)
+        case SIMD_AVX512:
+            k = radix2_avx512(re, im, half, w_real, w_imag, k, end);
+            k = radix2_avx2(re, im, half, w_real, w_imag, k, end);
+            break;
+        case SIMD_AVX2:
+            k = radix2_avx2(re, im, half, w_real, w_imag, k, end);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    for (; k < end; k++) {
+        double xr = re[k + half], xi = im[k + half];
+        double tr = w_real[k] * xr - w_imag[k] * xi;
+        double ti = w_real[k] * xi + w_imag[k] * xr;
+
+        re[k + half] = re[k] - tr;
+        im[k + half] = im[k] - ti;
+        re[k] += tr;
+        im[k] += ti;
+    }
+}
+
+// Swap pairs (i, bit_reverse[i]) for i in [start, end)
+static void bit_reverse_range(const FFTPlan *plan, double *re, double *im, int start, int end) {
+    for (int i = start; i < end; i++) {
+        int j = plan->bit_reverse[i];
+        if (i < j) {
+            double temp = re[i];
+            re[i] = re[j];
+            re[j] = temp;
+            temp = im[i];
+            im[i] = im[j];
+            im[j] = temp;
+        }
+    }
+}
+
+// One pass of a parallel transform, split into FFT_PARALLEL_CHUNK pieces
+typedef struct {
+    const FFTPlan *plan;
+    double *re;
+    double *im;
+    const double *twiddles;
+    int q;              // Radix-4 quarter length (0: bit reversal, -1: radix-2 tail)
+    int count;          // Items in the pass
+    SimdLevel level;
+} FFTPassJob;
+
+static void fft_pass_task(void *context, int index) {
+    FFTPassJob *job = (FFTPassJob*)context;
+    int start = index * FFT_PARALLEL_CHUNK;
+    int end = start + FFT_PARALLEL_CHUNK;
+    if (end > job->count) end = job->count;
+
+    if (job->q == 0) {
+        bit_reverse_range(job->plan, job->re, job->im, start, end);
+    } else if (job->q < 0) {
+        radix2_range(job->re, job->im, job->plan->n, job->twiddles, start, end, job->level);
+    } else {
+        radix4_range(job->re, job->im, job->q, job->plan->direction, job->twiddles,
+                     start, end, job->level);
+    }
+}
+
+// Run one pass over count items on the thread pool
+static void run_fft_pass(FFTPassJob *job, int q, int count) {
+    job->q = q;
+    job->count = count;
+    conv_parallel_for((count + FFT_PARALLEL_CHUNK - 1) / FFT_PARALLEL_CHUNK, fft_pass_task, job);
+}
+
+// Stage-parallel transform: every pass is split into independent butterfly
+// ranges. Each butterfly does the same arithmetic as in the serial loops, so
+// the result does not depend on the thread count.
+static void fft_execute_parallel(const FFTPlan *plan, double *re, double *im, SimdLevel level) {
+    int n = plan->n;
+    FFTPassJob job = {plan, re, im, plan->twiddles, 0, 0, level};
+
+    run_fft_pass(&job, 0, n);
+
+    int q = 1;
+    while (4 * q <= n) {
+        run_fft_pass(&job, q, n / 4);
+        job.twiddles += 6 * q;
+        q *= 4;
+    }
+
+    if (q < n) {
+        run_fft_pass(&job, -1, n / 2);
+    }
+}
+
+// One mixed-radix pass: l interleaved sub-transforms of length r*m in a
+// (sample t + m*q of sub-transform j at (t + m*q)*l + j) become r*l of
+// length m in b (output k of sub-transform j at (t*r + k)*l + j), each
+// output k > 0 multiplied by its twiddle w^(t*k)
+static void mixed_pass(const double *ar, const double *ai, double *br, double *bi,
+                       int r, int m, int l, const double *w, double direction) {
+    const double *w_real = w;
+    const double *w_imag = w + (size_t)(r - 1) * m;
+
+    if (r == 2) {
+        for (int t = 0; t < m; t++) {
+            double wr = w_real[t], wi = w_imag[t];
+            const double *x0r = ar + (size_t)t * l, *x0i = ai + (size_t)t * l;
+            const double *x1r = x0r + (size_t)m * l, *x1i = x0i + (size_t)m * l;
+            double *y0r = br + (size_t)2 * t * l, *y0i = bi + (size_t)2 * t * l;
+            double *y1r = y0r + l, *y1i = y0i + l;
+
+            for (int j = 0; j < l; j++) {
+                double dr = x0r[j] - x1r[j], di = x0i[j] - x1i[j];
+                y0r[j] = x0r[j] + x1r[j];
+                y0i[j] = x0i[j] + x1i[j];
+                y1r[j] = wr * dr - wi * di;
+                y1i[j] = wr * di + wi * dr;
+            }
+        }
+        return;
+    }
+
+    if (r == 4) {
+        for (int t = 0; t < m; t++) {
+            double w1r = w_real[t], w1i = w_imag[t];
+            double w2r = w_real[m + t], w2i = w_imag[m + t];
+            double w3r = w_real[2 * m + t], w3i = w_imag[2 * m + t];
+            size_t in = (size_t)t * l, step = (size_t)m * l;
+            size_t out = (size_t)4 * t * l;
+
+            for (int j = 0; j < l; j++) {
+                double x0r = ar[in + j], x0i = ai[in + j];
+                double x1r = ar[in + step + j], x1i = ai[in + step + j];
+                double x2r = ar[in + 2 * step + j], x2i = ai[in + 2 * step + j];
+                double x3r = ar[in + 3 * step + j], x3i = ai[in + 3 * step + j];
+
+                double t0r = x0r + x2r, t0i = x0i + x2i;
+                double t1r = x0r - x2r, t1i = x0i - x2i;
+                double t2r = x1r + x3r, t2i = x1i + x3i;
+                // direction * i * (x1 - x3)
+                double t3r = -direction * (x1i - x3i), t3i = direction * (x1r - x3r);
+
+                double y1r = t1r + t3r, y1i = t1i + t3i;
+                double y2r = t0r - t2r, y2i = t0i - t2i;
+                double y3r = t1r - t3r, y3i = t1i - t3i;
+
+                br[out + j] = t0r + t2r;
+                bi[out + j] = t0i + t2i;
+                br[out + l + j] = w1r * y1r - w1i * y1i;
+                bi[out + l + j] = w1r * y1i + w1i * y1r;
+                br[out + 2 * l + j] = w2r * y2r - w2i * y2i;
+                bi[out + 2 * l + j] = w2r * y2i + w2i * y2r;
+                br[out + 3 * l + j] = w3r * y3r - w3i * y3i;
+                bi[out + 3 * l + j] = w3r * y3i + w3i * y3r;
+            }
+        }
+        return;
+    }
+
+    if (r == 3) {
+        // sin(2*pi/3); cos(2*pi/3) = -1/2
+        const double s3 = direction * 0.86602540378443864676;
+        for (int t = 0; t < m; t++) {
+            double w1r = w_real[t], w1i = w_imag[t];
+            double w2r = w_real[m + t], w2i = w_imag[m + t];
+            size_t in = (size_t)t * l, step = (size_t)m * l;
+            size_t out = (size_t)3 * t * l;
+
+            for (int j = 0; j < l; j++) {
+                double x0r = ar[in + j], x0i = ai[in + j];
+                double x1r = ar[in + step + j], x1i = ai[in + step + j];
+                double x2r = ar[in + 2 * step + j], x2i = ai[in + 2 * step + j];
+
+                double sr = x1r + x2r, si = x1i + x2i;
+                double er = x0r - 0.5 * sr, ei = x0i - 0.5 * si;
+                // direction * i * sin(2*pi/3) * (x1 - x2)
+                double or_ = -s3 * (x1i - x2i), oi = s3 * (x1r - x2r);
+
+                double y1r = er + or_, y1i = ei + oi;
+                double y2r = er - or_, y2i = ei - oi;
+
+                br[out + j] = x0r + sr;
+                bi[out + j] = x0i + si;
+                br[out + l + j] = w1r * y1r - w1i * y1i;
+                bi[out + l + j] = w1r * y1i + w1i * y1r;
+                br[out + 2 * l + j] = w2r * y2r - w2i * y2i;
+                bi[out + 2 * l + j] = w2r * y2i + w2i * y2r;
+            }
+        }
+        return;
+    }
+
+    if (r == 5) {
+        const double c1 = 0.30901699437494742410;   // cos(2*pi/5)
+        const double c2 = -0.80901699437494742410;  // cos(4*pi/5)
+        const double s1 = direction * 0.95105651629515357212;
+        const double s2 = direction * 0.58778525229247312917;
+        for (int t = 0; t < m; t++) {
+            size_t in = (size_t)t * l, step = (size_t)m * l;
+            size_t out = (size_t)5 * t * l;
+            const double *wr = w_real + t, *wi = w_imag + t;
+
+            for (int j = 0; j < l; j++) {
+                double x0r = ar[in + j], x0i = ai[in + j];
+                double x1r = ar[in + step + j], x1i = ai[in + step + j];
+                double x2r = ar[in + 2 * step + j], x2i = ai[in + 2 * step + j];
+                double x3r = ar[in + 3 * step + j], x3i = ai[in + 3 * step + j];
+                double x4r = ar[in + 4 * step + j], x4i = ai[in + 4 * step + j];
+
+                double p1r = x1r + x4r, p1i = x1i + x4i;
+                double q1r = x1r - x4r, q1i = x1i - x4i;
+                double p2r = x2r + x3r, p2i = x2i + x3i;
+                double q2r = x2r - x3r, q2i = x2i - x3i;
+
+                double e1r = x0r + c1 * p1r + c2 * p2r, e1i = x0i + c1 * p1i + c2 * p2i;
+                double e2r = x0r + c2 * p1r + c1 * p2r, e2i = x0i + c2 * p1i + c1 * p2i;
+                // direction * i * (sine sums of the differences)
+                double o1r = -(s1 * q1i + s2 * q2i), o1i = s1 * q1r + s2 * q2r;
+                double o2r = -(s2 * q1i - s1 * q2i), o2i = s2 * q1r - s1 * q2r;
+
+                double yr[5] = {x0r + p1r + p2r, e1r + o1r, e2r + o2r, e2r - o2r, e1r - o1r};
+                double yi[5] = {x0i + p1i + p2i, e1i + o1i, e2i + o2i, e2i - o2i, e1i - o1i};
+
+                br[out + j] = yr[0];
+                bi[out + j] = yi[0];
+                for (int k = 1; k < 5; k++) {
+                    double twr = wr[(size_t)(k - 1) * m], twi = wi[(size_t)(k - 1) * m];
+                    br[out + (size_t)k * l + j] = twr * yr[k] - twi * yi[k];
+                    bi[out + (size_t)k * l + j] = twr * yi[k] + twi * yr[k];
+                }
+            }
+        }
+        return;
+    }
+
+    // Radix 7: outputs k and 7-k share the sums over the symmetric pairs
+    // x[q] + x[7-q] and x[q] - x[7-q]
+    double cos_table[3][3], sin_table[3][3];
+    for (int k = 1; k <= 3; k++) {
+        for (int q = 1; q <= 3; q++) {
+            cos_table[k - 1][q - 1] = cos(FFT_TWO_PI * ((q * k) % 7) / 7);
+            sin_table[k - 1][q - 1] = direction * sin(FFT_TWO_PI * ((q * k) % 7) / 7);
+        }
+    }
+
+    for (int t = 0; t < m; t++) {
+        size_t in = (size_t)t * l, step = (size_t)m * l;
+        size_t out = (size_t)7 * t * l;
+
+        for (int j = 0; j < l; j++) {
+            double x0r = ar[in + j], x0i = ai[in + j];
+            double sum_r[3], sum_i[3], diff_r[3], diff_i[3];
+            double y_r[7], y_i[7];
+
+            y_r[0] = x0r;
+            y_i[0] = x0i;
+            for (int q = 1; q <= 3; q++) {
+                double ur = ar[in + q * step + j], ui = ai[in + q * step + j];
+                double vr = ar[in + (7 - q) * step + j], vi = ai[in + (7 - q) * step + j];
+                sum_r[q - 1] = ur + vr;
+                sum_i[q - 1] = ui + vi;
+                diff_r[q - 1] = ur - vr;
+                diff_i[q - 1] = ui - vi;
+                y_r[0] += sum_r[q - 1];
+                y_i[0] += sum_i[q - 1];
+            }
+
+            for (int k = 1; k <= 3; k++) {
+                const double *c = cos_table[k - 1], *sn = sin_table[k - 1];
+                double er = x0r + c[0] * sum_r[0] + c[1] * sum_r[1] + c[2] * sum_r[2];
+                double ei = x0i + c[0] * sum_i[0] + c[1] * sum_i[1] + c[2] * sum_i[2];
+                double or_ = sn[0] * diff_r[0] + sn[1] * diff_r[1] + sn[2] * diff_r[2];
+                double oi = sn[0] * diff_i[0] + sn[1] * diff_i[1] + sn[2] * diff_i[2];
+                // y[k] = E + i * O, y[7-k] = E - i * O (direction is in O)
+                y_r[k] = er - oi;
+                y_i[k] = ei + or_;
+                y_r[7 - k] = er + oi;
+                y_i[7 - k] = ei - or_;
+            }
+
+            br[out + j] = y_r[0];
+            bi[out + j] = y_i[0];
+            for (int k = 1; k < 7; k++) {
+                double wr = w_real[(size_t)(k - 1) * m + t], wi = w_imag[(size_t)(k - 1) * m + t];
+                br[out + (size_t)k * l + j] = wr * y_r[k] - wi * y_i[k];
+                bi[out + (size_t)k * l + j] = wr * y_i[k] + wi * y_r[k];
+            }
+        }
+    }
+}
+
+// Mixed-radix transform: the passes alternate between the data and this
+// thread's stage buffer, so the result may need one copy back
+static void execute_mixed(const FFTPlan *plan, double *re, double *im) {
+    int n = plan->n;
+    double *work = work_buffer(&stage_work, 2 * (size_t)n);
+    if (!work) return;
+
+    double *src_r = re, *src_i = im;
+    double *dst_r = work, *dst_i = work + n;
+    const double *w = plan->twiddles;
+    int l = 1, m = n;
+
+    for (int s = 0; s < plan->stage_count; s++) {
+        int r = plan->radices[s];
+        m /= r;
+        mixed_pass(src_r, src_i, dst_r, dst_i, r, m, l, w, plan->direction);
+        w += 2 * (size_t)(r - 1) * m;
+        l *= r;
+
+        double *swap_r = src_r, *swap_i = src_i;
+        src_r = dst_r;
+        src_i = dst_i;
+        dst_r = swap_r;
+        dst_i = swap_i;
+    }
+
+    if (src_r != re) {
+        memcpy(re, src_r, n * sizeof(double));
+        memcpy(im, src_i, n * sizeof(double));
+    }
+}
+
+static void execute_split(const FFTPlan *plan, double *re, double *im);
+
+// Bluestein transform: chirp, convolve with the conjugate chirp through the
+// chirp_size-point plans, chirp again
+static void execute_bluestein(const FFTPlan *plan, double *re, double *im) {
+    int n = plan->n;
+    int size = plan->chirp_size;
+    double *ar = work_buffer(&chirp_work, 2 * (size_t)size);
+    if (!ar) return;
+    double *ai = ar + size;
+
+    const double *c_real = plan->chirp;
+    const double *c_imag = plan->chirp + n;
+    const double *b_real = plan->chirp + 2 * n;
+    const double *b_imag = b_real + size;
+
+    for (int t = 0; t < n; t++) {
+        ar[t] = re[t] * c_real[t] - im[t] * c_imag[t];
+        ai[t] = re[t] * c_imag[t] + im[t] * c_real[t];
+    }
+    memset(ar + n, 0, (size_t)(size - n) * sizeof(double));
+    memset(ai + n, 0, (size_t)(size - n) * sizeof(double));
+
+    execute_split(plan->chirp_forward, ar, ai);
+    for (int k = 0; k < size; k++) {
+        double xr = ar[k], xi = ai[k];
+        ar[k] = xr * b_real[k] - xi * b_imag[k];
+        ai[k] = xr * b_imag[k] + xi * b_real[k];
+    }
+    execute_split(plan->chirp_inverse, ar, ai);
+
+    for (int k = 0; k < n; k++) {
+        re[k] = ar[k] * c_real[k] - ai[k] * c_imag[k];
+        im[k] = ar[k] * c_imag[k] + ai[k] * c_real[k];
+    }
+}
+
+// Complex transform of split data (see fft_execute_split), n > 1
+static void execute_split(const FFTPlan *plan, double *re, double *im) {
+    int n = plan->n;
+    SimdLevel level = conv_get_simd_level();
+
+    if (plan->chirp) {
+        execute_bluestein(plan, re, im);
+        return;
+    }
+    if (plan->stage_count > 0) {
+        execute_mixed(plan, re, im);
+        return;
+    }
+
+    if (n >= FFT_PARALLEL_MIN_SIZE && conv_get_num_threads() > 1) {
+        fft_execute_parallel(plan, re, im, level);
+        return;
+    }
+
+    bit_reverse_range(plan, re, im, 0, n);
+
+    const double *twiddles = plan->twiddles;
+    int q = 1;
+    while (4 * q <= n) {
+        radix4_range(re, im, q, plan->direction, twiddles, 0, n / 4, level);
+        twiddles += 6 * q;
+        q *= 4;
+    }
+
+    if (q < n) {
+        radix2_range(re, im, n, twiddles, 0, n / 2, level);
+    }
+}
+
+// Execute a plan in place on split data: re[i] + i*im[i] (radix-4 passes
+// with a radix-2 tail for powers of 2). This is the engine's native layout;
+// the power-of-2 butterflies run as AVX2/AVX-512 vectors without lane
+// shuffles. Not normalized.
+void fft_execute_split(const FFTPlan *plan, double *re, double *im) {
+    if (!plan || !re || !im || plan->is_real) return;
+    if (plan->n <= 1) return;
+
+    CONV_STATS_TRANSFORM(plan->n);
+    execute_split(plan, re, im);
+}
+
+// Execute a plan in place on interleaved Complex data. The points are split
+// into this thread's boundary buffer, transformed, and interleaved back.
+void fft_execute(const FFTPlan *plan, Complex *data) {
+    if (!plan || !data || plan->is_real) return;
+
+    int n = plan->n;
+    if (n <= 1) return;
+
+    double *re = work_buffer(&boundary_work, 2 * (size_t)n);
+    if (!re) return;
+    double *im = re + n;
+    for (int i = 0; i < n; i++) {
+        re[i] = data[i].real;
+        im[i] = data[i].imag;
+    }
+
+    fft_execute_split(plan, re, im);
+
+    for (int i = 0; i < n; i++) {
+        data[i].real = re[i];
+        data[i].imag = im[i];
+    }
+}
+
+// Odd-size real transforms run the n-point complex plan with a zero
+// imaginary part. The bins are written after the samples are copied, so
+// they may overlap them.
+static void real_forward_odd(const FFTPlan *plan, const double *in,
+                             double *out_real, double *out_imag) {
+    int n = plan->n;
+    double *zr = work_buffer(&packed_work, 2 * (size_t)n);
+    if (!zr) return;
+    double *zi = zr + n;
+
+    memcpy(zr, in, n * sizeof(double));
+    memset(zi, 0, n * sizeof(double));
+
+    CONV_STATS_TRANSFORM(n);
+    execute_split(plan->half, zr, zi);
+
+    memcpy(out_real, zr, (n / 2 + 1) * sizeof(double));
+    memcpy(out_imag, zi, (n / 2 + 1) * sizeof(double));
+}
+
+// Inverse of real_forward_odd: the other half of the spectrum is the
+// conjugate mirror of the stored bins
+static void real_inverse_odd(const FFTPlan *plan, const double *in_real,
+                             const double *in_imag, double *out) {
+    int n = plan->n;
+    double *zr = work_buffer(&packed_work, 2 * (size_t)n);
+    if (!zr) return;
+    double *zi = zr + n;
+
+    zr[0] = in_real[0];
+    zi[0] = 0.0;
+    for (int k = 1; k <= n / 2; k++) {
+        zr[k] = zr[n - k] = in_real[k];
+        zi[k] = in_imag[k];
+        zi[n - k] = -in_imag[k];
+    }
+
+    CONV_STATS_TRANSFORM(n);
+    execute_split(plan->half, zr, zi);
+
+    memcpy(out, zr, n * sizeof(double));
+}
+
+// Real-to-complex transform into split bins: n real samples -> n/2+1 bins
+// in out_real/out_imag (not normalized). The samples are packed as
+// z[k] = x[2k] + i*x[2k+1] in this thread's packing buffer, transformed with
+// the n/2-point complex plan, and the even/odd spectra are split back
+// apart. The input is read before any bin is written, so the outputs may
+// overlap it.
+void fft_execute_r2c_split(const FFTPlan *plan, const double *in,
+                           double *out_real, double *out_imag) {
+    if (!plan || !in || !out_real || !out_imag || !plan->is_real) return;
+
+    if (plan->n % 2) {
+        real_forward_odd(plan, in, out_real, out_imag);
+        return;
+    }
+
+    int half = plan->n / 2;
+    int split = half / 2 + 1;
+    double *zr = work_buffer(&packed_work, plan->n);
+    if (!zr) return;
+    double *zi = zr + half;
+
+    for (int k = 0; k < half; k++) {
+        zr[k] = in[2*k];
+        zi[k] = in[2*k + 1];
+    }
+
+    CONV_STATS_TRANSFORM(plan->n);
+    if (half > 1) execute_split(plan->half, zr, zi);
+
+    // DC and Nyquist come from the sum/difference of the packed halves
+    out_real[0] = zr[0] + zi[0];
+    out_imag[0] = 0.0;
+    out_real[half] = zr[0] - zi[0];
+    out_imag[half] = 0.0;
+
+    // X[k] = E + w^k O and X[half-k] = conj(E - w^k O), where
+    // E = (Z[k] + conj(Z[half-k])) / 2 and O = (Z[k] - conj(Z[half-k])) / 2i
+    const double *w_real = plan->twiddles;
+    const double *w_imag = plan->twiddles + split;
+    for (int k = 1; k <= half / 2; k++) {
+        double even_real = 0.5 * (zr[k] + zr[half - k]);
+        double even_imag = 0.5 * (zi[k] - zi[half - k]);
+        double odd_real = 0.5 * (zi[k] + zi[half - k]);
+        double odd_imag = -0.5 * (zr[k] - zr[half - k]);
+
+        double rot_real = w_real[k] * odd_real - w_imag[k] * odd_imag;
+        double rot_imag = w_real[k] * odd_imag + w_imag[k] * odd_real;
+
+        out_real[k] = even_real + rot_real;
+        out_imag[k] = even_imag + rot_imag;
+        out_real[half - k] = even_real - rot_real;
+        out_imag[half - k] = -(even_imag - rot_imag);
+    }
+}
+
+// Complex-to-real transform from split bins: n/2+1 bins -> n real samples,
+// scaled by n like an unnormalized inverse FFT. The bins are read before any
+// sample is written (they are not modified), so out may overlap them.
+void fft_execute_c2r_split(const FFTPlan *plan, const double *in_real,
+                           const double *in_imag, double *out) {
+    if (!plan || !in_real || !in_imag || !out || !plan->is_real) return;
+
+    if (plan->n % 2) {
+        real_inverse_odd(plan, in_real, in_imag, out);
+        return;
+    }
+
+    int half = plan->n / 2;
+    int split = half / 2 + 1;
+    double *zr = work_buffer(&packed_work, plan->n);
+    if (!zr) return;
+    double *zi = zr + half;
+
+    // Rebuild Z[k] = 2E + i*2O with E = X[k] + conj(X[half-k]) halves and
+    // O = (X[k] - conj(X[half-k])) * conj(w^k) halves (w from the forward side)
+    zr[0] = in_real[0] + in_real[half];
+    zi[0] = in_real[0] - in_real[half];
+
+    const double *w_real = plan->twiddles;
+    const double *w_imag = plan->twiddles + split;
+    for (int k = 1; k <= half / 2; k++) {
+        double even_real = in_real[k] + in_real[half - k];
+        double even_imag = in_imag[k] - in_imag[half - k];
+        double diff_real = in_real[k] - in_real[half - k];
+        double diff_imag = in_imag[k] + in_imag[half - k];
+
+        double odd_real = w_real[k] * diff_real - w_imag[k] * diff_imag;
+        double odd_imag = w_real[k] * diff_imag + w_imag[k] * diff_real;
+
+        // Z[k] = E + i*O, Z[half-k] = conj(E) + i*conj(O)
+        zr[k] = even_real - odd_imag;
+        zi[k] = even_imag + odd_real;
+        zr[half - k] = even_real + odd_imag;
+        zi[half - k] = -even_imag + odd_real;
+    }
+
+    CONV_STATS_TRANSFORM(plan->n);
+    if (half > 1) execute_split(plan->half, zr, zi);
+
+    for (int k = 0; k < half; k++) {
+        out[2*k] = zr[k];
+        out[2*k + 1] = zi[k];
+    }
+}
+
+// Real-to-complex transform: n real samples -> n/2+1 interleaved bins (not
+// normalized). Runs fft_execute_r2c_split into this thread's boundary
+// buffer; out may alias in.
+void fft_execute_r2c(const FFTPlan *plan, const double *in, Complex *out) {
+    if (!plan || !in || !out || !plan->is_real) return;
+
+    int bins = plan->n / 2 + 1;
+    double *re = work_buffer(&boundary_work, 2 * (size_t)bins);
+    if (!re) return;
+    double *im = re + bins;
+
+    fft_execute_r2c_split(plan, in, re, im);
+
+    for (int k = 0; k < bins; k++) {
+        out[k].real = re[k];
+        out[k].imag = im[k];
+    }
+}
+
+// Complex-to-real transform: n/2+1 interleaved bins -> n real samples,
+// scaled by n like an unnormalized inverse FFT. out may alias in.
+void fft_execute_c2r(const FFTPlan *plan, Complex *in, double *out) {
+    if (!plan || !in || !out || !plan->is_real) return;
+
+    int bins = plan->n / 2 + 1;
+    double *re = work_buffer(&boundary_work, 2 * (size_t)bins);
+    if (!re) return;
+    double *im = re + bins;
+
+    for (int k = 0; k < bins; k++) {
+        re[k] = in[k].real;
+        im[k] = in[k].imag;
+    }
+
+    fft_execute_c2r_split(plan, re, im, out);
+}
+
+// Take a plan of the given kind from the process-wide cache, creating one
+// if none is idle. The caller has exclusive use of the plan (and its scratch
+// buffer) until it hands it back with fft_plan_release.
+static FFTPlan* acquire_plan(int n, int direction, int is_real) {
+    pthread_mutex_lock(&plan_cache_lock);
+    FFTPlan **link = &plan_cache;
+    while (*link) {
+        FFTPlan *plan = *link;
+        if (plan->n == n && plan->direction == direction && plan->is_real == is_real) {
+            *link = plan->next;
+            plan->next = NULL;
+            pthread_mutex_unlock(&plan_cache_lock);
+            CONV_STATS_PLAN(1);
+            return plan;
+        }
+        link = &plan->next;
+    }
+    pthread_mutex_unlock(&plan_cache_lock);
+
+    CONV_STATS_PLAN(0);
+    return is_real ? fft_plan_create_real(n, direction) : fft_plan_create(n, direction);
+}
+
+FFTPlan* fft_plan_acquire(int n, int direction) {
+    return acquire_plan(n, direction, 0);
+}
+
+FFTPlan* fft_plan_acquire_real(int n, int direction) {
+    return acquire_plan(n, direction, 1);
+}
+
+// Return a plan to the cache for reuse
+void fft_plan_release(FFTPlan *plan) {
+    if (!plan) return;
+
+    pthread_mutex_lock(&plan_cache_lock);
+    plan->next = plan_cache;
+    plan_cache = plan;
+    pthread_mutex_unlock(&plan_cache_lock);
+}
+
+// Free every idle plan held by the cache (double and float)
+void fft_plan_cache_clear(void) {
+    fft_plan_cache_clear_f32();
+
+    pthread_mutex_lock(&plan_cache_lock);
+    FFTPlan *plan = plan_cache;
+    plan_cache = NULL;
+    pthread_mutex_unlock(&plan_cache_lock);
+
+    while (plan) {
+        FFTPlan *next = plan->next;
+        fft_plan_destroy(plan);
+        plan = next;
+    }
+}
+
+// Frequency in Hz of each of the fft_size bins at sample_rate: 0..N/2 are
+// the non-negative frequencies, the rest are negative. The first N/2+1
+// entries are therefore also the axis of a half spectrum. The table is
+// built once per size and rate and must not be freed by the caller.
+// FFTResults carry their own axis and do not populate this cache.
+const double* fft_frequency_axis(int fft_size, double sample_rate) {
+    if (fft_size < 1) return NULL;
+
+    pthread_mutex_lock(&axis_cache_lock);
+    for (FrequencyAxis *axis = axis_cache; axis; axis = axis->next) {
+        if (axis->fft_size == fft_size && axis->sample_rate == sample_rate) {
+            pthread_mutex_unlock(&axis_cache_lock);
+            return axis->bins;
+        }
+    }
+
+    FrequencyAxis *axis = (FrequencyAxis*)malloc(sizeof(FrequencyAxis));
+    double *bins = (double*)malloc(fft_size * sizeof(double));
+    if (!axis || !bins) {
+        pthread_mutex_unlock(&axis_cache_lock);
+        free(axis);
+        free(bins);
+        return NULL;
+    }
+
+    double freq_resolution = sample_rate / fft_size;
+    for (int i = 0; i < fft_size; i++) {
+        bins[i] = (i <= fft_size / 2) ? i * freq_resolution
+                                      : (i - fft_size) * freq_resolution;
+    }
+
+    axis->fft_size = fft_size;
+    axis->sample_rate = sample_rate;
+    axis->bins = bins;
+    axis->next = axis_cache;
+    axis_cache = axis;
+    pthread_mutex_unlock(&axis_cache_lock);
+
+    return bins;
+}
+
+// Free every cached frequency axis. Pointers returned by fft_frequency_axis
+// dangle afterwards, so call this only once they are no longer used.
+void fft_frequency_axis_cache_clear(void) {
+    pthread_mutex_lock(&axis_cache_lock);
+    FrequencyAxis *axis = axis_cache;
+    axis_cache = NULL;
+    pthread_mutex_unlock(&axis_cache_lock);
+
+    while (axis) {
+        FrequencyAxis *next = axis->next;
+        free(axis->bins);
+        free(axis);
+        axis = next;
+    }
+}
+
+// In-place FFT of any length using a cached plan.
+// The transform is not normalized.
+void fft_iterative(Complex *data, int n, int direction) {
+    if (!data || n <= 1) return;
+
+    FFTPlan *plan = fft_plan_acquire(n, direction);
+    if (!plan) return;
+
+    fft_execute(plan, data);
+    fft_plan_release(plan);
+}
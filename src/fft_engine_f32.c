@@ -0,0 +1,342 @@
+#include "../include/convolution.h"
+#include <pthread.h>
+
+// Single-precision counterpart of fft_engine.c: the same radix-4 passes and
+// real-input packing on float data. Twiddles are computed in double and
+// rounded once, so they are as accurate as a float can hold.
+
+#define FFT_TWO_PI 6.28318530717958647692
+
+// Idle float plans waiting to be handed out again, newest first
+static FFTPlanF32 *plan_cache = NULL;
+static pthread_mutex_t plan_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Per-pass twiddle table, laid out as in fft_engine.c
+static void fill_twiddles(ComplexF32 *twiddles, int n, int direction) {
+    int count = 0;
+
+    int q = 1;
+    while (4 * q <= n) {
+        for (int k = 0; k < q; k++) {
+            double angle = direction * FFT_TWO_PI * k / (4 * q);
+            for (int m = 1; m <= 3; m++) {
+                twiddles[count].real = (float)cos(m * angle);
+                twiddles[count].imag = (float)sin(m * angle);
+                count++;
+            }
+        }
+        q *= 4;
+    }
+
+    if (q < n) {
+        for (int k = 0; k < n / 2; k++) {
+            double angle = direction * FFT_TWO_PI * k / n;
+            twiddles[count].real = (float)cos(angle);
+            twiddles[count].imag = (float)sin(angle);
+            count++;
+        }
+    }
+}
+
+// Create a single-precision FFT plan for a power-of-2 size
+FFTPlanF32* fft_plan_create_f32(int n, int direction) {
+    if (n < 1 || (n & (n - 1)) != 0) return NULL;
+    if (direction != FFT_FORWARD && direction != FFT_INVERSE) return NULL;
+
+    FFTPlanF32 *plan = (FFTPlanF32*)calloc(1, sizeof(FFTPlanF32));
+    if (!plan) return NULL;
+
+    plan->n = n;
+    plan->direction = direction;
+    plan->bit_reverse = (int*)malloc(n * sizeof(int));
+    plan->twiddles = (ComplexF32*)malloc((n + n / 2 + 1) * sizeof(ComplexF32));
+    plan->scratch = (ComplexF32*)malloc(n * sizeof(ComplexF32));
+
+    if (!plan->bit_reverse || !plan->twiddles || !plan->scratch) {
+        fft_plan_destroy_f32(plan);
+        return NULL;
+    }
+
+    plan->bit_reverse[0] = 0;
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        plan->bit_reverse[i] = j;
+    }
+
+    fill_twiddles(plan->twiddles, n, direction);
+    CONV_STATS_ALLOC(sizeof(FFTPlanF32) + n * (sizeof(int) + sizeof(ComplexF32)) +
+                     (n + n / 2 + 1) * sizeof(ComplexF32));
+
+    return plan;
+}
+
+// Create a single-precision real-input plan (see fft_plan_create_real)
+FFTPlanF32* fft_plan_create_real_f32(int n, int direction) {
+    if (n < 2 || (n & (n - 1)) != 0) return NULL;
+    if (direction != FFT_FORWARD && direction != FFT_INVERSE) return NULL;
+
+    FFTPlanF32 *plan = (FFTPlanF32*)calloc(1, sizeof(FFTPlanF32));
+    if (!plan) return NULL;
+
+    int half = n / 2;
+    plan->n = n;
+    plan->direction = direction;
+    plan->is_real = 1;
+    plan->half = fft_plan_create_f32(half, direction);
+    plan->twiddles = (ComplexF32*)malloc((half / 2 + 1) * sizeof(ComplexF32));
+    plan->scratch = (ComplexF32*)malloc((half + 1) * sizeof(ComplexF32));
+
+    if (!plan->half || !plan->twiddles || !plan->scratch) {
+        fft_plan_destroy_f32(plan);
+        return NULL;
+    }
+
+    for (int k = 0; k <= half / 2; k++) {
+        double angle = direction * FFT_TWO_PI * k / n;
+        plan->twiddles[k].real = (float)cos(angle);
+        plan->twiddles[k].imag = (float)sin(angle);
+    }
+    CONV_STATS_ALLOC(sizeof(FFTPlanF32) + (half / 2 + 1 + half + 1) * sizeof(ComplexF32));
+
+    return plan;
+}
+
+// Free a single-precision plan
+void fft_plan_destroy_f32(FFTPlanF32 *plan) {
+    if (plan) {
+        if (plan->bit_reverse) free(plan->bit_reverse);
+        if (plan->twiddles) free(plan->twiddles);
+        if (plan->scratch) free(plan->scratch);
+        fft_plan_destroy_f32(plan->half);
+        free(plan);
+    }
+}
+
+// Radix-4 butterfly (see radix4_butterfly in fft_engine.c)
+static void radix4_butterfly(ComplexF32 *p, int q, float direction, const ComplexF32 *w) {
+    ComplexF32 w1 = w[0];
+    ComplexF32 w2 = w[1];
+    ComplexF32 w3 = w[2];
+
+    ComplexF32 a = p[0];
+    ComplexF32 b = {
+        w2.real * p[q].real - w2.imag * p[q].imag,
+        w2.real * p[q].imag + w2.imag * p[q].real
+    };
+    ComplexF32 c = {
+        w1.real * p[2*q].real - w1.imag * p[2*q].imag,
+        w1.real * p[2*q].imag + w1.imag * p[2*q].real
+    };
+    ComplexF32 d = {
+        w3.real * p[3*q].real - w3.imag * p[3*q].imag,
+        w3.real * p[3*q].imag + w3.imag * p[3*q].real
+    };
+
+    ComplexF32 t0 = {a.real + b.real, a.imag + b.imag};
+    ComplexF32 t1 = {a.real - b.real, a.imag - b.imag};
+    ComplexF32 t2 = {c.real + d.real, c.imag + d.imag};
+    ComplexF32 t3 = {c.real - d.real, c.imag - d.imag};
+
+    ComplexF32 rot = {-direction * t3.imag, direction * t3.real};
+
+    p[0].real   = t0.real + t2.real;
+    p[0].imag   = t0.imag + t2.imag;
+    p[q].real   = t1.real + rot.real;
+    p[q].imag   = t1.imag + rot.imag;
+    p[2*q].real = t0.real - t2.real;
+    p[2*q].imag = t0.imag - t2.imag;
+    p[3*q].real = t1.real - rot.real;
+    p[3*q].imag = t1.imag - rot.imag;
+}
+
+// Complex transform in place (see fft_execute_f32)
+static void execute_complex_f32(const FFTPlanF32 *plan, ComplexF32 *data) {
+    int n = plan->n;
+    if (n <= 1) return;
+
+    for (int i = 0; i < n; i++) {
+        int j = plan->bit_reverse[i];
+        if (i < j) {
+            ComplexF32 temp = data[i];
+            data[i] = data[j];
+            data[j] = temp;
+        }
+    }
+
+    const ComplexF32 *twiddles = plan->twiddles;
+    float direction = (float)plan->direction;
+    int q = 1;
+    while (4 * q <= n) {
+        for (int k = 0; k < q; k++) {
+            for (int base = k; base < n; base += 4 * q) {
+                radix4_butterfly(&data[base], q, direction, &twiddles[3*k]);
+            }
+        }
+        twiddles += 3 * q;
+        q *= 4;
+    }
+
+    if (q < n) {
+        int half = n / 2;
+        for (int k = 0; k < half; k++) {
+            ComplexF32 twiddle = twiddles[k];
+            ComplexF32 temp = {
+                twiddle.real * data[k + half].real - twiddle.imag * data[k + half].imag,
+                twiddle.real * data[k + half].imag + twiddle.imag * data[k + half].real
+            };
+            data[k + half].real = data[k].real - temp.real;
+            data[k + half].imag = data[k].imag - temp.imag;
+            data[k].real += temp.real;
+            data[k].imag += temp.imag;
+        }
+    }
+}
+
+// Execute a single-precision plan in place (not normalized)
+void fft_execute_f32(const FFTPlanF32 *plan, ComplexF32 *data) {
+    if (!plan || !data || plan->is_real) return;
+    if (plan->n <= 1) return;
+
+    CONV_STATS_TRANSFORM(plan->n);
+    execute_complex_f32(plan, data);
+}
+
+// Real-to-complex transform: n floats -> n/2+1 bins (see fft_execute_r2c)
+void fft_execute_r2c_f32(const FFTPlanF32 *plan, const float *in, ComplexF32 *out) {
+    if (!plan || !in || !out || !plan->is_real) return;
+
+    int half = plan->n / 2;
+
+    for (int k = 0; k < half; k++) {
+        out[k].real = in[2*k];
+        out[k].imag = in[2*k + 1];
+    }
+
+    CONV_STATS_TRANSFORM(plan->n);
+    execute_complex_f32(plan->half, out);
+
+    float z0_real = out[0].real;
+    float z0_imag = out[0].imag;
+    out[0].real = z0_real + z0_imag;
+    out[0].imag = 0.0f;
+    out[half].real = z0_real - z0_imag;
+    out[half].imag = 0.0f;
+
+    for (int k = 1; k <= half / 2; k++) {
+        ComplexF32 zk = out[k];
+        ComplexF32 zm = out[half - k];
+        ComplexF32 w = plan->twiddles[k];
+
+        float even_real = 0.5f * (zk.real + zm.real);
+        float even_imag = 0.5f * (zk.imag - zm.imag);
+        float odd_real = 0.5f * (zk.imag + zm.imag);
+        float odd_imag = -0.5f * (zk.real - zm.real);
+
+        float rot_real = w.real * odd_real - w.imag * odd_imag;
+        float rot_imag = w.real * odd_imag + w.imag * odd_real;
+
+        out[k].real = even_real + rot_real;
+        out[k].imag = even_imag + rot_imag;
+        out[half - k].real = even_real - rot_real;
+        out[half - k].imag = -(even_imag - rot_imag);
+    }
+}
+
+// Complex-to-real transform: n/2+1 bins -> n floats, scaled by n
+// (see fft_execute_c2r). The input is overwritten; out may alias it.
+void fft_execute_c2r_f32(const FFTPlanF32 *plan, ComplexF32 *in, float *out) {
+    if (!plan || !in || !out || !plan->is_real) return;
+
+    int half = plan->n / 2;
+
+    float x0 = in[0].real;
+    float xh = in[half].real;
+    in[0].real = x0 + xh;
+    in[0].imag = x0 - xh;
+
+    for (int k = 1; k <= half / 2; k++) {
+        ComplexF32 xk = in[k];
+        ComplexF32 xm = in[half - k];
+        ComplexF32 w = plan->twiddles[k];
+
+        float even_real = xk.real + xm.real;
+        float even_imag = xk.imag - xm.imag;
+        float diff_real = xk.real - xm.real;
+        float diff_imag = xk.imag + xm.imag;
+
+        float odd_real = w.real * diff_real - w.imag * diff_imag;
+        float odd_imag = w.real * diff_imag + w.imag * diff_real;
+
+        in[k].real = even_real - odd_imag;
+        in[k].imag = even_imag + odd_real;
+        in[half - k].real = even_real + odd_imag;
+        in[half - k].imag = -even_imag + odd_real;
+    }
+
+    CONV_STATS_TRANSFORM(plan->n);
+    execute_complex_f32(plan->half, in);
+
+    for (int k = 0; k < half; k++) {
+        float real = in[k].real;
+        float imag = in[k].imag;
+        out[2*k] = real;
+        out[2*k + 1] = imag;
+    }
+}
+
+// Take a float plan from the cache, creating one if none is idle
+static FFTPlanF32* acquire_plan(int n, int direction, int is_real) {
+    pthread_mutex_lock(&plan_cache_lock);
+    FFTPlanF32 **link = &plan_cache;
+    while (*link) {
+        FFTPlanF32 *plan = *link;
+        if (plan->n == n && plan->direction == direction && plan->is_real == is_real) {
+            *link = plan->next;
+            plan->next = NULL;
+            pthread_mutex_unlock(&plan_cache_lock);
+            CONV_STATS_PLAN(1);
+            return plan;
+        }
+        link = &plan->next;
+    }
+    pthread_mutex_unlock(&plan_cache_lock);
+
+    CONV_STATS_PLAN(0);
+    return is_real ? fft_plan_create_real_f32(n, direction) : fft_plan_create_f32(n, direction);
+}
+
+FFTPlanF32* fft_plan_acquire_f32(int n, int direction) {
+    return acquire_plan(n, direction, 0);
+}
+
+FFTPlanF32* fft_plan_acquire_real_f32(int n, int direction) {
+    return acquire_plan(n, direction, 1);
+}
+
+// Return a float plan to the cache for reuse
+void fft_plan_release_f32(FFTPlanF32 *plan) {
+    if (!plan) return;
+
+    pthread_mutex_lock(&plan_cache_lock);
+    plan->next = plan_cache;
+    plan_cache = plan;
+    pthread_mutex_unlock(&plan_cache_lock);
+}
+
+// Free every idle float plan (called by fft_plan_cache_clear)
+void fft_plan_cache_clear_f32(void) {
+    pthread_mutex_lock(&plan_cache_lock);
+    FFTPlanF32 *plan = plan_cache;
+    plan_cache = NULL;
+    pthread_mutex_unlock(&plan_cache_lock);
+
+    while (plan) {
+        FFTPlanF32 *next = plan->next;
+        fft_plan_destroy_f32(plan);
+        plan = next;
+    }
+}
@@ -0,0 +1,576 @@
+#include "../include/convolution.h"
+
+// Single-precision signals and the float32 entry points of convolve,
+// convolve_fft, convolve_overlap_add and compute_fft. Samples stay float
+// end to end; conv_get_precision() picks float or double arithmetic.
+
+// Create a single-precision signal (from the bound arena when there is one)
+SignalF32* create_signal_f32(int length, double sample_rate) {
+    SignalArena *arena = signal_arena_current();
+    if (arena && length >= 0) {
+        size_t header = (sizeof(SignalF32) + 63) & ~(size_t)63;
+        unsigned char *block = (unsigned char*)signal_arena_alloc(
+            arena, header + (size_t)length * sizeof(float));
+        if (block) {
+            SignalF32 *signal = (SignalF32*)block;
+            signal->data = (float*)(block + header);
+            memset(signal->data, 0, (size_t)length * sizeof(float));
+            signal_init_f32(signal, signal->data, length, sample_rate);
+            signal->storage = STORAGE_ARENA;
+            CONV_STATS_ALLOC(header + (size_t)length * sizeof(float));
+            return signal;
+        }
+    }
+
+    SignalF32 *signal = (SignalF32*)malloc(sizeof(SignalF32));
+    if (!signal) return NULL;
+
+    signal->data = (float*)calloc(length, sizeof(float));
+    if (!signal->data) {
+        free(signal);
+        return NULL;
+    }
+
+    signal_init_f32(signal, signal->data, length, sample_rate);
+    signal->storage = STORAGE_HEAP;
+    CONV_STATS_ALLOC(sizeof(SignalF32) + (size_t)length * sizeof(float));
+
+    return signal;
+}
+
+// Wrap caller-owned float samples (see signal_init)
+void signal_init_f32(SignalF32 *signal, float *data, int length, double sample_rate) {
+    if (!signal) return;
+
+    signal->data = data;
+    signal->length = length;
+    signal->sample_rate = sample_rate;
+    signal->duration = (double)length / sample_rate;
+    signal->type = SIGNAL_CUSTOM;
+    strcpy(signal->name, "Untitled Signal");
+    signal->storage = STORAGE_EXTERNAL;
+}
+
+// Free a single-precision signal (heap signals only)
+void free_signal_f32(SignalF32 *signal) {
+    if (signal && signal->storage == STORAGE_HEAP) {
+        if (signal->data) {
+            free(signal->data);
+        }
+        free(signal);
+    }
+}
+
+// Float copy of a double signal
+SignalF32* signal_to_f32(const Signal *signal) {
+    if (!signal) return NULL;
+
+    SignalF32 *result = create_signal_f32(signal->length, signal->sample_rate);
+    if (!result) return NULL;
+
+    for (int i = 0; i < signal->length; i++) {
+        result->data[i] = (float)signal->data[i];
+    }
+    result->type = signal->type;
+    strcpy(result->name, signal->name);
+
+    return result;
+}
+
+// Double copy of a float signal
+Signal* signal_from_f32(const SignalF32 *signal) {
+    if (!signal) return NULL;
+
+    Signal *result = create_signal(signal->length, signal->sample_rate);
+    if (!result) return NULL;
+
+    for (int i = 0; i < signal->length; i++) {
+        result->data[i] = signal->data[i];
+    }
+    result->type = signal->type;
+    strcpy(result->name, signal->name);
+
+    return result;
+}
+
+// New float signal of the given length for the result of a convolution
+static SignalF32* create_result_f32(int length, const SignalF32 *signal1,
+                                    const SignalF32 *signal2, const char *prefix) {
+    SignalF32 *result = create_signal_f32(length, signal1->sample_rate);
+    if (!result) return NULL;
+
+    result->type = SIGNAL_CUSTOM;
+    snprintf(result->name, sizeof(result->name), "%.8s(%.24s * %.24s)",
+             prefix, signal1->name, signal2->name);
+
+    return result;
+}
+
+// Direct linear convolution of float signals
+SignalF32* convolve_f32(const SignalF32 *signal1, const SignalF32 *signal2) {
+    if (!signal1 || !signal2) return NULL;
+
+    SignalF32 *result = create_result_f32(signal1->length + signal2->length - 1,
+                                          signal1, signal2, "Conv");
+    if (!result) return NULL;
+
+    convolve_into_f32(result, signal1, signal2);
+
+    return result;
+}
+
+// Direct convolution into a caller-provided signal of exactly
+// signal1->length + signal2->length - 1 samples. Returns 0 or -1.
+int convolve_into_f32(SignalF32 *output, const SignalF32 *signal1, const SignalF32 *signal2) {
+    if (!output || !signal1 || !signal2) return -1;
+    if (output->length != signal1->length + signal2->length - 1) return -1;
+    CONV_STATS_START(stats_start);
+
+    convolve_direct_kernel_f32(signal1->data, signal1->length,
+                               signal2->data, signal2->length, output->data);
+
+    CONV_STATS_STOP(CONV_STAT_F32, stats_start, output->length);
+    return 0;
+}
+
+// FFT-based convolution of float signals
+SignalF32* convolve_fft_f32(const SignalF32 *signal1, const SignalF32 *signal2) {
+    if (!signal1 || !signal2 || signal1->length < 1 || signal2->length < 1) return NULL;
+
+    SignalF32 *result = create_result_f32(signal1->length + signal2->length - 1,
+                                          signal1, signal2, "FFTConv");
+    if (!result) return NULL;
+
+    if (convolve_fft_into_f32(result, signal1, signal2) != 0) {
+        free_signal_f32(result);
+        return NULL;
+    }
+
+    return result;
+}
+
+// Full-length FFT convolution in single precision, laid out like
+// convolve_fft_into on float plans
+static int convolve_fft_single(float *output, const SignalF32 *signal1,
+                               const SignalF32 *signal2, int fft_size) {
+    FFTPlanF32 *forward = fft_plan_acquire_real_f32(fft_size, FFT_FORWARD);
+    FFTPlanF32 *inverse = fft_plan_acquire_real_f32(fft_size, FFT_INVERSE);
+
+    if (!forward || !inverse) {
+        fft_plan_release_f32(forward);
+        fft_plan_release_f32(inverse);
+        return -1;
+    }
+
+    ComplexF32 *fft1 = forward->scratch;
+    ComplexF32 *fft2 = inverse->scratch;
+    float *padded1 = (float*)fft1;
+    float *padded2 = (float*)fft2;
+
+    memcpy(padded1, signal1->data, signal1->length * sizeof(float));
+    memset(padded1 + signal1->length, 0, (fft_size - signal1->length) * sizeof(float));
+    memcpy(padded2, signal2->data, signal2->length * sizeof(float));
+    memset(padded2 + signal2->length, 0, (fft_size - signal2->length) * sizeof(float));
+
+    fft_execute_r2c_f32(forward, padded1, fft1);
+    fft_execute_r2c_f32(forward, padded2, fft2);
+
+    float scale = 1.0f / fft_size;
+    for (int i = 0; i <= fft_size / 2; i++) {
+        ComplexF32 temp = {
+            (fft1[i].real * fft2[i].real - fft1[i].imag * fft2[i].imag) * scale,
+            (fft1[i].real * fft2[i].imag + fft1[i].imag * fft2[i].real) * scale
+        };
+        fft1[i] = temp;
+    }
+
+    fft_execute_c2r_f32(inverse, fft1, padded1);
+    memcpy(output, padded1, (signal1->length + signal2->length - 1) * sizeof(float));
+
+    fft_plan_release_f32(forward);
+    fft_plan_release_f32(inverse);
+
+    return 0;
+}
+
+// Full-length FFT convolution of float samples on the double engine
+static int convolve_fft_mixed(float *output, const SignalF32 *signal1,
+                              const SignalF32 *signal2, int fft_size) {
+    FFTPlan *forward = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+    FFTPlan *inverse = fft_plan_acquire_real(fft_size, FFT_INVERSE);
+
+    if (!forward || !inverse) {
+        fft_plan_release(forward);
+        fft_plan_release(inverse);
+        return -1;
+    }
+
+    int bins = fft_size / 2 + 1;
+    double *fft1 = (double*)forward->scratch;
+    double *fft2 = (double*)inverse->scratch;
+
+    for (int i = 0; i < fft_size; i++) {
+        fft1[i] = (i < signal1->length) ? signal1->data[i] : 0.0;
+        fft2[i] = (i < signal2->length) ? signal2->data[i] : 0.0;
+    }
+
+    fft_execute_r2c_split(forward, fft1, fft1, fft1 + bins);
+    fft_execute_r2c_split(forward, fft2, fft2, fft2 + bins);
+
+    double scale = 1.0 / fft_size;
+    for (int i = 0; i < 2 * bins; i++) {
+        fft2[i] *= scale;
+    }
+    spectrum_multiply_split(fft1, fft2, bins);
+
+    fft_execute_c2r_split(inverse, fft1, fft1 + bins, fft1);
+
+    int conv_length = signal1->length + signal2->length - 1;
+    for (int i = 0; i < conv_length; i++) {
+        output[i] = (float)fft1[i];
+    }
+
+    fft_plan_release(forward);
+    fft_plan_release(inverse);
+
+    return 0;
+}
+
+// FFT convolution into a caller-provided signal of exactly
+// signal1->length + signal2->length - 1 samples. Returns 0 or -1.
+int convolve_fft_into_f32(SignalF32 *output, const SignalF32 *signal1, const SignalF32 *signal2) {
+    if (!output || !signal1 || !signal2) return -1;
+    if (signal1->length < 1 || signal2->length < 1) return -1;
+
+    int conv_length = signal1->length + signal2->length - 1;
+    if (output->length != conv_length) return -1;
+
+    int fft_size = next_power_of_2(conv_length);
+    if (fft_size < 2) fft_size = 2;
+    CONV_STATS_START(stats_start);
+
+    int status = (conv_get_precision() == CONV_PRECISION_MIXED)
+        ? convolve_fft_mixed(output->data, signal1, signal2, fft_size)
+        : convolve_fft_single(output->data, signal1, signal2, fft_size);
+
+    CONV_STATS_STOP(CONV_STAT_F32, stats_start, conv_length);
+    return status;
+}
+
+// Overlap-add convolution of float signals with an automatic block size
+SignalF32* convolve_overlap_add_f32(const SignalF32 *signal, const SignalF32 *kernel) {
+    if (!signal || !kernel || signal->length < 1 || kernel->length < 1) return NULL;
+
+    SignalF32 *result = create_result_f32(signal->length + kernel->length - 1,
+                                          signal, kernel, "OLA");
+    if (!result) return NULL;
+
+    if (convolve_overlap_add_into_f32(result, signal, kernel, 0) != 0) {
+        free_signal_f32(result);
+        return NULL;
+    }
+
+    return result;
+}
+
+// Overlap-add in single precision. Each block's F outputs go straight to
+// the output, except for the first M - 1, which add the carry left by the
+// blocks before it; workspace holds the kernel bins (F + 2 floats) and
+// the carry (M - 1 floats).
+static int overlap_add_single(float *output, const SignalF32 *signal,
+                              const SignalF32 *kernel, int fft_size, double *workspace) {
+    int history = kernel->length - 1;
+    int block_length = fft_size - history;
+
+    FFTPlanF32 *forward = fft_plan_acquire_real_f32(fft_size, FFT_FORWARD);
+    FFTPlanF32 *inverse = fft_plan_acquire_real_f32(fft_size, FFT_INVERSE);
+
+    if (!forward || !inverse) {
+        fft_plan_release_f32(forward);
+        fft_plan_release_f32(inverse);
+        return -1;
+    }
+
+    // Kernel spectrum, pre-scaled by 1/F
+    ComplexF32 *kernel_bins = (ComplexF32*)workspace;
+    float *carry = (float*)(workspace + fft_size + 2);
+    float *padded = (float*)kernel_bins;
+    memcpy(padded, kernel->data, kernel->length * sizeof(float));
+    memset(padded + kernel->length, 0, (fft_size - kernel->length) * sizeof(float));
+    fft_execute_r2c_f32(forward, padded, kernel_bins);
+
+    int bins = fft_size / 2 + 1;
+    float scale = 1.0f / fft_size;
+    for (int i = 0; i < bins; i++) {
+        kernel_bins[i].real *= scale;
+        kernel_bins[i].imag *= scale;
+    }
+
+    memset(carry, 0, history * sizeof(float));
+    float *buffer = (float*)forward->scratch;
+    ComplexF32 *block_bins = forward->scratch;
+
+    for (int start = 0; start < signal->length; start += block_length) {
+        int count = signal->length - start;
+        if (count > block_length) count = block_length;
+
+        memcpy(buffer, &signal->data[start], count * sizeof(float));
+        memset(buffer + count, 0, (fft_size - count) * sizeof(float));
+
+        fft_execute_r2c_f32(forward, buffer, block_bins);
+        for (int i = 0; i < bins; i++) {
+            ComplexF32 temp = {
+                block_bins[i].real * kernel_bins[i].real - block_bins[i].imag * kernel_bins[i].imag,
+                block_bins[i].real * kernel_bins[i].imag + block_bins[i].imag * kernel_bins[i].real
+            };
+            block_bins[i] = temp;
+        }
+        fft_execute_c2r_f32(inverse, block_bins, buffer);
+
+        for (int i = 0; i < history; i++) {
+            buffer[i] += carry[i];
+        }
+
+        if (start + block_length >= signal->length) {
+            memcpy(&output[start], buffer, (count + history) * sizeof(float));
+        } else {
+            memcpy(&output[start], buffer, block_length * sizeof(float));
+            memcpy(carry, buffer + block_length, history * sizeof(float));
+        }
+    }
+
+    fft_plan_release_f32(forward);
+    fft_plan_release_f32(inverse);
+
+    return 0;
+}
+
+// Overlap-add of float samples on the double engine: blocks are widened to
+// double, filtered with kernel_spectrum_filter, and the carry between
+// blocks is kept in double, so each output is rounded to float once.
+// workspace holds the kernel bins (F + 2 doubles) and the carry.
+static int overlap_add_mixed(float *output, const SignalF32 *signal,
+                             const SignalF32 *kernel, int fft_size, double *workspace) {
+    int history = kernel->length - 1;
+    int block_length = fft_size - history;
+
+    FFTPlan *forward = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+    FFTPlan *inverse = fft_plan_acquire_real(fft_size, FFT_INVERSE);
+
+    if (!forward || !inverse) {
+        fft_plan_release(forward);
+        fft_plan_release(inverse);
+        return -1;
+    }
+
+    int bins = fft_size / 2 + 1;
+    KernelSpectrum spectrum = {workspace, fft_size, kernel->length};
+    double *carry = workspace + fft_size + 2;
+    double *padded = workspace;
+    for (int i = 0; i < fft_size; i++) {
+        padded[i] = (i < kernel->length) ? kernel->data[i] : 0.0;
+    }
+    fft_execute_r2c_split(forward, padded, spectrum.bins, spectrum.bins + bins);
+
+    double scale = 1.0 / fft_size;
+    for (int i = 0; i < 2 * bins; i++) {
+        spectrum.bins[i] *= scale;
+    }
+
+    memset(carry, 0, history * sizeof(double));
+    double *buffer = (double*)forward->scratch;
+
+    for (int start = 0; start < signal->length; start += block_length) {
+        int count = signal->length - start;
+        if (count > block_length) count = block_length;
+
+        for (int i = 0; i < count; i++) {
+            buffer[i] = signal->data[start + i];
+        }
+        memset(buffer + count, 0, (fft_size - count) * sizeof(double));
+
+        kernel_spectrum_filter(&spectrum, forward, inverse, buffer);
+
+        for (int i = 0; i < history; i++) {
+            buffer[i] += carry[i];
+        }
+
+        int finished = block_length;
+        if (start + block_length >= signal->length) {
+            finished = count + history;
+        } else {
+            memcpy(carry, buffer + block_length, history * sizeof(double));
+        }
+        for (int i = 0; i < finished; i++) {
+            output[start + i] = (float)buffer[i];
+        }
+    }
+
+    fft_plan_release(forward);
+    fft_plan_release(inverse);
+
+    return 0;
+}
+
+// Overlap-add into a caller-provided signal of exactly
+// signal->length + kernel->length - 1 samples. fft_size 0 picks the size
+// as convolve_block does. Returns 0 on success, -1 on error.
+int convolve_overlap_add_into_f32(SignalF32 *output, const SignalF32 *signal,
+                                  const SignalF32 *kernel, int fft_size) {
+    if (!output || !signal || !kernel || signal->length < 1 || kernel->length < 1) return -1;
+
+    int conv_length = signal->length + kernel->length - 1;
+    if (output->length != conv_length) return -1;
+
+    if (fft_size <= 0) {
+        fft_size = choose_block_fft_size(kernel->length);
+
+        int full_size = next_power_of_2(conv_length);
+        if (full_size < 2) full_size = 2;
+        if (fft_size > full_size) fft_size = full_size;
+    }
+    if (fft_size < kernel->length || (fft_size & (fft_size - 1)) != 0) return -1;
+
+    double *workspace = conv_workspace((size_t)fft_size + 2 + kernel->length);
+    if (!workspace) return -1;
+    CONV_STATS_START(stats_start);
+
+    int status = (conv_get_precision() == CONV_PRECISION_MIXED)
+        ? overlap_add_mixed(output->data, signal, kernel, fft_size, workspace)
+        : overlap_add_single(output->data, signal, kernel, fft_size, workspace);
+
+    CONV_STATS_STOP(CONV_STAT_F32, stats_start, conv_length);
+    return status;
+}
+
+// Allocate a single-precision FFT result with length bins (one block, see
+// fft_result_create)
+FFTResultF32* fft_result_create_f32(int length) {
+    if (length < 1) return NULL;
+
+    size_t header = (sizeof(FFTResultF32) + 63) & ~(size_t)63;
+    size_t bytes = header + (size_t)length * (sizeof(ComplexF32) + 3 * sizeof(float));
+
+    StorageKind storage = STORAGE_ARENA;
+    unsigned char *block = (unsigned char*)signal_arena_alloc(signal_arena_current(), bytes);
+    if (!block) {
+        storage = STORAGE_HEAP;
+        block = (unsigned char*)malloc(bytes);
+        if (!block) return NULL;
+    }
+    CONV_STATS_ALLOC(bytes);
+
+    FFTResultF32 *result = (FFTResultF32*)block;
+    result->data = (ComplexF32*)(block + header);
+    result->magnitude = (float*)(result->data + length);
+    result->phase = result->magnitude + length;
+    result->frequency = result->phase + length;
+    result->length = length;
+    result->storage = storage;
+
+    return result;
+}
+
+// Spectrum of a float signal (see compute_fft)
+FFTResultF32* compute_fft_f32(const SignalF32 *signal) {
+    if (!signal) return NULL;
+
+    FFTResultF32 *result = fft_result_create_f32(next_power_of_2(signal->length));
+    if (!result) return NULL;
+
+    if (compute_fft_into_f32(result, signal) != 0) {
+        free_fft_result_f32(result);
+        return NULL;
+    }
+
+    return result;
+}
+
+// Lower bins 0..F/2 of the real FFT of a float signal, plus magnitude and
+// phase. Mixed precision transforms and derives them in double.
+static int half_spectrum_f32(FFTResultF32 *result, const SignalF32 *signal, int fft_size) {
+    int half = fft_size / 2;
+
+    if (conv_get_precision() == CONV_PRECISION_MIXED) {
+        FFTPlan *plan = fft_plan_acquire_real(fft_size, FFT_FORWARD);
+        if (!plan) return -1;
+
+        double *padded = (double*)plan->scratch;
+        double *real = padded;
+        double *imag = padded + half + 1;
+        for (int i = 0; i < fft_size; i++) {
+            padded[i] = (i < signal->length) ? signal->data[i] : 0.0;
+        }
+        fft_execute_r2c_split(plan, padded, real, imag);
+
+        for (int i = 0; i <= half; i++) {
+            result->data[i].real = (float)real[i];
+            result->data[i].imag = (float)imag[i];
+            result->magnitude[i] = (float)sqrt(real[i] * real[i] + imag[i] * imag[i]);
+            result->phase[i] = (float)atan2(imag[i], real[i]);
+        }
+
+        fft_plan_release(plan);
+        return 0;
+    }
+
+    FFTPlanF32 *plan = fft_plan_acquire_real_f32(fft_size, FFT_FORWARD);
+    if (!plan) return -1;
+
+    float *padded = (float*)plan->scratch;
+    memcpy(padded, signal->data, signal->length * sizeof(float));
+    memset(padded + signal->length, 0, (fft_size - signal->length) * sizeof(float));
+    fft_execute_r2c_f32(plan, padded, result->data);
+    fft_plan_release_f32(plan);
+
+    for (int i = 0; i <= half; i++) {
+        ComplexF32 bin = result->data[i];
+        result->magnitude[i] = sqrtf(bin.real * bin.real + bin.imag * bin.imag);
+        result->phase[i] = atan2f(bin.imag, bin.real);
+    }
+
+    return 0;
+}
+
+// Spectrum of a float signal into a caller-provided result of
+// next_power_of_2(signal->length) bins. Returns 0 on success, -1 on error.
+int compute_fft_into_f32(FFTResultF32 *result, const SignalF32 *signal) {
+    if (!result || !signal || !signal->data || signal->length < 1) return -1;
+
+    int fft_size = next_power_of_2(signal->length);
+    if (result->length != fft_size) return -1;
+    CONV_STATS_START(stats_start);
+
+    if (fft_size == 1) {
+        result->data[0].real = signal->data[0];
+        result->data[0].imag = 0.0f;
+        result->magnitude[0] = fabsf(signal->data[0]);
+        result->phase[0] = atan2f(0.0f, signal->data[0]);
+    } else {
+        if (half_spectrum_f32(result, signal, fft_size) != 0) return -1;
+
+        // Upper bins by conjugate symmetry
+        for (int i = 1; i < fft_size / 2; i++) {
+            result->data[fft_size - i].real = result->data[i].real;
+            result->data[fft_size - i].imag = -result->data[i].imag;
+            result->magnitude[fft_size - i] = result->magnitude[i];
+            result->phase[fft_size - i] = -result->phase[i];
+        }
+    }
+
+    double freq_resolution = signal->sample_rate / fft_size;
+    for (int i = 0; i < fft_size; i++) {
+        int bin = (i <= fft_size / 2) ? i : i - fft_size;
+        result->frequency[i] = (float)(bin * freq_resolution);
+    }
+
+    CONV_STATS_STOP(CONV_STAT_SPECTRUM, stats_start, signal->length);
+    return 0;
+}
+
+// Free a single-precision FFT result (heap results only)
+void free_fft_result_f32(FFTResultF32 *result) {
+    if (result && result->storage == STORAGE_HEAP) {
+        free(result);
+    }
+}
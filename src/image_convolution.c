@@ -0,0 +1,702 @@
+#include "../include/convolution.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONV_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Output tile of the direct path: a TILE_WIDTH-pixel row segment stays in
+// L1 while every kernel tap is added into it, and the TILE_ROWS rows of a
+// tile share their input rows through L2
+#define TILE_WIDTH 256
+#define TILE_ROWS 16
+
+// Spectrum columns the FFT column passes gather at once: one cache line
+// of every row
+#define FFT_COLUMN_GROUP 8
+
+// A kernel is separable when its rank-1 fit misses no tap by more than
+// this fraction of the largest tap
+#define SEPARABLE_TOLERANCE 1e-12
+
+// Convolutions with at least this many multiply-adds use the thread pool
+#define IMAGE_PARALLEL_MIN_WORK (1 << 20)
+
+static const char *image_algorithm_names[] = {"direct", "separable", "fft"};
+
+// Display name of a 2D algorithm
+const char* image_conv_algorithm_name(ImageConvAlgorithm algorithm) {
+    if (algorithm < IMAGE_CONV_DIRECT || algorithm > IMAGE_CONV_FFT) return "unknown";
+    return image_algorithm_names[algorithm];
+}
+
+// Create a zeroed width x height image. Like create_signal, it draws from
+// the bound arena when there is one.
+Image* create_image(int width, int height) {
+    if (width < 1 || height < 1) return NULL;
+
+    size_t bytes = (size_t)width * height * sizeof(double);
+    SignalArena *arena = signal_arena_current();
+    if (arena) {
+        size_t header = (sizeof(Image) + 63) & ~(size_t)63;
+        unsigned char *block = (unsigned char*)signal_arena_alloc(arena, header + bytes);
+        if (block) {
+            Image *image = (Image*)block;
+            double *data = (double*)(block + header);
+            memset(data, 0, bytes);
+            image_init(image, data, width, height, width);
+            image->storage = STORAGE_ARENA;
+            CONV_STATS_ALLOC(header + bytes);
+            return image;
+        }
+    }
+
+    Image *image = (Image*)malloc(sizeof(Image));
+    if (!image) return NULL;
+
+    double *data = (double*)calloc((size_t)width * height, sizeof(double));
+    if (!data) {
+        free(image);
+        return NULL;
+    }
+
+    image_init(image, data, width, height, width);
+    image->storage = STORAGE_HEAP;
+    CONV_STATS_ALLOC(sizeof(Image) + bytes);
+
+    return image;
+}
+
+// Wrap caller-owned pixels (rows stride doubles apart) in a caller-owned
+// Image. free_image must not be called on it.
+void image_init(Image *image, double *data, int width, int height, int stride) {
+    if (!image) return;
+
+    image->data = data;
+    image->width = width;
+    image->height = height;
+    image->stride = (stride >= width) ? stride : width;
+    image->storage = STORAGE_EXTERNAL;
+    snprintf(image->name, sizeof(image->name), "Image %dx%d", width, height);
+}
+
+// Free a heap image; arena and caller-owned images are left alone
+void free_image(Image *image) {
+    if (image && image->storage == STORAGE_HEAP) {
+        if (image->data) free(image->data);
+        free(image);
+    }
+}
+
+// First index and length a mode keeps along one axis of a full
+// convolution of n pixels with m taps
+static void axis_range(ConvMode mode, int n, int m, int *start, int *length) {
+    int shorter = (n < m) ? n : m;
+    int longer = (n < m) ? m : n;
+
+    switch (mode) {
+        case CONV_MODE_SAME:
+            *start = (m - 1) / 2;
+            *length = n;
+            break;
+        case CONV_MODE_VALID:
+            *start = shorter - 1;
+            *length = longer - shorter + 1;
+            break;
+        default:
+            *start = 0;
+            *length = n + m - 1;
+            break;
+    }
+}
+
+// Split count items into ranges of *chunk for the pool; small jobs get a
+// single range. Returns the number of ranges.
+static int split_work(int count, double work, int *chunk) {
+    int tasks = 1;
+    int threads = conv_get_num_threads();
+    if (threads > 1 && work >= IMAGE_PARALLEL_MIN_WORK) {
+        tasks = 4 * threads;
+        if (tasks > count) tasks = count;
+    }
+
+    *chunk = (count + tasks - 1) / tasks;
+    return (count + *chunk - 1) / *chunk;
+}
+
+// y[0..n) += a * x[0..n)
+static void axpy_scalar(double *y, double a, const double *x, int n) {
+    for (int i = 0; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+#if defined(CONV_HAVE_X86_SIMD)
+__attribute__((target("avx2,fma")))
+static int axpy_avx2(double *y, double a, const double *x, int n) {
+    __m256d av = _mm256_set1_pd(a);
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256d y0 = _mm256_fmadd_pd(av, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i));
+        __m256d y1 = _mm256_fmadd_pd(av, _mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4));
+        _mm256_storeu_pd(y + i, y0);
+        _mm256_storeu_pd(y + i + 4, y1);
+    }
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(av, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static int axpy_avx512(double *y, double a, const double *x, int n) {
+    __m512d av = _mm512_set1_pd(a);
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m512d y0 = _mm512_fmadd_pd(av, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i));
+        __m512d y1 = _mm512_fmadd_pd(av, _mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8));
+        _mm512_storeu_pd(y + i, y0);
+        _mm512_storeu_pd(y + i + 8, y1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(y + i, _mm512_fmadd_pd(av, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+    }
+
+    return i;
+}
+#endif
+
+// Row update used by the direct and separable column passes
+static void axpy(double *y, double a, const double *x, int n, SimdLevel level) {
+    int done = 0;
+
+#if defined(CONV_HAVE_X86_SIMD)
+    if (level == SIMD_AVX512) {
+        done = axpy_avx512(y, a, x, n);
+    } else if (level == SIMD_AVX2) {
+        done = axpy_avx2(y, a, x, n);
+    }
+#else
+    (void)level;
+#endif
+
+    axpy_scalar(y + done, a, x + done, n - done);
+}
+
+// Test whether kernel = column * row^T. On success, and when the buffers
+// are given, fill column (kernel->height taps) and row (kernel->width
+// taps). Returns 1 if separable, 0 if not.
+int image_kernel_separable(const Image *kernel, double *column, double *row) {
+    if (!kernel || !kernel->data || kernel->width < 1 || kernel->height < 1) return 0;
+
+    int kh = kernel->height;
+    int kw = kernel->width;
+    int stride = kernel->stride;
+    const double *k = kernel->data;
+
+    // Factor through the largest tap: column = its column, row = its row
+    // divided by it
+    int pivot_row = 0, pivot_column = 0;
+    double peak = 0.0;
+    for (int i = 0; i < kh; i++) {
+        for (int j = 0; j < kw; j++) {
+            if (fabs(k[i * stride + j]) > peak) {
+                peak = fabs(k[i * stride + j]);
+                pivot_row = i;
+                pivot_column = j;
+            }
+        }
+    }
+
+    double pivot = k[pivot_row * stride + pivot_column];
+    double tolerance = SEPARABLE_TOLERANCE * peak;
+    if (peak > 0.0) {
+        for (int i = 0; i < kh; i++) {
+            double c = k[i * stride + pivot_column];
+            for (int j = 0; j < kw; j++) {
+                double fit = c * (k[pivot_row * stride + j] / pivot);
+                if (fabs(k[i * stride + j] - fit) > tolerance) return 0;
+            }
+        }
+    }
+
+    if (column) {
+        for (int i = 0; i < kh; i++) column[i] = k[i * stride + pivot_column];
+    }
+    if (row) {
+        for (int j = 0; j < kw; j++) row[j] = (peak > 0.0) ? k[pivot_row * stride + j] / pivot : 0.0;
+    }
+    return 1;
+}
+
+// Shared state of a separable convolution. The row pass writes full rows
+// (width + row_length - 1 pixels) of every image row into rows; the column
+// pass combines column_length of them per output row.
+typedef struct {
+    const Image *image;
+    const double *column;
+    const double *row;
+    int column_length;
+    int row_length;
+    double *rows;
+    int row_stride;
+    Image *output;
+    int y0, x0;             // Full-convolution coordinates of output pixel (0, 0)
+    int chunk;
+    SimdLevel level;
+} SeparableJob;
+
+static void separable_row_task(void *context, int index) {
+    const SeparableJob *job = (const SeparableJob*)context;
+    const Image *image = job->image;
+    int start = index * job->chunk;
+    int end = (start + job->chunk < image->height) ? start + job->chunk : image->height;
+
+    for (int y = start; y < end; y++) {
+        convolve_direct_kernel_at(image->data + (size_t)y * image->stride, image->width,
+                                  job->row, job->row_length,
+                                  job->rows + (size_t)y * job->row_stride, job->level);
+    }
+}
+
+static void separable_column_task(void *context, int index) {
+    const SeparableJob *job = (const SeparableJob*)context;
+    Image *output = job->output;
+    int start = index * job->chunk;
+    int end = (start + job->chunk < output->height) ? start + job->chunk : output->height;
+
+    for (int oy = start; oy < end; oy++) {
+        double *out = output->data + (size_t)oy * output->stride;
+        memset(out, 0, output->width * sizeof(double));
+
+        int y = job->y0 + oy;
+        for (int i = 0; i < job->column_length; i++) {
+            int source = y - i;
+            if (source < 0 || source >= job->image->height) continue;
+
+            axpy(out, job->column[i], job->rows + (size_t)source * job->row_stride + job->x0,
+                 output->width, job->level);
+        }
+    }
+}
+
+// Separable convolution into output: the row kernel along every image row
+// with the 1D SIMD kernel, then the column kernel down the columns as
+// whole-row updates
+static int separable_convolve(Image *output, const Image *image, const double *column,
+                              int column_length, const double *row, int row_length,
+                              int y0, int x0) {
+    SeparableJob job;
+    job.image = image;
+    job.column = column;
+    job.row = row;
+    job.column_length = column_length;
+    job.row_length = row_length;
+    job.row_stride = image->width + row_length - 1;
+    job.output = output;
+    job.y0 = y0;
+    job.x0 = x0;
+    job.level = conv_get_simd_level();
+    job.rows = (double*)malloc((size_t)image->height * job.row_stride * sizeof(double));
+    if (!job.rows) return -1;
+
+    double work = (double)image->height * job.row_stride * row_length;
+    int tasks = split_work(image->height, work, &job.chunk);
+    conv_parallel_for(tasks, separable_row_task, &job);
+
+    work = (double)output->height * output->width * column_length;
+    tasks = split_work(output->height, work, &job.chunk);
+    conv_parallel_for(tasks, separable_column_task, &job);
+
+    free(job.rows);
+    return 0;
+}
+
+// Shared state of a tiled direct convolution
+typedef struct {
+    const Image *image;
+    const Image *kernel;
+    Image *output;
+    int y0, x0;
+    int tiles_across;
+    int tile_count;
+    int chunk;
+    SimdLevel level;
+} DirectImageJob;
+
+// One output tile: every kernel tap is added into each row segment while
+// it is in L1. Taps that are zero (common in edge kernels) are skipped.
+static void direct_tile(const DirectImageJob *job, int tile) {
+    const Image *image = job->image;
+    const Image *kernel = job->kernel;
+    Image *output = job->output;
+
+    int oy_start = (tile / job->tiles_across) * TILE_ROWS;
+    int ox_start = (tile % job->tiles_across) * TILE_WIDTH;
+    int oy_end = (oy_start + TILE_ROWS < output->height) ? oy_start + TILE_ROWS : output->height;
+    int ox_end = (ox_start + TILE_WIDTH < output->width) ? ox_start + TILE_WIDTH : output->width;
+
+    for (int oy = oy_start; oy < oy_end; oy++) {
+        double *out = output->data + (size_t)oy * output->stride + ox_start;
+        memset(out, 0, (ox_end - ox_start) * sizeof(double));
+
+        int y = job->y0 + oy;
+        for (int i = 0; i < kernel->height; i++) {
+            int source = y - i;
+            if (source < 0 || source >= image->height) continue;
+
+            const double *pixels = image->data + (size_t)source * image->stride;
+            const double *taps = kernel->data + (size_t)i * kernel->stride;
+
+            for (int j = 0; j < kernel->width; j++) {
+                if (taps[j] == 0.0) continue;
+
+                // Output column x0 + ox reads image column x0 + ox - j
+                int lo = ox_start, hi = ox_end;
+                if (lo < j - job->x0) lo = j - job->x0;
+                if (hi > image->width + j - job->x0) hi = image->width + j - job->x0;
+                if (lo >= hi) continue;
+
+                axpy(out + (lo - ox_start), taps[j], pixels + job->x0 + lo - j, hi - lo, job->level);
+            }
+        }
+    }
+}
+
+static void direct_tile_task(void *context, int index) {
+    const DirectImageJob *job = (const DirectImageJob*)context;
+    int start = index * job->chunk;
+    int end = (start + job->chunk < job->tile_count) ? start + job->chunk : job->tile_count;
+
+    for (int tile = start; tile < end; tile++) {
+        direct_tile(job, tile);
+    }
+}
+
+static int direct_convolve(Image *output, const Image *image, const Image *kernel,
+                           int y0, int x0) {
+    DirectImageJob job;
+    job.image = image;
+    job.kernel = kernel;
+    job.output = output;
+    job.y0 = y0;
+    job.x0 = x0;
+    job.level = conv_get_simd_level();
+    job.tiles_across = (output->width + TILE_WIDTH - 1) / TILE_WIDTH;
+    job.tile_count = job.tiles_across * ((output->height + TILE_ROWS - 1) / TILE_ROWS);
+
+    double work = (double)output->height * output->width * kernel->height * kernel->width;
+    int tasks = split_work(job.tile_count, work, &job.chunk);
+    conv_parallel_for(tasks, direct_tile_task, &job);
+
+    return 0;
+}
+
+// Shared state of one pass of a 2D FFT. spectrum holds fft_rows x bins
+// complex values: the real plane, then the imaginary plane.
+typedef struct {
+    double *spectrum;
+    int fft_rows;
+    int fft_columns;
+    int bins;
+    const Image *source;    // Forward row pass: rows past its height are zero
+    Image *output;          // Inverse row pass: output rows from y0, columns from x0
+    int y0, x0;
+    int direction;          // Column passes
+    int count;
+    int chunk;
+    int failed;
+} ImageFFTJob;
+
+// Real transform of every row
+static void fft_rows_forward_task(void *context, int index) {
+    ImageFFTJob *job = (ImageFFTJob*)context;
+    FFTPlan *plan = fft_plan_acquire_real(job->fft_columns, FFT_FORWARD);
+    if (!plan) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    const Image *source = job->source;
+    double *buffer = (double*)plan->scratch;
+    double *imag = job->spectrum + (size_t)job->fft_rows * job->bins;
+    int start = index * job->chunk;
+    int end = (start + job->chunk < job->count) ? start + job->chunk : job->count;
+
+    for (int y = start; y < end; y++) {
+        double *re = job->spectrum + (size_t)y * job->bins;
+        double *im = imag + (size_t)y * job->bins;
+
+        if (y >= source->height) {
+            memset(re, 0, job->bins * sizeof(double));
+            memset(im, 0, job->bins * sizeof(double));
+            continue;
+        }
+
+        memcpy(buffer, source->data + (size_t)y * source->stride, source->width * sizeof(double));
+        memset(buffer + source->width, 0, (job->fft_columns - source->width) * sizeof(double));
+        fft_execute_r2c_split(plan, buffer, re, im);
+    }
+
+    fft_plan_release(plan);
+}
+
+// Complex transform of every bin column, FFT_COLUMN_GROUP columns at a time
+static void fft_columns_task(void *context, int index) {
+    ImageFFTJob *job = (ImageFFTJob*)context;
+    int rows = job->fft_rows;
+    FFTPlan *plan = fft_plan_acquire(rows, job->direction);
+    double *group = conv_workspace((size_t)2 * FFT_COLUMN_GROUP * rows);
+    if (!plan || !group) {
+        fft_plan_release(plan);
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    double *group_imag = group + (size_t)FFT_COLUMN_GROUP * rows;
+    double *plane_real = job->spectrum;
+    double *plane_imag = job->spectrum + (size_t)rows * job->bins;
+    int start = index * job->chunk;
+    int end = (start + job->chunk < job->count) ? start + job->chunk : job->count;
+
+    for (int g = start; g < end; g++) {
+        int first = g * FFT_COLUMN_GROUP;
+        int width = (job->bins - first < FFT_COLUMN_GROUP) ? job->bins - first : FFT_COLUMN_GROUP;
+
+        for (int y = 0; y < rows; y++) {
+            const double *re = plane_real + (size_t)y * job->bins + first;
+            const double *im = plane_imag + (size_t)y * job->bins + first;
+            for (int c = 0; c < width; c++) {
+                group[(size_t)c * rows + y] = re[c];
+                group_imag[(size_t)c * rows + y] = im[c];
+            }
+        }
+
+        for (int c = 0; c < width; c++) {
+            fft_execute_split(plan, group + (size_t)c * rows, group_imag + (size_t)c * rows);
+        }
+
+        for (int y = 0; y < rows; y++) {
+            double *re = plane_real + (size_t)y * job->bins + first;
+            double *im = plane_imag + (size_t)y * job->bins + first;
+            for (int c = 0; c < width; c++) {
+                re[c] = group[(size_t)c * rows + y];
+                im[c] = group_imag[(size_t)c * rows + y];
+            }
+        }
+    }
+
+    fft_plan_release(plan);
+}
+
+// Inverse real transform of the rows the output keeps
+static void fft_rows_inverse_task(void *context, int index) {
+    ImageFFTJob *job = (ImageFFTJob*)context;
+    FFTPlan *plan = fft_plan_acquire_real(job->fft_columns, FFT_INVERSE);
+    if (!plan) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    Image *output = job->output;
+    double *buffer = (double*)plan->scratch;
+    double *imag = job->spectrum + (size_t)job->fft_rows * job->bins;
+    int start = index * job->chunk;
+    int end = (start + job->chunk < job->count) ? start + job->chunk : job->count;
+
+    for (int oy = start; oy < end; oy++) {
+        size_t offset = (size_t)(job->y0 + oy) * job->bins;
+        fft_execute_c2r_split(plan, job->spectrum + offset, imag + offset, buffer);
+        memcpy(output->data + (size_t)oy * output->stride, buffer + job->x0,
+               output->width * sizeof(double));
+    }
+
+    fft_plan_release(plan);
+}
+
+// Run one pass over count items on the pool
+static int run_fft_pass(ImageFFTJob *job, ConvTaskFunction task, int count, int direction) {
+    job->count = count;
+    job->direction = direction;
+    job->failed = 0;
+
+    double work = (double)job->fft_rows * job->fft_columns * 8.0;
+    int tasks = split_work(count, work, &job->chunk);
+    conv_parallel_for(tasks, task, job);
+
+    return job->failed ? -1 : 0;
+}
+
+// Forward 2D transform of source into spectrum
+static int fft_forward_2d(ImageFFTJob *job, const Image *source) {
+    job->source = source;
+    if (run_fft_pass(job, fft_rows_forward_task, job->fft_rows, FFT_FORWARD) != 0) return -1;
+
+    int groups = (job->bins + FFT_COLUMN_GROUP - 1) / FFT_COLUMN_GROUP;
+    return run_fft_pass(job, fft_columns_task, groups, FFT_FORWARD);
+}
+
+// Row-column 2D FFT convolution: fft_rows x fft_columns (fast sizes) hold
+// the full result, the kernel spectrum is pre-scaled by the inverse's
+// 1 / (fft_rows * fft_columns), and only the kept rows are inverse-transformed
+static int fft_convolve_2d(Image *output, const Image *image, const Image *kernel,
+                           int y0, int x0) {
+    int fft_rows = fft_next_fast_size(image->height + kernel->height - 1);
+    int fft_columns = fft_next_fast_size_real(image->width + kernel->width - 1);
+    int bins = fft_columns / 2 + 1;
+    size_t span = (size_t)2 * fft_rows * bins;
+
+    double *spectra = (double*)malloc(2 * span * sizeof(double));
+    if (!spectra) return -1;
+
+    ImageFFTJob job = {0};
+    job.fft_rows = fft_rows;
+    job.fft_columns = fft_columns;
+    job.bins = bins;
+
+    job.spectrum = spectra + span;
+    int status = fft_forward_2d(&job, kernel);
+    if (status == 0) {
+        double scale = 1.0 / ((double)fft_rows * fft_columns);
+        for (size_t i = 0; i < span; i++) {
+            job.spectrum[i] *= scale;
+        }
+
+        job.spectrum = spectra;
+        status = fft_forward_2d(&job, image);
+    }
+
+    if (status == 0) {
+        spectrum_multiply_split(spectra, spectra + span, fft_rows * bins);
+
+        int groups = (bins + FFT_COLUMN_GROUP - 1) / FFT_COLUMN_GROUP;
+        status = run_fft_pass(&job, fft_columns_task, groups, FFT_INVERSE);
+    }
+
+    if (status == 0) {
+        job.output = output;
+        job.y0 = y0;
+        job.x0 = x0;
+        status = run_fft_pass(&job, fft_rows_inverse_task, output->height, FFT_INVERSE);
+    }
+
+    free(spectra);
+    return status;
+}
+
+// Output image of a mode, named after the inputs
+static Image* image_output(const Image *image, int kernel_height, int kernel_width,
+                           ConvMode mode, int *y0, int *x0) {
+    int height, width;
+    axis_range(mode, image->height, kernel_height, y0, &height);
+    axis_range(mode, image->width, kernel_width, x0, &width);
+
+    return create_image(width, height);
+}
+
+// Separable convolution with known factors: kernel = column * row^T
+// (column_length rows, row_length columns)
+Image* convolve_image_separable(const Image *image, const double *column, int column_length,
+                                const double *row, int row_length, ConvMode mode) {
+    if (!image || !image->data || !column || !row || column_length < 1 || row_length < 1) {
+        return NULL;
+    }
+    CONV_STATS_START(stats_start);
+
+    int y0, x0;
+    Image *output = image_output(image, column_length, row_length, mode, &y0, &x0);
+    if (!output) return NULL;
+
+    snprintf(output->name, sizeof(output->name), "Conv2D(%.48s)", image->name);
+    if (separable_convolve(output, image, column, column_length, row, row_length, y0, x0) != 0) {
+        free_image(output);
+        return NULL;
+    }
+
+    CONV_STATS_STOP(CONV_STAT_IMAGE, stats_start, (size_t)output->width * output->height);
+    return output;
+}
+
+// 2D convolution with an explicitly chosen algorithm. SAME keeps the
+// image's size, centred like the 1D modes; VALID keeps the pixels where
+// the kernel lies inside the image. IMAGE_CONV_SEPARABLE falls back to
+// the direct path for a kernel that is not rank 1.
+Image* convolve_image_with_algorithm(const Image *image, const Image *kernel,
+                                     ConvMode mode, ImageConvAlgorithm algorithm) {
+    if (!image || !kernel || !image->data || !kernel->data) return NULL;
+    if (image->width < 1 || image->height < 1 || kernel->width < 1 || kernel->height < 1) {
+        return NULL;
+    }
+    CONV_STATS_START(stats_start);
+
+    int y0, x0;
+    Image *output = image_output(image, kernel->height, kernel->width, mode, &y0, &x0);
+    if (!output) return NULL;
+
+    snprintf(output->name, sizeof(output->name), "Conv2D(%.26s * %.26s)", image->name, kernel->name);
+
+    int status = -1;
+    switch (algorithm) {
+        case IMAGE_CONV_SEPARABLE: {
+            double *factors = (double*)malloc((kernel->height + kernel->width) * sizeof(double));
+            if (!factors) break;
+
+            double *column = factors;
+            double *row = factors + kernel->height;
+            if (image_kernel_separable(kernel, column, row)) {
+                status = separable_convolve(output, image, column, kernel->height,
+                                            row, kernel->width, y0, x0);
+            } else {
+                status = direct_convolve(output, image, kernel, y0, x0);
+            }
+            free(factors);
+            break;
+        }
+
+        case IMAGE_CONV_FFT:
+            status = fft_convolve_2d(output, image, kernel, y0, x0);
+            break;
+
+        case IMAGE_CONV_DIRECT:
+            status = direct_convolve(output, image, kernel, y0, x0);
+            break;
+
+        default:
+            break;
+    }
+
+    if (status != 0) {
+        free_image(output);
+        return NULL;
+    }
+
+    CONV_STATS_STOP(CONV_STAT_IMAGE, stats_start, (size_t)output->width * output->height);
+    return output;
+}
+
+// Cheapest algorithm for this image and kernel under the cost model:
+// separable kernels compare the two 1D passes with the FFT, others the
+// tiled direct sums
+ImageConvAlgorithm image_select_algorithm(const Image *image, const Image *kernel) {
+    if (!image || !kernel) return IMAGE_CONV_DIRECT;
+
+    ImageConvAlgorithm spatial = image_kernel_separable(kernel, NULL, NULL) ? IMAGE_CONV_SEPARABLE
+                                                                            : IMAGE_CONV_DIRECT;
+    int h = image->height, w = image->width;
+    int kh = kernel->height, kw = kernel->width;
+
+    if (conv_estimate_image_cost(IMAGE_CONV_FFT, h, w, kh, kw) <
+        conv_estimate_image_cost(spatial, h, w, kh, kw)) {
+        return IMAGE_CONV_FFT;
+    }
+    return spatial;
+}
+
+// 2D convolution with the algorithm picked by the cost model
+Image* convolve_image(const Image *image, const Image *kernel, ConvMode mode) {
+    if (!image || !kernel) return NULL;
+    return convolve_image_with_algorithm(image, kernel, mode, image_select_algorithm(image, kernel));
+}
@@ -30,8 +30,13 @@ int get_user_choice(int min, int max) {
     }
 }
 
-// Main function
-int main() {
+// Main function: with arguments, run a headless command (see cli.c);
+// otherwise start the interactive menu
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        return conv_cli_run(argc, argv);
+    }
+    
     printf("╔════════════════════════════════════════════════╗\n");
     printf("║              CONVOLUTION EXPLORER              ║\n");
     printf("║     Understanding Signal Processing through    ║\n");
@@ -55,7 +60,7 @@ int main() {
     int choice;
     do {
         show_main_menu();
-        choice = get_user_choice(0, 7);
+        choice = get_user_choice(0, 9);
         
         switch (choice) {
             case 1:
@@ -79,6 +84,16 @@ int main() {
             case 7:
                 run_interactive_demo();
                 break;
+            case 8: {
+                // Counters of everything run in this session so far
+                ConvStats stats;
+                conv_stats_snapshot(&stats);
+                conv_stats_print(&stats);
+                break;
+            }
+            case 9:
+                demo_edge_detection();
+                break;
             case 0:
                 printf("Thank you for using Convolution Explorer!\n");
                 break;
@@ -107,6 +122,8 @@ void show_main_menu(void) {
     printf("5. Custom Signal Generator\n");
     printf("6. Performance Comparison (Direct vs FFT)\n");
     printf("7. Interactive Tutorial\n");
+    printf("8. Operation Counters\n");
+    printf("9. Image Convolution (Blur and Edge Detection)\n");
     printf("0. Exit\n");
     printf("═══════════════════════════════════════════════════════════\n");
 }
@@ -337,8 +354,8 @@ void demo_performance_comparison(void) {
     int num_tests = 4;
     double sample_rate = 1000.0;
     
-    printf("%-10s %-15s %-15s %-15s\n", "Length", "Direct (ms)", "FFT (ms)", "Speedup");
-    printf("-----------------------------------------------------------\n");
+    printf("%-10s %-15s %-15s %-15s %-15s\n", "Length", "Direct (ms)", "FFT (ms)", "Speedup", "Auto picks");
+    printf("---------------------------------------------------------------------------\n");
     
     for (int i = 0; i < num_tests; i++) {
         int N = lengths[i];
@@ -346,25 +363,194 @@ void demo_performance_comparison(void) {
         Signal *sig1 = generate_sine_wave(50.0, 1.0, 0.0, (double)N/sample_rate, sample_rate);
         Signal *sig2 = generate_gaussian_pulse(1.0, 0.01, 0.5, (double)N/sample_rate, sample_rate);
         
-        clock_t start = clock();
+        unsigned long long start = conv_stats_now();
         Signal *direct_result = convolve(sig1, sig2);
-        clock_t direct_time = clock() - start;
+        unsigned long long direct_time = conv_stats_now() - start;
         
-        start = clock();
+        start = conv_stats_now();
         Signal *fft_result = convolve_fft(sig1, sig2);
-        clock_t fft_time = clock() - start;
+        unsigned long long fft_time = conv_stats_now() - start;
         
-        double direct_ms = ((double)direct_time / CLOCKS_PER_SEC) * 1000.0;
-        double fft_ms = ((double)fft_time / CLOCKS_PER_SEC) * 1000.0;
+        double direct_ms = direct_time / 1e6;
+        double fft_ms = fft_time / 1e6;
         double speedup = (fft_ms > 0) ? direct_ms / fft_ms : 0.0;
         
-        printf("%-10d %-15.3f %-15.3f %-15.2fx\n", N, direct_ms, fft_ms, speedup);
+        printf("%-10d %-15.3f %-15.3f %-15.2fx %-15s\n", N, direct_ms, fft_ms, speedup,
+               conv_algorithm_name(conv_select_algorithm(sig1->length, sig2->length)));
         
         free_signal(sig1);
         free_signal(sig2);
         if (direct_result) free_signal(direct_result);
         if (fft_result) free_signal(fft_result);
     }
+    
+    // Calibrate the cost model used by convolve_auto on this machine
+    printf("\nCalibrating the automatic algorithm selection...\n");
+    ConvTuning tuning;
+    conv_tuning_calibrate(&tuning);
+    conv_tuning_set(&tuning);
+    
+    printf("  Direct:      %.3f ns per multiply-add (%.3f ns with %s)\n",
+           tuning.direct_ns, tuning.simd_ns, conv_simd_level_name(conv_get_simd_level()));
+    printf("  FFT:         %.3f ns per N log2 N\n", tuning.fft_ns);
+    printf("  Overlap-add: %.3f ns per N log2 N per block\n", tuning.block_ns);
+    printf("  Setup:       %.0f ns per FFT call\n", tuning.setup_ns);
+    
+    int signal_lengths[] = {1024, 65536, 1048576};
+    int kernel_lengths[] = {7, 31, 127, 511, 2047, 8191};
+    
+    printf("\nCrossover table (algorithm chosen for signal x kernel length):\n");
+    printf("%-10s", "N \\ M");
+    for (int j = 0; j < 6; j++) printf(" %-12d", kernel_lengths[j]);
+    printf("\n");
+    for (int i = 0; i < 3; i++) {
+        printf("%-10d", signal_lengths[i]);
+        for (int j = 0; j < 6; j++) {
+            printf(" %-12s", conv_algorithm_name(conv_select_algorithm(signal_lengths[i], kernel_lengths[j])));
+        }
+        printf("\n");
+    }
+    
+    const char *tuning_file = getenv("CONV_TUNING_FILE");
+    if (tuning_file && conv_tuning_save(&tuning, tuning_file) == 0) {
+        printf("\nTuning saved to %s (loaded automatically on startup)\n", tuning_file);
+    } else {
+        printf("\nSet CONV_TUNING_FILE to save this tuning and load it on startup.\n");
+    }
+}
+
+// Kernel image from a row-major table of taps
+static Image* kernel_from_taps(const double *taps, int width, int height, const char *name) {
+    Image *kernel = create_image(width, height);
+    if (!kernel) return NULL;
+
+    memcpy(kernel->data, taps, (size_t)width * height * sizeof(double));
+    snprintf(kernel->name, sizeof(kernel->name), "%s", name);
+    return kernel;
+}
+
+void demo_edge_detection(void) {
+    printf("\n╔═══════════════════════════════════════════════╗\n");
+    printf("║        IMAGE CONVOLUTION & EDGE DETECTION     ║\n");
+    printf("╚═══════════════════════════════════════════════╝\n");
+
+    printf("2D convolution slides a small kernel over every pixel:\n");
+    printf("    (I * K)[y][x] = Σ Σ I[y-i][x-j] × K[i][j]\n\n");
+
+    // Test scene: a bright rectangle and a dimmer disc on a dark background
+    int width = 96, height = 48;
+    Image *scene = create_image(width, height);
+    if (!scene) return;
+    snprintf(scene->name, sizeof(scene->name), "Test scene");
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double dx = x - 66.0, dy = (y - 24.0) * 2.0;
+            double value = 0.1;
+            if (x >= 10 && x < 40 && y >= 10 && y < 38) value = 1.0;
+            if (dx * dx + dy * dy < 18.0 * 18.0) value = 0.6;
+            scene->data[y * scene->stride + x] = value;
+        }
+    }
+    plot_image_ascii(scene, 96, 24);
+
+    // Gaussian blur: the outer product of binomial rows, so separable
+    double binomial[5] = {1.0 / 16, 4.0 / 16, 6.0 / 16, 4.0 / 16, 1.0 / 16};
+    double gaussian[25];
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 5; j++) gaussian[i * 5 + j] = binomial[i] * binomial[j];
+    }
+    double sobel_x[9] = {1, 0, -1, 2, 0, -2, 1, 0, -1};
+    double sobel_y[9] = {1, 2, 1, 0, 0, 0, -1, -2, -1};
+    double laplacian[9] = {0, 1, 0, 1, -4, 1, 0, 1, 0};
+
+    Image *blur = kernel_from_taps(gaussian, 5, 5, "Gaussian 5x5");
+    Image *gx_kernel = kernel_from_taps(sobel_x, 3, 3, "Sobel x");
+    Image *gy_kernel = kernel_from_taps(sobel_y, 3, 3, "Sobel y");
+    Image *laplace = kernel_from_taps(laplacian, 3, 3, "Laplacian");
+
+    Image *kernels[] = {blur, gx_kernel, laplace};
+    printf("\nKernels (separable kernels run as a row pass and a column pass):\n");
+    for (int k = 0; k < 3; k++) {
+        if (!kernels[k]) continue;
+        printf("  %-14s separable: %-3s  algorithm: %s\n", kernels[k]->name,
+               image_kernel_separable(kernels[k], NULL, NULL) ? "yes" : "no",
+               image_conv_algorithm_name(image_select_algorithm(scene, kernels[k])));
+    }
+
+    Image *blurred = blur ? convolve_image(scene, blur, CONV_MODE_SAME) : NULL;
+    if (blurred) {
+        snprintf(blurred->name, sizeof(blurred->name), "Blurred (Gaussian 5x5)");
+        plot_image_ascii(blurred, 96, 24);
+    }
+
+    // Edge strength: gradient magnitude from the two Sobel responses
+    Image *gx = gx_kernel ? convolve_image(scene, gx_kernel, CONV_MODE_SAME) : NULL;
+    Image *gy = gy_kernel ? convolve_image(scene, gy_kernel, CONV_MODE_SAME) : NULL;
+    if (gx && gy) {
+        for (int i = 0; i < width * height; i++) {
+            gx->data[i] = sqrt(gx->data[i] * gx->data[i] + gy->data[i] * gy->data[i]);
+        }
+        snprintf(gx->name, sizeof(gx->name), "Edges (Sobel magnitude)");
+        plot_image_ascii(gx, 96, 24);
+    }
+
+    Image *outline = laplace ? convolve_image(scene, laplace, CONV_MODE_SAME) : NULL;
+    if (outline) {
+        for (int i = 0; i < width * height; i++) outline->data[i] = fabs(outline->data[i]);
+        snprintf(outline->name, sizeof(outline->name), "Edges (|Laplacian|)");
+        plot_image_ascii(outline, 96, 24);
+    }
+
+    // Camera-frame sized timing of the three algorithms
+    int frame = 1024;
+    Image *camera = create_image(frame, frame);
+    if (camera) {
+        conv_fill_uniform(camera->data, frame * frame, 0.0, 1.0, 1);
+
+        printf("\n%dx%d frame, SAME output (ms):\n", frame, frame);
+        printf("%-16s %-10s %-10s %-10s %-10s\n", "Kernel", "Direct", "Separable", "FFT", "Auto picks");
+        printf("------------------------------------------------------------\n");
+
+        int sizes[] = {3, 9, 31};
+        for (int s = 0; s < 3; s++) {
+            int size = sizes[s];
+            Image *kernel = create_image(size, size);
+            if (!kernel) continue;
+
+            // Gaussian taps: rank 1, so all three algorithms apply
+            double sigma = size / 6.0;
+            for (int i = 0; i < size; i++) {
+                for (int j = 0; j < size; j++) {
+                    double di = i - size / 2, dj = j - size / 2;
+                    kernel->data[i * size + j] = exp(-(di * di + dj * dj) / (2.0 * sigma * sigma));
+                }
+            }
+
+            double times[3];
+            for (int a = 0; a < 3; a++) {
+                unsigned long long start = conv_stats_now();
+                free_image(convolve_image_with_algorithm(camera, kernel, CONV_MODE_SAME,
+                                                         (ImageConvAlgorithm)a));
+                times[a] = (conv_stats_now() - start) / 1e6;
+            }
+
+            char label[32];
+            snprintf(label, sizeof(label), "Gaussian %dx%d", size, size);
+            printf("%-16s %-10.2f %-10.2f %-10.2f %-10s\n", label, times[0], times[1], times[2],
+                   image_conv_algorithm_name(image_select_algorithm(camera, kernel)));
+            free_image(kernel);
+        }
+        free_image(camera);
+    }
+
+    printf("\nKey Takeaways:\n");
+    printf("• Blur, sharpen and edge detection are all 2D convolutions\n");
+    printf("• A rank-1 kernel costs M + N taps per pixel instead of M × N\n");
+    printf("• Large kernels are cheapest through the 2D FFT\n\n");
+
+    Image *images[] = {scene, blur, gx_kernel, gy_kernel, laplace, blurred, gx, gy, outline};
+    for (int i = 0; i < 9; i++) free_image(images[i]);
 }
 
 void run_interactive_demo(void) {
@@ -0,0 +1,587 @@
+#include "../include/convolution.h"
+#include <limits.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONV_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Designed filters span this many zero crossings of the sinc on each side
+// per unit of the larger rate factor (as scipy's resample_poly does)
+#define RESAMPLER_HALF_CROSSINGS 10
+
+// Kaiser shape of the designed filters
+#define RESAMPLER_KAISER_BETA 5.0
+
+// Input samples a streaming filter buffers per pass
+#define POLYPHASE_BLOCK 4096
+
+// Rate changes with at least this many multiply-adds use the thread pool
+#define MULTIRATE_PARALLEL_MIN_WORK (1 << 20)
+
+// Decimators split into per-input-phase convolutions when each branch
+// gets at least this many taps; shorter branches cost more in gathering
+// than they save, so those filters run as one dot product per output
+#define DECIMATE_MIN_BRANCH 8
+
+// Decimators compute this many outputs at a time, so the input span their
+// branches gather from stays in cache across the branches
+#define DECIMATE_BLOCK 512
+
+// Output ranges handed to the pool are multiples of the widest vector
+// block of the direct body, so every output is computed as serially
+#define MULTIRATE_BLOCK_ALIGN 32
+
+static int gcd(int a, int b) {
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Anti-aliasing lowpass for a rate change by up/down: a Kaiser-windowed
+// sinc cut off at the lower of the two Nyquist rates, scaled by up so that
+// interpolation keeps the signal's level. The up and down factors are
+// reduced first; the filter has 2 * 10 * max(up, down) + 1 taps, so its
+// delay is exactly half its length.
+Signal* fir_design_resampler(int up, int down) {
+    if (up < 1 || down < 1) return NULL;
+
+    int common = gcd(up, down);
+    up /= common;
+    down /= common;
+
+    int rate = (up > down) ? up : down;
+    int half = RESAMPLER_HALF_CROSSINGS * rate;
+    int length = 2 * half + 1;
+
+    Signal *filter = create_signal(length, 1.0);
+    if (!filter) return NULL;
+
+    window_fill_kaiser(filter->data, length, RESAMPLER_KAISER_BETA);
+
+    double cutoff = 1.0 / rate;
+    for (int j = 0; j < length; j++) {
+        double x = cutoff * (j - half);
+        double sinc = (j == half) ? 1.0 : sin(PI * x) / (PI * x);
+        filter->data[j] *= up * cutoff * sinc;
+    }
+
+    filter->type = SIGNAL_CUSTOM;
+    snprintf(filter->name, sizeof(filter->name), "Resampler %d/%d", up, down);
+    return filter;
+}
+
+// Split the taps into branches. Interpolators and resamplers get one
+// branch per output phase: output t = q * up + p reads taps p, p + up, ...
+// against inputs q, q - 1, .... Decimators (up == 1) with long enough
+// filters get one branch per input phase, taps s, s + down, ..., so each
+// branch is an ordinary convolution of every down-th input sample.
+// Branches are stored reversed for convolve_direct_body and dot.
+static int polyphase_setup(PolyphaseFilter *filter, const double *taps, int length,
+                           int up, int down) {
+    memset(filter, 0, sizeof(*filter));
+
+    int stride = up;
+    if (up == 1 && (length + down - 1) / down >= DECIMATE_MIN_BRANCH) stride = down;
+    filter->up = up;
+    filter->down = down;
+    filter->filter_length = length;
+    filter->phase_count = stride;
+    filter->phase_length = (length + stride - 1) / stride;
+    filter->history = (stride == down && down > 1) ? filter->phase_length * down - 1
+                                                   : filter->phase_length - 1;
+
+    int branch = filter->phase_length;
+    filter->phases = (double*)calloc((size_t)stride * branch, sizeof(double));
+    if (!filter->phases) return -1;
+
+    for (int p = 0; p < stride; p++) {
+        for (int j = 0; j < branch; j++) {
+            long long tap = p + (long long)(branch - 1 - j) * stride;
+            if (tap < length) filter->phases[(size_t)p * branch + j] = taps[tap];
+        }
+    }
+    return 0;
+}
+
+// sum(a[i] * b[i]) for i < n
+static double dot_scalar(const double *a, const double *b, int n) {
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#if defined(CONV_HAVE_X86_SIMD)
+__attribute__((target("avx2,fma")))
+static double dot_avx2(const double *a, const double *b, int n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+#endif
+
+static double dot(const double *a, const double *b, int n) {
+#if defined(CONV_HAVE_X86_SIMD)
+    if (conv_get_simd_level() >= SIMD_AVX2) return dot_avx2(a, b, n);
+#endif
+    return dot_scalar(a, b, n);
+}
+
+// Outputs [first, first + count) into out. Input sample i (counting zeros
+// before the signal as negative indices) is x[i - base]; every sample an
+// output reads must be there. Returns -1 if scratch runs out.
+static int polyphase_run(const PolyphaseFilter *filter, const double *x, long long base,
+                         long long first, int count, double *out) {
+    int branch = filter->phase_length;
+    int up = filter->up;
+    int down = filter->down;
+
+    if (up == 1 && down == 1) {
+        // Plain filtering: one branch over contiguous input
+        long long q = filter->offset + first;
+        convolve_direct_body(x + (q - branch + 1 - base), count, filter->phases, branch, out);
+        return 0;
+    }
+
+    if (up == 1 && filter->phase_count > 1) {
+        // Decimation: branch s convolves inputs q0 - s, q0 - s - down, ...
+        // gathered into a contiguous stream, and the branches add up
+        int block = (count < DECIMATE_BLOCK) ? count : DECIMATE_BLOCK;
+        double *work = conv_workspace((size_t)2 * block + branch - 1);
+        if (!work) return -1;
+        double *stream = work;
+        double *partial = work + block + branch - 1;
+
+        for (int done = 0; done < count; done += block) {
+            int outputs = (count - done < block) ? count - done : block;
+            int stream_length = outputs + branch - 1;
+            double *y = out + done;
+
+            long long q0 = filter->offset + (first + done) * down;
+            for (int s = 0; s < down; s++) {
+                const double *source = x + (q0 - s - (long long)(branch - 1) * down - base);
+                for (int i = 0; i < stream_length; i++) {
+                    stream[i] = source[(size_t)i * down];
+                }
+
+                const double *taps = filter->phases + (size_t)s * branch;
+                if (s == 0) {
+                    convolve_direct_body(stream, outputs, taps, branch, y);
+                    continue;
+                }
+                convolve_direct_body(stream, outputs, taps, branch, partial);
+                for (int i = 0; i < outputs; i++) {
+                    y[i] += partial[i];
+                }
+            }
+        }
+        return 0;
+    }
+
+    if (down == 1) {
+        // Interpolation: every up-th output uses the same branch over
+        // consecutive inputs
+        double *partial = conv_workspace((size_t)count / up + 1);
+        if (!partial) return -1;
+
+        long long t0 = filter->offset + first;
+        for (int p = 0; p < up; p++) {
+            int start = (int)((p - t0 % up + up) % up);
+            if (start >= count) continue;
+
+            int outputs = (count - 1 - start) / up + 1;
+            long long q = (t0 + start) / up;
+            convolve_direct_body(x + (q - branch + 1 - base), outputs,
+                                 filter->phases + (size_t)p * branch, branch, partial);
+            for (int i = 0; i < outputs; i++) {
+                out[start + (size_t)i * up] = partial[i];
+            }
+        }
+        return 0;
+    }
+
+    // Rational rates (and decimators with short branches): consecutive
+    // outputs change branch and step down inputs, so each is its own dot
+    // product. Output t = q * up + p moves on by down / up inputs and
+    // down % up phases.
+    long long t = filter->offset + first * down;
+    const double *window = x + (t / up - branch + 1 - base);
+    int p = (int)(t % up);
+    int input_step = down / up;
+    int phase_step = down % up;
+
+    for (int i = 0; i < count; i++) {
+        out[i] = dot(filter->phases + (size_t)p * branch, window, branch);
+
+        window += input_step;
+        p += phase_step;
+        if (p >= up) {
+            p -= up;
+            window++;
+        }
+    }
+    return 0;
+}
+
+// Input index the newest tap of output k reads
+static long long polyphase_input_of(const PolyphaseFilter *filter, long long k) {
+    return (filter->offset + k * filter->down) / filter->up;
+}
+
+// First output whose newest input is at least q
+static long long polyphase_first_reading(const PolyphaseFilter *filter, long long q) {
+    long long reach = q * filter->up - filter->offset;
+    if (reach <= 0) return 0;
+    return (reach + filter->down - 1) / filter->down;
+}
+
+// Outputs [first, last) near the ends of an n-sample signal, through a
+// copy of the inputs they read with zeros outside the signal
+static int polyphase_run_padded(const PolyphaseFilter *filter, const double *x, long long n,
+                                long long first, long long last, double *out) {
+    if (last <= first) return 0;
+
+    long long low = polyphase_input_of(filter, first) - filter->history;
+    long long high = polyphase_input_of(filter, last - 1);
+    double *padded = (double*)calloc((size_t)(high - low + 1), sizeof(double));
+    if (!padded) return -1;
+
+    long long from = (low > 0) ? low : 0;
+    long long to = (high < n - 1) ? high : n - 1;
+    if (to >= from) {
+        memcpy(padded + (from - low), x + from, (size_t)(to - from + 1) * sizeof(double));
+    }
+
+    int status = polyphase_run(filter, padded, low, first, (int)(last - first), out + first);
+    free(padded);
+    return status;
+}
+
+// Output ranges of a one-shot rate change, one per pool task
+typedef struct {
+    const PolyphaseFilter *filter;
+    const double *input;
+    double *output;
+    int first;
+    int count;
+    int chunk;
+    int failed;
+} MultirateJob;
+
+static void multirate_task(void *context, int index) {
+    MultirateJob *job = (MultirateJob*)context;
+
+    int first = job->first + index * job->chunk;
+    int end = job->first + job->count;
+    int count = end - first < job->chunk ? end - first : job->chunk;
+    if (polyphase_run(job->filter, job->input, 0, first, count, job->output + first) != 0) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Run a set-up filter over a whole signal (see multirate_apply)
+static Signal* multirate_compute(const Signal *signal, PolyphaseFilter *polyphase, ConvMode mode) {
+    int up = polyphase->up;
+    int down = polyphase->down;
+    long long n = signal->length;
+    long long m = polyphase->filter_length;
+    long long upsampled = (n - 1) * up + 1;
+    long long start, length;
+
+    switch (mode) {
+        case CONV_MODE_SAME:
+            start = (m - 1) / 2;
+            length = n * up;
+            break;
+        case CONV_MODE_VALID: {
+            long long shorter = (upsampled < m) ? upsampled : m;
+            start = shorter - 1;
+            length = (upsampled > m ? upsampled - m : m - upsampled) + 1;
+            break;
+        }
+        default:
+            start = 0;
+            length = upsampled + m - 1;
+            break;
+    }
+
+    long long count = (length + down - 1) / down;
+    if (count > INT_MAX) return NULL;
+    polyphase->offset = start;
+
+    Signal *result = create_signal((int)count, signal->sample_rate * up / down);
+    if (!result) return NULL;
+
+    // Outputs that read only signal samples run in place; the few at
+    // either end that read past it go through zero-padded copies
+    long long head = polyphase_first_reading(polyphase, polyphase->history);
+    long long tail = polyphase_first_reading(polyphase, n);
+    if (head > count) head = count;
+    if (tail > count) tail = count;
+    if (tail < head) tail = head;
+
+    int status = polyphase_run_padded(polyphase, signal->data, n, 0, head, result->data);
+    if (status == 0) {
+        status = polyphase_run_padded(polyphase, signal->data, n, tail, count, result->data);
+    }
+
+    MultirateJob job = {polyphase, signal->data, result->data, (int)head, (int)(tail - head),
+                        (int)(tail - head), 0};
+    if (status == 0 && job.count > 0) {
+        double work = (double)job.count * polyphase->phase_length * polyphase->phase_count / up;
+        int threads = conv_get_num_threads();
+        int tasks = 1;
+        if (threads > 1 && work >= MULTIRATE_PARALLEL_MIN_WORK) {
+            int chunk = (job.count + 4 * threads - 1) / (4 * threads);
+            job.chunk = (chunk + MULTIRATE_BLOCK_ALIGN - 1) / MULTIRATE_BLOCK_ALIGN * MULTIRATE_BLOCK_ALIGN;
+            tasks = (job.count + job.chunk - 1) / job.chunk;
+        }
+        conv_parallel_for(tasks, multirate_task, &job);
+    }
+
+    if (status != 0 || job.failed) {
+        free_signal(result);
+        return NULL;
+    }
+
+    result->type = SIGNAL_CUSTOM;
+    return result;
+}
+
+// Rate change of a whole signal. The output is the linear convolution of
+// the signal, upsampled by up (up - 1 zeros after each sample), with the
+// filter, cropped by mode and then decimated by down: FULL starts at the
+// first convolution sample, SAME at the filter's centre delay (keeping
+// ceil(n * up / down) samples), VALID where the filter lies inside the
+// upsampled signal. A NULL filter designs one (fir_design_resampler).
+static Signal* multirate_apply(const Signal *signal, const Signal *filter,
+                               int up, int down, ConvMode mode) {
+    if (!signal || signal->length < 1 || up < 1 || down < 1) return NULL;
+    if (filter && filter->length < 1) return NULL;
+
+    Signal *designed = NULL;
+    if (!filter) {
+        designed = fir_design_resampler(up, down);
+        if (!designed) return NULL;
+
+        int common = gcd(up, down);
+        up /= common;
+        down /= common;
+        filter = designed;
+    }
+    CONV_STATS_START(stats_start);
+
+    Signal *result = NULL;
+    PolyphaseFilter polyphase;
+    if (polyphase_setup(&polyphase, filter->data, filter->length, up, down) == 0) {
+        result = multirate_compute(signal, &polyphase, mode);
+    }
+    free(polyphase.phases);
+    free_signal(designed);
+
+    if (result) CONV_STATS_STOP(CONV_STAT_MULTIRATE, stats_start, result->length);
+    return result;
+}
+
+// Lowpass filter and keep every factor-th sample, computing only the kept
+// outputs (1/factor of the work of convolve followed by subsampling).
+// A NULL filter uses fir_design_resampler(1, factor).
+Signal* fir_decimate(const Signal *signal, const Signal *filter, int factor, ConvMode mode) {
+    Signal *result = multirate_apply(signal, filter, 1, factor, mode);
+    if (result) {
+        snprintf(result->name, sizeof(result->name), "%.40s / %d", signal->name, factor);
+    }
+    return result;
+}
+
+// Insert factor - 1 zeros after each sample and lowpass filter, skipping
+// the taps that land on the zeros. A NULL filter uses
+// fir_design_resampler(factor, 1).
+Signal* fir_interpolate(const Signal *signal, const Signal *filter, int factor, ConvMode mode) {
+    Signal *result = multirate_apply(signal, filter, factor, 1, mode);
+    if (result) {
+        snprintf(result->name, sizeof(result->name), "%.40s x %d", signal->name, factor);
+    }
+    return result;
+}
+
+// Change the sample rate by up/down: interpolate by up, filter, decimate by
+// down, computing only the outputs kept. A NULL filter designs one for the
+// reduced ratio; a given filter runs at up times the input rate and the
+// factors are used as given.
+Signal* fir_resample(const Signal *signal, const Signal *filter, int up, int down, ConvMode mode) {
+    Signal *result = multirate_apply(signal, filter, up, down, mode);
+    if (result) {
+        snprintf(result->name, sizeof(result->name), "%.40s x %d/%d", signal->name, up, down);
+    }
+    return result;
+}
+
+// Create a streaming rate changer. Concatenated outputs equal the FULL
+// fir_resample of the concatenated inputs. A NULL filter designs one for
+// the reduced ratio. Returns NULL on bad arguments.
+PolyphaseFilter* polyphase_filter_create(const Signal *filter, int up, int down) {
+    if (up < 1 || down < 1 || (filter && filter->length < 1)) return NULL;
+
+    Signal *designed = NULL;
+    if (!filter) {
+        designed = fir_design_resampler(up, down);
+        if (!designed) return NULL;
+
+        int common = gcd(up, down);
+        up /= common;
+        down /= common;
+        filter = designed;
+    }
+
+    PolyphaseFilter *polyphase = (PolyphaseFilter*)malloc(sizeof(PolyphaseFilter));
+    if (!polyphase || polyphase_setup(polyphase, filter->data, filter->length, up, down) != 0) {
+        if (polyphase) free(polyphase->phases);
+        free(polyphase);
+        free_signal(designed);
+        return NULL;
+    }
+    free_signal(designed);
+
+    polyphase->input_capacity = polyphase->history + POLYPHASE_BLOCK;
+    polyphase->input = (double*)malloc((size_t)polyphase->input_capacity * sizeof(double));
+    if (!polyphase->input) {
+        polyphase_filter_destroy(polyphase);
+        return NULL;
+    }
+
+    polyphase_filter_reset(polyphase);
+    return polyphase;
+}
+
+void polyphase_filter_destroy(PolyphaseFilter *filter) {
+    if (filter) {
+        free(filter->phases);
+        free(filter->input);
+        free(filter);
+    }
+}
+
+// Push n samples (zeros if in is NULL) and write every output they
+// complete, up to output index last_output. Returns the count written.
+static int polyphase_push(PolyphaseFilter *filter, const double *in, int n, double *out,
+                          long long last_output) {
+    int written = 0;
+
+    do {
+        int piece = filter->input_capacity - filter->input_fill;
+        if (piece > n) piece = n;
+
+        double *tail = filter->input + filter->input_fill;
+        if (in) {
+            memcpy(tail, in, (size_t)piece * sizeof(double));
+            in += piece;
+        } else {
+            memset(tail, 0, (size_t)piece * sizeof(double));
+        }
+        filter->input_fill += piece;
+        filter->received += piece;
+        n -= piece;
+
+        // Output k is ready once input floor((offset + k * down) / up) is
+        // in. Filters shorter than up end before the last input's zeros.
+        long long reach = filter->received * filter->up;
+        long long full = (filter->received - 1) * filter->up + filter->filter_length;
+        if (full < reach) reach = full;
+        reach -= 1 + filter->offset;
+        long long last = (reach < 0) ? -1 : reach / filter->down;
+        if (last > last_output) last = last_output;
+
+        if (last >= filter->produced) {
+            int count = (int)(last - filter->produced + 1);
+            if (polyphase_run(filter, filter->input, filter->input_base, filter->produced,
+                              count, out + written) != 0) {
+                return -1;
+            }
+            filter->produced += count;
+            written += count;
+        }
+
+        // Keep the inputs from the oldest one the next output reads
+        long long next = (filter->offset + filter->produced * filter->down) / filter->up;
+        long long drop = next - filter->history - filter->input_base;
+        if (drop > filter->input_fill) drop = filter->input_fill;
+        if (drop > 0) {
+            filter->input_fill -= (int)drop;
+            memmove(filter->input, filter->input + drop,
+                    (size_t)filter->input_fill * sizeof(double));
+            filter->input_base += drop;
+        }
+
+        if (piece == 0 && n > 0) return -1;
+    } while (n > 0);
+
+    return written;
+}
+
+// Push n input samples (in may be NULL to push zeros) and write the outputs
+// they complete: at most (n * up + down - 1) / down. Returns the number
+// written, or -1 on bad arguments.
+int polyphase_filter_process(PolyphaseFilter *filter, const double *in, int n, double *out) {
+    if (!filter || n < 0 || (n > 0 && !out)) return -1;
+    CONV_STATS_START(stats_start);
+
+    int written = polyphase_push(filter, in, n, out, LLONG_MAX);
+
+    CONV_STATS_STOP(CONV_STAT_MULTIRATE, stats_start, written > 0 ? written : 0);
+    return written;
+}
+
+// Write the outputs of the filter tail after the last input (at most
+// (filter_length - 1) / down + 1), then reset. Returns the number written.
+int polyphase_filter_flush(PolyphaseFilter *filter, double *out) {
+    if (!filter || !out) return -1;
+
+    int written = 0;
+    if (filter->received > 0) {
+        long long full = (filter->received - 1) * filter->up + filter->filter_length;
+        long long last = (full - 1 - filter->offset) / filter->down;
+        long long needed = (filter->offset + last * filter->down) / filter->up + 1;
+        long long zeros = needed - filter->received;
+        if (zeros < 0) zeros = 0;
+
+        written = polyphase_push(filter, NULL, (int)zeros, out, last);
+    }
+
+    polyphase_filter_reset(filter);
+    return written;
+}
+
+// Drop all buffered input; the next input is sample 0 again
+void polyphase_filter_reset(PolyphaseFilter *filter) {
+    if (!filter) return;
+
+    // The history starts as the zeros before the signal
+    memset(filter->input, 0, (size_t)filter->history * sizeof(double));
+    filter->input_fill = filter->history;
+    filter->input_base = -filter->history;
+    filter->received = 0;
+    filter->produced = 0;
+}
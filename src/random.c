@@ -0,0 +1,292 @@
+#include "../include/convolution.h"
+#include <pthread.h>
+#include <time.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONV_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Weyl increment of splitmix64 (2^64 / golden ratio)
+#define SPLITMIX_GAMMA 0x9E3779B97F4A7C15ULL
+
+// Bulk fills interleave this many independent generators: sample i of a
+// chunk comes from lane i % FILL_LANES, the same on every SIMD level
+#define FILL_LANES 4
+
+// Samples per fill chunk. Every chunk seeds its own lanes from the fill
+// seed and its index, so output does not depend on the thread count.
+#define FILL_CHUNK 65536
+
+// Fills of at least this many samples use the thread pool
+#define FILL_PARALLEL_MIN (4 * FILL_CHUNK)
+
+// Bit pattern of 1.0: OR'd under 52 random mantissa bits gives [1, 2)
+#define UNIT_EXPONENT_BITS 0x3FF0000000000000ULL
+
+// Seed sequence behind conv_random_next_seed. The base comes from the
+// clock until conv_random_seed sets one; the generation tells thread
+// generators to reseed after the sequence restarts.
+static pthread_mutex_t seed_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t seed_base = 0;
+static uint64_t seed_counter = 0;
+static int seed_base_set = 0;
+static unsigned seed_generation = 1;
+
+static __thread ConvRng thread_rng;
+static __thread unsigned thread_rng_generation = 0;
+
+static uint64_t splitmix64_next(uint64_t *state) {
+    uint64_t z = (*state += SPLITMIX_GAMMA);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// 52 random bits as a double in [0, 1)
+static double unit_from_bits(uint64_t bits) {
+    uint64_t pattern = (bits >> 12) | UNIT_EXPONENT_BITS;
+    double value;
+    memcpy(&value, &pattern, sizeof(value));
+    return value - 1.0;
+}
+
+// Fill the state from a splitmix64 stream, as the xoshiro authors advise
+static void seed_from_stream(ConvRng *rng, uint64_t *stream) {
+    for (int i = 0; i < 4; i++) {
+        rng->state[i] = splitmix64_next(stream);
+    }
+}
+
+// Seed a generator. Equal seeds give equal sequences on every platform.
+void conv_rng_seed(ConvRng *rng, uint64_t seed) {
+    if (!rng) return;
+
+    uint64_t stream = seed;
+    seed_from_stream(rng, &stream);
+}
+
+// Next 64 random bits (xoshiro256**)
+uint64_t conv_rng_next(ConvRng *rng) {
+    uint64_t *s = rng->state;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+
+    return result;
+}
+
+// Uniform double in [0, 1)
+double conv_rng_uniform(ConvRng *rng) {
+    return unit_from_bits(conv_rng_next(rng));
+}
+
+// Standard normal deviate (Box-Muller, one of the pair)
+double conv_rng_gaussian(ConvRng *rng) {
+    double u1 = 1.0 - conv_rng_uniform(rng);
+    double u2 = conv_rng_uniform(rng);
+    return sqrt(-2.0 * log(u1)) * cos(TWO_PI * u2);
+}
+
+// Restart the seed sequence at seed: later generate_noise calls and
+// thread generators become reproducible
+void conv_random_seed(uint64_t seed) {
+    pthread_mutex_lock(&seed_lock);
+    seed_base = seed;
+    seed_counter = 0;
+    seed_base_set = 1;
+    __atomic_add_fetch(&seed_generation, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&seed_lock);
+}
+
+// Next seed of the process-wide sequence. Every call returns a different
+// seed, so back-to-back generators never repeat each other.
+uint64_t conv_random_next_seed(void) {
+    pthread_mutex_lock(&seed_lock);
+    if (!seed_base_set) {
+        uint64_t stream = (uint64_t)time(NULL) ^ ((uint64_t)clock() << 32);
+        seed_base = splitmix64_next(&stream);
+        seed_base_set = 1;
+    }
+    uint64_t stream = seed_base + seed_counter++ * SPLITMIX_GAMMA;
+    pthread_mutex_unlock(&seed_lock);
+
+    return splitmix64_next(&stream);
+}
+
+// This thread's generator, seeded from the seed sequence on first use and
+// again after conv_random_seed
+ConvRng* conv_rng_thread(void) {
+    unsigned generation = __atomic_load_n(&seed_generation, __ATOMIC_ACQUIRE);
+    if (thread_rng_generation != generation) {
+        conv_rng_seed(&thread_rng, conv_random_next_seed());
+        thread_rng_generation = generation;
+    }
+    return &thread_rng;
+}
+
+// Lanes of fill chunk `chunk`: consecutive 4-word runs of one splitmix64
+// stream, so chunk 0 lane 0 is conv_rng_seed(seed)
+static void seed_chunk_lanes(ConvRng lanes[FILL_LANES], uint64_t seed, int chunk) {
+    uint64_t stream = seed + (uint64_t)chunk * (4 * FILL_LANES) * SPLITMIX_GAMMA;
+    for (int lane = 0; lane < FILL_LANES; lane++) {
+        seed_from_stream(&lanes[lane], &stream);
+    }
+}
+
+// low + span * u for count samples (a multiple of FILL_LANES)
+static void fill_lanes_scalar(ConvRng lanes[FILL_LANES], double *output, int count,
+                              double low, double span) {
+    for (int i = 0; i < count; i += FILL_LANES) {
+        for (int lane = 0; lane < FILL_LANES; lane++) {
+            output[i + lane] = low + conv_rng_uniform(&lanes[lane]) * span;
+        }
+    }
+}
+
+#if defined(CONV_HAVE_X86_SIMD)
+// The four lanes in the four 64-bit elements. AVX2 has no 64-bit rotate
+// or multiply, so both are shifts and adds.
+__attribute__((target("avx2")))
+static void fill_lanes_avx2(ConvRng lanes[FILL_LANES], double *output, int count,
+                            double low, double span) {
+    __m256i s[4];
+    for (int w = 0; w < 4; w++) {
+        s[w] = _mm256_set_epi64x((long long)lanes[3].state[w], (long long)lanes[2].state[w],
+                                 (long long)lanes[1].state[w], (long long)lanes[0].state[w]);
+    }
+
+    const __m256i exponent = _mm256_set1_epi64x((long long)UNIT_EXPONENT_BITS);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d low_v = _mm256_set1_pd(low);
+    const __m256d span_v = _mm256_set1_pd(span);
+
+    for (int i = 0; i < count; i += FILL_LANES) {
+        __m256i x = _mm256_add_epi64(_mm256_slli_epi64(s[1], 2), s[1]);
+        x = _mm256_or_si256(_mm256_slli_epi64(x, 7), _mm256_srli_epi64(x, 57));
+        __m256i result = _mm256_add_epi64(_mm256_slli_epi64(x, 3), x);
+        __m256i t = _mm256_slli_epi64(s[1], 17);
+
+        s[2] = _mm256_xor_si256(s[2], s[0]);
+        s[3] = _mm256_xor_si256(s[3], s[1]);
+        s[1] = _mm256_xor_si256(s[1], s[2]);
+        s[0] = _mm256_xor_si256(s[0], s[3]);
+        s[2] = _mm256_xor_si256(s[2], t);
+        s[3] = _mm256_or_si256(_mm256_slli_epi64(s[3], 45), _mm256_srli_epi64(s[3], 19));
+
+        __m256i bits = _mm256_or_si256(_mm256_srli_epi64(result, 12), exponent);
+        __m256d u = _mm256_sub_pd(_mm256_castsi256_pd(bits), one);
+        _mm256_storeu_pd(output + i, _mm256_add_pd(low_v, _mm256_mul_pd(u, span_v)));
+    }
+
+    uint64_t words[FILL_LANES];
+    for (int w = 0; w < 4; w++) {
+        _mm256_storeu_si256((__m256i*)words, s[w]);
+        for (int lane = 0; lane < FILL_LANES; lane++) {
+            lanes[lane].state[w] = words[lane];
+        }
+    }
+}
+#endif
+
+// Uniform samples in [low, low + span) from the chunk's lanes
+static void fill_lanes(ConvRng lanes[FILL_LANES], double *output, int count,
+                       double low, double span) {
+    int body = count - count % FILL_LANES;
+
+#if defined(CONV_HAVE_X86_SIMD)
+    if (conv_get_simd_level() >= SIMD_AVX2) {
+        fill_lanes_avx2(lanes, output, body, low, span);
+    } else {
+        fill_lanes_scalar(lanes, output, body, low, span);
+    }
+#else
+    fill_lanes_scalar(lanes, output, body, low, span);
+#endif
+
+    for (int i = body; i < count; i++) {
+        output[i] = low + conv_rng_uniform(&lanes[i - body]) * span;
+    }
+}
+
+// Shared state of a bulk fill
+typedef struct {
+    double *output;
+    int length;
+    int gaussian;
+    double low, span;       // Uniform fills
+    double mean, stddev;    // Gaussian fills
+    uint64_t seed;
+} FillJob;
+
+// Box-Muller on pairs of uniforms, in place
+static void gaussian_from_uniform(ConvRng *lane, double *output, int count,
+                                  double mean, double stddev) {
+    int pairs = count / 2;
+    for (int p = 0; p < pairs; p++) {
+        double radius = stddev * sqrt(-2.0 * log(1.0 - output[2 * p]));
+        double angle = TWO_PI * output[2 * p + 1];
+        output[2 * p] = mean + radius * cos(angle);
+        output[2 * p + 1] = mean + radius * sin(angle);
+    }
+
+    // An odd last sample draws its own pair
+    if (count % 2) output[count - 1] = mean + stddev * conv_rng_gaussian(lane);
+}
+
+static void fill_chunk(const FillJob *job, int chunk) {
+    ConvRng lanes[FILL_LANES];
+    seed_chunk_lanes(lanes, job->seed, chunk);
+
+    int start = chunk * FILL_CHUNK;
+    int count = job->length - start < FILL_CHUNK ? job->length - start : FILL_CHUNK;
+    double *output = job->output + start;
+
+    if (job->gaussian) {
+        fill_lanes(lanes, output, count, 0.0, 1.0);
+        gaussian_from_uniform(&lanes[0], output, count, job->mean, job->stddev);
+    } else {
+        fill_lanes(lanes, output, count, job->low, job->span);
+    }
+}
+
+static void fill_task(void *context, int index) {
+    fill_chunk((const FillJob*)context, index);
+}
+
+static void run_fill(const FillJob *job) {
+    if (!job->output || job->length <= 0) return;
+
+    int chunks = (job->length + FILL_CHUNK - 1) / FILL_CHUNK;
+    if (job->length >= FILL_PARALLEL_MIN && conv_get_num_threads() > 1) {
+        conv_parallel_for(chunks, fill_task, (void*)job);
+    } else {
+        for (int chunk = 0; chunk < chunks; chunk++) {
+            fill_chunk(job, chunk);
+        }
+    }
+}
+
+// Fill output with uniform samples in [low, high). The samples depend only
+// on seed and length, never on the SIMD level or thread count.
+void conv_fill_uniform(double *output, int length, double low, double high, uint64_t seed) {
+    FillJob job = {output, length, 0, low, high - low, 0.0, 0.0, seed};
+    run_fill(&job);
+}
+
+// Fill output with normal samples of the given mean and standard deviation
+// (same determinism as conv_fill_uniform)
+void conv_fill_gaussian(double *output, int length, double mean, double stddev, uint64_t seed) {
+    FillJob job = {output, length, 1, 0.0, 0.0, mean, stddev, seed};
+    run_fill(&job);
+}
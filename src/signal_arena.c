@@ -0,0 +1,99 @@
+#include "../include/convolution.h"
+
+// Arena blocks are aligned for SIMD loads
+#define ARENA_ALIGNMENT 64
+
+// Arena used by create_signal and fft_result_create on this thread
+static __thread SignalArena *bound_arena = NULL;
+
+// Per-thread scratch buffer (see conv_workspace)
+static __thread double *workspace = NULL;
+static __thread size_t workspace_capacity = 0;
+
+// Create an arena with a fixed capacity in bytes
+SignalArena* signal_arena_create(size_t capacity) {
+    SignalArena *arena = (SignalArena*)malloc(sizeof(SignalArena));
+    if (!arena) return NULL;
+
+    // Over-allocate so the first block can be aligned
+    arena->block = (unsigned char*)malloc(capacity + ARENA_ALIGNMENT);
+    if (!arena->block) {
+        free(arena);
+        return NULL;
+    }
+
+    size_t offset = (size_t)(-(uintptr_t)arena->block & (ARENA_ALIGNMENT - 1));
+    arena->memory = arena->block + offset;
+    arena->capacity = capacity;
+    arena->used = 0;
+    arena->peak = 0;
+    arena->overflows = 0;
+    CONV_STATS_ALLOC(sizeof(SignalArena) + capacity + ARENA_ALIGNMENT);
+
+    return arena;
+}
+
+// Free an arena and everything allocated from it
+void signal_arena_destroy(SignalArena *arena) {
+    if (arena) {
+        if (bound_arena == arena) bound_arena = NULL;
+        free(arena->block);
+        free(arena);
+    }
+}
+
+// Release every allocation at once (e.g. at the end of a frame)
+void signal_arena_reset(SignalArena *arena) {
+    if (arena) arena->used = 0;
+}
+
+// Allocate bytes from the arena (64-byte aligned). Returns NULL, and counts
+// an overflow, when the arena is full.
+void* signal_arena_alloc(SignalArena *arena, size_t bytes) {
+    if (!arena) return NULL;
+
+    size_t start = (arena->used + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (start > arena->capacity || bytes > arena->capacity - start) {
+        arena->overflows++;
+        return NULL;
+    }
+
+    arena->used = start + bytes;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+
+    return arena->memory + start;
+}
+
+// Make create_signal and fft_result_create on this thread draw from arena
+// (NULL returns to the heap). Returns the previously bound arena.
+SignalArena* signal_arena_bind(SignalArena *arena) {
+    SignalArena *previous = bound_arena;
+    bound_arena = arena;
+    return previous;
+}
+
+// Arena bound to this thread, or NULL
+SignalArena* signal_arena_current(void) {
+    return bound_arena;
+}
+
+// Per-thread scratch space of at least count doubles, grown on demand and
+// kept for the next call. The contents are undefined. A routine must be done
+// with its workspace before calling anything else that uses it.
+double* conv_workspace(size_t count) {
+    if (count > workspace_capacity) {
+        double *grown = (double*)realloc(workspace, count * sizeof(double));
+        if (!grown) return NULL;
+        CONV_STATS_ALLOC((count - workspace_capacity) * sizeof(double));
+        workspace = grown;
+        workspace_capacity = count;
+    }
+    return workspace;
+}
+
+// Free this thread's workspace
+void conv_workspace_release(void) {
+    free(workspace);
+    workspace = NULL;
+    workspace_capacity = 0;
+}
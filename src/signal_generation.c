@@ -1,8 +1,25 @@
 #include "../include/convolution.h"
-#include <time.h>
 
 // Create a new signal structure
 Signal* create_signal(int length, double sample_rate) {
+    // Draw from the bound arena when there is one; struct and samples share
+    // one block so a full arena falls back to the heap as a whole
+    SignalArena *arena = signal_arena_current();
+    if (arena && length >= 0) {
+        size_t header = (sizeof(Signal) + 63) & ~(size_t)63;
+        unsigned char *block = (unsigned char*)signal_arena_alloc(
+            arena, header + (size_t)length * sizeof(double));
+        if (block) {
+            Signal *signal = (Signal*)block;
+            signal->data = (double*)(block + header);
+            memset(signal->data, 0, (size_t)length * sizeof(double));
+            signal_init(signal, signal->data, length, sample_rate);
+            signal->storage = STORAGE_ARENA;
+            CONV_STATS_ALLOC(header + (size_t)length * sizeof(double));
+            return signal;
+        }
+    }
+
     Signal *signal = (Signal*)malloc(sizeof(Signal));
     if (!signal) return NULL;
     
@@ -12,18 +29,30 @@ Signal* create_signal(int length, double sample_rate) {
         return NULL;
     }
     
+    signal_init(signal, signal->data, length, sample_rate);
+    signal->storage = STORAGE_HEAP;
+    CONV_STATS_ALLOC(sizeof(Signal) + (size_t)length * sizeof(double));
+    
+    return signal;
+}
+
+// Wrap caller-owned samples in a caller-owned Signal (no allocation).
+// free_signal must not be called on it.
+void signal_init(Signal *signal, double *data, int length, double sample_rate) {
+    if (!signal) return;
+
+    signal->data = data;
     signal->length = length;
     signal->sample_rate = sample_rate;
     signal->duration = (double)length / sample_rate;
     signal->type = SIGNAL_CUSTOM;
     strcpy(signal->name, "Untitled Signal");
-    
-    return signal;
+    signal->storage = STORAGE_EXTERNAL;
 }
 
-// Free signal memory
+// Free signal memory (arena signals are released by signal_arena_reset)
 void free_signal(Signal *signal) {
-    if (signal) {
+    if (signal && signal->storage == STORAGE_HEAP) {
         if (signal->data) {
             free(signal->data);
         }
@@ -31,6 +60,163 @@ void free_signal(Signal *signal) {
     }
 }
 
+// Oscillator samples per anchor block. Every block starts from a phase
+// computed from its absolute sample index, so rounding never accumulates
+// past one block and any block can be generated on its own.
+#define OSCILLATOR_BLOCK 256
+
+// Gaussian pulse blocks are shorter: the error of its recurrence grows with
+// the square of the distance from the anchor
+#define PULSE_BLOCK 64
+
+// Samples per parallel task (a multiple of both block sizes)
+#define GENERATOR_TASK_SAMPLES 65536
+
+// Generators of at least this many samples use the thread pool
+#define GENERATOR_PARALLEL_MIN (4 * GENERATOR_TASK_SAMPLES)
+
+// One generator run; tasks fill disjoint ranges of output
+typedef struct {
+    SignalType type;
+    double *output;
+    int length;
+    double amplitude;
+    double cycles_per_sample;      // frequency / sample_rate
+    double phase;                  // Sine: radians at sample 0
+    const double *rotation_cos;    // Sine: cos and sin of the phase advance
+    const double *rotation_sin;    // over k samples, k < OSCILLATOR_BLOCK
+    int center;                    // Pulse: centre sample
+    double inverse_variance;       // Pulse: 1 / sigma^2, sigma in samples
+    double ratio_step;             // Pulse: exp(-inverse_variance)
+} GeneratorJob;
+
+static double cycle_fraction(double cycles) {
+    return cycles - floor(cycles);
+}
+
+// sin(a + b) = sin(a) cos(b) + cos(a) sin(b): one sin/cos pair per block,
+// the advance within the block comes from the shared tables
+static void sine_block(const GeneratorJob *job, int start, int count) {
+    double angle = job->phase + TWO_PI * cycle_fraction((double)start * job->cycles_per_sample);
+    double a_sin = job->amplitude * sin(angle);
+    double a_cos = job->amplitude * cos(angle);
+    double *out = job->output + start;
+
+    for (int k = 0; k < count; k++) {
+        out[k] = a_sin * job->rotation_cos[k] + a_cos * job->rotation_sin[k];
+    }
+}
+
+// Square, triangle and sawtooth from the phase in cycles. The anchor is in
+// [0, 1) and the step is reduced to [0, 1), so truncation wraps the phase.
+static void periodic_block(const GeneratorJob *job, int start, int count) {
+    double base = cycle_fraction((double)start * job->cycles_per_sample);
+    double step = cycle_fraction(job->cycles_per_sample);
+    double amplitude = job->amplitude;
+    double *out = job->output + start;
+
+    for (int k = 0; k < count; k++) {
+        double phase = base + k * step;
+        phase -= (double)(long long)phase;
+
+        switch (job->type) {
+            case SIGNAL_SQUARE:
+                out[k] = phase <= 0.5 ? amplitude : -amplitude;
+                break;
+            case SIGNAL_TRIANGLE:
+                out[k] = amplitude * (phase < 0.5 ? 4.0 * phase - 1.0 : 3.0 - 4.0 * phase);
+                break;
+            default:
+                out[k] = amplitude * (2.0 * phase - 1.0);
+                break;
+        }
+    }
+}
+
+// exp(-d^2 / 2s^2) by recurrence: consecutive samples differ by the factor
+// exp(-(d + 1/2) / s^2), which itself shrinks by exp(-1 / s^2) per sample
+static void pulse_block(const GeneratorJob *job, int start, int count) {
+    double d = (double)(start - job->center);
+    double iv = job->inverse_variance;
+    double *out = job->output + start;
+
+    // Blocks wholly in the tails underflow to zero (exp(x) is 0 below -746)
+    double nearest = d > 0.0 ? d : (d + count - 1 < 0.0 ? -(d + count - 1) : 0.0);
+    if (0.5 * nearest * nearest * iv > 746.0) {
+        memset(out, 0, (size_t)count * sizeof(double));
+        return;
+    }
+
+    double value = job->amplitude * exp(-0.5 * d * d * iv);
+    double ratio = exp(-(d + 0.5) * iv);
+
+    // Underflow at the anchor or an overflowing ratio (a pulse narrower
+    // than a sample) breaks the recurrence: evaluate every sample instead
+    if (value == 0.0 || !isfinite(ratio)) {
+        for (int k = 0; k < count; k++) {
+            double dk = d + k;
+            out[k] = job->amplitude * exp(-0.5 * dk * dk * iv);
+        }
+        return;
+    }
+
+    for (int k = 0; k < count; k++) {
+        out[k] = value;
+        value *= ratio;
+        ratio *= job->ratio_step;
+    }
+}
+
+// Samples [start, end): start is a multiple of the block size
+static void generate_range(const GeneratorJob *job, int start, int end) {
+    int block = job->type == SIGNAL_GAUSSIAN ? PULSE_BLOCK : OSCILLATOR_BLOCK;
+
+    for (int b = start; b < end; b += block) {
+        int count = end - b < block ? end - b : block;
+        switch (job->type) {
+            case SIGNAL_SINE:     sine_block(job, b, count); break;
+            case SIGNAL_GAUSSIAN: pulse_block(job, b, count); break;
+            default:              periodic_block(job, b, count); break;
+        }
+    }
+}
+
+static void generator_task(void *context, int index) {
+    const GeneratorJob *job = (const GeneratorJob*)context;
+    int start = index * GENERATOR_TASK_SAMPLES;
+    int end = job->length - start < GENERATOR_TASK_SAMPLES ? job->length : start + GENERATOR_TASK_SAMPLES;
+    generate_range(job, start, end);
+}
+
+// Fill signal->data. Block anchors depend only on the sample index, so
+// the samples are the same for every thread count.
+static void run_generator(GeneratorJob *job, Signal *signal) {
+    double rotation_cos[OSCILLATOR_BLOCK];
+    double rotation_sin[OSCILLATOR_BLOCK];
+
+    job->output = signal->data;
+    job->length = signal->length;
+    if (job->length <= 0) return;
+
+    if (job->type == SIGNAL_SINE) {
+        int table = job->length < OSCILLATOR_BLOCK ? job->length : OSCILLATOR_BLOCK;
+        for (int k = 0; k < table; k++) {
+            double angle = TWO_PI * (k * job->cycles_per_sample);
+            rotation_cos[k] = cos(angle);
+            rotation_sin[k] = sin(angle);
+        }
+        job->rotation_cos = rotation_cos;
+        job->rotation_sin = rotation_sin;
+    }
+
+    if (job->length >= GENERATOR_PARALLEL_MIN && conv_get_num_threads() > 1) {
+        int tasks = (job->length + GENERATOR_TASK_SAMPLES - 1) / GENERATOR_TASK_SAMPLES;
+        conv_parallel_for(tasks, generator_task, job);
+    } else {
+        generate_range(job, 0, job->length);
+    }
+}
+
 // Generate sine wave
 Signal* generate_sine_wave(double frequency, double amplitude, double phase, 
                           double duration, double sample_rate) {
@@ -42,97 +228,92 @@ Signal* generate_sine_wave(double frequency, double amplitude, double phase,
     snprintf(signal->name, sizeof(signal->name), 
              "Sine Wave (%.1fHz, %.2fA)", frequency, amplitude);
     
-    for (int i = 0; i < length; i++) {
-        double t = (double)i / sample_rate;
-        signal->data[i] = amplitude * sin(TWO_PI * frequency * t + phase);
-    }
+    GeneratorJob job = {0};
+    job.type = SIGNAL_SINE;
+    job.amplitude = amplitude;
+    job.cycles_per_sample = frequency / sample_rate;
+    job.phase = phase;
+    run_generator(&job, signal);
     
     return signal;
 }
 
-// Generate square wave
-Signal* generate_square_wave(double frequency, double amplitude, 
-                           double duration, double sample_rate) {
+// Square, triangle and sawtooth waves share the phase accumulator
+static Signal* generate_periodic_wave(SignalType type, const char *label, double frequency,
+                                      double amplitude, double duration, double sample_rate) {
     int length = (int)(duration * sample_rate);
     Signal *signal = create_signal(length, sample_rate);
     if (!signal) return NULL;
     
-    signal->type = SIGNAL_SQUARE;
+    signal->type = type;
     snprintf(signal->name, sizeof(signal->name), 
-             "Square Wave (%.1fHz, %.2fA)", frequency, amplitude);
+             "%s Wave (%.1fHz, %.2fA)", label, frequency, amplitude);
     
-    for (int i = 0; i < length; i++) {
-        double t = (double)i / sample_rate;
-        double sine_val = sin(TWO_PI * frequency * t);
-        signal->data[i] = amplitude * (sine_val >= 0 ? 1.0 : -1.0);
-    }
+    GeneratorJob job = {0};
+    job.type = type;
+    job.amplitude = amplitude;
+    job.cycles_per_sample = frequency / sample_rate;
+    run_generator(&job, signal);
     
     return signal;
 }
 
+// Generate square wave (high for the first half of each cycle)
+Signal* generate_square_wave(double frequency, double amplitude, 
+                           double duration, double sample_rate) {
+    return generate_periodic_wave(SIGNAL_SQUARE, "Square", frequency, amplitude,
+                                  duration, sample_rate);
+}
+
 // Generate triangle wave
 Signal* generate_triangle_wave(double frequency, double amplitude, 
                              double duration, double sample_rate) {
-    int length = (int)(duration * sample_rate);
-    Signal *signal = create_signal(length, sample_rate);
-    if (!signal) return NULL;
-    
-    signal->type = SIGNAL_TRIANGLE;
-    snprintf(signal->name, sizeof(signal->name), 
-             "Triangle Wave (%.1fHz, %.2fA)", frequency, amplitude);
-    
-    for (int i = 0; i < length; i++) {
-        double t = (double)i / sample_rate;
-        double phase = fmod(t * frequency, 1.0);
-        
-        if (phase < 0.5) {
-            signal->data[i] = amplitude * (4.0 * phase - 1.0);
-        } else {
-            signal->data[i] = amplitude * (3.0 - 4.0 * phase);
-        }
-    }
-    
-    return signal;
+    return generate_periodic_wave(SIGNAL_TRIANGLE, "Triangle", frequency, amplitude,
+                                  duration, sample_rate);
 }
 
 // Generate sawtooth wave
 Signal* generate_sawtooth_wave(double frequency, double amplitude, 
                              double duration, double sample_rate) {
+    return generate_periodic_wave(SIGNAL_SAWTOOTH, "Sawtooth", frequency, amplitude,
+                                  duration, sample_rate);
+}
+
+// Generate white noise, uniform in [-amplitude, amplitude). Each call
+// takes a fresh seed from the process-wide sequence (see conv_random_seed).
+Signal* generate_noise(double amplitude, double duration, double sample_rate) {
+    return generate_noise_seeded(amplitude, duration, sample_rate, conv_random_next_seed());
+}
+
+// Generate white noise from an explicit seed: equal seeds give equal
+// signals on any machine and thread count
+Signal* generate_noise_seeded(double amplitude, double duration, double sample_rate,
+                              uint64_t seed) {
     int length = (int)(duration * sample_rate);
     Signal *signal = create_signal(length, sample_rate);
     if (!signal) return NULL;
     
-    signal->type = SIGNAL_SAWTOOTH;
+    signal->type = SIGNAL_NOISE;
     snprintf(signal->name, sizeof(signal->name), 
-             "Sawtooth Wave (%.1fHz, %.2fA)", frequency, amplitude);
+             "White Noise (%.2fA)", amplitude);
     
-    for (int i = 0; i < length; i++) {
-        double t = (double)i / sample_rate;
-        double phase = fmod(t * frequency, 1.0);
-        signal->data[i] = amplitude * (2.0 * phase - 1.0);
-    }
+    conv_fill_uniform(signal->data, length, -amplitude, amplitude, seed);
     
     return signal;
 }
 
-// Generate white noise
-Signal* generate_noise(double amplitude, double duration, double sample_rate) {
+// Generate zero-mean Gaussian white noise
+Signal* generate_gaussian_noise(double stddev, double duration, double sample_rate,
+                                uint64_t seed) {
     int length = (int)(duration * sample_rate);
     Signal *signal = create_signal(length, sample_rate);
     if (!signal) return NULL;
     
     signal->type = SIGNAL_NOISE;
     snprintf(signal->name, sizeof(signal->name), 
-             "White Noise (%.2fA)", amplitude);
-    
-    // Seed random number generator
-    srand((unsigned int)time(NULL));
+             "Gaussian Noise (σ=%.2f)", stddev);
     
-    for (int i = 0; i < length; i++) {
-        // Generate random number between -1 and 1
-        double random_val = 2.0 * ((double)rand() / RAND_MAX) - 1.0;
-        signal->data[i] = amplitude * random_val;
-    }
+    conv_fill_gaussian(signal->data, length, 0.0, stddev, seed);
     
     return signal;
 }
@@ -150,12 +331,7 @@ Signal* generate_impulse(double amplitude, double delay,
     
     int delay_samples = (int)(delay * sample_rate);
     
-    // Set all samples to 0 except the impulse
-    for (int i = 0; i < length; i++) {
-        signal->data[i] = 0.0;
-    }
-    
-    // Set the impulse
+    // create_signal zeroed the samples; set the impulse
     if (delay_samples >= 0 && delay_samples < length) {
         signal->data[delay_samples] = amplitude;
     }
@@ -174,17 +350,34 @@ Signal* generate_gaussian_pulse(double amplitude, double sigma, double center,
     snprintf(signal->name, sizeof(signal->name), 
              "Gaussian Pulse (σ=%.3f, center=%.3fs)", sigma, center);
     
-    int center_sample = (int)(center * sample_rate);
+    double sigma_samples = sigma * sample_rate;
     
-    for (int i = 0; i < length; i++) {
-        double t = (double)(i - center_sample) / sample_rate;
-        double exponent = -(t * t) / (2.0 * sigma * sigma);
-        signal->data[i] = amplitude * exp(exponent);
-    }
+    GeneratorJob job = {0};
+    job.type = SIGNAL_GAUSSIAN;
+    job.amplitude = amplitude;
+    job.center = (int)(center * sample_rate);
+    job.inverse_variance = 1.0 / (sigma_samples * sigma_samples);
+    job.ratio_step = exp(-job.inverse_variance);
+    run_generator(&job, signal);
     
     return signal;
 }
 
+// Print range, mean and spread of a view's samples
+static void print_view_statistics(const SignalView *view) {
+    SignalStats stats;
+    if (signal_view_statistics(view, &stats) != 0) {
+        printf("\n");
+        return;
+    }
+    
+    printf("  Range: [%.6f, %.6f]\n", stats.min, stats.max);
+    printf("  Mean: %.6f\n", stats.mean);
+    printf("  Standard Deviation: %.6f\n", stats.stddev);
+    printf("  RMS: %.6f (peak %.6f)\n", stats.rms, stats.peak);
+    printf("\n");
+}
+
 // Print signal information
 void print_signal_info(const Signal *signal) {
     if (!signal) {
@@ -212,88 +405,39 @@ void print_signal_info(const Signal *signal) {
     printf("  Sample Rate: %.1f Hz\n", signal->sample_rate);
     printf("  Duration: %.3f seconds\n", signal->duration);
     
-    // Calculate basic statistics
-    double min_val = signal->data[0];
-    double max_val = signal->data[0];
-    double sum = 0.0;
-    
-    for (int i = 0; i < signal->length; i++) {
-        double val = signal->data[i];
-        if (val < min_val) min_val = val;
-        if (val > max_val) max_val = val;
-        sum += val;
+    SignalView view = signal_view(signal);
+    print_view_statistics(&view);
+}
+
+// Print information about a view
+void print_signal_view_info(const SignalView *view) {
+    if (!view || !view->data) {
+        printf("Signal view is NULL\n");
+        return;
     }
     
-    double mean = sum / signal->length;
-    double variance = 0.0;
+    printf("Signal View Information:\n");
+    printf("  Length: %d samples (stride %d)\n", view->length, view->stride);
+    printf("  Sample Rate: %.1f Hz\n", view->sample_rate);
+    printf("  Duration: %.3f seconds\n", view->length / view->sample_rate);
     
-    for (int i = 0; i < signal->length; i++) {
-        double diff = signal->data[i] - mean;
-        variance += diff * diff;
-    }
-    variance /= signal->length;
-    
-    printf("  Range: [%.6f, %.6f]\n", min_val, max_val);
-    printf("  Mean: %.6f\n", mean);
-    printf("  Standard Deviation: %.6f\n", sqrt(variance));
-    printf("\n");
+    print_view_statistics(view);
 }
 
 // Normalize signal to [-1, 1] range
 void normalize_signal(Signal *signal) {
     if (!signal || !signal->data) return;
     
-    // Find min and max values
-    double min_val = signal->data[0];
-    double max_val = signal->data[0];
-    
-    for (int i = 1; i < signal->length; i++) {
-        if (signal->data[i] < min_val) min_val = signal->data[i];
-        if (signal->data[i] > max_val) max_val = signal->data[i];
-    }
-    
-    // Avoid division by zero
-    double range = max_val - min_val;
-    if (range < 1e-10) return;
-    
-    // Normalize to [-1, 1]
-    for (int i = 0; i < signal->length; i++) {
-        signal->data[i] = 2.0 * (signal->data[i] - min_val) / range - 1.0;
-    }
+    SignalView view = signal_view(signal);
+    normalize_signal_view(&view);
 }
 
-// Apply window function to signal
-Signal* window_signal(const Signal *signal, const char *window_type) {
-    if (!signal) return NULL;
-    
-    Signal *windowed = create_signal(signal->length, signal->sample_rate);
-    if (!windowed) return NULL;
-    
-    // Copy original data
-    memcpy(windowed->data, signal->data, signal->length * sizeof(double));
-    windowed->type = signal->type;
-    snprintf(windowed->name, sizeof(windowed->name), 
-             "%s (%s windowed)", signal->name, window_type);
-    
-    // Apply window function
-    for (int i = 0; i < signal->length; i++) {
-        double window_val = 1.0; // Default: rectangular window
-        
-        if (strcmp(window_type, "hann") == 0 || strcmp(window_type, "hanning") == 0) {
-            // Hann window
-            window_val = 0.5 * (1.0 - cos(TWO_PI * i / (signal->length - 1)));
-        } else if (strcmp(window_type, "hamming") == 0) {
-            // Hamming window
-            window_val = 0.54 - 0.46 * cos(TWO_PI * i / (signal->length - 1));
-        } else if (strcmp(window_type, "blackman") == 0) {
-            // Blackman window
-            double a0 = 0.42, a1 = 0.5, a2 = 0.08;
-            window_val = a0 - a1 * cos(TWO_PI * i / (signal->length - 1)) 
-                           + a2 * cos(4.0 * PI * i / (signal->length - 1));
-        }
-        
-        windowed->data[i] *= window_val;
-    }
-    
-    return windowed;
-}
\ No newline at end of file
+// Normalize the samples a view covers to [-1, 1], in place: one pass for
+// the range, one to rescale
+void normalize_signal_view(SignalView *view) {
+    if (!view || !view->data || view->length < 1) return;
+    
+    SignalStats stats;
+    if (signal_view_statistics(view, &stats) != 0) return;
+    normalize_signal_view_with_stats(view, &stats);
+}
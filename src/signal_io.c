@@ -0,0 +1,1081 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/convolution.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary signal format: a fixed 128-byte little-endian header followed by
+// frames x channels interleaved samples.
+//
+//   0   char[8]  magic "CVSIGNAL"
+//   8   u32      version (1)
+//   12  u32      header size (offset of the samples, multiple of 8)
+//   16  u32      sample format (SampleFormat)
+//   20  u32      channels
+//   24  u64      frames
+//   32  f64      sample rate
+//   40  char[64] name (NUL-terminated)
+//   104 reserved (zero)
+#define SIGNAL_FILE_MAGIC "CVSIGNAL"
+#define SIGNAL_FILE_VERSION 1
+#define SIGNAL_FILE_HEADER_SIZE 128
+
+// Samples converted per write call
+#define SIGNAL_FILE_CHUNK 4096
+
+// Initial CSV text buffer of a streaming reader (grown for longer lines)
+#define READER_TEXT_CHUNK (1 << 20)
+
+// Frames per chunk in convolve_file (rounded up to whole convolver blocks)
+#define CONVOLVE_FILE_CHUNK 65536
+
+// Width the streaming CSV writer pads its Length/Duration lines to, so they
+// can be rewritten in place once the length is known
+#define CSV_PATCHABLE_LINE 40
+
+static int host_is_little_endian(void) {
+    uint16_t probe = 1;
+    unsigned char first;
+    memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+static void put_u32(unsigned char *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static void put_u64(unsigned char *out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char *in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= (uint32_t)in[i] << (8 * i);
+    return value;
+}
+
+static uint64_t get_u64(const unsigned char *in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= (uint64_t)in[i] << (8 * i);
+    return value;
+}
+
+static void put_f64(unsigned char *out, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_u64(out, bits);
+}
+
+static double get_f64(const unsigned char *in) {
+    uint64_t bits = get_u64(in);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void put_f32(unsigned char *out, double value) {
+    float narrow = (float)value;
+    uint32_t bits;
+    memcpy(&bits, &narrow, sizeof(bits));
+    put_u32(out, bits);
+}
+
+static double get_f32(const unsigned char *in) {
+    uint32_t bits = get_u32(in);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static size_t sample_size(SampleFormat format) {
+    return (format == SAMPLE_FLOAT32) ? 4 : 8;
+}
+
+// Decode count samples of the given format into doubles
+static void decode_samples(const unsigned char *in, size_t count, SampleFormat format, double *out) {
+    size_t width = sample_size(format);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (format == SAMPLE_FLOAT32) ? get_f32(in + i * width) : get_f64(in + i * width);
+    }
+}
+
+// Write count samples in the given format. Returns 0 on success, -1 on error.
+static int write_samples(FILE *file, const double *samples, size_t count, SampleFormat format) {
+    if (format == SAMPLE_FLOAT64 && host_is_little_endian()) {
+        // Native layout: write the samples as they are
+        return (fwrite(samples, sizeof(double), count, file) == count) ? 0 : -1;
+    }
+
+    unsigned char buffer[SIGNAL_FILE_CHUNK * 8];
+    size_t width = sample_size(format);
+
+    for (size_t done = 0; done < count; ) {
+        size_t chunk = count - done;
+        if (chunk > SIGNAL_FILE_CHUNK) chunk = SIGNAL_FILE_CHUNK;
+
+        for (size_t i = 0; i < chunk; i++) {
+            if (format == SAMPLE_FLOAT32) {
+                put_f32(buffer + i * width, samples[done + i]);
+            } else {
+                put_f64(buffer + i * width, samples[done + i]);
+            }
+        }
+        if (fwrite(buffer, width, chunk, file) != chunk) return -1;
+        done += chunk;
+    }
+
+    return 0;
+}
+
+// Fields of a binary signal file header
+typedef struct {
+    uint32_t header_size;
+    SampleFormat format;
+    int channels;
+    uint64_t frames;
+    double sample_rate;
+    char name[64];
+} SignalFileHeader;
+
+static void encode_header(unsigned char *out, SampleFormat format, int channels,
+                          uint64_t frames, double sample_rate, const char *name) {
+    memset(out, 0, SIGNAL_FILE_HEADER_SIZE);
+    memcpy(out, SIGNAL_FILE_MAGIC, 8);
+    put_u32(out + 8, SIGNAL_FILE_VERSION);
+    put_u32(out + 12, SIGNAL_FILE_HEADER_SIZE);
+    put_u32(out + 16, (uint32_t)format);
+    put_u32(out + 20, (uint32_t)channels);
+    put_u64(out + 24, frames);
+    put_f64(out + 32, sample_rate);
+    if (name) strncpy((char*)out + 40, name, 63);
+}
+
+// Check and decode a header read from a file of file_size bytes. Returns 0
+// on success, -1 if it is not a valid header or the samples do not fit.
+static int decode_header(const unsigned char *in, uint64_t file_size, SignalFileHeader *header) {
+    uint32_t format = get_u32(in + 16);
+    uint32_t channels = get_u32(in + 20);
+
+    header->header_size = get_u32(in + 12);
+    header->frames = get_u64(in + 24);
+    header->sample_rate = get_f64(in + 32);
+    memcpy(header->name, in + 40, sizeof(header->name) - 1);
+    header->name[sizeof(header->name) - 1] = '\0';
+
+    if (memcmp(in, SIGNAL_FILE_MAGIC, 8) != 0 || get_u32(in + 8) != SIGNAL_FILE_VERSION) return -1;
+    if (header->header_size < SIGNAL_FILE_HEADER_SIZE || header->header_size % 8 != 0) return -1;
+    if (format != SAMPLE_FLOAT64 && format != SAMPLE_FLOAT32) return -1;
+    if (channels < 1 || channels > (uint32_t)INT32_MAX) return -1;
+    if (header->header_size > file_size) return -1;
+
+    header->format = (SampleFormat)format;
+    header->channels = (int)channels;
+
+    uint64_t frame_bytes = (uint64_t)channels * sample_size(header->format);
+    if (header->frames > (file_size - header->header_size) / frame_bytes) return -1;
+
+    return 0;
+}
+
+// Write interleaved samples as a binary signal file. Returns 0 on success,
+// -1 on error.
+int save_frames_binary(const double *frames, int frame_count, int channels,
+                       double sample_rate, const char *name,
+                       SampleFormat format, const char *filename) {
+    if (!frames || frame_count < 0 || channels < 1 || !filename) return -1;
+    if (format != SAMPLE_FLOAT64 && format != SAMPLE_FLOAT32) return -1;
+
+    unsigned char header[SIGNAL_FILE_HEADER_SIZE];
+    encode_header(header, format, channels, (uint64_t)frame_count, sample_rate, name);
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) return -1;
+
+    int status = (fwrite(header, 1, sizeof(header), file) == sizeof(header)) ? 0 : -1;
+    if (status == 0) {
+        status = write_samples(file, frames, (size_t)frame_count * channels, format);
+    }
+
+    if (fclose(file) != 0) status = -1;
+    return status;
+}
+
+// Write a signal as a mono binary signal file. Returns 0 on success, -1 on error.
+int save_signal_binary(const Signal *signal, const char *filename, SampleFormat format) {
+    if (!signal || !signal->data) return -1;
+
+    return save_frames_binary(signal->data, signal->length, 1, signal->sample_rate,
+                              signal->name, format, filename);
+}
+
+// 1 if the file starts with the binary signal magic, 0 otherwise
+int is_binary_signal_file(const char *filename) {
+    if (!filename) return 0;
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+
+    char magic[8];
+    int match = (fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                 memcmp(magic, SIGNAL_FILE_MAGIC, sizeof(magic)) == 0);
+    fclose(file);
+
+    return match;
+}
+
+// Map a binary signal file. Float64 samples on a little-endian host are
+// used straight from the mapped pages (private copy-on-write mapping, so
+// writes never reach the file); anything else is decoded once. Returns NULL
+// if the file is missing, truncated or not a signal file.
+MappedSignal* map_signal_file(const char *filename) {
+    if (!filename) return NULL;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < SIGNAL_FILE_HEADER_SIZE) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t map_length = (size_t)info.st_size;
+    void *map = mmap(NULL, map_length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    // Mapped samples are indexed with an int
+    SignalFileHeader header;
+    MappedSignal *mapped = NULL;
+    if (decode_header((const unsigned char*)map, map_length, &header) == 0 &&
+        header.frames * header.channels <= (uint64_t)INT32_MAX) {
+        mapped = (MappedSignal*)calloc(1, sizeof(MappedSignal));
+    }
+    if (!mapped) {
+        munmap(map, map_length);
+        return NULL;
+    }
+
+    uint32_t header_size = header.header_size;
+    SampleFormat format = header.format;
+    mapped->frames = (int)header.frames;
+    mapped->channels = header.channels;
+    mapped->sample_rate = header.sample_rate;
+    mapped->format = format;
+    memcpy(mapped->name, header.name, sizeof(mapped->name));
+
+    size_t count = (size_t)header.frames * header.channels;
+    const unsigned char *data = (const unsigned char*)map + header_size;
+
+    if (format == SAMPLE_FLOAT64 && host_is_little_endian()) {
+        mapped->map = map;
+        mapped->map_length = map_length;
+        mapped->samples = (double*)((unsigned char*)map + header_size);
+    } else {
+        mapped->decoded = (double*)malloc((count > 0 ? count : 1) * sizeof(double));
+        if (mapped->decoded) {
+            decode_samples(data, count, format, mapped->decoded);
+        }
+        munmap(map, map_length);
+        if (!mapped->decoded) {
+            free(mapped);
+            return NULL;
+        }
+        mapped->samples = mapped->decoded;
+    }
+
+    if (mapped->channels == 1) {
+        signal_init(&mapped->signal, mapped->samples, mapped->frames, mapped->sample_rate);
+        strcpy(mapped->signal.name, mapped->name);
+    }
+
+    return mapped;
+}
+
+// View of one channel of a mapped file (empty view if out of range)
+SignalView mapped_signal_channel(const MappedSignal *mapped, int channel) {
+    if (!mapped) {
+        SignalView empty = {NULL, 0, 1, 0.0};
+        return empty;
+    }
+    return signal_view_channel(mapped->samples, mapped->frames, mapped->channels,
+                               channel, mapped->sample_rate);
+}
+
+// Unmap a file; views and the Signal taken from it become invalid
+void unmap_signal_file(MappedSignal *mapped) {
+    if (mapped) {
+        if (mapped->map) munmap(mapped->map, mapped->map_length);
+        free(mapped->decoded);
+        free(mapped);
+    }
+}
+
+// Load one channel of a binary signal file into a new signal
+Signal* load_signal_binary(const char *filename, int channel) {
+    MappedSignal *mapped = map_signal_file(filename);
+    if (!mapped) return NULL;
+
+    SignalView view = mapped_signal_channel(mapped, channel);
+    Signal *signal = view.data ? signal_from_view(&view) : NULL;
+    if (signal) {
+        strcpy(signal->name, mapped->name);
+    }
+
+    unmap_signal_file(mapped);
+    return signal;
+}
+
+// Save signal to CSV file for external analysis
+void save_signal_to_file(const Signal *signal, const char *filename) {
+    if (!signal || !filename) return;
+    
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        printf("Error: Could not open file %s for writing\n", filename);
+        return;
+    }
+    
+    fprintf(file, "# %s\n", signal->name);
+    fprintf(file, "# Sample Rate: %.1f Hz\n", signal->sample_rate);
+    fprintf(file, "# Length: %d samples\n", signal->length);
+    fprintf(file, "# Duration: %.6f seconds\n", signal->duration);
+    fprintf(file, "Time,Amplitude\n");
+    
+    for (int i = 0; i < signal->length; i++) {
+        double time = (double)i / signal->sample_rate;
+        fprintf(file, "%.6f,%.6f\n", time, signal->data[i]);
+    }
+    
+    fclose(file);
+    printf("Signal saved to %s\n", filename);
+}
+
+// Powers of ten that are exact in a double
+static const double exact_powers_of_10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parse a decimal number starting at text (leading blanks skipped), as
+// sscanf("%lf") would. Numbers with at most 19 digits whose
+// mantissa and power of ten are exact doubles are converted with a single
+// multiply or divide, which is correctly rounded (Clinger's fast path);
+// anything else goes through strtod. A number never extends past the end
+// of its line, and text must be NUL-terminated somewhere after it. value may
+// be NULL to only validate. Returns the end of the number, or NULL if there
+// is none.
+static const char* parse_csv_double(const char *text, double *value) {
+    while (*text == ' ' || *text == '\t') text++;
+    
+    const char *p = text;
+    int negative = 0;
+    if (*p == '-' || *p == '+') negative = (*p++ == '-');
+    
+    // Accumulate up to 19 digits exactly; longer mantissas take the slow path
+    uint64_t mantissa = 0;
+    const char *first_digit = p;
+    while ((unsigned)(*p - '0') < 10) {
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        p++;
+    }
+    int digits = (int)(p - first_digit);
+    int exponent = 0;
+    if (*p == '.') {
+        const char *fraction = ++p;
+        while ((unsigned)(*p - '0') < 10) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            p++;
+        }
+        exponent = -(int)(p - fraction);
+        digits -= exponent;
+    }
+    if (*p == 'x' || *p == 'X') digits = 0; // Hex float: leave it to strtod
+    if (digits > 0 && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int exponent_negative = 0;
+        if (*q == '-' || *q == '+') exponent_negative = (*q++ == '-');
+        if (*q >= '0' && *q <= '9') {
+            int written = 0;
+            for (; *q >= '0' && *q <= '9'; q++) {
+                if (written < 10000) written = written * 10 + (*q - '0');
+            }
+            exponent += exponent_negative ? -written : written;
+            p = q;
+        }
+    }
+    
+    if (digits > 0 && digits <= 19 && mantissa <= ((uint64_t)1 << 53) &&
+        exponent >= -22 && exponent <= 22) {
+        if (value) {
+            double result = (double)mantissa;
+            result = (exponent < 0) ? result / exact_powers_of_10[-exponent]
+                                    : result * exact_powers_of_10[exponent];
+            *value = negative ? -result : result;
+        }
+        return p;
+    }
+    
+    // Long mantissas, large exponents, inf/nan, hex floats. strtod would
+    // skip line breaks, so stop at them here.
+    if (*text == '\n' || *text == '\r' || *text == '\v' || *text == '\f') return NULL;
+    char *end;
+    double result = strtod(text, &end);
+    if (value) *value = result;
+    return (end == text) ? NULL : end;
+}
+
+// Whole file as NUL-terminated text. The file is mapped when the page
+// past its end supplies the terminator (size not a multiple of the page
+// size); otherwise it is read into a buffer. Release with release_text.
+static char* load_text(const char *filename, size_t *length, size_t *map_length) {
+    *map_length = 0;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)info.st_size;
+    long page = sysconf(_SC_PAGESIZE);
+    if (size > 0 && page > 0 && size % (size_t)page != 0) {
+        void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            close(fd);
+            *length = size;
+            *map_length = size;
+            return (char*)map;
+        }
+    }
+
+    char *text = (char*)malloc(size + 1);
+    size_t used = 0;
+    while (text && used < size) {
+        ssize_t got = read(fd, text + used, size - used);
+        if (got <= 0) break;
+        used += (size_t)got;
+    }
+    close(fd);
+
+    if (text) {
+        text[used] = '\0';
+        *length = used;
+    }
+    return text;
+}
+
+static void release_text(char *text, size_t map_length) {
+    if (map_length > 0) {
+        munmap(text, map_length);
+    } else {
+        free(text);
+    }
+}
+
+// Parse the CSV line starting at line (text_end is the end of the buffered
+// text, where a NUL follows). Comment lines may set *sample_rate, sample
+// lines ("time,amplitude": the time must parse and be followed by a comma)
+// set *amplitude and *has_sample. Returns the start of the next line.
+static const char* parse_csv_line(const char *line, const char *text_end,
+                                  double *sample_rate, double *amplitude, int *has_sample) {
+    const char *end = line;
+    *has_sample = 0;
+    
+    if (line[0] == '#') {
+        const char *newline = memchr(line, '\n', text_end - line);
+        end = newline ? newline : text_end;
+        
+        char header[256];
+        size_t header_length = end - line;
+        if (header_length > sizeof(header) - 1) header_length = sizeof(header) - 1;
+        memcpy(header, line, header_length);
+        header[header_length] = '\0';
+        if (strstr(header, "Sample Rate:")) {
+            sscanf(header, "# Sample Rate: %lf Hz", sample_rate);
+        }
+    } else if (line[0] != 'T') { // Skip "Time,Amplitude" header
+        const char *p = parse_csv_double(line, NULL);
+        if (p && *p == ',') {
+            p = parse_csv_double(p + 1, amplitude);
+            if (p) {
+                *has_sample = 1;
+                end = p;
+            }
+        }
+    }
+    
+    // Rest of the line is ignored
+    if (*end == '\n') return end + 1;
+    
+    const char *newline = memchr(end, '\n', text_end - end);
+    return newline ? newline + 1 : text_end;
+}
+
+// Load signal from CSV file (or a binary signal file). The file is mapped
+// (or read in one go) and parsed in a single pass; lines may be any length.
+Signal* load_signal_from_file(const char *filename) {
+    if (!filename) return NULL;
+    
+    // Binary signal files load without parsing (first channel)
+    if (is_binary_signal_file(filename)) {
+        return load_signal_binary(filename, 0);
+    }
+    
+    size_t text_length = 0;
+    size_t map_length;
+    char *text = load_text(filename, &text_length, &map_length);
+    if (!text) {
+        fprintf(stderr, "Error: Could not open file %s for reading\n", filename);
+        return NULL;
+    }
+    
+    double sample_rate = 44100.0; // Default
+    size_t capacity = text_length / 16 + 16;
+    size_t count = 0;
+    double *samples = (double*)malloc(capacity * sizeof(double));
+    
+    const char *line = text;
+    const char *text_end = text + text_length;
+    
+    while (samples && line < text_end) {
+        double amplitude;
+        int has_sample;
+        line = parse_csv_line(line, text_end, &sample_rate, &amplitude, &has_sample);
+        if (!has_sample) continue;
+        
+        if (count == capacity) {
+            double *grown = (double*)realloc(samples, 2 * capacity * sizeof(double));
+            if (!grown) {
+                free(samples);
+                samples = NULL;
+                break;
+            }
+            samples = grown;
+            capacity *= 2;
+        }
+        samples[count++] = amplitude;
+    }
+    release_text(text, map_length);
+    
+    if (!samples || count == 0 || count > INT32_MAX) {
+        free(samples);
+        return NULL;
+    }
+    
+    Signal *signal = NULL;
+    if (!signal_arena_current()) {
+        // Heap signal: adopt the sample buffer instead of copying it
+        signal = (Signal*)malloc(sizeof(Signal));
+        if (signal) {
+            double *data = (double*)realloc(samples, count * sizeof(double));
+            signal_init(signal, data ? data : samples, (int)count, sample_rate);
+            signal->storage = STORAGE_HEAP;
+            samples = NULL;
+        }
+    } else {
+        signal = create_signal((int)count, sample_rate);
+        if (signal) memcpy(signal->data, samples, count * sizeof(double));
+    }
+    free(samples);
+    
+    if (signal) strcpy(signal->name, "Loaded from file");
+    return signal;
+}
+
+// Fill the CSV buffer until it holds at least one complete unparsed line
+// (or the rest of the file). Returns 0 on success, -1 on error.
+static int csv_refill(SignalReader *reader) {
+    while (1) {
+        // Complete lines end after the last newline; at EOF the rest counts
+        size_t end = reader->text_end;
+        if (!reader->at_eof) {
+            while (end > reader->text_start && reader->buffer[end - 1] != '\n') end--;
+        }
+        reader->complete_end = end;
+        if (end > reader->text_start || reader->at_eof) return 0;
+
+        // Move the unparsed tail to the front, growing if one line fills it
+        size_t pending = reader->text_end - reader->text_start;
+        memmove(reader->buffer, reader->buffer + reader->text_start, pending);
+        reader->text_start = 0;
+        reader->text_end = pending;
+
+        if (pending == reader->buffer_capacity) {
+            unsigned char *grown = (unsigned char*)realloc(reader->buffer,
+                                                           2 * reader->buffer_capacity + 1);
+            if (!grown) return -1;
+            reader->buffer = grown;
+            reader->buffer_capacity *= 2;
+        }
+
+        size_t got = fread(reader->buffer + reader->text_end, 1,
+                           reader->buffer_capacity - reader->text_end, reader->file);
+        reader->text_end += got;
+        reader->buffer[reader->text_end] = '\0';
+        if (got == 0) reader->at_eof = 1;
+    }
+}
+
+// Open a CSV or binary signal file for chunked reading. The header (sample
+// rate, channels, name) is available as soon as this returns.
+SignalReader* signal_reader_open(const char *filename) {
+    if (!filename) return NULL;
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) return NULL;
+
+    SignalReader *reader = (SignalReader*)calloc(1, sizeof(SignalReader));
+    if (!reader) {
+        fclose(file);
+        return NULL;
+    }
+    reader->file = file;
+    reader->channels = 1;
+    reader->frames = -1;
+    reader->sample_rate = 44100.0; // CSV default, as load_signal_from_file
+    strcpy(reader->name, "Untitled Signal");
+
+    unsigned char header[SIGNAL_FILE_HEADER_SIZE];
+    size_t got = fread(header, 1, sizeof(header), file);
+
+    if (got >= 8 && memcmp(header, SIGNAL_FILE_MAGIC, 8) == 0) {
+        struct stat info;
+        SignalFileHeader decoded;
+        if (got != sizeof(header) || fstat(fileno(file), &info) != 0 ||
+            decode_header(header, (uint64_t)info.st_size, &decoded) != 0 ||
+            fseek(file, (long)decoded.header_size, SEEK_SET) != 0) {
+            signal_reader_close(reader);
+            return NULL;
+        }
+
+        reader->type = SIGNAL_FILE_BINARY;
+        reader->format = decoded.format;
+        reader->channels = decoded.channels;
+        reader->sample_rate = decoded.sample_rate;
+        reader->frames = (long long)decoded.frames;
+        memcpy(reader->name, decoded.name, sizeof(reader->name));
+        return reader;
+    }
+
+    // CSV: the bytes already read start the text buffer
+    reader->type = SIGNAL_FILE_CSV;
+    reader->buffer_capacity = READER_TEXT_CHUNK;
+    reader->buffer = (unsigned char*)malloc(reader->buffer_capacity + 1);
+    if (!reader->buffer) {
+        signal_reader_close(reader);
+        return NULL;
+    }
+    memcpy(reader->buffer, header, got);
+    reader->text_end = got;
+    reader->buffer[got] = '\0';
+    if (got < sizeof(header)) reader->at_eof = 1;
+
+    // Leading comment lines: "# name" first, then the sample rate
+    int line_number = 0;
+    while (csv_refill(reader) == 0 && reader->text_start < reader->complete_end) {
+        const char *line = (const char*)reader->buffer + reader->text_start;
+        if (line[0] != '#' && line[0] != 'T') break;
+
+        if (line_number++ == 0 && line[0] == '#') {
+            const char *text = line + 1;
+            while (*text == ' ') text++;
+            size_t length = strcspn(text, "\r\n");
+            if (length > sizeof(reader->name) - 1) length = sizeof(reader->name) - 1;
+            memcpy(reader->name, text, length);
+            reader->name[length] = '\0';
+        }
+
+        double amplitude;
+        int has_sample;
+        const char *next = parse_csv_line(line, (const char*)reader->buffer + reader->complete_end,
+                                          &reader->sample_rate, &amplitude, &has_sample);
+        reader->text_start = next - (const char*)reader->buffer;
+    }
+
+    return reader;
+}
+
+// Read up to max_frames frames (interleaved channels) into frames. Returns
+// the number of frames read, 0 at the end of the file, or -1 on error.
+int signal_reader_read(SignalReader *reader, double *frames, int max_frames) {
+    if (!reader || !frames || max_frames < 0) return -1;
+
+    int count = 0;
+
+    if (reader->type == SIGNAL_FILE_BINARY) {
+        long long remaining = reader->frames - reader->frames_read;
+        if (remaining < max_frames) max_frames = (int)remaining;
+
+        size_t samples = (size_t)max_frames * reader->channels;
+        size_t done = 0;
+
+        if (reader->format == SAMPLE_FLOAT64 && host_is_little_endian()) {
+            done = fread(frames, sizeof(double), samples, reader->file);
+        } else {
+            size_t width = sample_size(reader->format);
+            if (!reader->buffer) {
+                reader->buffer_capacity = SIGNAL_FILE_CHUNK * 8;
+                reader->buffer = (unsigned char*)malloc(reader->buffer_capacity);
+                if (!reader->buffer) return -1;
+            }
+            while (done < samples) {
+                size_t chunk = samples - done;
+                if (chunk > SIGNAL_FILE_CHUNK) chunk = SIGNAL_FILE_CHUNK;
+                size_t got = fread(reader->buffer, width, chunk, reader->file);
+                decode_samples(reader->buffer, got, reader->format, frames + done);
+                done += got;
+                if (got < chunk) break;
+            }
+        }
+
+        count = (int)(done / reader->channels);
+        if (count < max_frames && ferror(reader->file)) return -1;
+    } else {
+        const char *text = (const char*)reader->buffer;
+
+        while (count < max_frames) {
+            if (reader->text_start >= reader->complete_end) {
+                if (csv_refill(reader) != 0) return -1;
+                if (reader->text_start >= reader->complete_end) break;
+            }
+
+            int has_sample;
+            text = (const char*)reader->buffer;
+            const char *next = parse_csv_line(text + reader->text_start,
+                                              text + reader->complete_end,
+                                              &reader->sample_rate, &frames[count], &has_sample);
+            reader->text_start = next - text;
+            count += has_sample;
+        }
+    }
+
+    reader->frames_read += count;
+    return count;
+}
+
+// Close a reader
+void signal_reader_close(SignalReader *reader) {
+    if (reader) {
+        if (reader->file) fclose(reader->file);
+        free(reader->buffer);
+        free(reader);
+    }
+}
+
+// CSV Length/Duration header lines, padded so they can be rewritten in place
+static int write_csv_length_lines(FILE *file, long long frames, double sample_rate) {
+    char line[CSV_PATCHABLE_LINE + 1];
+
+    snprintf(line, sizeof(line), "# Length: %lld samples", frames);
+    if (fprintf(file, "%-*s\n", CSV_PATCHABLE_LINE - 1, line) < 0) return -1;
+
+    snprintf(line, sizeof(line), "# Duration: %.6f seconds", frames / sample_rate);
+    if (fprintf(file, "%-*s\n", CSV_PATCHABLE_LINE - 1, line) < 0) return -1;
+
+    return 0;
+}
+
+// Open a signal file for chunked writing. CSV files are mono; binary files
+// store any number of interleaved channels. The frame count in the header
+// is filled in by signal_writer_close.
+SignalWriter* signal_writer_open(const char *filename, SignalFileType type,
+                                 SampleFormat format, int channels,
+                                 double sample_rate, const char *name) {
+    if (!filename || channels < 1 || sample_rate <= 0.0) return NULL;
+    if (type == SIGNAL_FILE_CSV && channels != 1) return NULL;
+    if (type == SIGNAL_FILE_BINARY && format != SAMPLE_FLOAT64 && format != SAMPLE_FLOAT32) {
+        return NULL;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) return NULL;
+
+    SignalWriter *writer = (SignalWriter*)calloc(1, sizeof(SignalWriter));
+    if (!writer) {
+        fclose(file);
+        return NULL;
+    }
+    writer->file = file;
+    writer->type = type;
+    writer->format = format;
+    writer->channels = channels;
+    writer->sample_rate = sample_rate;
+
+    int status;
+    if (type == SIGNAL_FILE_BINARY) {
+        unsigned char header[SIGNAL_FILE_HEADER_SIZE];
+        encode_header(header, format, channels, 0, sample_rate, name);
+        status = (fwrite(header, 1, sizeof(header), file) == sizeof(header)) ? 0 : -1;
+    } else {
+        // Same layout as save_signal_to_file
+        status = (fprintf(file, "# %s\n", name ? name : "Untitled Signal") < 0 ||
+                  fprintf(file, "# Sample Rate: %.1f Hz\n", sample_rate) < 0) ? -1 : 0;
+        writer->length_offset = ftell(file);
+        if (status == 0) status = write_csv_length_lines(file, 0, sample_rate);
+        if (status == 0 && fprintf(file, "Time,Amplitude\n") < 0) status = -1;
+    }
+
+    if (status != 0) {
+        fclose(file);
+        free(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+// Append frame_count frames (interleaved channels). Returns 0 on success,
+// -1 on error.
+int signal_writer_write(SignalWriter *writer, const double *frames, int frame_count) {
+    if (!writer || frame_count < 0 || (frame_count > 0 && !frames)) return -1;
+
+    if (writer->type == SIGNAL_FILE_BINARY) {
+        if (write_samples(writer->file, frames, (size_t)frame_count * writer->channels,
+                          writer->format) != 0) return -1;
+    } else {
+        for (int i = 0; i < frame_count; i++) {
+            double time = (double)(writer->frames + i) / writer->sample_rate;
+            if (fprintf(writer->file, "%.6f,%.6f\n", time, frames[i]) < 0) return -1;
+        }
+    }
+
+    writer->frames += frame_count;
+    return 0;
+}
+
+// Fill in the header's length and close the file. Returns 0 on success,
+// -1 on error.
+int signal_writer_close(SignalWriter *writer) {
+    if (!writer) return -1;
+
+    int status = 0;
+    if (writer->type == SIGNAL_FILE_BINARY) {
+        unsigned char frames[8];
+        put_u64(frames, (uint64_t)writer->frames);
+        if (fseek(writer->file, 24, SEEK_SET) != 0 ||
+            fwrite(frames, 1, sizeof(frames), writer->file) != sizeof(frames)) status = -1;
+    } else {
+        if (fseek(writer->file, writer->length_offset, SEEK_SET) != 0 ||
+            write_csv_length_lines(writer->file, writer->frames, writer->sample_rate) != 0) {
+            status = -1;
+        }
+    }
+
+    if (fclose(writer->file) != 0) status = -1;
+    free(writer);
+    return status;
+}
+
+// Read-ahead of input chunks on one thread that lives for the whole
+// convolve_file run. The caller requests a buffer, filters the current
+// chunk, then waits for the read; without a thread the read runs inline.
+typedef struct {
+    SignalReader *reader;
+    int max_frames;
+    pthread_t thread;
+    int running;             // Reader thread started
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    double *frames;          // Buffer of the requested read, NULL when idle
+    int pending;             // A read is requested or in progress
+    int result;              // Frames of the last finished read, or -1
+    int stop;
+} Prefetcher;
+
+static void* prefetch_main(void *context) {
+    Prefetcher *prefetch = (Prefetcher*)context;
+
+    pthread_mutex_lock(&prefetch->lock);
+    while (1) {
+        while (!prefetch->stop && !prefetch->frames) {
+            pthread_cond_wait(&prefetch->changed, &prefetch->lock);
+        }
+        if (prefetch->stop) break;
+
+        double *frames = prefetch->frames;
+        pthread_mutex_unlock(&prefetch->lock);
+        int result = signal_reader_read(prefetch->reader, frames, prefetch->max_frames);
+        pthread_mutex_lock(&prefetch->lock);
+
+        prefetch->frames = NULL;
+        prefetch->result = result;
+        prefetch->pending = 0;
+        pthread_cond_broadcast(&prefetch->changed);
+    }
+    pthread_mutex_unlock(&prefetch->lock);
+
+    return NULL;
+}
+
+static void prefetch_start(Prefetcher *prefetch, SignalReader *reader, int max_frames) {
+    memset(prefetch, 0, sizeof(*prefetch));
+    prefetch->reader = reader;
+    prefetch->max_frames = max_frames;
+    prefetch->result = -1;
+    if (pthread_mutex_init(&prefetch->lock, NULL) != 0) return;
+    if (pthread_cond_init(&prefetch->changed, NULL) != 0) {
+        pthread_mutex_destroy(&prefetch->lock);
+        return;
+    }
+    prefetch->running = (pthread_create(&prefetch->thread, NULL, prefetch_main, prefetch) == 0);
+    if (!prefetch->running) {
+        pthread_cond_destroy(&prefetch->changed);
+        pthread_mutex_destroy(&prefetch->lock);
+    }
+}
+
+// Start reading the next chunk into frames
+static void prefetch_request(Prefetcher *prefetch, double *frames) {
+    if (!prefetch->running) {
+        prefetch->frames = frames;
+        return;
+    }
+
+    pthread_mutex_lock(&prefetch->lock);
+    prefetch->frames = frames;
+    prefetch->pending = 1;
+    pthread_cond_broadcast(&prefetch->changed);
+    pthread_mutex_unlock(&prefetch->lock);
+}
+
+// Frames read by the last request, or -1 on error
+static int prefetch_wait(Prefetcher *prefetch) {
+    if (!prefetch->running) {
+        int result = signal_reader_read(prefetch->reader, prefetch->frames, prefetch->max_frames);
+        prefetch->frames = NULL;
+        return result;
+    }
+
+    pthread_mutex_lock(&prefetch->lock);
+    while (prefetch->pending) {
+        pthread_cond_wait(&prefetch->changed, &prefetch->lock);
+    }
+    int result = prefetch->result;
+    pthread_mutex_unlock(&prefetch->lock);
+
+    return result;
+}
+
+static void prefetch_stop(Prefetcher *prefetch) {
+    if (!prefetch->running) return;
+
+    pthread_mutex_lock(&prefetch->lock);
+    prefetch->stop = 1;
+    pthread_cond_broadcast(&prefetch->changed);
+    pthread_mutex_unlock(&prefetch->lock);
+
+    pthread_join(prefetch->thread, NULL);
+    pthread_cond_destroy(&prefetch->changed);
+    pthread_mutex_destroy(&prefetch->lock);
+}
+
+// Filter count frames of interleaved input (NULL: zeros) through one
+// convolver per channel into interleaved output
+static void convolve_frames(Convolver **convolvers, int channels, const double *input,
+                            int count, double *output, double *channel_in, double *channel_out) {
+    if (channels == 1) {
+        convolver_process(convolvers[0], input, count, output);
+        return;
+    }
+
+    for (int c = 0; c < channels; c++) {
+        if (input) {
+            for (int i = 0; i < count; i++) channel_in[i] = input[(size_t)i * channels + c];
+        }
+        convolver_process(convolvers[c], input ? channel_in : NULL, count, channel_out);
+        for (int i = 0; i < count; i++) output[(size_t)i * channels + c] = channel_out[i];
+    }
+}
+
+// Convolve every channel of a signal file with a kernel and write the full
+// result (N + M - 1 frames) to output_file. The input is streamed through
+// one Convolver per channel in fixed-size chunks, so memory use does not
+// depend on the file length, and the next chunk is read on a reader thread
+// (one per call) while the current one is filtered. Returns 0 on success, -1 on error.
+int convolve_file(const char *input_file, const Signal *kernel,
+                  const char *output_file, SignalFileType output_type) {
+    if (!input_file || !kernel || !kernel->data || kernel->length < 1 || !output_file) return -1;
+
+    SignalReader *reader = signal_reader_open(input_file);
+    if (!reader) return -1;
+
+    int channels = reader->channels;
+    Convolver **convolvers = (Convolver**)calloc(channels, sizeof(Convolver*));
+    int status = convolvers ? 0 : -1;
+    for (int c = 0; c < channels && status == 0; c++) {
+        convolvers[c] = convolver_create(kernel, 0);
+        if (!convolvers[c]) status = -1;
+    }
+
+    // Whole blocks per chunk, so each chunk costs one FFT pair per block
+    int chunk = CONVOLVE_FILE_CHUNK;
+    if (status == 0) {
+        int block = convolvers[0]->block_size;
+        chunk = (chunk + block - 1) / block * block;
+    }
+
+    size_t chunk_samples = (size_t)chunk * channels;
+    double *buffers = NULL;
+    SignalWriter *writer = NULL;
+    if (status == 0) {
+        // Two input chunks, one output chunk, and channel scratch
+        buffers = (double*)malloc((3 * chunk_samples + 2 * (size_t)chunk) * sizeof(double));
+
+        char name[64];
+        snprintf(name, sizeof(name), "Conv(%.27s * %.27s)", reader->name, kernel->name);
+        writer = signal_writer_open(output_file, output_type, SAMPLE_FLOAT64, channels,
+                                    reader->sample_rate, name);
+        if (!buffers || !writer) status = -1;
+    }
+
+    if (status == 0) {
+        double *input[2] = {buffers, buffers + chunk_samples};
+        double *output = buffers + 2 * chunk_samples;
+        double *channel_in = output + chunk_samples;
+        double *channel_out = channel_in + chunk;
+
+        Prefetcher prefetch;
+        prefetch_start(&prefetch, reader, chunk);
+
+        int current = 0;
+        int count = signal_reader_read(reader, input[current], chunk);
+
+        while (count > 0 && status == 0) {
+            prefetch_request(&prefetch, input[1 - current]);
+
+            convolve_frames(convolvers, channels, input[current], count, output,
+                            channel_in, channel_out);
+            if (signal_writer_write(writer, output, count) != 0) status = -1;
+
+            count = prefetch_wait(&prefetch);
+            current = 1 - current;
+        }
+        if (count < 0) status = -1;
+        prefetch_stop(&prefetch);
+
+        // Convolution tail: kernel_length - 1 frames of pushed zeros
+        for (int remaining = kernel->length - 1; remaining > 0 && status == 0; ) {
+            int n = (remaining < chunk) ? remaining : chunk;
+            convolve_frames(convolvers, channels, NULL, n, output, channel_in, channel_out);
+            if (signal_writer_write(writer, output, n) != 0) status = -1;
+            remaining -= n;
+        }
+    }
+
+    if (writer && signal_writer_close(writer) != 0) status = -1;
+    if (convolvers) {
+        for (int c = 0; c < channels; c++) convolver_destroy(convolvers[c]);
+        free(convolvers);
+    }
+    free(buffers);
+    signal_reader_close(reader);
+
+    return status;
+}
@@ -0,0 +1,347 @@
+#include "../include/convolution.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONV_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Samples summarized at a time. A block sits in L1 while its mean and its
+// squared deviations are taken, so memory is read once.
+#define STATS_BLOCK 1024
+
+// Block sums use this many interleaved accumulators: sample i of a block
+// goes to lane i % STATS_LANES on every SIMD level
+#define STATS_LANES 8
+
+// Samples per parallel task (a multiple of STATS_BLOCK)
+#define STATS_CHUNK 65536
+
+// Views of at least this many samples use the thread pool
+#define STATS_PARALLEL_MIN (4 * STATS_CHUNK)
+
+// Count, mean, sum of squared deviations and range of some samples
+typedef struct {
+    double count;
+    double mean;
+    double m2;
+    double min;
+    double max;
+} Moments;
+
+// Lane accumulators of one pass over a block
+typedef struct {
+    double sum[STATS_LANES];
+    double min[STATS_LANES];
+    double max[STATS_LANES];
+} LaneTotals;
+
+// Chan et al.: combine b into a (either may be empty)
+static void moments_merge(Moments *a, const Moments *b) {
+    if (b->count == 0) return;
+    if (a->count == 0) {
+        *a = *b;
+        return;
+    }
+
+    double count = a->count + b->count;
+    double delta = b->mean - a->mean;
+    a->mean += delta * (b->count / count);
+    a->m2 += b->m2 + delta * delta * (a->count * b->count / count);
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+    a->count = count;
+}
+
+// Fixed-order sum of the lanes
+static double lane_sum(const double *lanes) {
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+           ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+// Samples past the last full group of lanes, shared by every level
+static void tail_sums(const double *x, int start, int count, double mean, int squared,
+                      LaneTotals *totals) {
+    for (int i = start; i < count; i++) {
+        int lane = i - start;
+        double v = x[i];
+        if (squared) {
+            double d = v - mean;
+            totals->sum[lane] += d * d;
+        } else {
+            totals->sum[lane] += v;
+            totals->min[lane] = v < totals->min[lane] ? v : totals->min[lane];
+            totals->max[lane] = v > totals->max[lane] ? v : totals->max[lane];
+        }
+    }
+}
+
+// Sum, min and max (squared == 0) or sum of (x - mean)^2 (squared != 0)
+static void block_sums_scalar(const double *x, int body, double mean, int squared,
+                              LaneTotals *totals) {
+    for (int i = 0; i < body; i += STATS_LANES) {
+        for (int lane = 0; lane < STATS_LANES; lane++) {
+            double v = x[i + lane];
+            if (squared) {
+                double d = v - mean;
+                totals->sum[lane] += d * d;
+            } else {
+                totals->sum[lane] += v;
+                totals->min[lane] = v < totals->min[lane] ? v : totals->min[lane];
+                totals->max[lane] = v > totals->max[lane] ? v : totals->max[lane];
+            }
+        }
+    }
+}
+
+#if defined(CONV_HAVE_X86_SIMD)
+// Lanes 0-3 in lo, 4-7 in hi. min_pd(v, m) is v < m ? v : m, as above.
+__attribute__((target("avx2")))
+static void block_sums_avx2(const double *x, int body, double mean, int squared,
+                            LaneTotals *totals) {
+    __m256d sum_lo = _mm256_loadu_pd(totals->sum), sum_hi = _mm256_loadu_pd(totals->sum + 4);
+    __m256d min_lo = _mm256_loadu_pd(totals->min), min_hi = _mm256_loadu_pd(totals->min + 4);
+    __m256d max_lo = _mm256_loadu_pd(totals->max), max_hi = _mm256_loadu_pd(totals->max + 4);
+    const __m256d mean_v = _mm256_set1_pd(mean);
+
+    if (squared) {
+        for (int i = 0; i < body; i += STATS_LANES) {
+            __m256d d_lo = _mm256_sub_pd(_mm256_loadu_pd(x + i), mean_v);
+            __m256d d_hi = _mm256_sub_pd(_mm256_loadu_pd(x + i + 4), mean_v);
+            sum_lo = _mm256_add_pd(sum_lo, _mm256_mul_pd(d_lo, d_lo));
+            sum_hi = _mm256_add_pd(sum_hi, _mm256_mul_pd(d_hi, d_hi));
+        }
+    } else {
+        for (int i = 0; i < body; i += STATS_LANES) {
+            __m256d lo = _mm256_loadu_pd(x + i);
+            __m256d hi = _mm256_loadu_pd(x + i + 4);
+            sum_lo = _mm256_add_pd(sum_lo, lo);
+            sum_hi = _mm256_add_pd(sum_hi, hi);
+            min_lo = _mm256_min_pd(lo, min_lo);
+            min_hi = _mm256_min_pd(hi, min_hi);
+            max_lo = _mm256_max_pd(lo, max_lo);
+            max_hi = _mm256_max_pd(hi, max_hi);
+        }
+    }
+
+    _mm256_storeu_pd(totals->sum, sum_lo);
+    _mm256_storeu_pd(totals->sum + 4, sum_hi);
+    _mm256_storeu_pd(totals->min, min_lo);
+    _mm256_storeu_pd(totals->min + 4, min_hi);
+    _mm256_storeu_pd(totals->max, max_lo);
+    _mm256_storeu_pd(totals->max + 4, max_hi);
+}
+
+__attribute__((target("avx512f")))
+static void block_sums_avx512(const double *x, int body, double mean, int squared,
+                              LaneTotals *totals) {
+    __m512d sum = _mm512_loadu_pd(totals->sum);
+    __m512d min = _mm512_loadu_pd(totals->min);
+    __m512d max = _mm512_loadu_pd(totals->max);
+    const __m512d mean_v = _mm512_set1_pd(mean);
+
+    if (squared) {
+        for (int i = 0; i < body; i += STATS_LANES) {
+            __m512d d = _mm512_sub_pd(_mm512_loadu_pd(x + i), mean_v);
+            sum = _mm512_add_pd(sum, _mm512_mul_pd(d, d));
+        }
+    } else {
+        for (int i = 0; i < body; i += STATS_LANES) {
+            __m512d v = _mm512_loadu_pd(x + i);
+            sum = _mm512_add_pd(sum, v);
+            min = _mm512_min_pd(v, min);
+            max = _mm512_max_pd(v, max);
+        }
+    }
+
+    _mm512_storeu_pd(totals->sum, sum);
+    _mm512_storeu_pd(totals->min, min);
+    _mm512_storeu_pd(totals->max, max);
+}
+#endif
+
+static void block_sums(const double *x, int count, double mean, int squared,
+                       LaneTotals *totals) {
+    int body = count - count % STATS_LANES;
+
+#if defined(CONV_HAVE_X86_SIMD)
+    switch (conv_get_simd_level()) {
+        case SIMD_AVX512: block_sums_avx512(x, body, mean, squared, totals); break;
+        case SIMD_AVX2:   block_sums_avx2(x, body, mean, squared, totals); break;
+        default:          block_sums_scalar(x, body, mean, squared, totals); break;
+    }
+#else
+    block_sums_scalar(x, body, mean, squared, totals);
+#endif
+
+    tail_sums(x, body, count, mean, squared, totals);
+}
+
+// Two passes over one contiguous block: mean first, then the deviations
+// about it, which keeps the variance exact for signals with a large offset
+static void block_moments(const double *x, int count, Moments *moments) {
+    LaneTotals totals;
+    for (int lane = 0; lane < STATS_LANES; lane++) {
+        totals.sum[lane] = 0.0;
+        totals.min[lane] = x[0];
+        totals.max[lane] = x[0];
+    }
+
+    block_sums(x, count, 0.0, 0, &totals);
+    moments->count = count;
+    moments->mean = lane_sum(totals.sum) / count;
+    moments->min = totals.min[0];
+    moments->max = totals.max[0];
+    for (int lane = 1; lane < STATS_LANES; lane++) {
+        if (totals.min[lane] < moments->min) moments->min = totals.min[lane];
+        if (totals.max[lane] > moments->max) moments->max = totals.max[lane];
+    }
+
+    for (int lane = 0; lane < STATS_LANES; lane++) totals.sum[lane] = 0.0;
+    block_sums(x, count, moments->mean, 1, &totals);
+    moments->m2 = lane_sum(totals.sum);
+}
+
+// Moments of samples [start, end) of a view; start is a multiple of
+// STATS_BLOCK. Strided samples are gathered a block at a time.
+static void range_moments(const SignalView *view, int start, int end, Moments *moments) {
+    double gathered[STATS_BLOCK];
+    moments->count = 0;
+
+    for (int b = start; b < end; b += STATS_BLOCK) {
+        int count = end - b < STATS_BLOCK ? end - b : STATS_BLOCK;
+        const double *x = view->data + (ptrdiff_t)b * view->stride;
+
+        if (view->stride != 1) {
+            for (int i = 0; i < count; i++) {
+                gathered[i] = x[(ptrdiff_t)i * view->stride];
+            }
+            x = gathered;
+        }
+
+        Moments block;
+        block_moments(x, count, &block);
+        moments_merge(moments, &block);
+    }
+}
+
+// Partial moments of every chunk, merged in chunk order afterwards so the
+// result does not depend on the thread count
+typedef struct {
+    const SignalView *view;
+    Moments *partials;
+} StatsJob;
+
+static void stats_task(void *context, int index) {
+    const StatsJob *job = (const StatsJob*)context;
+    int start = index * STATS_CHUNK;
+    int end = job->view->length - start < STATS_CHUNK ? job->view->length : start + STATS_CHUNK;
+    range_moments(job->view, start, end, &job->partials[index]);
+}
+
+// Summarize the samples of a view in one pass over memory. Returns 0, or
+// -1 for an empty or NULL view.
+int signal_view_statistics(const SignalView *view, SignalStats *stats) {
+    if (!stats) return -1;
+    memset(stats, 0, sizeof(*stats));
+    if (!view || !view->data || view->length < 1) return -1;
+
+    int chunks = (view->length + STATS_CHUNK - 1) / STATS_CHUNK;
+    Moments total = {0};
+    Moments *partials = NULL;
+
+    if (view->length >= STATS_PARALLEL_MIN && conv_get_num_threads() > 1) {
+        partials = (Moments*)malloc((size_t)chunks * sizeof(Moments));
+    }
+
+    if (partials) {
+        StatsJob job = {view, partials};
+        conv_parallel_for(chunks, stats_task, &job);
+        for (int c = 0; c < chunks; c++) moments_merge(&total, &partials[c]);
+        free(partials);
+    } else {
+        for (int c = 0; c < chunks; c++) {
+            int start = c * STATS_CHUNK;
+            int end = view->length - start < STATS_CHUNK ? view->length : start + STATS_CHUNK;
+            Moments chunk;
+            range_moments(view, start, end, &chunk);
+            moments_merge(&total, &chunk);
+        }
+    }
+
+    stats->count = view->length;
+    stats->min = total.min;
+    stats->max = total.max;
+    stats->mean = total.mean;
+    stats->variance = total.m2 / total.count;
+    stats->stddev = sqrt(stats->variance);
+    stats->rms = sqrt(total.mean * total.mean + stats->variance);
+    stats->peak = fabs(total.min) > fabs(total.max) ? fabs(total.min) : fabs(total.max);
+    return 0;
+}
+
+// Summarize a signal's samples (see signal_view_statistics)
+int signal_statistics(const Signal *signal, SignalStats *stats) {
+    if (!signal || !signal->data) {
+        if (stats) memset(stats, 0, sizeof(*stats));
+        return -1;
+    }
+
+    SignalView view = signal_view(signal);
+    return signal_view_statistics(&view, stats);
+}
+
+// Map [min, max] of stats onto [-1, 1]
+typedef struct {
+    const SignalView *view;
+    double min;
+    double range;
+} NormalizeJob;
+
+static void normalize_range(const NormalizeJob *job, int start, int end) {
+    double *data = job->view->data;
+    ptrdiff_t stride = job->view->stride;
+    double min_val = job->min;
+    double range = job->range;
+
+    if (stride == 1) {
+        for (int i = start; i < end; i++) {
+            data[i] = 2.0 * (data[i] - min_val) / range - 1.0;
+        }
+    } else {
+        for (int i = start; i < end; i++) {
+            double *sample = &data[(ptrdiff_t)i * stride];
+            *sample = 2.0 * (*sample - min_val) / range - 1.0;
+        }
+    }
+}
+
+static void normalize_task(void *context, int index) {
+    const NormalizeJob *job = (const NormalizeJob*)context;
+    int start = index * STATS_CHUNK;
+    int end = job->view->length - start < STATS_CHUNK ? job->view->length : start + STATS_CHUNK;
+    normalize_range(job, start, end);
+}
+
+// Normalize a view to [-1, 1] with statistics computed earlier (one pass).
+// Views whose range is below 1e-10 are left unchanged.
+void normalize_signal_view_with_stats(SignalView *view, const SignalStats *stats) {
+    if (!view || !view->data || view->length < 1 || !stats) return;
+
+    double range = stats->max - stats->min;
+    if (range < 1e-10) return;
+
+    NormalizeJob job = {view, stats->min, range};
+    if (view->length >= STATS_PARALLEL_MIN && conv_get_num_threads() > 1) {
+        conv_parallel_for((view->length + STATS_CHUNK - 1) / STATS_CHUNK, normalize_task, &job);
+    } else {
+        normalize_range(&job, 0, view->length);
+    }
+}
+
+// Normalize a signal with statistics computed earlier
+void normalize_signal_with_stats(Signal *signal, const SignalStats *stats) {
+    if (!signal || !signal->data) return;
+
+    SignalView view = signal_view(signal);
+    normalize_signal_view_with_stats(&view, stats);
+}
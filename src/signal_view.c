@@ -0,0 +1,114 @@
+#include "../include/convolution.h"
+
+// View of a whole signal
+SignalView signal_view(const Signal *signal) {
+    SignalView view = {NULL, 0, 1, 0.0};
+    if (signal) {
+        view.data = signal->data;
+        view.length = signal->length;
+        view.sample_rate = signal->sample_rate;
+    }
+    return view;
+}
+
+// Samples [start, start + length) of a view, clipped to the view
+SignalView signal_view_slice(const SignalView *view, int start, int length) {
+    SignalView slice = {NULL, 0, 1, 0.0};
+    if (!view || !view->data) return slice;
+
+    if (start < 0) {
+        length += start;
+        start = 0;
+    }
+    if (start > view->length) start = view->length;
+    if (length > view->length - start) length = view->length - start;
+    if (length < 0) length = 0;
+
+    slice.data = view->data + (ptrdiff_t)start * view->stride;
+    slice.length = length;
+    slice.stride = view->stride;
+    slice.sample_rate = view->sample_rate;
+    return slice;
+}
+
+// One channel of an interleaved buffer (frame_count frames of channels samples)
+SignalView signal_view_channel(double *frames, int frame_count, int channels,
+                               int channel, double sample_rate) {
+    SignalView view = {NULL, 0, 1, 0.0};
+    if (!frames || frame_count < 0 || channels < 1 || channel < 0 || channel >= channels) {
+        return view;
+    }
+
+    view.data = frames + channel;
+    view.length = frame_count;
+    view.stride = channels;
+    view.sample_rate = sample_rate;
+    return view;
+}
+
+// Copy a view's samples into a contiguous buffer of view->length doubles
+void signal_view_gather(const SignalView *view, double *output) {
+    if (!view || !view->data || !output) return;
+
+    if (view->stride == 1) {
+        memcpy(output, view->data, view->length * sizeof(double));
+        return;
+    }
+
+    const double *input = view->data;
+    for (int i = 0; i < view->length; i++) {
+        output[i] = *input;
+        input += view->stride;
+    }
+}
+
+// Owning copy of a view
+Signal* signal_from_view(const SignalView *view) {
+    if (!view || !view->data) return NULL;
+
+    Signal *signal = create_signal(view->length, view->sample_rate);
+    if (!signal) return NULL;
+
+    signal_view_gather(view, signal->data);
+    strcpy(signal->name, "View");
+
+    return signal;
+}
+
+// Present a view as a Signal: contiguous views are wrapped in place, strided
+// ones are gathered into *copy (free it with free_signal)
+static const Signal* view_as_signal(const SignalView *view, Signal *wrapper, Signal **copy) {
+    *copy = NULL;
+
+    if (view->stride == 1) {
+        signal_init(wrapper, view->data, view->length, view->sample_rate);
+        strcpy(wrapper->name, "View");
+        return wrapper;
+    }
+
+    *copy = signal_from_view(view);
+    return *copy;
+}
+
+// Convolution of two views with the algorithm picked by the cost model.
+// Contiguous views are read in place; strided views are gathered once,
+// since every kernel streams contiguous samples.
+Signal* convolve_view(const SignalView *view1, const SignalView *view2, ConvMode mode) {
+    if (!view1 || !view2 || !view1->data || !view2->data) return NULL;
+    if (view1->length < 1 || view2->length < 1) return NULL;
+
+    Signal wrapper1, wrapper2;
+    Signal *copy1, *copy2;
+    const Signal *signal1 = view_as_signal(view1, &wrapper1, &copy1);
+    const Signal *signal2 = view_as_signal(view2, &wrapper2, &copy2);
+
+    Signal *result = NULL;
+    if (signal1 && signal2) {
+        result = convolve_auto(signal1, signal2, mode);
+    }
+
+    free_signal(copy1);
+    free_signal(copy2);
+
+    return result;
+}
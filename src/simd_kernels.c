@@ -0,0 +1,388 @@
+#include "../include/convolution.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONV_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define CONV_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Kernels up to this length are reversed into a stack buffer
+#define REVERSED_KERNEL_STACK 512
+
+// Kernels at least this long compute their edges with the vector body
+#define PADDED_EDGE_MIN_TAPS 16
+
+// Convolutions with at least this many multiply-adds use the thread pool
+#define DIRECT_PARALLEL_MIN_WORK (1 << 20)
+
+// Smallest body chunk per task. Chunks are multiples of the widest vector
+// block (32 outputs), so every output is computed the same way as serially.
+#define DIRECT_PARALLEL_MIN_CHUNK 2048
+#define DIRECT_BLOCK_ALIGN 32
+
+// -1 until the first call detects the CPU
+static int detected_simd_level = -1;
+static int active_simd_level = -1;
+
+// Best SIMD level supported by this CPU
+SimdLevel conv_simd_detect(void) {
+    if (detected_simd_level < 0) {
+        int level = SIMD_SCALAR;
+#if defined(CONV_HAVE_X86_SIMD)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            level = SIMD_AVX512;
+        } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            level = SIMD_AVX2;
+        }
+#elif defined(CONV_HAVE_NEON)
+        level = SIMD_NEON;
+#endif
+        detected_simd_level = level;
+    }
+    return (SimdLevel)detected_simd_level;
+}
+
+// SIMD level used by the direct convolution kernels
+SimdLevel conv_get_simd_level(void) {
+    if (active_simd_level < 0) {
+        active_simd_level = conv_simd_detect();
+    }
+    return (SimdLevel)active_simd_level;
+}
+
+// Select a SIMD level (clamped to what the CPU supports); SIMD_SCALAR forces
+// the portable loops, e.g. to compare against the vector paths
+void conv_set_simd_level(SimdLevel level) {
+    SimdLevel best = conv_simd_detect();
+    if (level > best) level = best;
+#if !defined(CONV_HAVE_NEON)
+    if (level == SIMD_NEON) level = SIMD_SCALAR;
+#endif
+    active_simd_level = level;
+}
+
+// Display name of a SIMD level
+const char* conv_simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SIMD_SCALAR: return "scalar";
+        case SIMD_NEON: return "NEON";
+        case SIMD_AVX2: return "AVX2+FMA";
+        case SIMD_AVX512: return "AVX-512";
+        default: return "unknown";
+    }
+}
+
+// Outputs [start, end) with partial overlap, computed with exact bounds:
+// y[t] = sum(x[k] * h[t-k]) for max(0, t-m+1) <= k <= min(t, n-1)
+static void direct_edge(const double *x, int n, const double *h, int m,
+                        double *y, int start, int end) {
+    for (int t = start; t < end; t++) {
+        int k_min = (t >= m - 1) ? t - m + 1 : 0;
+        int k_max = (t < n) ? t : n - 1;
+
+        double sum = 0.0;
+        for (int k = k_min; k <= k_max; k++) {
+            sum += x[k] * h[t - k];
+        }
+        y[t] = sum;
+    }
+}
+
+// Full-overlap outputs [start, end), scalar: y[t] = sum(hr[j] * xs[t + j])
+// where hr is the reversed kernel and xs = x - (m - 1)
+static void direct_body_scalar(const double *xs, const double *hr, int m,
+                               double *y, int start, int end) {
+    for (int t = start; t < end; t++) {
+        const double *xp = xs + t;
+        double sum = 0.0;
+        for (int j = 0; j < m; j++) {
+            sum += hr[j] * xp[j];
+        }
+        y[t] = sum;
+    }
+}
+
+#if defined(CONV_HAVE_X86_SIMD)
+// AVX2 body: 16 outputs per iteration in four accumulators
+__attribute__((target("avx2,fma")))
+static int direct_body_avx2(const double *xs, const double *hr, int m,
+                            double *y, int start, int end) {
+    int t = start;
+
+    for (; t + 16 <= end; t += 16) {
+        const double *xp = xs + t;
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        __m256d acc2 = _mm256_setzero_pd();
+        __m256d acc3 = _mm256_setzero_pd();
+
+        for (int j = 0; j < m; j++) {
+            __m256d hj = _mm256_broadcast_sd(&hr[j]);
+            acc0 = _mm256_fmadd_pd(hj, _mm256_loadu_pd(xp + j), acc0);
+            acc1 = _mm256_fmadd_pd(hj, _mm256_loadu_pd(xp + j + 4), acc1);
+            acc2 = _mm256_fmadd_pd(hj, _mm256_loadu_pd(xp + j + 8), acc2);
+            acc3 = _mm256_fmadd_pd(hj, _mm256_loadu_pd(xp + j + 12), acc3);
+        }
+
+        _mm256_storeu_pd(y + t, acc0);
+        _mm256_storeu_pd(y + t + 4, acc1);
+        _mm256_storeu_pd(y + t + 8, acc2);
+        _mm256_storeu_pd(y + t + 12, acc3);
+    }
+
+    for (; t + 4 <= end; t += 4) {
+        const double *xp = xs + t;
+        __m256d acc = _mm256_setzero_pd();
+        for (int j = 0; j < m; j++) {
+            acc = _mm256_fmadd_pd(_mm256_broadcast_sd(&hr[j]), _mm256_loadu_pd(xp + j), acc);
+        }
+        _mm256_storeu_pd(y + t, acc);
+    }
+
+    return t;
+}
+
+// AVX-512 body: 32 outputs per iteration in four accumulators
+__attribute__((target("avx512f")))
+static int direct_body_avx512(const double *xs, const double *hr, int m,
+                              double *y, int start, int end) {
+    int t = start;
+
+    for (; t + 32 <= end; t += 32) {
+        const double *xp = xs + t;
+        __m512d acc0 = _mm512_setzero_pd();
+        __m512d acc1 = _mm512_setzero_pd();
+        __m512d acc2 = _mm512_setzero_pd();
+        __m512d acc3 = _mm512_setzero_pd();
+
+        for (int j = 0; j < m; j++) {
+            __m512d hj = _mm512_set1_pd(hr[j]);
+            acc0 = _mm512_fmadd_pd(hj, _mm512_loadu_pd(xp + j), acc0);
+            acc1 = _mm512_fmadd_pd(hj, _mm512_loadu_pd(xp + j + 8), acc1);
+            acc2 = _mm512_fmadd_pd(hj, _mm512_loadu_pd(xp + j + 16), acc2);
+            acc3 = _mm512_fmadd_pd(hj, _mm512_loadu_pd(xp + j + 24), acc3);
+        }
+
+        _mm512_storeu_pd(y + t, acc0);
+        _mm512_storeu_pd(y + t + 8, acc1);
+        _mm512_storeu_pd(y + t + 16, acc2);
+        _mm512_storeu_pd(y + t + 24, acc3);
+    }
+
+    for (; t + 8 <= end; t += 8) {
+        const double *xp = xs + t;
+        __m512d acc = _mm512_setzero_pd();
+        for (int j = 0; j < m; j++) {
+            acc = _mm512_fmadd_pd(_mm512_set1_pd(hr[j]), _mm512_loadu_pd(xp + j), acc);
+        }
+        _mm512_storeu_pd(y + t, acc);
+    }
+
+    return t;
+}
+#endif
+
+#if defined(CONV_HAVE_NEON)
+// NEON body: 8 outputs per iteration in four accumulators
+static int direct_body_neon(const double *xs, const double *hr, int m,
+                            double *y, int start, int end) {
+    int t = start;
+
+    for (; t + 8 <= end; t += 8) {
+        const double *xp = xs + t;
+        float64x2_t acc0 = vdupq_n_f64(0.0);
+        float64x2_t acc1 = vdupq_n_f64(0.0);
+        float64x2_t acc2 = vdupq_n_f64(0.0);
+        float64x2_t acc3 = vdupq_n_f64(0.0);
+
+        for (int j = 0; j < m; j++) {
+            float64x2_t hj = vdupq_n_f64(hr[j]);
+            acc0 = vfmaq_f64(acc0, hj, vld1q_f64(xp + j));
+            acc1 = vfmaq_f64(acc1, hj, vld1q_f64(xp + j + 2));
+            acc2 = vfmaq_f64(acc2, hj, vld1q_f64(xp + j + 4));
+            acc3 = vfmaq_f64(acc3, hj, vld1q_f64(xp + j + 6));
+        }
+
+        vst1q_f64(y + t, acc0);
+        vst1q_f64(y + t + 2, acc1);
+        vst1q_f64(y + t + 4, acc2);
+        vst1q_f64(y + t + 6, acc3);
+    }
+
+    return t;
+}
+#endif
+
+// Full-overlap outputs [start, end) at the given SIMD level
+static void direct_body(const double *xs, const double *hr, int m, double *y,
+                        int start, int end, SimdLevel level) {
+    int t = start;
+
+    switch (level) {
+#if defined(CONV_HAVE_X86_SIMD)
+        case SIMD_AVX512:
+            t = direct_body_avx512(xs, hr, m, y, t, end);
+            t = direct_body_avx2(xs, hr, m, y, t, end);
+            break;
+        case SIMD_AVX2:
+            t = direct_body_avx2(xs, hr, m, y, t, end);
+            break;
+#endif
+#if defined(CONV_HAVE_NEON)
+        case SIMD_NEON:
+            t = direct_body_neon(xs, hr, m, y, t, end);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    direct_body_scalar(xs, hr, m, y, t, end);
+}
+
+// Head and tail (m - 1 outputs each) through the vector body: the edge
+// samples are copied next to m - 1 zeros so every output sees m taps. The
+// zero products are exact, so the sums match direct_edge's. padded holds
+// 2 * (m - 1) doubles.
+static void direct_edges_padded(const double *x, int n, const double *hr, int m,
+                                double *y, SimdLevel level, double *padded) {
+    int edge = m - 1;
+
+    // Head: [0 x (m-1), x[0..m-2]] -> y[0..m-2]
+    memset(padded, 0, edge * sizeof(double));
+    memcpy(padded + edge, x, edge * sizeof(double));
+    direct_body(padded, hr, m, y, 0, edge, level);
+
+    // Tail: [x[n-m+1..n-1], 0 x (m-1)] -> y[n..n+m-2]
+    memcpy(padded, x + n - edge, edge * sizeof(double));
+    memset(padded + edge, 0, edge * sizeof(double));
+    direct_body(padded, hr, m, y + n, 0, edge, level);
+}
+
+// Edges plus the full-overlap body split into fixed-size output ranges
+typedef struct {
+    const double *x;
+    const double *h;
+    const double *hr;
+    double *y;
+    double *padded;     // Edge buffer, or NULL for scalar edges
+    int n;
+    int m;
+    int chunk;
+    SimdLevel level;
+} DirectJob;
+
+// Both edges, serially, as convolve_direct_kernel_at does
+static void direct_edges(const DirectJob *job) {
+    if (job->padded) {
+        direct_edges_padded(job->x, job->n, job->hr, job->m, job->y, job->level, job->padded);
+    } else {
+        direct_edge(job->x, job->n, job->h, job->m, job->y, 0, job->m - 1);
+        direct_edge(job->x, job->n, job->h, job->m, job->y, job->n, job->n + job->m - 1);
+    }
+}
+
+// Task 0 computes the edges, task i > 0 the i-th body chunk
+static void direct_task(void *context, int index) {
+    DirectJob *job = (DirectJob*)context;
+
+    if (index == 0) {
+        direct_edges(job);
+        return;
+    }
+
+    int start = job->m - 1 + (index - 1) * job->chunk;
+    int end = start + job->chunk;
+    if (end > job->n) end = job->n;
+    direct_body(job->x - (job->m - 1), job->hr, job->m, job->y, start, end, job->level);
+}
+
+// Direct linear convolution y = x * h (n + m - 1 outputs). The longer input
+// is streamed and the shorter one reversed, so the full-overlap body reads
+// both arrays forwards without per-tap bounds checks; long kernels also run
+// the edges through the body on zero-padded copies. The body runs at the
+// requested SIMD level (clamped to the CPU); large convolutions split it
+// into output ranges on the thread pool. Long kernels and the edge buffer
+// live in the calling thread's workspace, so repeated calls do not allocate.
+void convolve_direct_kernel_at(const double *x, int n, const double *h, int m,
+                               double *y, SimdLevel level) {
+    if (!x || !h || !y || n < 1 || m < 1) return;
+
+    // Convolution is commutative: keep the kernel as the shorter input
+    if (m > n) {
+        const double *tmp_data = x;
+        x = h;
+        h = tmp_data;
+        int tmp_length = n;
+        n = m;
+        m = tmp_length;
+    }
+
+    int output_length = n + m - 1;
+    CONV_STATS_START(stats_start);
+
+    SimdLevel best = conv_simd_detect();
+    if (level > best) level = best;
+
+    // Workspace: reversed kernel (if too long for the stack), then the
+    // 2 * (m - 1) padded edge samples
+    int heap_kernel = (m > REVERSED_KERNEL_STACK) ? m : 0;
+    int padded_edges = (level != SIMD_SCALAR && m >= PADDED_EDGE_MIN_TAPS) ? 2 * (m - 1) : 0;
+    double *workspace = NULL;
+    if (heap_kernel + padded_edges > 0) {
+        workspace = conv_workspace((size_t)heap_kernel + padded_edges);
+    }
+
+    double stack_kernel[REVERSED_KERNEL_STACK];
+    double *hr = heap_kernel ? workspace : stack_kernel;
+    if (!hr) {
+        direct_edge(x, n, h, m, y, 0, output_length);
+        CONV_STATS_STOP(CONV_STAT_DIRECT, stats_start, output_length);
+        return;
+    }
+    for (int j = 0; j < m; j++) {
+        hr[j] = h[m - 1 - j];
+    }
+
+    double *padded = (workspace && padded_edges) ? workspace + heap_kernel : NULL;
+    DirectJob job = {x, h, hr, y, padded, n, m, 0, level};
+    int body_length = n - m + 1;
+    int threads = conv_get_num_threads();
+
+    if (threads > 1 && (double)output_length * m >= DIRECT_PARALLEL_MIN_WORK) {
+        int chunk = body_length / (4 * threads);
+        if (chunk < DIRECT_PARALLEL_MIN_CHUNK) chunk = DIRECT_PARALLEL_MIN_CHUNK;
+        job.chunk = (chunk + DIRECT_BLOCK_ALIGN - 1) / DIRECT_BLOCK_ALIGN * DIRECT_BLOCK_ALIGN;
+
+        conv_parallel_for(1 + (body_length + job.chunk - 1) / job.chunk, direct_task, &job);
+    } else {
+        direct_body(x - (m - 1), hr, m, y, m - 1, n, level);
+        direct_edges(&job);
+    }
+
+    CONV_STATS_STOP(CONV_STAT_DIRECT, stats_start, output_length);
+}
+
+// Full-overlap outputs for a kernel that is already reversed:
+// y[t] = sum(hr[j] * xs[t + j]) for t in [0, count), at the active SIMD
+// level. Callers that reuse one kernel many times (the polyphase filters)
+// keep it reversed and skip the edge handling of convolve_direct_kernel.
+void convolve_direct_body(const double *xs, int count, const double *hr, int m, double *y) {
+    if (!xs || !hr || !y || count < 1 || m < 1) return;
+
+    SimdLevel level = conv_get_simd_level();
+    SimdLevel best = conv_simd_detect();
+    if (level > best) level = best;
+
+    direct_body(xs, hr, m, y, 0, count, level);
+}
+
+// Direct linear convolution at the active SIMD level
+void convolve_direct_kernel(const double *x, int n, const double *h, int m, double *y) {
+    convolve_direct_kernel_at(x, n, h, m, y, conv_get_simd_level());
+}
@@ -0,0 +1,482 @@
+#include "../include/convolution.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONV_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define CONV_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Kernels at least this long compute their edges with the vector body
+#define PADDED_EDGE_MIN_TAPS 16
+
+// Convolutions with at least this many multiply-adds use the thread pool
+#define DIRECT_PARALLEL_MIN_WORK (1 << 20)
+
+// Smallest body chunk per task, a multiple of the widest vector block
+// (64 single-precision outputs) so chunking does not change any output
+#define DIRECT_PARALLEL_MIN_CHUNK 2048
+#define DIRECT_BLOCK_ALIGN 64
+
+// Arithmetic of the float32 entry points
+static ConvPrecision active_precision = CONV_PRECISION_SINGLE;
+
+// Select single precision (float accumulators and float FFTs; twice the
+// SIMD width of double) or mixed precision (float storage, double
+// accumulators and double FFTs) for the float32 entry points
+void conv_set_precision(ConvPrecision precision) {
+    active_precision = (precision == CONV_PRECISION_MIXED) ? CONV_PRECISION_MIXED
+                                                           : CONV_PRECISION_SINGLE;
+}
+
+ConvPrecision conv_get_precision(void) {
+    return active_precision;
+}
+
+// Direct convolution state: the reversed kernel is held as float (single
+// precision) or double (mixed precision)
+typedef struct {
+    const float *x;
+    const float *h;
+    const float *hr;        // Reversed kernel, single precision
+    const double *hr_mixed; // Reversed kernel, mixed precision
+    float *y;
+    float *padded;          // Edge buffer, or NULL for scalar edges
+    int n;
+    int m;
+    int chunk;
+    SimdLevel level;
+} DirectJobF32;
+
+// Outputs [start, end) with partial overlap, computed with exact bounds
+static void direct_edge(const DirectJobF32 *job, int start, int end) {
+    const float *x = job->x;
+    const float *h = job->h;
+    int n = job->n;
+    int m = job->m;
+
+    for (int t = start; t < end; t++) {
+        int k_min = (t >= m - 1) ? t - m + 1 : 0;
+        int k_max = (t < n) ? t : n - 1;
+
+        if (job->hr_mixed) {
+            double sum = 0.0;
+            for (int k = k_min; k <= k_max; k++) {
+                sum += (double)x[k] * h[t - k];
+            }
+            job->y[t] = (float)sum;
+        } else {
+            float sum = 0.0f;
+            for (int k = k_min; k <= k_max; k++) {
+                sum += x[k] * h[t - k];
+            }
+            job->y[t] = sum;
+        }
+    }
+}
+
+// Full-overlap outputs [start, end), scalar: y[t] = sum(hr[j] * xs[t + j])
+static void direct_body_scalar(const float *xs, const float *hr, int m,
+                               float *y, int start, int end) {
+    for (int t = start; t < end; t++) {
+        const float *xp = xs + t;
+        float sum = 0.0f;
+        for (int j = 0; j < m; j++) {
+            sum += hr[j] * xp[j];
+        }
+        y[t] = sum;
+    }
+}
+
+// Scalar body with double accumulators
+static void direct_body_scalar_mixed(const float *xs, const double *hr, int m,
+                                     float *y, int start, int end) {
+    for (int t = start; t < end; t++) {
+        const float *xp = xs + t;
+        double sum = 0.0;
+        for (int j = 0; j < m; j++) {
+            sum += hr[j] * xp[j];
+        }
+        y[t] = (float)sum;
+    }
+}
+
+#if defined(CONV_HAVE_X86_SIMD)
+// AVX2 body: 32 outputs per iteration in four accumulators
+__attribute__((target("avx2,fma")))
+static int direct_body_avx2(const float *xs, const float *hr, int m,
+                            float *y, int start, int end) {
+    int t = start;
+
+    for (; t + 32 <= end; t += 32) {
+        const float *xp = xs + t;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+
+        for (int j = 0; j < m; j++) {
+            __m256 hj = _mm256_broadcast_ss(&hr[j]);
+            acc0 = _mm256_fmadd_ps(hj, _mm256_loadu_ps(xp + j), acc0);
+            acc1 = _mm256_fmadd_ps(hj, _mm256_loadu_ps(xp + j + 8), acc1);
+            acc2 = _mm256_fmadd_ps(hj, _mm256_loadu_ps(xp + j + 16), acc2);
+            acc3 = _mm256_fmadd_ps(hj, _mm256_loadu_ps(xp + j + 24), acc3);
+        }
+
+        _mm256_storeu_ps(y + t, acc0);
+        _mm256_storeu_ps(y + t + 8, acc1);
+        _mm256_storeu_ps(y + t + 16, acc2);
+        _mm256_storeu_ps(y + t + 24, acc3);
+    }
+
+    for (; t + 8 <= end; t += 8) {
+        const float *xp = xs + t;
+        __m256 acc = _mm256_setzero_ps();
+        for (int j = 0; j < m; j++) {
+            acc = _mm256_fmadd_ps(_mm256_broadcast_ss(&hr[j]), _mm256_loadu_ps(xp + j), acc);
+        }
+        _mm256_storeu_ps(y + t, acc);
+    }
+
+    return t;
+}
+
+// AVX2 mixed body: float loads widened to double, 16 outputs per iteration
+__attribute__((target("avx2,fma")))
+static int direct_body_avx2_mixed(const float *xs, const double *hr, int m,
+                                  float *y, int start, int end) {
+    int t = start;
+
+    for (; t + 16 <= end; t += 16) {
+        const float *xp = xs + t;
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        __m256d acc2 = _mm256_setzero_pd();
+        __m256d acc3 = _mm256_setzero_pd();
+
+        for (int j = 0; j < m; j++) {
+            __m256d hj = _mm256_broadcast_sd(&hr[j]);
+            acc0 = _mm256_fmadd_pd(hj, _mm256_cvtps_pd(_mm_loadu_ps(xp + j)), acc0);
+            acc1 = _mm256_fmadd_pd(hj, _mm256_cvtps_pd(_mm_loadu_ps(xp + j + 4)), acc1);
+            acc2 = _mm256_fmadd_pd(hj, _mm256_cvtps_pd(_mm_loadu_ps(xp + j + 8)), acc2);
+            acc3 = _mm256_fmadd_pd(hj, _mm256_cvtps_pd(_mm_loadu_ps(xp + j + 12)), acc3);
+        }
+
+        _mm_storeu_ps(y + t, _mm256_cvtpd_ps(acc0));
+        _mm_storeu_ps(y + t + 4, _mm256_cvtpd_ps(acc1));
+        _mm_storeu_ps(y + t + 8, _mm256_cvtpd_ps(acc2));
+        _mm_storeu_ps(y + t + 12, _mm256_cvtpd_ps(acc3));
+    }
+
+    for (; t + 4 <= end; t += 4) {
+        const float *xp = xs + t;
+        __m256d acc = _mm256_setzero_pd();
+        for (int j = 0; j < m; j++) {
+            acc = _mm256_fmadd_pd(_mm256_broadcast_sd(&hr[j]),
+                                  _mm256_cvtps_pd(_mm_loadu_ps(xp + j)), acc);
+        }
+        _mm_storeu_ps(y + t, _mm256_cvtpd_ps(acc));
+    }
+
+    return t;
+}
+
+// AVX-512 body: 64 outputs per iteration in four accumulators
+__attribute__((target("avx512f")))
+static int direct_body_avx512(const float *xs, const float *hr, int m,
+                              float *y, int start, int end) {
+    int t = start;
+
+    for (; t + 64 <= end; t += 64) {
+        const float *xp = xs + t;
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps();
+        __m512 acc3 = _mm512_setzero_ps();
+
+        for (int j = 0; j < m; j++) {
+            __m512 hj = _mm512_set1_ps(hr[j]);
+            acc0 = _mm512_fmadd_ps(hj, _mm512_loadu_ps(xp + j), acc0);
+            acc1 = _mm512_fmadd_ps(hj, _mm512_loadu_ps(xp + j + 16), acc1);
+            acc2 = _mm512_fmadd_ps(hj, _mm512_loadu_ps(xp + j + 32), acc2);
+            acc3 = _mm512_fmadd_ps(hj, _mm512_loadu_ps(xp + j + 48), acc3);
+        }
+
+        _mm512_storeu_ps(y + t, acc0);
+        _mm512_storeu_ps(y + t + 16, acc1);
+        _mm512_storeu_ps(y + t + 32, acc2);
+        _mm512_storeu_ps(y + t + 48, acc3);
+    }
+
+    for (; t + 16 <= end; t += 16) {
+        const float *xp = xs + t;
+        __m512 acc = _mm512_setzero_ps();
+        for (int j = 0; j < m; j++) {
+            acc = _mm512_fmadd_ps(_mm512_set1_ps(hr[j]), _mm512_loadu_ps(xp + j), acc);
+        }
+        _mm512_storeu_ps(y + t, acc);
+    }
+
+    return t;
+}
+
+// AVX-512 mixed body: float loads widened to double, 32 outputs per iteration
+__attribute__((target("avx512f")))
+static int direct_body_avx512_mixed(const float *xs, const double *hr, int m,
+                                    float *y, int start, int end) {
+    int t = start;
+
+    for (; t + 32 <= end; t += 32) {
+        const float *xp = xs + t;
+        __m512d acc0 = _mm512_setzero_pd();
+        __m512d acc1 = _mm512_setzero_pd();
+        __m512d acc2 = _mm512_setzero_pd();
+        __m512d acc3 = _mm512_setzero_pd();
+
+        for (int j = 0; j < m; j++) {
+            __m512d hj = _mm512_set1_pd(hr[j]);
+            acc0 = _mm512_fmadd_pd(hj, _mm512_cvtps_pd(_mm256_loadu_ps(xp + j)), acc0);
+            acc1 = _mm512_fmadd_pd(hj, _mm512_cvtps_pd(_mm256_loadu_ps(xp + j + 8)), acc1);
+            acc2 = _mm512_fmadd_pd(hj, _mm512_cvtps_pd(_mm256_loadu_ps(xp + j + 16)), acc2);
+            acc3 = _mm512_fmadd_pd(hj, _mm512_cvtps_pd(_mm256_loadu_ps(xp + j + 24)), acc3);
+        }
+
+        _mm256_storeu_ps(y + t, _mm512_cvtpd_ps(acc0));
+        _mm256_storeu_ps(y + t + 8, _mm512_cvtpd_ps(acc1));
+        _mm256_storeu_ps(y + t + 16, _mm512_cvtpd_ps(acc2));
+        _mm256_storeu_ps(y + t + 24, _mm512_cvtpd_ps(acc3));
+    }
+
+    for (; t + 8 <= end; t += 8) {
+        const float *xp = xs + t;
+        __m512d acc = _mm512_setzero_pd();
+        for (int j = 0; j < m; j++) {
+            acc = _mm512_fmadd_pd(_mm512_set1_pd(hr[j]),
+                                  _mm512_cvtps_pd(_mm256_loadu_ps(xp + j)), acc);
+        }
+        _mm256_storeu_ps(y + t, _mm512_cvtpd_ps(acc));
+    }
+
+    return t;
+}
+#endif
+
+#if defined(CONV_HAVE_NEON)
+// NEON body: 16 outputs per iteration in four accumulators
+static int direct_body_neon(const float *xs, const float *hr, int m,
+                            float *y, int start, int end) {
+    int t = start;
+
+    for (; t + 16 <= end; t += 16) {
+        const float *xp = xs + t;
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        float32x4_t acc2 = vdupq_n_f32(0.0f);
+        float32x4_t acc3 = vdupq_n_f32(0.0f);
+
+        for (int j = 0; j < m; j++) {
+            float32x4_t hj = vdupq_n_f32(hr[j]);
+            acc0 = vfmaq_f32(acc0, hj, vld1q_f32(xp + j));
+            acc1 = vfmaq_f32(acc1, hj, vld1q_f32(xp + j + 4));
+            acc2 = vfmaq_f32(acc2, hj, vld1q_f32(xp + j + 8));
+            acc3 = vfmaq_f32(acc3, hj, vld1q_f32(xp + j + 12));
+        }
+
+        vst1q_f32(y + t, acc0);
+        vst1q_f32(y + t + 4, acc1);
+        vst1q_f32(y + t + 8, acc2);
+        vst1q_f32(y + t + 12, acc3);
+    }
+
+    return t;
+}
+
+// NEON mixed body: float loads widened to double, 8 outputs per iteration
+static int direct_body_neon_mixed(const float *xs, const double *hr, int m,
+                                  float *y, int start, int end) {
+    int t = start;
+
+    for (; t + 8 <= end; t += 8) {
+        const float *xp = xs + t;
+        float64x2_t acc0 = vdupq_n_f64(0.0);
+        float64x2_t acc1 = vdupq_n_f64(0.0);
+        float64x2_t acc2 = vdupq_n_f64(0.0);
+        float64x2_t acc3 = vdupq_n_f64(0.0);
+
+        for (int j = 0; j < m; j++) {
+            float64x2_t hj = vdupq_n_f64(hr[j]);
+            acc0 = vfmaq_f64(acc0, hj, vcvt_f64_f32(vld1_f32(xp + j)));
+            acc1 = vfmaq_f64(acc1, hj, vcvt_f64_f32(vld1_f32(xp + j + 2)));
+            acc2 = vfmaq_f64(acc2, hj, vcvt_f64_f32(vld1_f32(xp + j + 4)));
+            acc3 = vfmaq_f64(acc3, hj, vcvt_f64_f32(vld1_f32(xp + j + 6)));
+        }
+
+        vst1_f32(y + t, vcvt_f32_f64(acc0));
+        vst1_f32(y + t + 2, vcvt_f32_f64(acc1));
+        vst1_f32(y + t + 4, vcvt_f32_f64(acc2));
+        vst1_f32(y + t + 6, vcvt_f32_f64(acc3));
+    }
+
+    return t;
+}
+#endif
+
+// Full-overlap outputs [start, end) at the job's SIMD level and precision
+static void direct_body(const DirectJobF32 *job, const float *xs, float *y,
+                        int start, int end) {
+    int t = start;
+    int m = job->m;
+
+    if (job->hr_mixed) {
+        switch (job->level) {
+#if defined(CONV_HAVE_X86_SIMD)
+            case SIMD_AVX512:
+                t = direct_body_avx512_mixed(xs, job->hr_mixed, m, y, t, end);
+                t = direct_body_avx2_mixed(xs, job->hr_mixed, m, y, t, end);
+                break;
+            case SIMD_AVX2:
+                t = direct_body_avx2_mixed(xs, job->hr_mixed, m, y, t, end);
+                break;
+#endif
+#if defined(CONV_HAVE_NEON)
+            case SIMD_NEON:
+                t = direct_body_neon_mixed(xs, job->hr_mixed, m, y, t, end);
+                break;
+#endif
+            default:
+                break;
+        }
+        direct_body_scalar_mixed(xs, job->hr_mixed, m, y, t, end);
+        return;
+    }
+
+    switch (job->level) {
+#if defined(CONV_HAVE_X86_SIMD)
+        case SIMD_AVX512:
+            t = direct_body_avx512(xs, job->hr, m, y, t, end);
+            t = direct_body_avx2(xs, job->hr, m, y, t, end);
+            break;
+        case SIMD_AVX2:
+            t = direct_body_avx2(xs, job->hr, m, y, t, end);
+            break;
+#endif
+#if defined(CONV_HAVE_NEON)
+        case SIMD_NEON:
+            t = direct_body_neon(xs, job->hr, m, y, t, end);
+            break;
+#endif
+        default:
+            break;
+    }
+    direct_body_scalar(xs, job->hr, m, y, t, end);
+}
+
+// Both edges, serially: through the vector body on zero-padded copies of
+// the edge samples (padded holds 2 * (m - 1) floats), or with exact bounds
+static void direct_edges(const DirectJobF32 *job) {
+    int n = job->n;
+    int edge = job->m - 1;
+
+    if (!job->padded) {
+        direct_edge(job, 0, edge);
+        direct_edge(job, n, n + edge);
+        return;
+    }
+
+    float *padded = job->padded;
+
+    memset(padded, 0, edge * sizeof(float));
+    memcpy(padded + edge, job->x, edge * sizeof(float));
+    direct_body(job, padded, job->y, 0, edge);
+
+    memcpy(padded, job->x + n - edge, edge * sizeof(float));
+    memset(padded + edge, 0, edge * sizeof(float));
+    direct_body(job, padded, job->y + n, 0, edge);
+}
+
+// Task 0 computes the edges, task i > 0 the i-th body chunk
+static void direct_task(void *context, int index) {
+    DirectJobF32 *job = (DirectJobF32*)context;
+
+    if (index == 0) {
+        direct_edges(job);
+        return;
+    }
+
+    int start = job->m - 1 + (index - 1) * job->chunk;
+    int end = start + job->chunk;
+    if (end > job->n) end = job->n;
+    direct_body(job, job->x - (job->m - 1), job->y, start, end);
+}
+
+// Single-precision direct linear convolution y = x * h (n + m - 1 outputs),
+// organised like convolve_direct_kernel_at. CONV_PRECISION_MIXED keeps the
+// reversed kernel and the accumulators in double and rounds each output to
+// float once. The reversed kernel and edge buffer live in the workspace.
+void convolve_direct_kernel_f32_at(const float *x, int n, const float *h, int m, float *y,
+                                   SimdLevel level, ConvPrecision precision) {
+    if (!x || !h || !y || n < 1 || m < 1) return;
+
+    if (m > n) {
+        const float *tmp_data = x;
+        x = h;
+        h = tmp_data;
+        int tmp_length = n;
+        n = m;
+        m = tmp_length;
+    }
+
+    SimdLevel best = conv_simd_detect();
+    if (level > best) level = best;
+
+    // Workspace: reversed kernel (m doubles or floats), then 2 * (m - 1)
+    // padded edge floats
+    int padded_edges = (level != SIMD_SCALAR && m >= PADDED_EDGE_MIN_TAPS);
+    double *workspace = conv_workspace((size_t)2 * m);
+
+    DirectJobF32 job = {x, h, NULL, NULL, y, NULL, n, m, 0, level};
+    if (!workspace) {
+        direct_edge(&job, 0, n + m - 1);
+        return;
+    }
+
+    if (precision == CONV_PRECISION_MIXED) {
+        double *hr = workspace;
+        for (int j = 0; j < m; j++) {
+            hr[j] = h[m - 1 - j];
+        }
+        job.hr_mixed = hr;
+    } else {
+        float *hr = (float*)workspace;
+        for (int j = 0; j < m; j++) {
+            hr[j] = h[m - 1 - j];
+        }
+        job.hr = hr;
+    }
+    if (padded_edges) {
+        job.padded = (float*)(workspace + m);
+    }
+
+    int output_length = n + m - 1;
+    int body_length = n - m + 1;
+    int threads = conv_get_num_threads();
+
+    if (threads > 1 && (double)output_length * m >= DIRECT_PARALLEL_MIN_WORK) {
+        int chunk = body_length / (4 * threads);
+        if (chunk < DIRECT_PARALLEL_MIN_CHUNK) chunk = DIRECT_PARALLEL_MIN_CHUNK;
+        job.chunk = (chunk + DIRECT_BLOCK_ALIGN - 1) / DIRECT_BLOCK_ALIGN * DIRECT_BLOCK_ALIGN;
+
+        conv_parallel_for(1 + (body_length + job.chunk - 1) / job.chunk, direct_task, &job);
+    } else {
+        direct_body(&job, x - (m - 1), y, m - 1, n);
+        direct_edges(&job);
+    }
+}
+
+// Single-precision direct convolution at the active SIMD level and precision
+void convolve_direct_kernel_f32(const float *x, int n, const float *h, int m, float *y) {
+    convolve_direct_kernel_f32_at(x, n, h, m, y, conv_get_simd_level(), conv_get_precision());
+}
@@ -0,0 +1,342 @@
+#include "../include/convolution.h"
+
+// Frames transformed per parallel task
+#define STFT_FRAMES_PER_TASK 32
+
+// Output samples normalized per parallel task during resynthesis
+#define STFT_SAMPLES_PER_TASK 65536
+
+// Samples whose summed squared window is below this are not recoverable
+// and resynthesize as zero
+#define STFT_NORM_FLOOR 1e-10
+
+// Create an STFT setup. fft_size 0 picks next_power_of_2(window_length).
+// The window comes from the shared table cache, so plans of the same
+// window shape and length do not recompute it.
+STFTPlan* stft_plan_create(WindowType window, int window_length, int hop_size, int fft_size) {
+    if (window_length < 1 || hop_size < 1) return NULL;
+
+    if (fft_size <= 0) fft_size = next_power_of_2(window_length);
+    if (fft_size < 2) fft_size = 2; // Smallest real-input transform
+    if ((fft_size & (fft_size - 1)) != 0 || fft_size < window_length) return NULL;
+
+    STFTPlan *plan = (STFTPlan*)calloc(1, sizeof(STFTPlan));
+    if (!plan) return NULL;
+
+    plan->window = window_table(window, window_length);
+    if (!plan->window) {
+        free(plan);
+        return NULL;
+    }
+
+    plan->window_type = window;
+    plan->window_length = window_length;
+    plan->hop_size = hop_size;
+    plan->fft_size = fft_size;
+    plan->bins = fft_size / 2 + 1;
+
+    return plan;
+}
+
+void stft_plan_destroy(STFTPlan *plan) {
+    free(plan);
+}
+
+// Frames needed to cover signal_length samples: one centred on every
+// hop_size-th sample, including sample 0, plus any needed to reach the last
+// sample when the hop exceeds half a window
+int stft_frame_count(const STFTPlan *plan, int signal_length) {
+    if (!plan || signal_length < 1) return 0;
+
+    int hop = plan->hop_size;
+    int frames = (signal_length - 1) / hop + 1;
+
+    long end = (long)(frames - 1) * hop - plan->window_length / 2 + plan->window_length;
+    if (end < signal_length) {
+        frames += (int)((signal_length - end + hop - 1) / hop);
+    }
+
+    return frames;
+}
+
+// Allocate the frames x bins matrix for a signal_length-sample signal. The
+// struct and both planes share one block, taken from the bound arena when
+// there is one.
+STFTResult* stft_result_create(const STFTPlan *plan, int signal_length, double sample_rate) {
+    int frames = stft_frame_count(plan, signal_length);
+    if (frames < 1) return NULL;
+
+    size_t cells = (size_t)frames * plan->bins;
+    size_t header = (sizeof(STFTResult) + 63) & ~(size_t)63;
+    size_t bytes = header + 2 * cells * sizeof(double);
+
+    StorageKind storage = STORAGE_ARENA;
+    unsigned char *block = (unsigned char*)signal_arena_alloc(signal_arena_current(), bytes);
+    if (!block) {
+        storage = STORAGE_HEAP;
+        block = (unsigned char*)malloc(bytes);
+        if (!block) return NULL;
+    }
+    CONV_STATS_ALLOC(bytes);
+
+    STFTResult *result = (STFTResult*)block;
+    result->real = (double*)(block + header);
+    result->imag = result->real + cells;
+    result->frames = frames;
+    result->bins = plan->bins;
+    result->fft_size = plan->fft_size;
+    result->hop_size = plan->hop_size;
+    result->signal_length = signal_length;
+    result->sample_rate = sample_rate;
+    result->storage = storage;
+
+    return result;
+}
+
+// Free an STFT result (arena results are released by signal_arena_reset)
+void free_stft_result(STFTResult *result) {
+    if (result && result->storage == STORAGE_HEAP) {
+        free(result);
+    }
+}
+
+// First input sample of frame f (negative for the leading frames)
+static long stft_frame_start(const STFTPlan *plan, int frame) {
+    return (long)frame * plan->hop_size - plan->window_length / 2;
+}
+
+// Analysis state: task t transforms frames [t * frames_per_task, ...) with
+// its own plan from the cache, straight into the result matrix
+typedef struct {
+    const STFTPlan *plan;
+    const SignalView *view;
+    STFTResult *result;
+    int frames_per_task;
+    int failed;
+} STFTAnalysisJob;
+
+static void stft_analysis_task(void *context, int index) {
+    STFTAnalysisJob *job = (STFTAnalysisJob*)context;
+    const STFTPlan *plan = job->plan;
+    const SignalView *view = job->view;
+
+    FFTPlan *forward = fft_plan_acquire_real(plan->fft_size, FFT_FORWARD);
+    if (!forward) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    int first = index * job->frames_per_task;
+    int last = first + job->frames_per_task;
+    if (last > job->result->frames) last = job->result->frames;
+
+    int length = plan->window_length;
+    double *frame = (double*)forward->scratch;
+
+    for (int f = first; f < last; f++) {
+        long start = stft_frame_start(plan, f);
+
+        // Window the part of the frame inside the signal, zero the rest
+        int begin = (start < 0) ? (int)-start : 0;
+        int end = (start + length > view->length) ? (int)(view->length - start) : length;
+        if (end < begin) end = begin;
+
+        memset(frame, 0, begin * sizeof(double));
+        if (view->stride == 1) {
+            window_multiply(frame + begin, view->data + (start + begin),
+                            plan->window + begin, end - begin);
+        } else {
+            for (int i = begin; i < end; i++) {
+                frame[i] = plan->window[i] * view->data[(start + i) * view->stride];
+            }
+        }
+        memset(frame + end, 0, (plan->fft_size - end) * sizeof(double));
+
+        size_t row = (size_t)f * plan->bins;
+        fft_execute_r2c_split(forward, frame, job->result->real + row, job->result->imag + row);
+    }
+
+    fft_plan_release(forward);
+}
+
+// STFT of a signal into a new frames x bins matrix
+STFTResult* compute_stft(const STFTPlan *plan, const Signal *signal) {
+    if (!plan || !signal) return NULL;
+
+    STFTResult *result = stft_result_create(plan, signal->length, signal->sample_rate);
+    if (!result) return NULL;
+
+    if (compute_stft_into(result, plan, signal) != 0) {
+        free_stft_result(result);
+        return NULL;
+    }
+
+    return result;
+}
+
+// STFT into a caller-provided result from stft_result_create for the same
+// plan and signal length. Returns 0 on success, -1 on error.
+int compute_stft_into(STFTResult *result, const STFTPlan *plan, const Signal *signal) {
+    if (!signal) return -1;
+
+    SignalView view = signal_view(signal);
+    return compute_stft_view_into(result, plan, &view);
+}
+
+// STFT of a view (see compute_stft_into). Frames are spread across the
+// thread pool; each writes only its own rows, so the result does not
+// depend on the thread count.
+int compute_stft_view_into(STFTResult *result, const STFTPlan *plan, const SignalView *view) {
+    if (!result || !plan || !view || !view->data) return -1;
+    if (result->fft_size != plan->fft_size || result->hop_size != plan->hop_size) return -1;
+    if (result->frames != stft_frame_count(plan, view->length)) return -1;
+
+    CONV_STATS_START(stats_start);
+    STFTAnalysisJob job = {plan, view, result, STFT_FRAMES_PER_TASK, 0};
+    int tasks = (result->frames + job.frames_per_task - 1) / job.frames_per_task;
+    conv_parallel_for(tasks, stft_analysis_task, &job);
+
+    result->signal_length = view->length;
+    result->sample_rate = view->sample_rate;
+
+    CONV_STATS_STOP(CONV_STAT_STFT, stats_start, view->length);
+    return job.failed ? -1 : 0;
+}
+
+// Resynthesis state. Frames are overlap-added in chunks of frames_per_task,
+// with frames_per_task * hop_size >= window_length so that a chunk's output
+// only overlaps its neighbours'. Even chunks run first and odd ones second,
+// which fixes the order of the additions into every sample.
+typedef struct {
+    const STFTPlan *plan;
+    const STFTResult *stft;
+    Signal *output;
+    int frames_per_task;
+    int first_chunk;            // 0 (even chunks) or 1 (odd chunks)
+    int failed;
+} STFTSynthesisJob;
+
+static void stft_synthesis_task(void *context, int index) {
+    STFTSynthesisJob *job = (STFTSynthesisJob*)context;
+    const STFTPlan *plan = job->plan;
+    const STFTResult *stft = job->stft;
+
+    FFTPlan *inverse = fft_plan_acquire_real(plan->fft_size, FFT_INVERSE);
+    if (!inverse) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    int chunk = job->first_chunk + 2 * index;
+    int first = chunk * job->frames_per_task;
+    int last = first + job->frames_per_task;
+    if (last > stft->frames) last = stft->frames;
+
+    int length = plan->window_length;
+    double *frame = (double*)inverse->scratch;
+    double *out = job->output->data;
+
+    for (int f = first; f < last; f++) {
+        size_t row = (size_t)f * plan->bins;
+        fft_execute_c2r_split(inverse, stft->real + row, stft->imag + row, frame);
+
+        long start = stft_frame_start(plan, f);
+        int begin = (start < 0) ? (int)-start : 0;
+        int end = (start + length > job->output->length) ? (int)(job->output->length - start) : length;
+
+        for (int i = begin; i < end; i++) {
+            out[start + i] += plan->window[i] * frame[i];
+        }
+    }
+
+    fft_plan_release(inverse);
+}
+
+// Divide each output sample by fft_size times the sum of the squared
+// windows of the frames covering it (weighted overlap-add normalization)
+typedef struct {
+    const STFTPlan *plan;
+    int frames;
+    Signal *output;
+} STFTNormalizeJob;
+
+static void stft_normalize_task(void *context, int index) {
+    STFTNormalizeJob *job = (STFTNormalizeJob*)context;
+    const STFTPlan *plan = job->plan;
+    int hop = plan->hop_size;
+    int length = plan->window_length;
+    int pad = length / 2;
+
+    int first = index * STFT_SAMPLES_PER_TASK;
+    int last = first + STFT_SAMPLES_PER_TASK;
+    if (last > job->output->length) last = job->output->length;
+
+    for (int t = first; t < last; t++) {
+        // Frames f with f * hop - pad <= t < f * hop - pad + length
+        long shifted = (long)t + pad;
+        long low = shifted - length + 1;
+        int f_first = (low <= 0) ? 0 : (int)((low + hop - 1) / hop);
+        int f_last = (int)(shifted / hop);
+        if (f_last > job->frames - 1) f_last = job->frames - 1;
+
+        double norm = 0.0;
+        for (int f = f_first; f <= f_last; f++) {
+            double w = plan->window[shifted - (long)f * hop];
+            norm += w * w;
+        }
+
+        job->output->data[t] = (norm > STFT_NORM_FLOOR)
+            ? job->output->data[t] / (norm * plan->fft_size) : 0.0;
+    }
+}
+
+// Resynthesize a signal from its STFT by weighted overlap-add
+Signal* inverse_stft(const STFTPlan *plan, const STFTResult *stft) {
+    if (!plan || !stft) return NULL;
+
+    Signal *result = create_signal(stft->signal_length, stft->sample_rate);
+    if (!result) return NULL;
+
+    result->type = SIGNAL_CUSTOM;
+    snprintf(result->name, sizeof(result->name), "ISTFT (%d frames)", stft->frames);
+
+    if (inverse_stft_into(result, plan, stft) != 0) {
+        free_signal(result);
+        return NULL;
+    }
+
+    return result;
+}
+
+// Weighted overlap-add resynthesis into a caller-provided signal: every
+// frame is inverse transformed, windowed again and added at its position,
+// then each sample is divided by the summed squared window. This inverts
+// compute_stft for any window and hop where the frames overlap enough to
+// cover every sample. Only the samples are written. The result does not
+// depend on the thread count. Returns 0 on success, -1 on error.
+int inverse_stft_into(Signal *output, const STFTPlan *plan, const STFTResult *stft) {
+    if (!output || !plan || !stft) return -1;
+    if (stft->fft_size != plan->fft_size || stft->hop_size != plan->hop_size) return -1;
+
+    CONV_STATS_START(stats_start);
+    memset(output->data, 0, output->length * sizeof(double));
+
+    int frames_per_task = STFT_FRAMES_PER_TASK;
+    int min_frames = (plan->window_length + plan->hop_size - 1) / plan->hop_size;
+    if (frames_per_task < min_frames) frames_per_task = min_frames;
+
+    int chunks = (stft->frames + frames_per_task - 1) / frames_per_task;
+    STFTSynthesisJob job = {plan, stft, output, frames_per_task, 0, 0};
+
+    conv_parallel_for((chunks + 1) / 2, stft_synthesis_task, &job);
+    job.first_chunk = 1;
+    conv_parallel_for(chunks / 2, stft_synthesis_task, &job);
+    if (job.failed) return -1;
+
+    STFTNormalizeJob normalize = {plan, stft->frames, output};
+    conv_parallel_for((output->length + STFT_SAMPLES_PER_TASK - 1) / STFT_SAMPLES_PER_TASK,
+                      stft_normalize_task, &normalize);
+
+    CONV_STATS_STOP(CONV_STAT_ISTFT, stats_start, output->length);
+    return 0;
+}
@@ -0,0 +1,187 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/convolution.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// Environment variable overriding the default thread count
+#define CONV_THREADS_ENV "CONV_NUM_THREADS"
+
+// Upper bound on the pool size
+#define CONV_MAX_THREADS 256
+
+// Persistent worker pool. Workers sleep on work_ready between jobs; a job is
+// one conv_parallel_for call whose indices are handed out through next_index.
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+static pthread_t workers[CONV_MAX_THREADS];
+static int worker_count = 0;
+static int busy_workers = 0;
+static int generation = 0;
+static int shutting_down = 0;
+
+// Only one job runs at a time; other callers fall back to running inline
+static pthread_mutex_t submit_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Current job
+static ConvTaskFunction job_task = NULL;
+static void *job_context = NULL;
+static int job_count = 0;
+static int next_index = 0;
+
+// Requested thread count (0 until first use)
+static int configured_threads = 0;
+
+// Set while this thread is running pool tasks, so nested calls run inline
+static __thread int inside_pool_task = 0;
+
+// Thread count used when none was set: $CONV_NUM_THREADS, else online cores
+static int default_thread_count(void) {
+    const char *value = getenv(CONV_THREADS_ENV);
+    if (value && atoi(value) > 0) return atoi(value);
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (int)cores : 1;
+}
+
+// Run job indices until none are left
+static void run_job_tasks(void) {
+    inside_pool_task = 1;
+    while (1) {
+        int index = __atomic_fetch_add(&next_index, 1, __ATOMIC_RELAXED);
+        if (index >= job_count) break;
+        job_task(job_context, index);
+    }
+    inside_pool_task = 0;
+}
+
+static void* worker_main(void *unused) {
+    (void)unused;
+    int seen_generation = 0;
+
+    pthread_mutex_lock(&pool_lock);
+    while (1) {
+        while (!shutting_down && generation == seen_generation) {
+            pthread_cond_wait(&work_ready, &pool_lock);
+        }
+        if (shutting_down) break;
+        seen_generation = generation;
+        pthread_mutex_unlock(&pool_lock);
+
+        run_job_tasks();
+
+        pthread_mutex_lock(&pool_lock);
+        if (--busy_workers == 0) {
+            pthread_cond_signal(&work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    return NULL;
+}
+
+// Start the workers (the calling thread is the remaining one)
+static void start_workers(int threads) {
+    int wanted = threads - 1;
+    if (wanted > CONV_MAX_THREADS) wanted = CONV_MAX_THREADS;
+
+    pthread_mutex_lock(&pool_lock);
+    shutting_down = 0;
+    generation = 0;
+    pthread_mutex_unlock(&pool_lock);
+
+    while (worker_count < wanted) {
+        if (pthread_create(&workers[worker_count], NULL, worker_main, NULL) != 0) break;
+        worker_count++;
+    }
+}
+
+// Stop and join all workers
+void conv_thread_pool_shutdown(void) {
+    pthread_mutex_lock(&submit_lock);
+
+    pthread_mutex_lock(&pool_lock);
+    shutting_down = 1;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    worker_count = 0;
+
+    pthread_mutex_unlock(&submit_lock);
+}
+
+// Set the number of threads used by the parallel routines (including the
+// caller). 0 restores the default. The pool is restarted on next use; do not
+// call this while another thread is inside a parallel routine.
+void conv_set_num_threads(int num_threads) {
+    if (num_threads < 0) num_threads = 0;
+    if (num_threads > CONV_MAX_THREADS) num_threads = CONV_MAX_THREADS;
+
+    conv_thread_pool_shutdown();
+    configured_threads = (num_threads > 0) ? num_threads : default_thread_count();
+}
+
+// Number of threads the parallel routines use
+int conv_get_num_threads(void) {
+    if (configured_threads == 0) {
+        configured_threads = default_thread_count();
+        if (configured_threads > CONV_MAX_THREADS) configured_threads = CONV_MAX_THREADS;
+    }
+    return configured_threads;
+}
+
+// Run task(context, i) for i = 0..count-1 on the pool and wait for all of
+// them. Indices are claimed dynamically, so tasks must not depend on which
+// thread runs them. Calls from inside a task, or while another thread's job
+// is running, execute inline on the calling thread. Returns the number of
+// threads that took part.
+int conv_parallel_for(int count, ConvTaskFunction task, void *context) {
+    if (!task || count < 1) return 0;
+
+    int threads = conv_get_num_threads();
+    if (count == 1 || threads <= 1 || inside_pool_task ||
+        pthread_mutex_trylock(&submit_lock) != 0) {
+        for (int i = 0; i < count; i++) {
+            task(context, i);
+        }
+        return 1;
+    }
+
+    if (worker_count == 0) {
+        start_workers(threads);
+    }
+    if (worker_count == 0) {
+        pthread_mutex_unlock(&submit_lock);
+        for (int i = 0; i < count; i++) {
+            task(context, i);
+        }
+        return 1;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    job_task = task;
+    job_context = context;
+    job_count = count;
+    next_index = 0;
+    busy_workers = worker_count;
+    generation++;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    run_job_tasks();
+
+    pthread_mutex_lock(&pool_lock);
+    while (busy_workers > 0) {
+        pthread_cond_wait(&work_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    int participants = worker_count + 1;
+    pthread_mutex_unlock(&submit_lock);
+
+    return participants;
+}
@@ -112,12 +112,12 @@ void plot_signal_ascii(const Signal *signal, int width, int height) {
 
 // Plot FFT magnitude spectrum
 void plot_fft_ascii(const FFTResult *fft, int width, int height, int show_phase) {
-    if (!fft || width < 10 || height < 5) return;
+    if (!fft || !fft->magnitude || width < 10 || height < 5) return;
     
     printf("\n=== FFT Magnitude Spectrum ===\n");
     
     // We'll only plot the positive frequencies (first half of FFT)
-    int half_length = fft->length / 2;
+    int half_length = fft->fft_size / 2;
     
     // Find max magnitude for scaling
     double max_mag = 0.0;
@@ -187,7 +187,7 @@ void plot_fft_ascii(const FFTResult *fft, int width, int height, int show_phase)
     printf("\n\n");
     
     // Show phase if requested
-    if (show_phase) {
+    if (show_phase && fft->phase) {
         printf("=== FFT Phase Spectrum ===\n");
         
         // Find significant phase values (where magnitude is substantial)
@@ -208,6 +208,56 @@ void plot_fft_ascii(const FFTResult *fft, int width, int height, int show_phase)
     free(plot);
 }
 
+// ASCII rendering of an image: each character averages a block of pixels,
+// shaded from the darkest to the brightest block
+void plot_image_ascii(const Image *image, int width, int height) {
+    static const char shades[] = " .:-=+*#%@";
+    int levels = (int)sizeof(shades) - 2;
+
+    if (!image || !image->data || width < 1 || height < 1) return;
+    if (width > image->width) width = image->width;
+    if (height > image->height) height = image->height;
+
+    double *cells = (double*)malloc((size_t)width * height * sizeof(double));
+    if (!cells) return;
+
+    double low = 0.0, high = 0.0;
+    for (int cy = 0; cy < height; cy++) {
+        int y_start = cy * image->height / height;
+        int y_end = (cy + 1) * image->height / height;
+        for (int cx = 0; cx < width; cx++) {
+            int x_start = cx * image->width / width;
+            int x_end = (cx + 1) * image->width / width;
+
+            double sum = 0.0;
+            for (int y = y_start; y < y_end; y++) {
+                for (int x = x_start; x < x_end; x++) {
+                    sum += image->data[(size_t)y * image->stride + x];
+                }
+            }
+            double value = sum / ((double)(y_end - y_start) * (x_end - x_start));
+            cells[cy * width + cx] = value;
+
+            if ((cx == 0 && cy == 0) || value < low) low = value;
+            if ((cx == 0 && cy == 0) || value > high) high = value;
+        }
+    }
+
+    printf("\n%s (%d x %d, range %.3f to %.3f)\n", image->name, image->width, image->height,
+           low, high);
+    double range = (high - low > 1e-12) ? high - low : 1.0;
+    for (int cy = 0; cy < height; cy++) {
+        printf("  |");
+        for (int cx = 0; cx < width; cx++) {
+            int level = (int)((cells[cy * width + cx] - low) / range * levels + 0.5);
+            putchar(shades[level]);
+        }
+        printf("|\n");
+    }
+
+    free(cells);
+}
+
 // Simple implementation of visualization functions for compatibility
 int init_visualization(int width, int height) {
     printf("ASCII Visualization initialized (%d x %d)\n", width, height);
@@ -320,6 +370,25 @@ void plot_signals_comparison(const Signal *sig1, const Signal *sig2, const char
             printf("  Cross-correlation: %.6f\n", correlation);
         }
     }
+
+    // Best alignment over all lags: the correlation peak relative to the
+    // Cauchy-Schwarz bound sqrt(E1 E2)
+    Signal *lags = correlate(sig1, sig2, CONV_MODE_FULL);
+    if (lags) {
+        double energy1 = 0.0, energy2 = 0.0;
+        for (int i = 0; i < sig1->length; i++) energy1 += sig1->data[i] * sig1->data[i];
+        for (int i = 0; i < sig2->length; i++) energy2 += sig2->data[i] * sig2->data[i];
+
+        int best = 0;
+        for (int i = 1; i < lags->length; i++) {
+            if (fabs(lags->data[i]) > fabs(lags->data[best])) best = i;
+        }
+        if (energy1 > 1e-20 && energy2 > 1e-20) {
+            printf("  Best alignment: lag %d (similarity %.6f)\n", best - (sig2->length - 1),
+                   lags->data[best] / sqrt(energy1 * energy2));
+        }
+        free_signal(lags);
+    }
     printf("\n");
 }
 
@@ -328,56 +397,60 @@ void show_signal_spectrogram(const Signal *signal, int window_size) {
     if (!signal || window_size <= 0) return;
     
     printf("\n=== Spectrogram-style Analysis: %s ===\n", signal->name);
-    printf("Window size: %d samples\n\n", window_size);
+    printf("Window size: %d samples (Hann, 50%% overlap)\n\n", window_size);
     
-    int num_windows = (signal->length - window_size) / (window_size / 2) + 1;
-    if (num_windows < 1) {
+    if (signal->length < window_size) {
         printf("Signal too short for spectrogram analysis.\n");
         return;
     }
     
-    printf("Time windows: %d\n", num_windows);
-    printf("Frequency analysis per window:\n\n");
+    int hop = (window_size > 1) ? window_size / 2 : 1;
+    STFTPlan *plan = stft_plan_create(WINDOW_HANN, window_size, hop, 0);
+    STFTResult *stft = plan ? compute_stft(plan, signal) : NULL;
+    if (!stft) {
+        stft_plan_destroy(plan);
+        return;
+    }
+    
+    // Every frame is analysed; long signals are summarised in at most
+    // max_rows rows, each showing the strongest bin of its frames
+    const int max_rows = 32;
+    int frames_per_row = (stft->frames + max_rows - 1) / max_rows;
+    double freq_resolution = signal->sample_rate / stft->fft_size;
     
-    for (int w = 0; w < num_windows && w < 10; w++) { // Limit to 10 windows for display
-        int start_idx = w * (window_size / 2);
-        if (start_idx + window_size > signal->length) break;
-        
-        // Create windowed signal
-        Signal windowed_signal;
-        windowed_signal.data = &signal->data[start_idx];
-        windowed_signal.length = window_size;
-        windowed_signal.sample_rate = signal->sample_rate;
-        windowed_signal.duration = (double)window_size / signal->sample_rate;
-        windowed_signal.type = signal->type;
-        snprintf(windowed_signal.name, sizeof(windowed_signal.name), 
-                "Window %d", w);
+    printf("Time windows: %d", stft->frames);
+    if (frames_per_row > 1) printf(" (%d per row)", frames_per_row);
+    printf("\nFrequency analysis per window:\n\n");
+    
+    for (int first = 0; first < stft->frames; first += frames_per_row) {
+        int last = first + frames_per_row;
+        if (last > stft->frames) last = stft->frames;
         
-        // Compute and display FFT
-        FFTResult *fft = compute_fft(&windowed_signal);
-        if (fft) {
-            double window_time = start_idx / signal->sample_rate;
-            printf("Window %d (t=%.3fs):\n", w, window_time);
-            
-            // Show dominant frequencies
-            int half_length = fft->length / 2;
-            double max_mag = 0.0;
-            int max_idx = 0;
-            
-            for (int i = 1; i < half_length && i < 20; i++) {
-                if (fft->magnitude[i] > max_mag) {
-                    max_mag = fft->magnitude[i];
+        // Peak search on squared magnitudes, skipping DC; only the winner
+        // needs a square root
+        double max_power = 0.0;
+        int max_idx = 0;
+        for (int f = first; f < last; f++) {
+            const double *real = stft->real + (size_t)f * stft->bins;
+            const double *imag = stft->imag + (size_t)f * stft->bins;
+            for (int i = 1; i < stft->bins; i++) {
+                double power = real[i] * real[i] + imag[i] * imag[i];
+                if (power > max_power) {
+                    max_power = power;
                     max_idx = i;
                 }
             }
-            
-            if (max_mag > 0) {
-                printf("  Dominant frequency: %.1f Hz (magnitude: %.4f)\n", 
-                       fft->frequency[max_idx], max_mag);
-            }
-            
-            free_fft_result(fft);
+        }
+        
+        double window_time = (double)first * hop / signal->sample_rate;
+        printf("Window %d (t=%.3fs):\n", first, window_time);
+        if (max_power > 0) {
+            printf("  Dominant frequency: %.1f Hz (magnitude: %.4f)\n", 
+                   max_idx * freq_resolution, sqrt(max_power));
         }
     }
+    
+    free_stft_result(stft);
+    stft_plan_destroy(plan);
     printf("\n");
 }
\ No newline at end of file
@@ -0,0 +1,306 @@
+#include "../include/convolution.h"
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONV_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Coefficient table for one window shape, length and (Kaiser) beta. Tables
+// are shared by every caller and live until window_cache_clear. Only
+// window_table / window_table_kaiser (and so STFT plans) populate the cache;
+// one-shot windowing computes its coefficients per call.
+typedef struct WindowTable {
+    WindowType type;
+    int length;
+    double beta;
+    double *coefficients;
+    struct WindowTable *next;
+} WindowTable;
+
+static WindowTable *window_cache = NULL;
+static pthread_mutex_t window_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Window type for a name as accepted by window_signal ("hann", "hamming",
+// ...). Unknown names give WINDOW_RECTANGULAR, as window_signal always has.
+WindowType window_type_from_name(const char *name) {
+    if (!name) return WINDOW_RECTANGULAR;
+
+    if (strcmp(name, "hann") == 0 || strcmp(name, "hanning") == 0) return WINDOW_HANN;
+    if (strcmp(name, "hamming") == 0) return WINDOW_HAMMING;
+    if (strcmp(name, "blackman") == 0) return WINDOW_BLACKMAN;
+    if (strcmp(name, "kaiser") == 0) return WINDOW_KAISER;
+    if (strcmp(name, "flattop") == 0 || strcmp(name, "flat-top") == 0) return WINDOW_FLAT_TOP;
+
+    return WINDOW_RECTANGULAR;
+}
+
+// Canonical name of a window type
+const char* window_type_name(WindowType type) {
+    switch (type) {
+        case WINDOW_HANN:      return "hann";
+        case WINDOW_HAMMING:   return "hamming";
+        case WINDOW_BLACKMAN:  return "blackman";
+        case WINDOW_KAISER:    return "kaiser";
+        case WINDOW_FLAT_TOP:  return "flattop";
+        default:               return "rectangular";
+    }
+}
+
+// Zeroth-order modified Bessel function of the first kind (power series)
+static double bessel_i0(double x) {
+    double term = 1.0;
+    double sum = 1.0;
+    double quarter_x2 = 0.25 * x * x;
+
+    for (int k = 1; k < 500 && term > 1e-17 * sum; k++) {
+        term *= quarter_x2 / ((double)k * k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+// Fill coefficients with a length-point Kaiser window of shape beta
+void window_fill_kaiser(double *coefficients, int length, double beta) {
+    if (!coefficients || length < 1) return;
+
+    if (length == 1) {
+        coefficients[0] = 1.0;
+        return;
+    }
+
+    double scale = 1.0 / bessel_i0(beta);
+    for (int i = 0; i < length; i++) {
+        double r = 2.0 * i / (length - 1) - 1.0;
+        double arg = 1.0 - r * r;
+        coefficients[i] = bessel_i0(beta * sqrt(arg > 0.0 ? arg : 0.0)) * scale;
+    }
+}
+
+// Fill coefficients with a length-point symmetric window of the given
+// shape. Kaiser windows use WINDOW_KAISER_BETA.
+void window_fill(double *coefficients, int length, WindowType type) {
+    if (!coefficients || length < 1) return;
+
+    if (type == WINDOW_KAISER) {
+        window_fill_kaiser(coefficients, length, WINDOW_KAISER_BETA);
+        return;
+    }
+
+    if (length == 1) {
+        coefficients[0] = 1.0;
+        return;
+    }
+
+    for (int i = 0; i < length; i++) {
+        double phase = TWO_PI * i / (length - 1);
+
+        switch (type) {
+            case WINDOW_HANN:
+                coefficients[i] = 0.5 * (1.0 - cos(phase));
+                break;
+            case WINDOW_HAMMING:
+                coefficients[i] = 0.54 - 0.46 * cos(phase);
+                break;
+            case WINDOW_BLACKMAN:
+                coefficients[i] = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2.0 * phase);
+                break;
+            case WINDOW_FLAT_TOP:
+                // Five-term flat-top (amplitude-accurate peaks, wide main lobe)
+                coefficients[i] = 0.21557895 - 0.41663158 * cos(phase)
+                                + 0.277263158 * cos(2.0 * phase)
+                                - 0.083578947 * cos(3.0 * phase)
+                                + 0.006947368 * cos(4.0 * phase);
+                break;
+            default:
+                coefficients[i] = 1.0;
+                break;
+        }
+    }
+}
+
+// Cached table for a shape, length and beta (ignored unless Kaiser)
+static const double* cached_window(WindowType type, int length, double beta) {
+    if (length < 1) return NULL;
+    if (type != WINDOW_KAISER) beta = 0.0;
+
+    pthread_mutex_lock(&window_cache_lock);
+    for (WindowTable *table = window_cache; table; table = table->next) {
+        if (table->type == type && table->length == length && table->beta == beta) {
+            pthread_mutex_unlock(&window_cache_lock);
+            return table->coefficients;
+        }
+    }
+
+    WindowTable *table = (WindowTable*)malloc(sizeof(WindowTable));
+    double *coefficients = (double*)malloc(length * sizeof(double));
+    if (!table || !coefficients) {
+        pthread_mutex_unlock(&window_cache_lock);
+        free(table);
+        free(coefficients);
+        return NULL;
+    }
+
+    if (type == WINDOW_KAISER) {
+        window_fill_kaiser(coefficients, length, beta);
+    } else {
+        window_fill(coefficients, length, type);
+    }
+
+    table->type = type;
+    table->length = length;
+    table->beta = beta;
+    table->coefficients = coefficients;
+    table->next = window_cache;
+    window_cache = table;
+    pthread_mutex_unlock(&window_cache_lock);
+
+    return coefficients;
+}
+
+// Shared coefficient table of a length-point window, computed on first use.
+// The table must not be modified or freed by the caller.
+const double* window_table(WindowType type, int length) {
+    return cached_window(type, length, WINDOW_KAISER_BETA);
+}
+
+// Shared Kaiser table with an explicit beta (see window_table)
+const double* window_table_kaiser(int length, double beta) {
+    return cached_window(WINDOW_KAISER, length, beta);
+}
+
+// Free every cached window table. Tables handed out earlier (including the
+// ones held by STFT plans) dangle afterwards, so call this only once they
+// are no longer used.
+void window_cache_clear(void) {
+    pthread_mutex_lock(&window_cache_lock);
+    WindowTable *table = window_cache;
+    window_cache = NULL;
+    pthread_mutex_unlock(&window_cache_lock);
+
+    while (table) {
+        WindowTable *next = table->next;
+        free(table->coefficients);
+        free(table);
+        table = next;
+    }
+}
+
+#if defined(CONV_HAVE_X86_SIMD)
+// AVX2 window multiply: samples [i, length) in four-sample vectors
+__attribute__((target("avx2")))
+static int window_multiply_avx2(double *out, const double *samples, const double *window,
+                                int length, int i) {
+    for (; i + 4 <= length; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(samples + i),
+                                                _mm256_loadu_pd(window + i)));
+    }
+
+    return i;
+}
+
+// AVX-512 window multiply, eight samples per vector
+__attribute__((target("avx512f")))
+static int window_multiply_avx512(double *out, const double *samples, const double *window,
+                                  int length, int i) {
+    for (; i + 8 <= length; i += 8) {
+        _mm512_storeu_pd(out + i, _mm512_mul_pd(_mm512_loadu_pd(samples + i),
+                                                _mm512_loadu_pd(window + i)));
+    }
+
+    return i;
+}
+#endif
+
+// out[i] = samples[i] * window[i] for contiguous samples. out may be
+// samples (in place). A plain multiply, so every SIMD level gives the same
+// result.
+void window_multiply(double *out, const double *samples, const double *window, int length) {
+    if (!out || !samples || !window) return;
+
+    int i = 0;
+    switch (conv_get_simd_level()) {
+#if defined(CONV_HAVE_X86_SIMD)
+        case SIMD_AVX512:
+            i = window_multiply_avx512(out, samples, window, length, i);
+            i = window_multiply_avx2(out, samples, window, length, i);
+            break;
+        case SIMD_AVX2:
+            i = window_multiply_avx2(out, samples, window, length, i);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    for (; i < length; i++) {
+        out[i] = samples[i] * window[i];
+    }
+}
+
+// Apply window function to signal
+Signal* window_signal(const Signal *signal, const char *window_type) {
+    if (!signal) return NULL;
+
+    SignalView view = signal_view(signal);
+    Signal *windowed = window_signal_view(&view, window_type);
+    if (!windowed) return NULL;
+
+    windowed->type = signal->type;
+    snprintf(windowed->name, sizeof(windowed->name),
+             "%s (%s windowed)", signal->name, window_type);
+
+    return windowed;
+}
+
+// Windowed copy of a view's samples. The window is computed straight into
+// the result, so one-shot calls do not grow the shared table cache.
+Signal* window_signal_view(const SignalView *view, const char *window_type) {
+    if (!view || !view->data || !window_type) return NULL;
+
+    Signal *windowed = create_signal(view->length, view->sample_rate);
+    if (!windowed) return NULL;
+
+    window_fill(windowed->data, view->length, window_type_from_name(window_type));
+    snprintf(windowed->name, sizeof(windowed->name), "View (%s windowed)", window_type);
+    if (view->stride == 1) {
+        window_multiply(windowed->data, view->data, windowed->data, view->length);
+    } else {
+        for (int i = 0; i < view->length; i++) {
+            windowed->data[i] *= view->data[(ptrdiff_t)i * view->stride];
+        }
+    }
+
+    return windowed;
+}
+
+// Apply a window to a signal's samples in place. Returns 0 on success,
+// -1 on error.
+int window_signal_in_place(Signal *signal, WindowType type) {
+    if (!signal) return -1;
+
+    SignalView view = signal_view(signal);
+    return window_signal_view_in_place(&view, type);
+}
+
+// Apply a window to the samples a view points at, in place. Uses a
+// temporary table rather than the shared cache (see window_signal_view).
+int window_signal_view_in_place(SignalView *view, WindowType type) {
+    if (!view || !view->data || view->length < 1) return -1;
+
+    double *window = (double*)malloc((size_t)view->length * sizeof(double));
+    if (!window) return -1;
+    window_fill(window, view->length, type);
+
+    if (view->stride == 1) {
+        window_multiply(view->data, view->data, window, view->length);
+    } else {
+        for (int i = 0; i < view->length; i++) {
+            view->data[(ptrdiff_t)i * view->stride] *= window[i];
+        }
+    }
+
+    free(window);
+    return 0;
+}